@@ -39,11 +39,13 @@ subject to the following restrictions:
 btSequentialImpulseConstraintSolver::btSequentialImpulseConstraintSolver()
 :m_btSeed2(0)
 {
-
+	m_fixedBody = new btRigidBody(0, 0, 0);
+	m_fixedBody->setMassProps(btScalar(0.),btVector3(btScalar(0.),btScalar(0.),btScalar(0.)));
 }
 
 btSequentialImpulseConstraintSolver::~btSequentialImpulseConstraintSolver()
 {
+	delete m_fixedBody;
 }
 
 #ifdef USE_SIMD
@@ -1240,8 +1242,6 @@ void	btSequentialImpulseConstraintSolver::reset()
 
 btRigidBody& btSequentialImpulseConstraintSolver::getFixedBody()
 {
-	static btRigidBody s_fixed(0, 0,0);
-	s_fixed.setMassProps(btScalar(0.),btVector3(btScalar(0.),btScalar(0.),btScalar(0.)));
-	return s_fixed;
+	return *m_fixedBody;
 }
 
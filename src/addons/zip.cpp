@@ -123,6 +123,8 @@ bool extract_zip(const std::string &from, const std::string &to, bool recursive)
     // stored filename will be c:/..., which then does not match
     // on removing it. getAbsolutePath will convert all \ to /.
     file_system->removeFileArchive(file_system->getAbsolutePath(from.c_str()));
+    // New files were added, so cached directory listings are outdated
+    file_manager->clearDirectoryCache();
 
     return !error;
 }   // extract_zip
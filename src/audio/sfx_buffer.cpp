@@ -20,15 +20,94 @@
 #include "audio/sfx_manager.hpp"
 #include "config/user_config.hpp"
 #include "io/file_manager.hpp"
+#include "io/file_saver.hpp"
 #include "utils/constants.hpp"
 #include "utils/file_utils.hpp"
 #include "utils/log.hpp"
+#include "utils/string_utils.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <zlib.h>
 
 #ifdef ENABLE_SOUND
 #  include <vorbis/codec.h>
 #  include <vorbis/vorbisfile.h>
 #endif
 
+namespace
+{
+    /** Version of the cached decoded files. */
+    const uint8_t PCM_CACHE_VERSION = 2;
+
+    /** Size of the header of a cached decoded file: version, endianness of
+     *  the samples, and rate, channels and length as little endian 32 bit
+     *  values. */
+    const unsigned int PCM_CACHE_HEADER_SIZE = 14;
+
+    /** Maximum total size (in bytes) of the cached decoded files. The least
+     *  recently used files are removed above this. */
+    const uintmax_t MAX_PCM_CACHE_SIZE = 256 * 1024 * 1024;
+
+    // ------------------------------------------------------------------------
+    void appendUInt32(std::string *s, uint32_t value)
+    {
+        for (unsigned int i = 0; i < 4; i++)
+            s->push_back((char)((value >> (8 * i)) & 0xff));
+    }   // appendUInt32
+
+    // ------------------------------------------------------------------------
+    uint32_t getUInt32(const uint8_t *data)
+    {
+        return  (uint32_t)data[0]        | ((uint32_t)data[1] << 8) |
+               ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+    }   // getUInt32
+
+#ifdef ENABLE_SOUND
+    /** An ogg file in memory, read by the callbacks below. */
+    struct MemoryFile
+    {
+        const std::vector<char> *m_data;
+        size_t                   m_pos;
+    };   // MemoryFile
+
+    // ------------------------------------------------------------------------
+    size_t readMemory(void *ptr, size_t size, size_t nmemb, void *source)
+    {
+        MemoryFile *file = (MemoryFile*)source;
+        if (size == 0)
+            return 0;
+        size_t n = std::min(nmemb, (file->m_data->size() - file->m_pos) / size);
+        memcpy(ptr, file->m_data->data() + file->m_pos, n * size);
+        file->m_pos += n * size;
+        return n;
+    }   // readMemory
+
+    // ------------------------------------------------------------------------
+    int seekMemory(void *source, ogg_int64_t offset, int whence)
+    {
+        MemoryFile *file = (MemoryFile*)source;
+        ogg_int64_t pos = offset;
+        if (whence == SEEK_CUR)
+            pos += file->m_pos;
+        else if (whence == SEEK_END)
+            pos += file->m_data->size();
+        if (pos < 0 || pos > (ogg_int64_t)file->m_data->size())
+            return -1;
+        file->m_pos = (size_t)pos;
+        return 0;
+    }   // seekMemory
+
+    // ------------------------------------------------------------------------
+    long tellMemory(void *source)
+    {
+        return (long)((MemoryFile*)source)->m_pos;
+    }   // tellMemory
+#endif
+}   // anonymous namespace
+
 //----------------------------------------------------------------------------
 /** Creates a sfx. The parameter are taken from the parameters:
  *  \param file File name of the buffer.
@@ -50,6 +129,9 @@ SFXBuffer::SFXBuffer(const std::string& file,
     m_loaded      = false;
     m_max_dist    = max_dist;
     m_duration    = -1.0f;
+    m_decoded     = false;
+    m_rate        = 0;
+    m_channels    = 0;
     m_file        = file;
     m_name        = name;
 
@@ -71,6 +153,9 @@ SFXBuffer::SFXBuffer(const std::string& file,
     m_rolloff     = 0.1f;
     m_max_dist    = 300.0f;
     m_duration    = -1.0f;
+    m_decoded     = false;
+    m_rate        = 0;
+    m_channels    = 0;
     m_positional  = false;
     m_loaded      = false;
     m_file        = file;
@@ -82,6 +167,66 @@ SFXBuffer::SFXBuffer(const std::string& file,
     node->get("duration",    &m_duration   );
 }   // SFXBuffer(XMLNode)
 
+//----------------------------------------------------------------------------
+/** Decodes the file of this buffer, so that load() only needs to copy the
+ *  data into an openal buffer. This does not use openal, so it can be called
+ *  from any thread (see SFXManager::loadSfx). The decoded data is cached on
+ *  disk, using the checksum of the file as name, so a file is only decoded
+ *  again when it changed, and identical files (e.g. used by several karts)
+ *  share the cached data.
+ *  \return Whether decoding was successful.
+ */
+bool SFXBuffer::decode()
+{
+#ifdef ENABLE_SOUND
+    if (m_decoded)
+        return true;
+    if (!UserConfigParams::m_sfx || !UserConfigParams::m_enable_sound)
+        return false;
+
+    FILE *file = FileUtils::fopenU8Path(m_file, "rb");
+    if (!file)
+    {
+        Log::error("SFXBuffer", "Couldn't open file '%s'.", m_file.c_str());
+        return false;
+    }
+    std::vector<char> ogg;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (size > 0)
+    {
+        ogg.resize(size);
+        if (fread(ogg.data(), 1, size, file) != (size_t)size)
+            ogg.clear();
+    }
+    fclose(file);
+
+    uLong crc = crc32(0L, Z_NULL, 0);
+    crc = crc32(crc, (const Bytef*)ogg.data(), (uInt)ogg.size());
+    char name[64];
+    sprintf(name, "sfx-%08lx-%lx.pcm", (unsigned long)crc,
+            (unsigned long)ogg.size());
+    const std::string cache_file = file_manager->getCachedDataDir() + name;
+
+    if (!loadPCMCache(cache_file))
+    {
+        if (!decodeVorbis(ogg))
+            return false;
+        savePCMCache(cache_file);
+    }
+
+    // Allow the xml data to overwrite the duration, but if there is no
+    // duration (which is the norm), compute it. We always use 16 bit data.
+    if (m_duration < 0)
+        m_duration = float(m_pcm.size()) / (m_rate * m_channels * 2);
+    m_decoded = true;
+    return true;
+#else
+    return false;
+#endif
+}   // decode
+
 //----------------------------------------------------------------------------
 /** \brief load the buffer from file into OpenAL.
  *  \note If this buffer is already loaded, this call does nothing and 
@@ -96,6 +241,13 @@ bool SFXBuffer::load()
     if (UserConfigParams::m_enable_sound)
     {
         if (m_loaded) return false;
+
+        if (!decode())
+        {
+            Log::error("SFXBuffer", "Could not load sound effect %s",
+                       m_file.c_str());
+            return false;
+        }
     
         alGetError(); // clear errors from previously
     
@@ -106,14 +258,15 @@ bool SFXBuffer::load()
         }
     
         assert(alIsBuffer(m_buffer));
-    
-        if (!loadVorbisBuffer(m_file, m_buffer))
-        {
-            Log::error("SFXBuffer", "Could not load sound effect %s",
-                       m_file.c_str());
-            // TODO: free al buffer here?
-            return false;
-        }
+
+        alBufferData(m_buffer, m_channels == 1 ? AL_FORMAT_MONO16
+                                               : AL_FORMAT_STEREO16,
+                     m_pcm.data(), (ALsizei)m_pcm.size(), m_rate);
+        SFXManager::checkError("filling a buffer");
+
+        // Openal has its own copy of the data now
+        std::vector<char>().swap(m_pcm);
+        m_decoded = false;
     }
 #endif
 
@@ -143,88 +296,200 @@ void SFXBuffer::unload()
 }   // unload
 
 //----------------------------------------------------------------------------
-/** Load a vorbis file into an OpenAL buffer
+/** Decodes a vorbis file into m_pcm.
  *  based on a routine by Peter Mulholland, used with permission (quote :
  *  "Feel free to use")
+ *  \param ogg Content of the file.
  */
-bool SFXBuffer::loadVorbisBuffer(const std::string &name, ALuint buffer)
+bool SFXBuffer::decodeVorbis(const std::vector<char> &ogg)
 {
 #ifdef ENABLE_SOUND
-    if (!UserConfigParams::m_enable_sound)
-        return false;
-        
     const int ogg_endianness = (IS_LITTLE_ENDIAN ? 0 : 1);
 
+    MemoryFile memory;
+    memory.m_data = &ogg;
+    memory.m_pos  = 0;
+    ov_callbacks callbacks;
+    callbacks.read_func  = readMemory;
+    callbacks.seek_func  = seekMemory;
+    callbacks.close_func = NULL;
+    callbacks.tell_func  = tellMemory;
 
-    bool success = false;
-    FILE *file;
-    vorbis_info *info;
     OggVorbis_File oggFile;
-
-    if (alIsBuffer(buffer) == AL_FALSE)
+    if (ov_open_callbacks(&memory, &oggFile, NULL, 0, callbacks) != 0)
     {
-        Log::error("SFXBuffer", "Error, bad OpenAL buffer");
+        Log::error("SFXBuffer", "decodeVorbis() - ov_open_callbacks() "
+                   "failed, file '%s' isn't vorbis?", m_file.c_str());
         return false;
     }
 
-    file = FileUtils::fopenU8Path(name, "rb");
-
-    if(!file)
-    {
-        Log::error("SFXBuffer", "LoadVorbisBuffer() - couldn't open file!");
-        return false;
-    }
-
-    if (ov_open_callbacks(file, &oggFile, NULL, 0,  OV_CALLBACKS_NOCLOSE) != 0)
-    {
-        fclose(file);
-        Log::error("SFXBuffer", "LoadVorbisBuffer() - ov_open_callbacks() failed, "
-                                "file isn't vorbis?");
-        return false;
-    }
-
-    info = ov_info(&oggFile, -1);
+    vorbis_info *info = ov_info(&oggFile, -1);
+    m_rate     = info->rate;
+    m_channels = info->channels;
 
     // always 16 bit data
     long len = (long)ov_pcm_total(&oggFile, -1) * info->channels * 2;
-
-    std::unique_ptr<char []> data = std::unique_ptr<char []>(new char[len]);
+    m_pcm.resize(len);
 
     int bs = -1;
     long todo = len;
-    char *bufpt = data.get();
+    char *bufpt = m_pcm.data();
 
     while (todo)
     {
         int read = ov_read(&oggFile, bufpt, todo, ogg_endianness, 2, 1, &bs);
+        if (read <= 0)
+        {
+            // Truncated file, keep what was decoded
+            m_pcm.resize(len - todo);
+            break;
+        }
         todo -= read;
         bufpt += read;
     }
 
-    alBufferData(buffer, (info->channels == 1) ? AL_FORMAT_MONO16
-                 : AL_FORMAT_STEREO16,
-                 data.get(), len, info->rate);
-    success = true;
+    ov_clear(&oggFile);
+    return true;
+#else
+    return false;
+#endif
+}   // decodeVorbis
 
-    int buffer_size, frequency, bits_per_sample, channels;
-    buffer_size = len;
-    frequency = info->rate;
-    // We use AL_FORMAT_MONO16 or AL_FORMAT_STEREO16 so it's always 16
-    bits_per_sample = 16;
-    channels = info->channels;
+//----------------------------------------------------------------------------
+/** Reads the decoded data from the cache.
+ *  \param cache_file Name of the cache file.
+ *  \return False if the file does not exist or can not be read.
+ */
+bool SFXBuffer::loadPCMCache(const std::string &cache_file)
+{
+    FILE *fd = FileUtils::fopenU8Path(cache_file, "rb");
+    if (!fd)
+        return false;
 
-    ov_clear(&oggFile);
-    fclose(file);
+    // The samples are stored in the endianness of the machine which
+    // decoded them, so the cache can't be used on a different one
+    uint8_t header[PCM_CACHE_HEADER_SIZE];
+    uint32_t rate = 0, channels = 0, len = 0;
+    bool ok = fread(header, PCM_CACHE_HEADER_SIZE, 1, fd) == 1 &&
+              header[0] == PCM_CACHE_VERSION &&
+              header[1] == (IS_LITTLE_ENDIAN ? 0 : 1);
+    if (ok)
+    {
+        rate     = getUInt32(header + 2);
+        channels = getUInt32(header + 6);
+        len      = getUInt32(header + 10);
+        ok = rate > 0 && (channels == 1 || channels == 2);
+    }
+    if (ok)
+    {
+        m_pcm.resize(len);
+        ok = len == 0 || fread(m_pcm.data(), 1, len, fd) == len;
+    }
+    fclose(fd);
+    if (!ok)
+    {
+        std::vector<char>().swap(m_pcm);
+        return false;
+    }
+    m_rate     = rate;
+    m_channels = channels;
 
-    // Allow the xml data to overwrite the duration, but if there is no
-    // duration (which is the norm), compute it:
-    if(m_duration < 0)
+    // Mark the file as recently used, see cleanPCMCache
+    std::error_code ec;
+    std::filesystem::last_write_time(FileUtils::getPortableReadingPath(
+        cache_file), std::filesystem::file_time_type::clock::now(), ec);
+    return true;
+}   // loadPCMCache
+
+//----------------------------------------------------------------------------
+/** Writes the decoded data to the cache.
+ *  \param cache_file Name of the cache file.
+ */
+void SFXBuffer::savePCMCache(const std::string &cache_file) const
+{
+    std::string content;
+    content.reserve(PCM_CACHE_HEADER_SIZE + m_pcm.size());
+    content.push_back((char)PCM_CACHE_VERSION);
+    content.push_back(IS_LITTLE_ENDIAN ? 0 : 1);
+    appendUInt32(&content, (uint32_t)m_rate);
+    appendUInt32(&content, (uint32_t)m_channels);
+    appendUInt32(&content, (uint32_t)m_pcm.size());
+    content.append(m_pcm.data(), m_pcm.size());
+    // Several buffers can be decoded at the same time, so write directly
+    // instead of queueing in the FileSaver
+    if (!FileSaver::writeFile(cache_file, content))
     {
-        m_duration = float(buffer_size) 
-                   / (frequency*channels*(bits_per_sample / 8));
+        Log::warn("SFXBuffer", "Can't write cache file '%s'.",
+                  cache_file.c_str());
     }
-    return success;
-#else
-    return false;
-#endif
-}   // loadVorbisBuffer
+}   // savePCMCache
+
+//----------------------------------------------------------------------------
+/** Removes the least recently used files from the cache of decoded sound
+ *  effects until they use at most MAX_PCM_CACHE_SIZE bytes, since files of
+ *  changed or removed sounds (e.g. of updated addons) are never used again.
+ *  Temporary files older than an hour, which are left over if the game
+ *  crashed while writing a file, are removed too.
+ */
+void SFXBuffer::cleanPCMCache()
+{
+    struct CacheFile
+    {
+        std::filesystem::path           m_path;
+        std::filesystem::file_time_type m_time;
+        uintmax_t                       m_size;
+    };
+    std::vector<CacheFile> files;
+    uintmax_t total_size = 0;
+    const std::filesystem::file_time_type old =
+        std::filesystem::file_time_type::clock::now() - std::chrono::hours(1);
+
+    std::error_code ec;
+    std::filesystem::directory_iterator it(FileUtils::getPortableReadingPath(
+        file_manager->getCachedDataDir()), ec);
+    for (; !ec && it != std::filesystem::directory_iterator();
+         it.increment(ec))
+    {
+        const std::string name = it->path().filename().string();
+        if (!StringUtils::startsWith(name, "sfx-"))
+            continue;
+        std::error_code file_ec;
+        CacheFile file;
+        file.m_path = it->path();
+        file.m_time = std::filesystem::last_write_time(file.m_path, file_ec);
+        file.m_size = std::filesystem::file_size(file.m_path, file_ec);
+        if (file_ec)
+            continue;
+        if (StringUtils::hasSuffix(name, ".tmp"))
+        {
+            if (file.m_time < old)
+                std::filesystem::remove(file.m_path, file_ec);
+        }
+        else if (StringUtils::hasSuffix(name, ".pcm"))
+        {
+            files.push_back(file);
+            total_size += file.m_size;
+        }
+    }
+
+    std::sort(files.begin(), files.end(),
+              [](const CacheFile &a, const CacheFile &b)
+        {
+            return a.m_time < b.m_time;
+        });
+    unsigned int removed = 0;
+    for (unsigned int i = 0;
+         i < files.size() && total_size > MAX_PCM_CACHE_SIZE; i++)
+    {
+        std::error_code file_ec;
+        if (std::filesystem::remove(files[i].m_path, file_ec))
+        {
+            total_size -= files[i].m_size;
+            removed++;
+        }
+    }
+    if (removed > 0)
+    {
+        Log::info("SFXBuffer", "Removed %d cached sound files.", removed);
+    }
+}   // cleanPCMCache
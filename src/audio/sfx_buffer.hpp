@@ -32,6 +32,7 @@ typedef unsigned int ALuint;
 
 #include <string>
 #include <memory>
+#include <vector>
 
 class SFXBase;
 class XMLNode;
@@ -71,7 +72,20 @@ private:
     /** Duration of the sfx. */
     float    m_duration;
 
-    bool loadVorbisBuffer(const std::string &name, ALuint buffer);
+    /** True if m_pcm contains the decoded file, see decode(). */
+    bool     m_decoded;
+
+    /** The decoded 16 bit data, only kept until it is copied into the
+     *  openal buffer. */
+    std::vector<char> m_pcm;
+
+    /** Sample rate and number of channels of the decoded data. */
+    int      m_rate;
+    int      m_channels;
+
+    bool decodeVorbis(const std::vector<char> &ogg);
+    bool loadPCMCache(const std::string &cache_file);
+    void savePCMCache(const std::string &cache_file) const;
 
 public:
 
@@ -89,8 +103,10 @@ public:
     }   // ~SFXBuffer
 
 
+    bool decode();
     bool load();
     void unload();
+    static void cleanPCMCache();
 
     // ------------------------------------------------------------------------
     /** \return whether this buffer was loaded from disk */
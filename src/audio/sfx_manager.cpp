@@ -27,8 +27,10 @@
 #include "utils/stk_process.hpp"
 #include "utils/profiler.hpp"
 #include "utils/string_utils.hpp"
+#include "utils/thread_pool.hpp"
 #include "utils/vs.hpp"
 
+#include <algorithm>
 #include <stdexcept>
 #include <map>
 
@@ -689,24 +691,32 @@ void SFXManager::loadSfx()
         }
     }
 
-    // Now load them in parallel
-    const int max = (int)m_all_sfx_types.size();
-    SFXBuffer **array = new SFXBuffer *[max];
-    i = 0;
-
+    std::vector<SFXBuffer*> buffers;
     for (std::map<std::string, SFXBuffer*>::iterator it = m_all_sfx_types.begin();
          it != m_all_sfx_types.end(); it++)
     {
-        SFXBuffer* const buffer = (*it).second;
-        array[i++] = buffer;
+        buffers.push_back(it->second);
     }
 
-    for (i = 0; i < max; i++)
+    // Now decode them in parallel, and create the openal buffers (which is
+    // done in this thread). The buffers are handled in batches, so that not
+    // all decoded data is in memory at the same time.
+    ThreadPool *pool = ThreadPool::get();
+    const unsigned batch = pool ? 4 * (pool->getNumThreads() + 1) : 1;
+    for (unsigned start = 0; start < buffers.size(); start += batch)
     {
-        array[i]->load();
+        unsigned count = std::min(batch, (unsigned)buffers.size() - start);
+        if (pool)
+        {
+            pool->parallelFor(count, [&buffers, start](unsigned n)
+                {
+                    buffers[start + n]->decode();
+                });
+        }
+        for (unsigned n = 0; n < count; n++)
+            buffers[start + n]->load();
     }
-
-    delete [] array;
+    SFXBuffer::cleanPCMCache();
 }   // loadSfx
 
 // -----------------------------------------------------------------------------
@@ -86,6 +86,11 @@ bool SFXOpenAL::init()
     if (!SFXManager::checkError("generating a source"))
         return false;
 
+    // Buffers of sounds which are not always needed (e.g. the engine sounds
+    // of all karts) are only loaded when they are used the first time
+    if (!m_sound_buffer->isLoaded())
+        m_sound_buffer->load();
+
     assert( alIsBuffer(m_sound_buffer->getBufferID()) );
     assert( alIsSource(m_sound_source) );
 
@@ -377,6 +382,8 @@ void SFXOpenAL::reallyPlayNow(SFXBuffer* buffer)
             reallyStopNow();
 
         m_sound_buffer = buffer;
+        if (!m_sound_buffer->isLoaded())
+            m_sound_buffer->load();
         alSourcei(m_sound_source, AL_BUFFER, m_sound_buffer->getBufferID());
 
         if (!SFXManager::checkError("attaching the buffer to the source"))
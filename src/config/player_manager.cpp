@@ -250,7 +250,8 @@ void PlayerManager::save()
     std::string filename = file_manager->getUserConfigFile("players.xml");
     try
     {
-        UTFWriter players_file(filename.c_str(), false);
+        UTFWriter players_file(filename.c_str(), false,
+                               /*background*/true);
 
         players_file << "<?xml version=\"1.0\"?>\n";
         players_file << "<players version=\"1\" >\n";
@@ -35,10 +35,10 @@ static std::vector<UserConfigParam*> all_params;
 #include "config/stk_config.hpp"
 #include "guiengine/engine.hpp"
 #include "io/file_manager.hpp"
+#include "io/file_saver.hpp"
 #include "io/utf_writer.hpp"
 #include "io/xml_node.hpp"
 #include "race/race_manager.hpp"
-#include "utils/file_utils.hpp"
 #include "utils/log.hpp"
 #include "utils/string_utils.hpp"
 #include "utils/translation.hpp"
@@ -742,20 +742,7 @@ void UserConfig::saveConfig()
     }
     ss << "</stkconfig>\n";
 
-    try
-    {
-        std::string s = ss.str();
-        std::ofstream configfile(FileUtils::getPortableWritingPath(filename),
-            std::ofstream::out);
-        configfile << ss.rdbuf();
-        configfile.close();
-    }
-    catch (const std::exception& e)
-    {
-        Log::error("UserConfig::saveConfig", "Failed to write config to %s, "
-            "because %s", filename.c_str(), e.what());
-    }
-
+    FileSaver::save(filename, ss.str());
 }   // saveConfig
 
 // ----------------------------------------------------------------------------
@@ -736,6 +736,25 @@ namespace UserConfigParams
         PARAM_DEFAULT(IntUserConfigParam(30, "record_fps",
         &m_recording_group, "Specify the fps of recording video"));
 
+    PARAM_PREFIX BoolUserConfigParam        m_binary_history
+        PARAM_DEFAULT(BoolUserConfigParam(false, "binary_history",
+        &m_recording_group, "Write the history (for --history) in binary "
+                            "format while racing, which is smaller and "
+                            "faster to load than the text format."));
+
+    PARAM_PREFIX BoolUserConfigParam        m_binary_replay
+        PARAM_DEFAULT(BoolUserConfigParam(false, "binary_replay",
+        &m_recording_group, "Save replays in binary format, which is smaller "
+                            "and faster to load, but can not be read by "
+                            "older versions of SuperTuxKart."));
+
+    PARAM_PREFIX IntUserConfigParam         m_recording_compression
+        PARAM_DEFAULT(IntUserConfigParam(1, "recording_compression",
+        &m_recording_group, "zlib compression level (1-9) of binary history "
+                            "files, 0 to disable compression. Binary replays "
+                            "are not compressed, so they can be read at any "
+                            "position."));
+
     // ---- Debug - not saved to config file
     /** If high scores will not be saved. For repeated testing on tracks. */
     PARAM_PREFIX bool m_no_high_scores PARAM_DEFAULT(false);
@@ -871,6 +890,10 @@ namespace UserConfigParams
      PARAM_PREFIX IntUserConfigParam m_timer_sync_difference_tolerance
         PARAM_DEFAULT(IntUserConfigParam(5, "timer-sync-difference-tolerance",
         &m_network_group, "Max time difference tolerance (in ms) to synchronize timer with server."));
+    PARAM_PREFIX BoolUserConfigParam m_incremental_rewind
+        PARAM_DEFAULT(BoolUserConfigParam(true, "incremental-rewind",
+        &m_network_group, "Skip the rewind when a state received from the "
+        "server is the same as the state predicted by this client."));
     PARAM_PREFIX IntUserConfigParam m_default_ip_type
         PARAM_DEFAULT(IntUserConfigParam(0, "default-ip-type",
         &m_network_group, "Default IP type of this machine, "
@@ -959,6 +982,54 @@ namespace UserConfigParams
     PARAM_PREFIX BoolUserConfigParam        m_cache_overworld
             PARAM_DEFAULT(  BoolUserConfigParam(true, "cache-overworld") );
 
+    PARAM_PREFIX IntUserConfigParam         m_worker_threads
+            PARAM_DEFAULT(  IntUserConfigParam(-1, "worker-threads",
+            "Number of worker threads used for parallel game logic (e.g. AI), "
+            "0 to disable, -1 to use the number of CPU cores minus one.") );
+
+    PARAM_PREFIX BoolUserConfigParam        m_mt_physics
+            PARAM_DEFAULT(  BoolUserConfigParam(false, "mt-physics",
+            "Solve independent physics islands in parallel using the "
+            "worker threads.") );
+    PARAM_PREFIX BoolUserConfigParam        m_mt_physics_deterministic
+            PARAM_DEFAULT(  BoolUserConfigParam(true,
+            "mt-physics-deterministic",
+            "Make the result of the multi-threaded physics independent of "
+            "the number of worker threads.") );
+
+    // ---- AI level of detail
+    PARAM_PREFIX GroupUserConfigParam       m_ai_lod_group
+        PARAM_DEFAULT( GroupUserConfigParam("AILevelOfDetail",
+                       "AI karts far away from all human players only plan "
+                       "their driving every few ticks.") );
+    PARAM_PREFIX BoolUserConfigParam        m_ai_lod
+            PARAM_DEFAULT(  BoolUserConfigParam(false, "enabled",
+            &m_ai_lod_group, "Enable reduced planning rate for far AI karts.") );
+    PARAM_PREFIX FloatUserConfigParam       m_ai_lod_distance
+            PARAM_DEFAULT(  FloatUserConfigParam(100.0f, "distance",
+            &m_ai_lod_group, "AI karts further away (along the track) from "
+            "every human player than this use the reduced planning rate.") );
+    PARAM_PREFIX IntUserConfigParam         m_ai_lod_rank
+            PARAM_DEFAULT(  IntUserConfigParam(0, "rank",
+            &m_ai_lod_group, "AI karts more than this many positions away "
+            "from every human player use the reduced planning rate, even if "
+            "they are close. 0 to only use the distance.") );
+    PARAM_PREFIX IntUserConfigParam         m_ai_lod_interval
+            PARAM_DEFAULT(  IntUserConfigParam(4, "interval",
+            &m_ai_lod_group, "Number of ticks between two plannings of an "
+            "AI kart with reduced planning rate.") );
+    PARAM_PREFIX BoolUserConfigParam        m_ai_lod_deterministic
+            PARAM_DEFAULT(  BoolUserConfigParam(false, "deterministic",
+            &m_ai_lod_group, "Only use the race state (not the cameras) to "
+            "select the planning rate and plan on fixed ticks. This is "
+            "always done in networking games.") );
+
+    PARAM_PREFIX IntUserConfigParam         m_kart_models_races
+            PARAM_DEFAULT(  IntUserConfigParam(5, "kart-models-races",
+            "Without graphics kart models are only loaded when a kart is "
+            "used in a race. They are unloaded again if the kart was not "
+            "used in this many races (0 to keep them loaded).") );
+
     // TODO : is this used with new code? does it still work?
     PARAM_PREFIX BoolUserConfigParam        m_crashed
             PARAM_DEFAULT(  BoolUserConfigParam(false, "crashed") );
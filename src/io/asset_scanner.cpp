@@ -0,0 +1,268 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2024 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+
+#include "io/asset_scanner.hpp"
+
+#include "io/file_manager.hpp"
+#include "io/file_saver.hpp"
+#include "io/xml_node.hpp"
+#include "utils/file_utils.hpp"
+#include "utils/log.hpp"
+#include "utils/thread_pool.hpp"
+#include "utils/time.hpp"
+
+#include <set>
+#include <zlib.h>
+
+namespace
+{
+    /** Version of the index file, must be increased whenever the format
+     *  (including XMLNode::saveBinary) changes. */
+    const uint8_t INDEX_VERSION = 3;
+
+    // ------------------------------------------------------------------------
+    /** Computes the CRC32 of a file.
+     *  \param file Full path of the file.
+     *  \param[out] crc The checksum.
+     *  \return False if the file could not be read.
+     */
+    bool getFileCRC(const std::string& file, uint32_t* crc)
+    {
+        FILE *fd = FileUtils::fopenU8Path(file, "rb");
+        if (!fd)
+            return false;
+        uLong c = crc32(0L, Z_NULL, 0);
+        char buffer[16384];
+        size_t n;
+        while ((n = fread(buffer, 1, sizeof(buffer), fd)) > 0)
+            c = crc32(c, (const Bytef*)buffer, (uInt)n);
+        bool ok = !ferror(fd);
+        fclose(fd);
+        *crc = (uint32_t)c;
+        return ok;
+    }   // getFileCRC
+}   // anonymous namespace
+
+// ----------------------------------------------------------------------------
+/** Scans the search directories and parses the config files of all assets.
+ *  \param search_path The directories to search.
+ *  \param config_name Name of the config file, appended to the directory
+ *         of an asset (e.g. "track.xml" or "/kart.xml").
+ *  \param subdir_suffix Appended to the name of a subdirectory to get the
+ *         directory of an asset (e.g. "/" for tracks).
+ *  \param index_name Name of the index file in the cached data directory,
+ *         or "" to always parse all config files.
+ */
+AssetScanner::AssetScanner(const std::vector<std::string>& search_path,
+                           const std::string& config_name,
+                           const std::string& subdir_suffix,
+                           const std::string& index_name)
+{
+    m_num_indexed = 0;
+    uint64_t start = StkTime::getMonoTimeUs();
+    if (!index_name.empty())
+    {
+        m_index_file = file_manager->getCachedDataDir() + index_name;
+        loadIndex();
+    }
+    for (const std::string& dir : search_path)
+    {
+        // First test if the directory itself contains an asset, in which
+        // case its subdirectories are not searched
+        if (file_manager->fileExists(dir + config_name))
+        {
+            m_assets.push_back({ dir, NULL, true, 0, 0, 0, false });
+            continue;
+        }
+        std::set<std::string> subdirs;
+        file_manager->listFiles(subdirs, dir);
+        for (const std::string& subdir : subdirs)
+        {
+            if (subdir == "." || subdir == "..")
+                continue;
+            m_assets.push_back({ dir + subdir + subdir_suffix, NULL, false,
+                                 0, 0, 0, false });
+        }
+    }
+    uint64_t discovered = StkTime::getMonoTimeUs();
+    m_discovery_time = (discovered - start) / 1000.0f;
+
+    // The index is only read here, so it can be used by all threads
+    auto parse = [this, &config_name](unsigned i)
+    {
+        Asset& asset = m_assets[i];
+        const std::string file = asset.m_dir + config_name;
+        struct stat info;
+        if (FileUtils::statU8Path(file, &info) == 0)
+        {
+            asset.m_exists = true;
+            asset.m_mtime = (uint64_t)info.st_mtime;
+            asset.m_size = (uint64_t)info.st_size;
+            // Without checksum the file is parsed, but not added to the index
+            if (!getFileCRC(file, &asset.m_crc))
+                asset.m_size = 0;
+            auto it = m_index.find(file);
+            if (it != m_index.end() && asset.m_size != 0 &&
+                it->second.m_mtime == asset.m_mtime &&
+                it->second.m_size == asset.m_size &&
+                it->second.m_crc == asset.m_crc)
+            {
+                const char* data = it->second.m_data.data();
+                asset.m_xml = XMLNode::loadBinary(file, &data,
+                    data + it->second.m_data.size());
+                asset.m_indexed = asset.m_xml != NULL;
+            }
+        }
+        else if (!asset.m_exists)
+        {
+            // The file might still be found by the irrlicht file system
+            asset.m_exists = file_manager->fileExists(file);
+        }
+        if (asset.m_exists && !asset.m_xml)
+            asset.m_xml = file_manager->createXMLTree(file);
+    };
+    ThreadPool* pool = ThreadPool::get();
+    if (pool && pool->getNumThreads() > 0)
+        pool->parallelFor((unsigned)m_assets.size(), parse);
+    else
+    {
+        for (unsigned i = 0; i < m_assets.size(); i++)
+            parse(i);
+    }
+
+    // Remove the subdirectories without asset, keeping the order
+    unsigned n = 0;
+    for (unsigned i = 0; i < m_assets.size(); i++)
+    {
+        if (m_assets[i].m_exists)
+            m_assets[n++] = m_assets[i];
+    }
+    m_assets.resize(n);
+    m_parse_time = (StkTime::getMonoTimeUs() - discovered) / 1000.0f;
+
+    if (!m_index_file.empty())
+    {
+        // Update the index with the files parsed now, and remove files
+        // which were not found anymore
+        bool changed = false;
+        std::map<std::string, IndexEntry> index;
+        for (Asset& asset : m_assets)
+        {
+            const std::string file = asset.m_dir + config_name;
+            auto it = m_index.find(file);
+            if (asset.m_indexed)
+            {
+                m_num_indexed++;
+                index[file] = std::move(it->second);
+                continue;
+            }
+            if (!asset.m_xml || asset.m_size == 0)
+                continue;
+            changed = true;
+            IndexEntry& entry = index[file];
+            entry.m_mtime = asset.m_mtime;
+            entry.m_size = asset.m_size;
+            entry.m_crc = asset.m_crc;
+            asset.m_xml->saveBinary(&entry.m_data);
+        }
+        changed |= index.size() != m_index.size();
+        std::swap(index, m_index);
+        if (changed)
+            saveIndex();
+    }
+}   // AssetScanner
+
+// ----------------------------------------------------------------------------
+/** Reads the index file. If it does not exist or is invalid, the index stays
+ *  empty and all config files are parsed.
+ */
+void AssetScanner::loadIndex()
+{
+    FILE *fd = FileUtils::fopenU8Path(m_index_file, "rb");
+    if (!fd)
+        return;
+
+    uint8_t version = 0;
+    uint32_t count = 0;
+    bool ok = fread(&version, 1, 1, fd) == 1 && version == INDEX_VERSION &&
+              fread(&count, 4, 1, fd) == 1;
+    for (uint32_t i = 0; ok && i < count; i++)
+    {
+        uint32_t sizes[2];
+        IndexEntry entry;
+        std::string file;
+        ok = fread(sizes, 4, 2, fd) == 2 &&
+             fread(&entry.m_mtime, 8, 1, fd) == 1 &&
+             fread(&entry.m_size, 8, 1, fd) == 1 &&
+             fread(&entry.m_crc, 4, 1, fd) == 1 &&
+             sizes[0] < 4096 && sizes[1] < (1 << 24);
+        if (!ok)
+            break;
+        file.resize(sizes[0]);
+        entry.m_data.resize(sizes[1]);
+        ok = (sizes[0] == 0 || fread(&file[0], sizes[0], 1, fd) == 1) &&
+             (sizes[1] == 0 || fread(&entry.m_data[0], sizes[1], 1, fd) == 1);
+        if (ok)
+            m_index[file] = std::move(entry);
+    }
+    fclose(fd);
+    if (!ok)
+    {
+        Log::warn("AssetScanner", "Invalid asset index '%s', ignored.",
+                  m_index_file.c_str());
+        m_index.clear();
+    }
+}   // loadIndex
+
+// ----------------------------------------------------------------------------
+/** Writes the index file, through a temporary file so that an interrupted
+ *  write never leaves a broken index. Errors are only logged, the config
+ *  files will then be parsed again next time.
+ */
+void AssetScanner::saveIndex()
+{
+    std::string content;
+    const uint32_t count = (uint32_t)m_index.size();
+    content.append((const char*)&INDEX_VERSION, 1);
+    content.append((const char*)&count, 4);
+    for (auto& p : m_index)
+    {
+        const uint32_t sizes[2] = { (uint32_t)p.first.size(),
+                                    (uint32_t)p.second.m_data.size() };
+        content.append((const char*)sizes, 8);
+        content.append((const char*)&p.second.m_mtime, 8);
+        content.append((const char*)&p.second.m_size, 8);
+        content.append((const char*)&p.second.m_crc, 4);
+        content.append(p.first);
+        content.append(p.second.m_data);
+    }
+    if (!FileSaver::writeFile(m_index_file, content))
+    {
+        Log::warn("AssetScanner", "Can not write asset index '%s'.",
+                  m_index_file.c_str());
+    }
+}   // saveIndex
+
+// ----------------------------------------------------------------------------
+/** Frees the config files which were not taken by the caller. */
+AssetScanner::~AssetScanner()
+{
+    for (Asset& asset : m_assets)
+        delete asset.m_xml;
+}   // ~AssetScanner
@@ -0,0 +1,135 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2024 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+
+#ifndef HEADER_ASSET_SCANNER_HPP
+#define HEADER_ASSET_SCANNER_HPP
+
+#include "utils/no_copy.hpp"
+#include "utils/types.hpp"
+
+#include <map>
+#include <string>
+#include <vector>
+
+class XMLNode;
+
+/** Finds all assets (tracks or karts) in a list of search directories and
+ *  reads their config files. An asset is either a search directory itself
+ *  (if it contains the config file), or else each of its subdirectories
+ *  containing the config file. Checking the subdirectories and parsing the
+ *  config files is done in parallel on the \ref ThreadPool, but the assets
+ *  are always returned in the order of a serial scan (search directories
+ *  in order, subdirectories sorted by name), so that the indices assigned
+ *  to tracks and karts do not depend on timing.
+ *  Creating the actual Track and KartProperties objects is left to the
+ *  caller on the main thread, since that also loads textures and models.
+ *  The parsed config files are kept in an index file in the cached data
+ *  directory, together with the modification time, size and checksum of
+ *  each file. Unchanged config files are then read from the index instead
+ *  of being parsed again, which saves most of the time for frequently
+ *  restarted servers. The checksum catches changes which keep the size
+ *  and happen within the (one second) resolution of the modification time.
+ * \ingroup io
+ */
+class AssetScanner : public NoCopy
+{
+private:
+    /** A possible asset directory. */
+    struct Asset
+    {
+        /** Directory of the asset. */
+        std::string m_dir;
+        /** The parsed config file, NULL if it could not be read. */
+        XMLNode    *m_xml;
+        /** If the config file exists. */
+        bool        m_exists;
+        /** Modification time and size of the config file, 0 if unknown. */
+        uint64_t    m_mtime;
+        uint64_t    m_size;
+        /** CRC32 of the config file, only valid if m_size is not 0. */
+        uint32_t    m_crc;
+        /** If the config file was read from the index. */
+        bool        m_indexed;
+    };
+
+    /** A config file in the index. */
+    struct IndexEntry
+    {
+        uint64_t    m_mtime;
+        uint64_t    m_size;
+        uint32_t    m_crc;
+        /** The config file, see XMLNode::saveBinary. */
+        std::string m_data;
+    };
+
+    /** All assets found, in the order of a serial scan. */
+    std::vector<Asset> m_assets;
+
+    /** The index, by name of the config file. */
+    std::map<std::string, IndexEntry> m_index;
+
+    /** Name of the index file, empty if no index is used. */
+    std::string m_index_file;
+
+    /** Number of config files read from the index. */
+    unsigned m_num_indexed;
+
+    /** Time in ms needed to list the directories. */
+    float m_discovery_time;
+
+    /** Time in ms needed to check and parse all config files. */
+    float m_parse_time;
+
+    void loadIndex();
+    void saveIndex();
+
+public:
+    AssetScanner(const std::vector<std::string>& search_path,
+                 const std::string& config_name,
+                 const std::string& subdir_suffix,
+                 const std::string& index_name = "");
+    ~AssetScanner();
+    // ------------------------------------------------------------------------
+    /** Returns the number of assets found. */
+    unsigned getNumAssets() const          { return (unsigned)m_assets.size(); }
+    // ------------------------------------------------------------------------
+    /** Returns the directory of an asset, in the same format as the track
+     *  and kart managers use it (i.e. with or without trailing '/'). */
+    const std::string& getDir(unsigned i) const    { return m_assets[i].m_dir; }
+    // ------------------------------------------------------------------------
+    /** Returns the parsed config file of an asset (or NULL if parsing
+     *  failed), and passes the ownership to the caller. */
+    XMLNode* takeXML(unsigned i)
+    {
+        XMLNode* xml = m_assets[i].m_xml;
+        m_assets[i].m_xml = NULL;
+        return xml;
+    }   // takeXML
+    // ------------------------------------------------------------------------
+    /** Returns the time in ms needed to list the search directories. */
+    float getDiscoveryTime() const               { return m_discovery_time; }
+    // ------------------------------------------------------------------------
+    /** Returns the time in ms needed to parse the config files. */
+    float getParseTime() const                       { return m_parse_time; }
+    // ------------------------------------------------------------------------
+    /** Returns how many config files were read from the index. */
+    unsigned getNumIndexed() const                  { return m_num_indexed; }
+};   // AssetScanner
+
+#endif
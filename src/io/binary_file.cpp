@@ -0,0 +1,318 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2024 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+
+#include "io/binary_file.hpp"
+
+#include "io/file_manager.hpp"
+#include "utils/log.hpp"
+#include "utils/string_utils.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace
+{
+    /** Longer strings are treated as a corrupted file. */
+    const uint64_t MAX_STRING_SIZE = 1024 * 1024;
+
+    // ------------------------------------------------------------------------
+    gzFile openFile(const std::string &filename, const char *mode)
+    {
+#ifdef WIN32
+        return gzopen_w(StringUtils::utf8ToWide(filename).c_str(), mode);
+#else
+        return gzopen(filename.c_str(), mode);
+#endif
+    }   // openFile
+}   // anonymous namespace
+
+// ----------------------------------------------------------------------------
+/** Creates a new binary file and writes the magic number and version.
+ *  \param filename Name of the file.
+ *  \param magic The 4 byte magic number identifying the type of file.
+ *  \param version Version of the file format.
+ *  \param compression zlib compression level (1 to 9), or 0 to store the
+ *         data uncompressed.
+ *  \return The file, or NULL if it can not be created.
+ */
+BinaryFile *BinaryFile::create(const std::string &filename, const char *magic,
+                               uint8_t version, int compression)
+{
+    std::string mode = compression > 0
+                     ? "wb" + StringUtils::toString(std::min(compression, 9))
+                     : "wbT";
+    gzFile file = openFile(filename, mode.c_str());
+    if (!file)
+    {
+        Log::error("BinaryFile", "Cannot create '%s'.", filename.c_str());
+        return NULL;
+    }
+    // Records are small, so buffer them for fewer system calls
+    gzbuffer(file, 64 * 1024);
+    BinaryFile *binary_file = new BinaryFile(file);
+    binary_file->write(magic, 4);
+    binary_file->writeUInt8(version);
+    return binary_file;
+}   // create
+
+// ----------------------------------------------------------------------------
+/** Opens a binary file for reading. It is not an error if the file exists
+ *  but has a different magic number, so that callers can try to read it as
+ *  a text file instead.
+ *  \param filename Name of the file.
+ *  \param magic The 4 byte magic number the file must start with.
+ *  \param version On return the version of the file format.
+ *  \return The file, or NULL if the file can not be opened or is a
+ *          different type of file.
+ */
+BinaryFile *BinaryFile::open(const std::string &filename, const char *magic,
+                             uint8_t *version)
+{
+    gzFile file = openFile(filename, "rb");
+    if (!file)
+        return NULL;
+    gzbuffer(file, 64 * 1024);
+    BinaryFile *binary_file = new BinaryFile(file);
+    char file_magic[4];
+    if (!binary_file->read(file_magic, 4) || memcmp(file_magic, magic, 4) != 0)
+    {
+        delete binary_file;
+        return NULL;
+    }
+    *version = binary_file->readUInt8();
+    if (binary_file->hasFailed())
+    {
+        delete binary_file;
+        return NULL;
+    }
+    return binary_file;
+}   // open
+
+// ----------------------------------------------------------------------------
+BinaryFile::~BinaryFile()
+{
+    gzclose(m_file);
+}   // ~BinaryFile
+
+// ----------------------------------------------------------------------------
+void BinaryFile::write(const void *data, unsigned int size)
+{
+    if (size > 0)
+        gzwrite(m_file, data, size);
+}   // write
+
+// ----------------------------------------------------------------------------
+void BinaryFile::writeUInt8(uint8_t value)
+{
+    gzputc(m_file, value);
+}   // writeUInt8
+
+// ----------------------------------------------------------------------------
+void BinaryFile::writeUInt32(uint32_t value)
+{
+    uint8_t buffer[4] = { (uint8_t)value,         (uint8_t)(value >> 8),
+                          (uint8_t)(value >> 16), (uint8_t)(value >> 24) };
+    gzwrite(m_file, buffer, 4);
+}   // writeUInt32
+
+// ----------------------------------------------------------------------------
+void BinaryFile::writeVarUInt(uint64_t value)
+{
+    uint8_t buffer[10];
+    unsigned int n = 0;
+    while (value >= 0x80)
+    {
+        buffer[n++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    buffer[n++] = (uint8_t)value;
+    gzwrite(m_file, buffer, n);
+}   // writeVarUInt
+
+// ----------------------------------------------------------------------------
+void BinaryFile::writeFloat(float value)
+{
+    uint32_t u;
+    memcpy(&u, &value, sizeof(float));
+    writeUInt32(u);
+}   // writeFloat
+
+// ----------------------------------------------------------------------------
+void BinaryFile::writeString(const std::string &value)
+{
+    writeVarUInt(value.size());
+    write(value.data(), (unsigned int)value.size());
+}   // writeString
+
+// ----------------------------------------------------------------------------
+/** Reads size bytes, returns false (and marks the file as failed) if not
+ *  enough data is available. */
+bool BinaryFile::read(void *data, unsigned int size)
+{
+    if (size == 0)
+        return !m_failed;
+    if (gzread(m_file, data, size) != (int)size)
+        m_failed = true;
+    return !m_failed;
+}   // read
+
+// ----------------------------------------------------------------------------
+uint8_t BinaryFile::readUInt8()
+{
+    int c = gzgetc(m_file);
+    if (c < 0)
+    {
+        m_failed = true;
+        return 0;
+    }
+    return (uint8_t)c;
+}   // readUInt8
+
+// ----------------------------------------------------------------------------
+uint32_t BinaryFile::readUInt32()
+{
+    uint8_t buffer[4];
+    if (!read(buffer, 4))
+        return 0;
+    return  (uint32_t)buffer[0]        | ((uint32_t)buffer[1] << 8) |
+           ((uint32_t)buffer[2] << 16) | ((uint32_t)buffer[3] << 24);
+}   // readUInt32
+
+// ----------------------------------------------------------------------------
+uint64_t BinaryFile::readVarUInt()
+{
+    uint64_t value = 0;
+    for (unsigned int shift = 0; shift < 64; shift += 7)
+    {
+        int c = gzgetc(m_file);
+        if (c < 0)
+            break;
+        value |= (uint64_t)(c & 0x7f) << shift;
+        if ((c & 0x80) == 0)
+            return value;
+    }
+    m_failed = true;
+    return 0;
+}   // readVarUInt
+
+// ----------------------------------------------------------------------------
+float BinaryFile::readFloat()
+{
+    uint32_t u = readUInt32();
+    float f;
+    memcpy(&f, &u, sizeof(float));
+    return f;
+}   // readFloat
+
+// ----------------------------------------------------------------------------
+std::string BinaryFile::readString()
+{
+    uint64_t size = readVarUInt();
+    if (size > MAX_STRING_SIZE)
+        m_failed = true;
+    if (m_failed)
+        return "";
+    std::string value((size_t)size, '\0');
+    if (!read(&value[0], (unsigned int)size))
+        return "";
+    return value;
+}   // readString
+
+// ----------------------------------------------------------------------------
+/** Returns true if all data of the file was read. */
+bool BinaryFile::isEnd()
+{
+    int c = gzgetc(m_file);
+    if (c < 0)
+        return true;
+    gzungetc(c, m_file);
+    return false;
+}   // isEnd
+
+// ----------------------------------------------------------------------------
+/** Writes all buffered data to the file, so that it can be read even if the
+ *  file is not closed properly. */
+void BinaryFile::flush()
+{
+    gzflush(m_file, Z_SYNC_FLUSH);
+}   // flush
+
+// ----------------------------------------------------------------------------
+void BinaryFile::unitTesting()
+{
+    const char magic[4] = { 'T', 'E', 'S', 'T' };
+    const std::string filename =
+        file_manager->getCachedDataDir() + "binary_file_test.dat";
+    const uint64_t var_uints[4] = { 0, 127, 128, UINT64_MAX };
+    const int64_t  var_ints[3]  = { -1, -1000000, INT64_MIN };
+    for (int compression = 0; compression <= 1; compression++)
+    {
+        // Each value is written and then read back into the same variable
+        uint8_t     u8  = 200;
+        uint32_t    u32 = 0x12345678;
+        float       f   = -1.5f;
+        std::string str = "abc";
+        BinaryFile *file = create(filename, magic, 3, compression);
+        assert(file);
+        file->writeUInt8(u8);
+        for (uint64_t value : var_uints)
+            file->writeVarUInt(value);
+        for (int64_t value : var_ints)
+            file->writeVarInt(value);
+        file->writeUInt32(u32);
+        file->writeFloat(f);
+        file->writeString("");
+        file->writeString(str);
+        delete file;
+
+        const char other_magic[4] = { 'T', 'E', 'S', 'X' };
+        uint8_t version = 0;
+        BinaryFile *other = open(filename, other_magic, &version);
+        assert(!other);
+        delete other;
+        file = open(filename, magic, &version);
+        assert(file && version == 3);
+        u8 = file->readUInt8();
+        assert(u8 == 200);
+        bool same = true;
+        for (uint64_t value : var_uints)
+            same &= file->readVarUInt() == value;
+        assert(same);
+        for (int64_t value : var_ints)
+            same &= file->readVarInt() == value;
+        assert(same);
+        u32 = file->readUInt32();
+        assert(u32 == 0x12345678);
+        f = file->readFloat();
+        assert(f == -1.5f);
+        str = file->readString();
+        assert(str == "");
+        str = file->readString();
+        assert(str == "abc");
+        same &= !file->hasFailed() && file->isEnd();
+        assert(same);
+        // Reading beyond the end fails
+        file->readVarUInt();
+        same &= file->hasFailed();
+        assert(same);
+        delete file;
+    }
+    file_manager->removeFile(filename);
+}   // unitTesting
@@ -0,0 +1,113 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2024 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+
+#ifndef HEADER_BINARY_FILE_HPP
+#define HEADER_BINARY_FILE_HPP
+
+#include "utils/no_copy.hpp"
+
+#include <stdint.h>
+#include <string>
+#include <zlib.h>
+
+/** A binary file used for histories and replays, optionally compressed with
+ *  zlib. Uncompressed files are detected when reading, so the same code
+ *  reads both. The file starts with a 4 byte magic number and a version
+ *  byte. Integers are stored with 7 bits per byte (the highest bit is set if
+ *  more bytes follow), so small values only need one byte, signed integers
+ *  are zig-zag encoded first. Floats are stored as 4 bytes in little endian
+ *  byte order.
+ *  Reading functions return 0 and mark the file as failed if the end of the
+ *  file is reached, so a caller only needs to check hasFailed() after
+ *  reading a record.
+ * \ingroup io
+ */
+class BinaryFile : public NoCopy
+{
+private:
+    gzFile m_file;
+
+    /** True if reading failed, e.g. because the end of the file was
+     *  reached. */
+    bool   m_failed;
+
+    BinaryFile(gzFile file) : m_file(file), m_failed(false) {}
+
+public:
+    // ------------------------------------------------------------------------
+    static BinaryFile *create(const std::string &filename, const char *magic,
+                              uint8_t version, int compression);
+    // ------------------------------------------------------------------------
+    static BinaryFile *open(const std::string &filename, const char *magic,
+                            uint8_t *version);
+    // ------------------------------------------------------------------------
+    static void unitTesting();
+    // ------------------------------------------------------------------------
+    ~BinaryFile();
+    // ------------------------------------------------------------------------
+    void        write(const void *data, unsigned int size);
+    // ------------------------------------------------------------------------
+    void        writeUInt8(uint8_t value);
+    // ------------------------------------------------------------------------
+    void        writeUInt32(uint32_t value);
+    // ------------------------------------------------------------------------
+    void        writeVarUInt(uint64_t value);
+    // ------------------------------------------------------------------------
+    /** Writes a signed integer, zig-zag encoded so that small negative
+     *  values only need one byte, too. */
+    void        writeVarInt(int64_t value)
+    {
+        writeVarUInt(((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+    }   // writeVarInt
+    // ------------------------------------------------------------------------
+    void        writeFloat(float value);
+    // ------------------------------------------------------------------------
+    void        writeString(const std::string &value);
+    // ------------------------------------------------------------------------
+    bool        read(void *data, unsigned int size);
+    // ------------------------------------------------------------------------
+    uint8_t     readUInt8();
+    // ------------------------------------------------------------------------
+    uint32_t    readUInt32();
+    // ------------------------------------------------------------------------
+    uint64_t    readVarUInt();
+    // ------------------------------------------------------------------------
+    /** Reads a signed integer written by writeVarInt(). */
+    int64_t     readVarInt()
+    {
+        uint64_t value = readVarUInt();
+        return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+    }   // readVarInt
+    // ------------------------------------------------------------------------
+    float       readFloat();
+    // ------------------------------------------------------------------------
+    std::string readString();
+    // ------------------------------------------------------------------------
+    bool        isEnd();
+    // ------------------------------------------------------------------------
+    /** Returns the (uncompressed) position in the file. */
+    uint64_t    tell() { return (uint64_t)gztell(m_file); }
+    // ------------------------------------------------------------------------
+    void        flush();
+    // ------------------------------------------------------------------------
+    /** Returns true if reading failed, e.g. at the end of the file. */
+    bool        hasFailed() const { return m_failed; }
+};   // BinaryFile
+
+#endif
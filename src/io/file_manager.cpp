@@ -259,6 +259,7 @@ FileManager::FileManager()
     checkAndCreateScreenshotDir();
     checkAndCreateReplayDir();
     checkAndCreateCachedTexturesDir();
+    checkAndCreateCachedDataDir();
     checkAndCreateGPDir();
 
     redirectOutput();
@@ -565,8 +566,13 @@ void FileManager::addRootDirs(const std::string &roots)
 }   // addRootDirs
 
 //-----------------------------------------------------------------------------
+/** Opens a XML file. This can be called from worker threads (see
+ *  AssetScanner), so the file system is locked while the file is found and
+ *  read, the actual parsing is done without lock.
+ */
 io::IXMLReader *FileManager::createXMLReader(const std::string &filename)
 {
+    std::lock_guard<std::mutex> lock(m_file_system_lock);
     return m_file_system->createXMLReader(filename.c_str());
 }   // getXMLReader
 //-----------------------------------------------------------------------------
@@ -637,6 +643,8 @@ io::path FileManager::createAbsoluteFilename(const std::string &f)
  */
 void FileManager::pushModelSearchPath(const std::string& path)
 {
+    // The directory might have changed since it was searched last time
+    removeFromDirectoryCache(path);
     std::lock_guard<std::mutex> lock(m_file_system_lock);
 
     m_model_search_path.push_back(path);
@@ -666,6 +674,7 @@ void FileManager::pushModelSearchPath(const std::string& path)
  */
 void FileManager::pushTextureSearchPath(const std::string& path, const std::string& container_id)
 {
+    removeFromDirectoryCache(path);
     std::lock_guard<std::mutex> lock(m_file_system_lock);
 
     m_texture_search_path.push_back(TextureSearchPath(path, container_id));
@@ -734,8 +743,11 @@ bool FileManager::findFile(std::string& full_path,
         i = search_path.rbegin();
         i != search_path.rend(); ++i)
     {
-        full_path = *i + file_name;
-        if(m_file_system->existFile(full_path.c_str())) return true;
+        if (isInSearchPath(*i, file_name))
+        {
+            full_path = *i + file_name;
+            return true;
+        }
     }
     full_path="";
     return false;
@@ -757,13 +769,107 @@ bool FileManager::findFile(std::string& full_path,
         i = search_path.rbegin();
         i != search_path.rend(); ++i)
     {
-        full_path = i->m_texture_search_path + file_name;
-        if (m_file_system->existFile(full_path.c_str())) return true;
+        if (isInSearchPath(i->m_texture_search_path, file_name))
+        {
+            full_path = i->m_texture_search_path + file_name;
+            return true;
+        }
     }
     full_path = "";
     return false;
 }   // findFile
 
+//-----------------------------------------------------------------------------
+/** Checks if a file is in a directory using the cached listing of the
+ *  directory, which is read the first time a directory is checked.
+ *  \param dir The directory, ending with '/'.
+ *  \param file_name Name of the file.
+ *  \return DL_UNKNOWN if the name contains a path or the directory could
+ *          not be listed, in which case the caller must check the file
+ *          system.
+ */
+FileManager::DirectoryLookup
+    FileManager::lookupInDirectory(const std::string& dir,
+                                   const std::string& file_name) const
+{
+    if (file_name.find_first_of("/\\") != std::string::npos)
+        return DL_UNKNOWN;
+
+    std::lock_guard<std::mutex> lock(m_dir_cache_lock);
+    auto it = m_dir_cache.find(dir);
+    if (it == m_dir_cache.end())
+    {
+        DirectoryListing listing;
+        listing.m_listed = isDirectory(dir);
+        if (listing.m_listed)
+        {
+            std::set<std::string> files;
+            listFiles(files, dir);
+            for (const std::string& f : files)
+            {
+#ifdef WIN32
+                listing.m_names.insert(StringUtils::toLowerCase(f));
+#else
+                listing.m_names.insert(f);
+#endif
+            }
+        }
+        it = m_dir_cache.emplace(dir, std::move(listing)).first;
+    }
+    if (!it->second.m_listed)
+        return DL_UNKNOWN;
+#ifdef WIN32
+    // File names are not case sensitive on windows
+    const std::string name = StringUtils::toLowerCase(file_name);
+#else
+    const std::string& name = file_name;
+#endif
+    return it->second.m_names.count(name) > 0 ? DL_FOUND : DL_NOT_FOUND;
+}   // lookupInDirectory
+
+//-----------------------------------------------------------------------------
+/** Checks if a file is in a search path directory. The file system is only
+ *  accessed if the cached listing of the directory can not answer it, so
+ *  files added to a listed directory by other programs are only found after
+ *  the cache was cleared (see clearDirectoryCache).
+ *  \param dir The directory, ending with '/'.
+ *  \param file_name Name of the file.
+ */
+bool FileManager::isInSearchPath(const std::string& dir,
+                                 const std::string& file_name) const
+{
+    switch (lookupInDirectory(dir, file_name))
+    {
+    case DL_FOUND:
+        return true;
+    case DL_NOT_FOUND:
+        return false;
+    default:
+        return m_file_system->existFile((dir + file_name).c_str());
+    }
+}   // isInSearchPath
+
+//-----------------------------------------------------------------------------
+/** Removes the cached listing of a directory, which is read again the next
+ *  time it is searched.
+ *  \param dir The directory.
+ */
+void FileManager::removeFromDirectoryCache(const std::string& dir)
+{
+    std::lock_guard<std::mutex> lock(m_dir_cache_lock);
+    m_dir_cache.erase(dir);
+}   // removeFromDirectoryCache
+
+//-----------------------------------------------------------------------------
+/** Removes all cached directory listings. Called whenever files are added
+ *  or removed, e.g. when installing addons.
+ */
+void FileManager::clearDirectoryCache() const
+{
+    std::lock_guard<std::mutex> lock(m_dir_cache_lock);
+    m_dir_cache.clear();
+}   // clearDirectoryCache
+
 //-----------------------------------------------------------------------------
 std::string FileManager::getAssetChecked(FileManager::AssetType type,
                                          const std::string& name,
@@ -844,6 +950,15 @@ std::string FileManager::getCachedTexturesDir() const
     return m_cached_textures_dir;
 }   // getCachedTexturesDir
 
+//-----------------------------------------------------------------------------
+/** Returns the directory in which data computed from the assets (e.g. the
+ *  AI data of a drive graph) should be cached.
+ */
+std::string FileManager::getCachedDataDir() const
+{
+    return m_cached_data_dir;
+}   // getCachedDataDir
+
 //-----------------------------------------------------------------------------
 /** Returns the directory in which user-defined grand prix should be stored.
  */
@@ -874,19 +989,16 @@ std::string FileManager::searchTexture(const std::string& file_name) const
 bool FileManager::searchTextureContainerId(std::string& container_id,
     const std::string& file_name) const
 {
-    std::string full_path;
     for (std::vector<TextureSearchPath>::const_reverse_iterator
         i = m_texture_search_path.rbegin();
         i != m_texture_search_path.rend(); ++i)
     {
-        full_path = i->m_texture_search_path + file_name;
-        if (m_file_system->existFile(full_path.c_str()))
+        if (isInSearchPath(i->m_texture_search_path, file_name))
         {
             container_id = i->m_container_id;
             return true;
         }
     }
-    full_path = "";
     return false;
 }   // findFile
 
@@ -913,6 +1025,7 @@ bool FileManager::checkAndCreateDirectory(const std::string &path)
     if(m_file_system->existFile(io::path(path.c_str())))
         return true;
 
+    clearDirectoryCache();
     Log::info("FileManager", "Creating directory '%s'.", path.c_str());
 
     // Otherwise try to create the directory:
@@ -937,6 +1050,7 @@ bool FileManager::checkAndCreateDirectoryP(const std::string &path)
     if(m_file_system->existFile(io::path(path.c_str())))
         return true;
 
+    clearDirectoryCache();
     Log::info("[FileManager]", "Creating directory(ies) '%s'", path.c_str());
 
     std::vector<std::string> split = StringUtils::split(path,'/');
@@ -1184,6 +1298,31 @@ void FileManager::checkAndCreateCachedTexturesDir()
 
 }   // checkAndCreateCachedTexturesDir
 
+// ----------------------------------------------------------------------------
+/** Creates the directory for other cached data. This will set
+ *  m_cached_data_dir with the appropriate path.
+ */
+void FileManager::checkAndCreateCachedDataDir()
+{
+#if defined(WIN32)
+    m_cached_data_dir = m_user_config_dir + "cached-data/";
+#elif defined(__APPLE__)
+    m_cached_data_dir = getenv("HOME");
+    m_cached_data_dir += "/Library/Application Support/SuperTuxKart/CachedData/";
+#else
+    m_cached_data_dir = checkAndCreateLinuxDir("XDG_CACHE_HOME", "supertuxkart", ".cache/", ".");
+    m_cached_data_dir += "cached-data/";
+#endif
+
+    if (!checkAndCreateDirectory(m_cached_data_dir))
+    {
+        Log::error("FileManager", "Can not create cached data directory '%s', "
+            "falling back to '.'.", m_cached_data_dir.c_str());
+        m_cached_data_dir = "./";
+    }
+
+}   // checkAndCreateCachedDataDir
+
 // ----------------------------------------------------------------------------
 /** Creates the directories for user-defined grand prix. This will set m_gp_dir
  *  with the appropriate path.
@@ -1499,6 +1638,7 @@ void FileManager::checkAndCreateDirForAddons(const std::string &dir)
  */
 bool FileManager::removeFile(const std::string &name) const
 {
+    clearDirectoryCache();
     // If the file does not exists, everything is fine
     if(!fileExists(name))
        return true;
@@ -1525,6 +1665,7 @@ bool FileManager::removeFile(const std::string &name) const
  */
 bool FileManager::removeDirectory(const std::string &name) const
 {
+    clearDirectoryCache();
     std::set<std::string> files;
     listFiles(files, name, /*is full path*/ true);
 
@@ -1574,6 +1715,7 @@ bool FileManager::removeDirectory(const std::string &name) const
  */
 bool FileManager::copyFile(const std::string &source, const std::string &dest)
 {
+    clearDirectoryCache();
     FILE *f_source = FileUtils::fopenU8Path(source, "rb");
     if(!f_source) return false;
 
@@ -1632,6 +1774,7 @@ bool FileManager::fileIsNewer(const std::string& f1, const std::string& f2) cons
 */
 bool FileManager::moveDirectoryInto(std::string source, std::string target)
 {
+    clearDirectoryCache();
     if (!isDirectory(source) || !isDirectory(target))
         return false;
 
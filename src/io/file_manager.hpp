@@ -29,6 +29,8 @@
 #include <string>
 #include <vector>
 #include <set>
+#include <unordered_map>
+#include <unordered_set>
 
 #include <irrString.h>
 #include <IFileSystem.h>
@@ -98,6 +100,9 @@ private:
     /** Directory where resized textures are cached. */
     std::string       m_cached_textures_dir;
 
+    /** Directory where other data computed from the assets is cached. */
+    std::string       m_cached_data_dir;
+
     /** Directory where user-defined grand prix are stored. */
     std::string       m_gp_dir;
 
@@ -112,6 +117,31 @@ private:
     std::vector<std::string> m_model_search_path;
     std::vector<std::string> m_music_search_path;
 
+    /** The cached listing of a search path directory. */
+    struct DirectoryListing
+    {
+        /** False if the directory could not be listed, e.g. because it is
+         *  inside an archive, then the file system must be checked. */
+        bool m_listed;
+        std::unordered_set<std::string> m_names;
+    };
+
+    /** Names of all files in the directories of the search paths, so that a
+     *  file can be found without accessing the file system for each
+     *  directory. A directory is listed the first time it is searched. */
+    mutable std::unordered_map<std::string, DirectoryListing> m_dir_cache;
+
+    /** Protects m_dir_cache. */
+    mutable std::mutex m_dir_cache_lock;
+
+    /** Result of looking up a file in a cached directory listing. */
+    enum DirectoryLookup { DL_FOUND, DL_NOT_FOUND, DL_UNKNOWN };
+
+    DirectoryLookup   lookupInDirectory(const std::string& dir,
+                                        const std::string& file_name) const;
+    bool              isInSearchPath(const std::string& dir,
+                                     const std::string& file_name) const;
+    void              removeFromDirectoryCache(const std::string& dir);
     bool              findFile(std::string& full_path,
                                const std::string& fname,
                                const std::vector<std::string>& search_path)
@@ -126,6 +156,7 @@ private:
     void              checkAndCreateScreenshotDir();
     void              checkAndCreateReplayDir();
     void              checkAndCreateCachedTexturesDir();
+    void              checkAndCreateCachedDataDir();
     void              checkAndCreateGPDir();
     void              discoverPaths();
     void              addAssetsSearchPath();
@@ -159,6 +190,7 @@ public:
     std::string       getScreenshotDir() const;
     std::string       getReplayDir() const;
     std::string       getCachedTexturesDir() const;
+    std::string       getCachedDataDir() const;
     std::string       getGPDir() const;
     bool              checkAndCreateDirectory(const std::string &path);
     bool              checkAndCreateDirectoryP(const std::string &path);
@@ -168,6 +200,7 @@ public:
     std::string        getAddonSfxDirectory() const;
     void checkAndCreateDirForAddons(const std::string &dir);
     bool isDirectory(const std::string &path) const;
+    void clearDirectoryCache() const;
     bool removeFile(const std::string &name) const;
     bool removeDirectory(const std::string &name) const;
     // ------------------------------------------------------------------------
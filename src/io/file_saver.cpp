@@ -0,0 +1,197 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2024 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#include "io/file_saver.hpp"
+
+#include "utils/file_utils.hpp"
+#include "utils/log.hpp"
+#include "utils/string_utils.hpp"
+#include "utils/vs.hpp"
+
+#include <cassert>
+#include <cstdio>
+#include <functional>
+
+#ifdef WIN32
+#  include <io.h>
+#  include <process.h>
+#  include <windows.h>
+#else
+#  include <unistd.h>
+#endif
+
+FileSaver *FileSaver::m_file_saver = NULL;
+
+// ----------------------------------------------------------------------------
+/** Creates the file saver and starts its thread. */
+void FileSaver::create()
+{
+    assert(!m_file_saver);
+    m_file_saver = new FileSaver();
+}   // create
+
+// ----------------------------------------------------------------------------
+/** Writes all files still queued and destroys the file saver. Files saved
+ *  afterwards are written immediately. */
+void FileSaver::destroy()
+{
+    delete m_file_saver;
+    m_file_saver = NULL;
+}   // destroy
+
+// ----------------------------------------------------------------------------
+FileSaver::FileSaver() : m_writing(false), m_exit(false)
+{
+    m_thread = std::thread(&FileSaver::mainLoop, this);
+}   // FileSaver
+
+// ----------------------------------------------------------------------------
+/** Writes all queued files before returning. */
+FileSaver::~FileSaver()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_exit = true;
+    }
+    m_pending_cv.notify_one();
+    m_thread.join();
+}   // ~FileSaver
+
+// ----------------------------------------------------------------------------
+/** Saves a file in the thread of the file saver, or immediately if there is
+ *  no file saver. Content queued earlier for the same file which was not
+ *  written yet is replaced.
+ *  \param filename Full path of the file.
+ *  \param content The new content of the file.
+ */
+void FileSaver::save(const std::string &filename, const std::string &content)
+{
+    FileSaver *saver = m_file_saver;
+    if (!saver)
+    {
+        if (!writeFile(filename, content))
+            Log::error("FileSaver", "Can't write '%s'.", filename.c_str());
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(saver->m_mutex);
+        saver->m_pending[filename] = content;
+    }
+    saver->m_pending_cv.notify_one();
+}   // save
+
+// ----------------------------------------------------------------------------
+/** Waits until all queued files are written, e.g. before the app can be
+ *  killed by the operating system. */
+void FileSaver::flush()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done_cv.wait(lock, [this]()
+        {
+            return m_pending.empty() && !m_writing;
+        });
+}   // flush
+
+// ----------------------------------------------------------------------------
+/** Writes a file by writing a temporary file, syncing it to disk, and
+ *  renaming it to the actual filename, which replaces the old file in one
+ *  step. The name of the temporary file contains the process and thread
+ *  id, since the same file can be written by several threads (e.g. cached
+ *  sound effects) or processes (e.g. server instances) at the same time.
+ *  \param filename Full path of the file.
+ *  \param content The content of the file.
+ *  \return True if the file was written.
+ */
+bool FileSaver::writeFile(const std::string &filename,
+                          const std::string &content)
+{
+#ifdef WIN32
+    const int pid = _getpid();
+#else
+    const int pid = (int)getpid();
+#endif
+    const size_t tid = std::hash<std::thread::id>()(std::this_thread::get_id());
+    const std::string temp = filename + "." + StringUtils::toString(pid) +
+                             "-" + StringUtils::toString(tid) + ".tmp";
+    FILE *fd = FileUtils::fopenU8Path(temp, "wb");
+    if (!fd)
+        return false;
+    bool ok = fwrite(content.data(), 1, content.size(), fd) == content.size();
+    ok = fflush(fd) == 0 && ok;
+#ifdef WIN32
+    ok = _commit(_fileno(fd)) == 0 && ok;
+#else
+    ok = fsync(fileno(fd)) == 0 && ok;
+#endif
+    ok = fclose(fd) == 0 && ok;
+    if (ok)
+    {
+#ifdef WIN32
+        // _wrename does not replace an existing file
+        ok = MoveFileExW(StringUtils::utf8ToWide(temp).c_str(),
+                         StringUtils::utf8ToWide(filename).c_str(),
+                         MOVEFILE_REPLACE_EXISTING |
+                         MOVEFILE_WRITE_THROUGH) != 0;
+#else
+        ok = FileUtils::renameU8Path(temp, filename) == 0;
+#endif
+    }
+    if (!ok)
+        remove(FileUtils::getPortableWritingPath(temp).c_str());
+    return ok;
+}   // writeFile
+
+// ----------------------------------------------------------------------------
+/** Writes queued files until the file saver is destroyed. All files queued
+ *  while writing are taken together in the next round. */
+void FileSaver::mainLoop()
+{
+    VS::setThreadName("FileSaver");
+    std::map<std::string, std::string> files;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_writing = false;
+            if (m_pending.empty())
+                m_done_cv.notify_all();
+            m_pending_cv.wait(lock, [this]()
+                {
+                    return m_exit || !m_pending.empty();
+                });
+            if (m_pending.empty())
+                return;
+            files.swap(m_pending);
+            m_writing = true;
+        }
+
+        for (auto &file : files)
+        {
+            if (writeFile(file.first, file.second))
+            {
+                m_failed.erase(file.first);
+            }
+            else if (m_failed.insert(file.first).second)
+            {
+                Log::error("FileSaver", "Can't write '%s'.",
+                           file.first.c_str());
+            }
+        }
+        files.clear();
+    }
+}   // mainLoop
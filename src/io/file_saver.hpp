@@ -0,0 +1,92 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2024 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#ifndef HEADER_FILE_SAVER_HPP
+#define HEADER_FILE_SAVER_HPP
+
+#include "utils/no_copy.hpp"
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
+/** Writes files like the user config, the highscores and the player
+ *  profiles (including achievements) in a separate thread, so that saving
+ *  them (e.g. at the end of a race) does not stall the game loop. The
+ *  content is created in the main thread and queued; if a file is saved
+ *  again before the previous content was written, only the newest content
+ *  is written. Each file is first written to a temporary file, which is
+ *  synced to disk and then renamed over the old file, so a crash while
+ *  saving leaves either the old or the new file, never a broken one.
+ *  If no FileSaver was created, files are written immediately.
+ * \ingroup io
+ */
+class FileSaver : public NoCopy
+{
+private:
+    static FileSaver *m_file_saver;
+
+    std::thread m_thread;
+
+    /** Protects m_pending, m_writing and m_exit. */
+    std::mutex m_mutex;
+
+    /** Signalled when a file is queued or the saver should exit. */
+    std::condition_variable m_pending_cv;
+
+    /** Signalled when the thread has written all queued files. */
+    std::condition_variable m_done_cv;
+
+    /** Content of the files waiting to be written, by filename. */
+    std::map<std::string, std::string> m_pending;
+
+    /** True while the thread writes files taken from m_pending. */
+    bool m_writing;
+
+    bool m_exit;
+
+    /** Files which could not be written, so the error is only printed
+     *  once. Only used by the thread. */
+    std::set<std::string> m_failed;
+
+    // ------------------------------------------------------------------------
+         FileSaver();
+        ~FileSaver();
+    void mainLoop();
+
+public:
+    // ------------------------------------------------------------------------
+    static void create();
+    // ------------------------------------------------------------------------
+    static void destroy();
+    // ------------------------------------------------------------------------
+    /** Returns the file saver, or NULL if it was not created. */
+    static FileSaver *get() { return m_file_saver; }
+    // ------------------------------------------------------------------------
+    static void save(const std::string &filename, const std::string &content);
+    // ------------------------------------------------------------------------
+    static bool writeFile(const std::string &filename,
+                          const std::string &content);
+    // ------------------------------------------------------------------------
+    void flush();
+};   // FileSaver
+
+#endif
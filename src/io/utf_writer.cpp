@@ -17,7 +17,7 @@
 //  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "io/utf_writer.hpp"
-#include "utils/file_utils.hpp"
+#include "io/file_saver.hpp"
 
 #include <wchar.h>
 #include <string>
@@ -26,17 +26,17 @@ using namespace irr;
 
 // ----------------------------------------------------------------------------
 
-UTFWriter::UTFWriter(const char* dest, bool wide)
-         : m_base(FileUtils::getPortableWritingPath(dest),
-                  std::ios::out | std::ios::binary)
+/** \param dest Full path of the file.
+ *  \param wide If true, use utf-16/32 (obsolete).
+ *  \param background If true, the file is written in the thread of the
+ *         FileSaver, so errors are only logged.
+ */
+UTFWriter::UTFWriter(const char* dest, bool wide, bool background)
+         : m_base(std::ios::out | std::ios::binary), m_filename(dest)
 {
-    m_wide = wide;
-
-    if (!m_base.is_open())
-    {
-        throw std::runtime_error("Failed to open file for writing : " +
-                                  std::string(dest));
-    }
+    m_wide       = wide;
+    m_background = background;
+    m_open       = true;
 
     if (wide)
     {
@@ -81,9 +81,23 @@ UTFWriter& UTFWriter::operator<< (const wchar_t*txt)
 }   // operator<< (wchar_t)
 
 // ----------------------------------------------------------------------------
+/** Writes the file. Unless it is written in the background, an exception
+ *  is thrown if the file can't be written, in which case the old file is
+ *  kept unchanged.
+ */
 void UTFWriter::close()
 {
-    m_base.close();
+    if (!m_open)
+        return;
+    m_open = false;
+    if (m_background)
+    {
+        FileSaver::save(m_filename, m_base.str());
+    }
+    else if (!FileSaver::writeFile(m_filename, m_base.str()))
+    {
+        throw std::runtime_error("Failed to write file : " + m_filename);
+    }
 }   // close
 
 // ----------------------------------------------------------------------------
@@ -23,23 +23,33 @@
 
 #include <irrString.h>
 
-#include <fstream>
+#include <sstream>
 
 /**
  * \brief utility class used to write wide (UTF-16 or UTF-32, depending of size of wchar_t) XML files
  * \note the inner base class (ofstream) is not public because it will take in any kind of data, and
  *       we only want to accept arrays of wchar_t to make sure we get reasonable files out
+ * \note the content is collected in memory and only written by close(), using
+ *       FileSaver, so that an error while writing never leaves a broken file
  * \ingroup io
  */
 class UTFWriter
 {
-    std::ofstream m_base;
+    std::ostringstream m_base;
+
+    std::string m_filename;
 
     /** If true, use utf-16/32 (obsolete) */
     bool m_wide;
+
+    /** If true, the file is written in the thread of the FileSaver. */
+    bool m_background;
+
+    /** False once close() was called. */
+    bool m_open;
 public:
 
-    UTFWriter(const char* dest, bool wide);
+    UTFWriter(const char* dest, bool wide, bool background = false);
     void close();
 
     UTFWriter& operator<< (const irr::core::stringw& txt);
@@ -78,7 +88,7 @@ public:
         return operator<<(StringUtils::toString<T>(t));
     }   // operator<< (template)
     // ------------------------------------------------------------------------
-    bool is_open() { return m_base.is_open(); }
+    bool is_open() { return m_open; }
 };
 
 #endif
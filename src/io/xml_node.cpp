@@ -23,14 +23,167 @@
 #include "utils/string_utils.hpp"
 #include "utils/vec3.hpp"
 
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <new>
 #include <stdexcept>
+#include <unordered_set>
 
+/** Memory of a XML tree. All nodes, attribute and child arrays and strings
+ *  of a tree are allocated in a few big blocks, which are freed together
+ *  when the root node is deleted. Names of elements and attributes are
+ *  interned, since the same few names are used again and again in a file.
+ */
+class XMLNode::Arena : public NoCopy
+{
+private:
+    /** Size of the first block. Each new block is twice as big as the
+     *  previous one up to the maximum size, so that small files do not
+     *  waste memory. Bigger allocations get their own block. */
+    static const size_t FIRST_BLOCK_SIZE = 1024;
+    static const size_t MAX_BLOCK_SIZE   = 65536;
+
+    std::vector<char*> m_blocks;
+
+    /** Bytes used and available in the last block. */
+    size_t m_used, m_size;
+
+    /** Size of the next block. */
+    size_t m_next_block_size;
+
+    std::unordered_set<std::string> m_names;
+
+    const std::string *m_empty_name;
+
+public:
+    // ------------------------------------------------------------------------
+    Arena() : m_used(0), m_size(0), m_next_block_size(FIRST_BLOCK_SIZE)
+    {
+        m_empty_name = intern("");
+    }   // Arena
+    // ------------------------------------------------------------------------
+    ~Arena()
+    {
+        for (char *block : m_blocks)
+            delete [] block;
+    }   // ~Arena
+    // ------------------------------------------------------------------------
+    void *allocate(size_t size, size_t align)
+    {
+        m_used = (m_used + align - 1) & ~(align - 1);
+        if (m_blocks.empty() || m_used + size > m_size)
+        {
+            m_size = std::max(size, m_next_block_size);
+            m_next_block_size = std::min(m_next_block_size * 2,
+                                         MAX_BLOCK_SIZE);
+            m_blocks.push_back(new char[m_size]);
+            m_used = 0;
+        }
+        void *p = m_blocks.back() + m_used;
+        m_used += size;
+        return p;
+    }   // allocate
+    // ------------------------------------------------------------------------
+    template<typename T> T *allocateArray(unsigned int count)
+    {
+        if (count == 0)
+            return NULL;
+        return (T*)allocate(count * sizeof(T), alignof(T));
+    }   // allocateArray
+    // ------------------------------------------------------------------------
+    char *allocateString(size_t size)
+    {
+        return size > 0 ? (char*)allocate(size, 1) : NULL;
+    }   // allocateString
+    // ------------------------------------------------------------------------
+    const std::string *intern(const std::string &name)
+    {
+        return &*m_names.insert(name).first;
+    }   // intern
+    // ------------------------------------------------------------------------
+    const std::string *getEmptyName() const { return m_empty_name; }
+};   // XMLNode::Arena
+
+namespace
+{
+    // ------------------------------------------------------------------------
+    void writeUInt32(std::string *out, uint32_t value)
+    {
+        out->append((const char*)&value, 4);
+    }   // writeUInt32
+
+    // ------------------------------------------------------------------------
+    void writeString(std::string *out, const char *s, uint32_t size)
+    {
+        writeUInt32(out, size);
+        out->append(s, size);
+    }   // writeString
+
+    // ------------------------------------------------------------------------
+    bool readUInt32(const char **data, const char *end, uint32_t *value)
+    {
+        if (end - *data < 4)
+            return false;
+        memcpy(value, *data, 4);
+        *data += 4;
+        return true;
+    }   // readUInt32
+
+    // ------------------------------------------------------------------------
+    /** Reads a string written by writeString(), returning a pointer to it in
+     *  the data. */
+    bool readString(const char **data, const char *end, const char **s,
+                    uint32_t *size)
+    {
+        if (!readUInt32(data, end, size) || (uint32_t)(end - *data) < *size)
+            return false;
+        *s = *data;
+        *data += *size;
+        return true;
+    }   // readString
+}   // anonymous namespace
+
+// ----------------------------------------------------------------------------
+/** Creates an empty node in the arena of a tree.
+ *  \param arena The arena of the tree.
+ *  \param file_name Interned name of the file of the tree.
+ */
+XMLNode::XMLNode(Arena *arena, const std::string *file_name)
+{
+    m_arena          = NULL;
+    m_name           = arena->getEmptyName();
+    m_attributes     = NULL;
+    m_num_attributes = 0;
+    m_nodes          = NULL;
+    m_num_nodes      = 0;
+    m_file_name      = file_name;
+}   // XMLNode
+
+// ----------------------------------------------------------------------------
+/** Initialises a root node, which creates the arena for the tree.
+ *  \param file_name Name of the file of the tree.
+ */
+void XMLNode::init(const std::string &file_name)
+{
+    m_arena          = new Arena();
+    m_name           = m_arena->getEmptyName();
+    m_attributes     = NULL;
+    m_num_attributes = 0;
+    m_nodes          = NULL;
+    m_num_nodes      = 0;
+    m_file_name      = m_arena->intern(file_name);
+}   // init
+
+// ----------------------------------------------------------------------------
 XMLNode::XMLNode(io::IXMLReader *xml)
 {
-    m_file_name = "[unknown]";
+    init("[unknown]");
 
     while(xml->getNodeType()!=io::EXN_ELEMENT && xml->read());
-    readXML(xml);
+    std::vector<XMLNode*> children;
+    readXML(xml, m_arena, &children);
 }   // XMLNode
 
 // ----------------------------------------------------------------------------
@@ -39,15 +192,17 @@ XMLNode::XMLNode(io::IXMLReader *xml)
  */
 XMLNode::XMLNode(const std::string &filename)
 {
-    m_file_name = filename;
+    init(filename);
 
     io::IXMLReader *xml = file_manager->createXMLReader(filename);
     
     if (xml == NULL)
     {
+        delete m_arena;
         throw std::invalid_argument("Cannot find file "+filename);
     }
 
+    std::vector<XMLNode*> children;
     bool is_first_element = true;
     while(xml->read())
     {
@@ -61,7 +216,7 @@ XMLNode::XMLNode(const std::string &filename)
                                 "More than one root element in '%s' - ignored.",
                             filename.c_str());
                 }
-                readXML(xml);
+                readXML(xml, m_arena, &children);
                 is_first_element = false;
                 break;
             }
@@ -76,50 +231,212 @@ XMLNode::XMLNode(const std::string &filename)
 }   // XMLNode
 
 // ----------------------------------------------------------------------------
-/** Destructor. */
+/** Destructor. Only the root node frees the memory of the tree, the other
+ *  nodes are destroyed by it. */
 XMLNode::~XMLNode()
 {
-    for(unsigned int i=0; i<m_nodes.size(); i++)
+    if (m_arena)
     {
-        delete m_nodes[i];
+        destroyChildren();
+        delete m_arena;
     }
-    m_nodes.clear();
 }   // ~XMLNode
 
 // ----------------------------------------------------------------------------
-/** Stores all attributes, and reads in all children.
+/** Calls the destructor of all nodes below this node, which are allocated in
+ *  the arena of the tree. */
+void XMLNode::destroyChildren()
+{
+    for (unsigned int i = 0; i < m_num_nodes; i++)
+    {
+        m_nodes[i]->destroyChildren();
+        m_nodes[i]->~XMLNode();
+    }
+    m_num_nodes = 0;
+}   // destroyChildren
+
+// ----------------------------------------------------------------------------
+/** Appends a compact binary copy of this node and all its children, which
+ *  can be read back with loadBinary() much faster than parsing the XML file
+ *  again. It is only meant for caches on the same machine, so the byte
+ *  order is not converted.
+ *  \param out The string to append the data to.
+ */
+void XMLNode::saveBinary(std::string *out) const
+{
+    writeString(out, m_name->c_str(), (uint32_t)m_name->size());
+    writeUInt32(out, m_num_attributes);
+    for (unsigned int i = 0; i < m_num_attributes; i++)
+    {
+        const Attribute &a = m_attributes[i];
+        writeString(out, a.m_name->c_str(), (uint32_t)a.m_name->size());
+        writeString(out, a.m_value, a.m_size);
+        out->push_back(a.m_wide ? 1 : 0);
+    }
+    writeUInt32(out, m_num_nodes);
+    for (unsigned int i = 0; i < m_num_nodes; i++)
+        m_nodes[i]->saveBinary(out);
+}   // saveBinary
+
+// ----------------------------------------------------------------------------
+/** Creates a tree from data written by saveBinary().
+ *  \param file_name Name of the XML file the data was created from, used
+ *         in error messages.
+ *  \param data Start of the data, on return the end of the data read.
+ *  \param end End of the available data.
+ *  \return The root node, or NULL if the data is invalid.
+ */
+XMLNode *XMLNode::loadBinary(const std::string &file_name, const char **data,
+                             const char *end)
+{
+    Arena *arena = new Arena();
+    XMLNode *node = new XMLNode(arena, arena->intern(file_name));
+    node->m_arena = arena;
+    if (!node->readBinary(arena, data, end))
+    {
+        delete node;
+        return NULL;
+    }
+    return node;
+}   // loadBinary
+
+// ----------------------------------------------------------------------------
+/** Reads this node and all its children from data written by saveBinary().
+ *  \return False if the data is invalid.
+ */
+bool XMLNode::readBinary(Arena *arena, const char **data, const char *end)
+{
+    const char *s;
+    uint32_t size, count;
+    if (!readString(data, end, &s, &size))
+        return false;
+    m_name = arena->intern(std::string(s, size));
+
+    // Each attribute and node needs at least 8 bytes, so this protects
+    // against allocating huge arrays for invalid data
+    if (!readUInt32(data, end, &count) || count > (uint32_t)(end - *data) / 8)
+        return false;
+    m_attributes = arena->allocateArray<Attribute>(count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        Attribute &a = m_attributes[i];
+        if (!readString(data, end, &s, &size))
+            return false;
+        a.m_name = arena->intern(std::string(s, size));
+        if (!readString(data, end, &s, &size) || *data == end)
+            return false;
+        char *value = arena->allocateString(size);
+        if (size > 0)
+            memcpy(value, s, size);
+        a.m_value = value;
+        a.m_size  = size;
+        a.m_wide  = *(*data)++ != 0;
+        m_num_attributes++;
+    }
+
+    if (!readUInt32(data, end, &count) || count > (uint32_t)(end - *data) / 8)
+        return false;
+    m_nodes = arena->allocateArray<XMLNode*>(count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        XMLNode *child = new (arena->allocate(sizeof(XMLNode),
+                                              alignof(XMLNode)))
+                                                XMLNode(arena, m_file_name);
+        if (!child->readBinary(arena, data, end))
+        {
+            child->destroyChildren();
+            child->~XMLNode();
+            return false;
+        }
+        m_nodes[m_num_nodes++] = child;
+    }
+    return true;
+}   // readBinary
+
+// ----------------------------------------------------------------------------
+/** Stores all attributes, and reads in all children. If called more than
+ *  once for a node (for files with more than one root element), the
+ *  attributes and children are appended.
  *  \param xml The XML reader.
+ *  \param arena The arena of the tree.
+ *  \param children Temporary list of nodes shared by all levels of the
+ *         tree, so that the children of a node can be collected before
+ *         they are stored in one array.
  */
-void XMLNode::readXML(io::IXMLReader *xml)
+void XMLNode::readXML(io::IXMLReader *xml, Arena *arena,
+                      std::vector<XMLNode*> *children)
 {
-    m_name = std::string(core::stringc(xml->getNodeName()).c_str());
+    m_name = arena->intern(core::stringc(xml->getNodeName()).c_str());
 
-    for(unsigned int i=0; i<xml->getAttributeCount(); i++)
+    unsigned int count = xml->getAttributeCount();
+    if (count > 0)
     {
-        std::string   name  = core::stringc(xml->getAttributeName(i)).c_str();
-        core::stringw value = xml->getAttributeValue(i);
-        m_attributes[name] = value;
-    }   // for i
+        Attribute *attributes =
+            arena->allocateArray<Attribute>(m_num_attributes + count);
+        if (m_num_attributes > 0)
+        {
+            memcpy(attributes, m_attributes,
+                   m_num_attributes * sizeof(Attribute));
+        }
+        for(unsigned int i=0; i<count; i++)
+        {
+            Attribute &a = attributes[m_num_attributes + i];
+            a.m_name =
+                arena->intern(core::stringc(xml->getAttributeName(i)).c_str());
+            // The XML reader stores each byte of an UTF-8 file in one
+            // wchar_t, so usually the value can be stored as bytes again
+            const wchar_t *value = xml->getAttributeValue(i);
+            size_t size = 0;
+            a.m_wide = false;
+            for (; value[size]; size++)
+            {
+                if ((uint32_t)value[size] > 255)
+                    a.m_wide = true;
+            }
+            if (a.m_wide)
+            {
+                std::string utf8 = StringUtils::wideToUtf8(value);
+                size = utf8.size();
+                char *p = arena->allocateString(size);
+                memcpy(p, utf8.c_str(), size);
+                a.m_value = p;
+            }
+            else
+            {
+                char *p = arena->allocateString(size);
+                for (size_t j = 0; j < size; j++)
+                    p[j] = (char)value[j];
+                a.m_value = p;
+            }
+            a.m_size = (uint32_t)size;
+        }   // for i
+        m_attributes      = attributes;
+        m_num_attributes += count;
+    }
 
     // If no children, we are done
     if(xml->isEmptyElement())
         return;
 
     /** Read all children elements. */
-    while(xml->read())
+    const size_t first = children->size();
+    bool end = false;
+    while(!end && xml->read())
     {
         switch (xml->getNodeType())
         {
         case io::EXN_ELEMENT:
             {
-                XMLNode* n = new XMLNode(xml);
-                n->m_file_name = m_file_name;
-                m_nodes.push_back(n);
+                XMLNode* n = new (arena->allocate(sizeof(XMLNode),
+                                                  alignof(XMLNode)))
+                                                XMLNode(arena, m_file_name);
+                n->readXML(xml, arena, children);
+                children->push_back(n);
                 break;
             }
         case io::EXN_ELEMENT_END:
             // End of this element found.
-            return;
+            end = true;
             break;
         case io::EXN_UNKNOWN:            break;
         case io::EXN_COMMENT:            break;
@@ -127,6 +444,19 @@ void XMLNode::readXML(io::IXMLReader *xml)
         default:                         break;
         }   // switch
     }   // while
+
+    count = (unsigned int)(children->size() - first);
+    if (count > 0)
+    {
+        XMLNode **nodes = arena->allocateArray<XMLNode*>(m_num_nodes + count);
+        if (m_num_nodes > 0)
+            memcpy(nodes, m_nodes, m_num_nodes * sizeof(XMLNode*));
+        memcpy(nodes + m_num_nodes, &(*children)[first],
+               count * sizeof(XMLNode*));
+        m_nodes      = nodes;
+        m_num_nodes += count;
+        children->resize(first);
+    }
 }   // readXML
 
 // ----------------------------------------------------------------------------
@@ -144,7 +474,7 @@ const XMLNode *XMLNode::getNode(unsigned int i) const
  */
 const XMLNode *XMLNode::getNode(const std::string &s) const
 {
-    for(unsigned int i=0; i<m_nodes.size(); i++)
+    for(unsigned int i=0; i<m_num_nodes; i++)
     {
         if(m_nodes[i]->getName()==s) return m_nodes[i];
     }
@@ -158,7 +488,7 @@ const XMLNode *XMLNode::getNode(const std::string &s) const
  */
 const void XMLNode::getNodes(const std::string &s, std::vector<XMLNode*>& out) const
 {
-    for(unsigned int i=0; i<m_nodes.size(); i++)
+    for(unsigned int i=0; i<m_num_nodes; i++)
     {
         if(m_nodes[i]->getName()==s)
         {
@@ -167,6 +497,21 @@ const void XMLNode::getNodes(const std::string &s, std::vector<XMLNode*>& out) c
     }
 }   // getNode
 
+// ----------------------------------------------------------------------------
+/** Returns the attribute with the given name, or NULL if it is not defined.
+ *  If an attribute is defined more than once, the last value is used.
+ */
+const XMLNode::Attribute *XMLNode::findAttribute(const std::string &attribute)
+                                                                          const
+{
+    for (unsigned int i = m_num_attributes; i > 0; i--)
+    {
+        if (*m_attributes[i - 1].m_name == attribute)
+            return &m_attributes[i - 1];
+    }
+    return NULL;
+}   // findAttribute
+
 // ----------------------------------------------------------------------------
 /** If 'attribute' was defined, set 'value' to the value of the
 *   attribute and return 1, otherwise return 0 and do not change value.
@@ -175,31 +520,41 @@ const void XMLNode::getNodes(const std::string &s, std::vector<XMLNode*>& out) c
 */
 int XMLNode::get(const std::string &attribute, std::string *value) const
 {
-    if(m_attributes.empty()) return 0;
-    std::map<std::string, core::stringw>::const_iterator o;
-    o = m_attributes.find(attribute);
-    if(o==m_attributes.end()) return 0;
-    *value=core::stringc(o->second).c_str();
+    const Attribute *a = findAttribute(attribute);
+    if(!a) return 0;
+    if (a->m_wide)
+    {
+        // Like before, only keep the lower byte of each character
+        core::stringw w =
+            StringUtils::utf8ToWide(std::string(a->m_value, a->m_size));
+        *value = core::stringc(w).c_str();
+    }
+    else
+        value->assign(a->m_value, a->m_size);
     return 1;
 }   // get
 // ----------------------------------------------------------------------------
 int XMLNode::get(const std::string &attribute, core::stringw *value) const
 {
-    if(m_attributes.empty()) return 0;
-    std::map<std::string, core::stringw>::const_iterator o;
-    o = m_attributes.find(attribute);
-    if(o==m_attributes.end()) return 0;
-    *value = o->second;
+    const Attribute *a = findAttribute(attribute);
+    if(!a) return 0;
+    if (a->m_wide)
+    {
+        *value = StringUtils::utf8ToWide(std::string(a->m_value, a->m_size));
+        return 1;
+    }
+    core::stringw w;
+    w.reserve(a->m_size + 1);
+    for (uint32_t i = 0; i < a->m_size; i++)
+        w.append((wchar_t)(unsigned char)a->m_value[i]);
+    *value = w;
     return 1;
 }   // get
 // ----------------------------------------------------------------------------
 int XMLNode::getAndDecode(const std::string &attribute, core::stringw *value) const
 {
-    if (m_attributes.empty()) return 0;
-    std::map<std::string, core::stringw>::const_iterator o;
-    o = m_attributes.find(attribute);
-    if (o == m_attributes.end()) return 0;
-    std::string raw_value = core::stringc(o->second).c_str();
+    std::string raw_value;
+    if (!get(attribute, &raw_value)) return 0;
     *value = StringUtils::xmlDecode(raw_value);
     return 1;
 }   // get
@@ -236,7 +591,7 @@ int XMLNode::get(const std::string &attribute, Vec3 *value) const
     if (v.size() != 3)
     {
         Log::warn("[XMLNode]", "WARNING: Expected 3 floating-point values, but found '%s' in file %s",
-                    s.c_str(), m_file_name.c_str());
+                    s.c_str(), m_file_name->c_str());
         return 0;
     }
 
@@ -253,7 +608,7 @@ int XMLNode::get(const std::string &attribute, Vec3 *value) const
     else
     {
         Log::warn("[XMLNode]", "WARNING: Expected 3 floating-point values, but found '%s' in file %s",
-                    s.c_str(), m_file_name.c_str());
+                    s.c_str(), m_file_name->c_str());
         return 0;
     }
 
@@ -318,7 +673,7 @@ int XMLNode::get(const std::string &attribute, int32_t *value) const
     if (!StringUtils::parseString<int>(s, value))
     {
         Log::warn("[XMLNode]", "WARNING: Expected int but found '%s' for attribute '%s' of node '%s' in file %s",
-                    s.c_str(), attribute.c_str(), m_name.c_str(), m_file_name.c_str());
+                    s.c_str(), attribute.c_str(), m_name->c_str(), m_file_name->c_str());
         return 0;
     }
 
@@ -334,7 +689,7 @@ int XMLNode::get(const std::string &attribute, int64_t *value) const
     if (!StringUtils::parseString<int64_t>(s, value))
     {
         Log::warn("[XMLNode]", "WARNING: Expected int but found '%s' for attribute '%s' of node '%s' in file %s",
-                    s.c_str(), attribute.c_str(), m_name.c_str(), m_file_name.c_str());
+                    s.c_str(), attribute.c_str(), m_name->c_str(), m_file_name->c_str());
         return 0;
     }
 
@@ -350,7 +705,7 @@ int XMLNode::get(const std::string &attribute, uint64_t *value) const
     if (!StringUtils::parseString<uint64_t>(s, value))
     {
         Log::warn("[XMLNode]", "WARNING: Expected int but found '%s' for attribute '%s' of node '%s' in file %s",
-                    s.c_str(), attribute.c_str(), m_name.c_str(), m_file_name.c_str());
+                    s.c_str(), attribute.c_str(), m_name->c_str(), m_file_name->c_str());
         return 0;
     }
 
@@ -366,7 +721,7 @@ int XMLNode::get(const std::string &attribute, uint16_t *value) const
     if (!StringUtils::parseString<uint16_t>(s, value))
     {
         Log::warn("[XMLNode]", "WARNING: Expected uint but found '%s' for attribute '%s' of node '%s' in file %s",
-                    s.c_str(), attribute.c_str(), m_name.c_str(), m_file_name.c_str());
+                    s.c_str(), attribute.c_str(), m_name->c_str(), m_file_name->c_str());
         return 0;
     }
 
@@ -382,7 +737,7 @@ int XMLNode::get(const std::string &attribute, uint32_t *value) const
     if (!StringUtils::parseString<unsigned int>(s, value))
     {
         Log::warn("[XMLNode]", "WARNING: Expected uint but found '%s' for attribute '%s' of node '%s' in file %s",
-                    s.c_str(), attribute.c_str(), m_name.c_str(), m_file_name.c_str());
+                    s.c_str(), attribute.c_str(), m_name->c_str(), m_file_name->c_str());
         return 0;
     }
 
@@ -398,7 +753,7 @@ int XMLNode::get(const std::string &attribute, float *value) const
     if (!StringUtils::parseString<float>(s, value))
     {
         Log::warn("[XMLNode]", "WARNING: Expected float but found '%s' for attribute '%s' of node '%s' in file %s",
-                    s.c_str(), attribute.c_str(), m_name.c_str(), m_file_name.c_str());
+                    s.c_str(), attribute.c_str(), m_name->c_str(), m_file_name->c_str());
         return 0;
     }
 
@@ -415,7 +770,7 @@ int XMLNode::get(const std::string &attribute, double *value) const
     {
         Log::warn("[XMLNode]", "WARNING: Expected double but found '%s' for"
             " attribute '%s' of node '%s' in file %s", s.c_str(),
-            attribute.c_str(), m_name.c_str(), m_file_name.c_str());
+            attribute.c_str(), m_name->c_str(), m_file_name->c_str());
         return 0;
     }
 
@@ -474,7 +829,7 @@ int XMLNode::get(const std::string &attribute,
         if (!StringUtils::parseString<float>(v[i], &curr))
         {
             Log::warn("[XMLNode]", "WARNING: Expected float but found '%s' for attribute '%s' of node '%s' in file %s",
-                        v[i].c_str(), attribute.c_str(), m_name.c_str(), m_file_name.c_str());
+                        v[i].c_str(), attribute.c_str(), m_name->c_str(), m_file_name->c_str());
             return 0;
         }
 
@@ -505,7 +860,7 @@ int XMLNode::get(const std::string &attribute, std::vector<int> *value) const
         if (!StringUtils::parseString<int>(v[i], &val))
         {
             Log::warn("[XMLNode]", "WARNING: Expected int but found '%s' for attribute '%s' of node '%s'",
-                        v[i].c_str(), attribute.c_str(), m_name.c_str());
+                        v[i].c_str(), attribute.c_str(), m_name->c_str());
             return 0;
         }
 
@@ -658,9 +1013,80 @@ int XMLNode::getHPR(Vec3 *value) const
 
 bool XMLNode::hasChildNamed(const char* name) const
 {
-    for (unsigned int i = 0; i < m_nodes.size(); i++)
+    for (unsigned int i = 0; i < m_num_nodes; i++)
     {
         if (m_nodes[i]->getName() == name) return true;
     }
     return false;
 }
+
+// ----------------------------------------------------------------------------
+/** Checks parsing into the arena and the binary format. */
+void XMLNode::unitTesting()
+{
+    const std::string content =
+        "<?xml version=\"1.0\"?>\n"
+        "<root a=\"1\" list=\"x y z\">\n"
+        "  <child n=\"c1\" v=\"1.5\"/>\n"
+        "  <!-- comment -->\n"
+        "  <child n=\"c2\"><sub s=\"\xc3\xbc\" empty=\"\"/></child>\n"
+        "  <other/>\n"
+        "</root>\n";
+    XMLNode *root = file_manager->createXMLTreeFromString(content);
+    assert(root);
+    // All results are collected in ok, so that the calls are not only done
+    // in debug builds
+    bool ok = root->getName() == "root";
+    assert(ok);
+    ok &= root->getNumNodes() == 3;
+    assert(ok);
+    int i = 0;
+    ok &= root->get("a", &i) == 1 && i == 1;
+    assert(ok);
+    std::vector<std::string> list;
+    ok &= root->get("list", &list) == 3 && list[2] == "z";
+    assert(ok);
+    ok &= root->get("missing", &i) == 0 && i == 1;
+    assert(ok);
+    std::vector<XMLNode*> children;
+    root->getNodes("child", children);
+    assert(children.size() == 2);
+    float f = 0.0f;
+    ok &= children[0]->get("v", &f) == 1 && f == 1.5f;
+    assert(ok);
+    ok &= root->getNode("other") == root->getNode(2);
+    assert(ok);
+    ok &= root->hasChildNamed("other") && !root->hasChildNamed("sub");
+    assert(ok);
+
+    // Values are kept as bytes, like the XML reader returns them
+    const XMLNode *sub = children[1]->getNode("sub");
+    assert(sub);
+    ok &= sub->getNumNodes() == 0;
+    assert(ok);
+    std::string s;
+    ok &= sub->get("s", &s) == 1 && s == "\xc3\xbc";
+    assert(ok);
+    core::stringw w;
+    ok &= sub->get("s", &w) == 1 && w.size() == 2 && w[0] == 0xc3;
+    assert(ok);
+    ok &= sub->get("empty", &s) == 1 && s.empty();
+    assert(ok);
+
+    std::string binary;
+    root->saveBinary(&binary);
+    const char *data = binary.c_str();
+    XMLNode *copy = loadBinary("copy", &data, data + binary.size());
+    assert(copy && data == binary.c_str() + binary.size());
+    std::string binary_copy;
+    copy->saveBinary(&binary_copy);
+    assert(binary == binary_copy);
+    delete copy;
+
+    // Truncated data must be detected
+    data = binary.c_str();
+    copy = loadBinary("copy", &data, data + binary.size() - 1);
+    assert(!copy);
+    delete copy;
+    delete root;
+}   // unitTesting
@@ -47,16 +47,44 @@ class Vec3;
 class XMLNode : public NoCopy
 {
 private:
-    /** Name of this element. */
-    std::string                          m_name;
+    class Arena;
+
+    /** An attribute. The value is stored as read from the file (i.e. UTF-8
+     *  for the usual XML files), only if the file contained characters
+     *  which do not fit into a byte it is converted to UTF-8. */
+    struct Attribute
+    {
+        /** Name of the attribute, interned in the arena. */
+        const std::string *m_name;
+        /** The value, not 0-terminated. */
+        const char        *m_value;
+        uint32_t           m_size;
+        /** True if the value was converted to UTF-8. */
+        bool               m_wide;
+    };
+
+    /** Memory of the whole tree: all nodes, attributes and names. Only set
+     *  for the root node, which owns the arena. */
+    Arena                               *m_arena;
+    /** Name of this element, interned in the arena. */
+    const std::string                   *m_name;
     /** List of all attributes. */
-    std::map<std::string, core::stringw> m_attributes;
+    Attribute                           *m_attributes;
+    unsigned int                         m_num_attributes;
     /** List of all sub nodes. */
-    std::vector<XMLNode *>               m_nodes;
+    XMLNode                            **m_nodes;
+    unsigned int                         m_num_nodes;
 
-    void readXML(io::IXMLReader *xml);
+    /** Name of the file this node was read from, for error messages. */
+    const std::string                   *m_file_name;
 
-    std::string                          m_file_name;
+    XMLNode(Arena *arena, const std::string *file_name);
+    void init(const std::string &file_name);
+    void readXML(io::IXMLReader *xml, Arena *arena,
+                 std::vector<XMLNode*> *children);
+    void destroyChildren();
+    const Attribute *findAttribute(const std::string &attribute) const;
+    bool readBinary(Arena *arena, const char **data, const char *end);
 
 public:
          LEAK_CHECK();
@@ -67,11 +95,16 @@ public:
 
         ~XMLNode();
 
-    const std::string &getName() const {return m_name; }
+    void           saveBinary(std::string *out) const;
+    static XMLNode *loadBinary(const std::string &file_name,
+                               const char **data, const char *end);
+    static void     unitTesting();
+
+    const std::string &getName() const {return *m_name; }
     const XMLNode     *getNode(const std::string &name) const;
     const void         getNodes(const std::string &s, std::vector<XMLNode*>& out) const;
     const XMLNode     *getNode(unsigned int i) const;
-    unsigned int       getNumNodes() const {return (unsigned int) m_nodes.size(); }
+    unsigned int       getNumNodes() const {return m_num_nodes; }
     int get(const std::string &attribute, std::string *value) const;
     int get(const std::string &attribute, core::stringw *value) const;
     int getAndDecode(const std::string &attribute, core::stringw *value) const;
@@ -666,14 +666,14 @@ void Flyable::moveToInfinity(bool set_moveable_trans)
 }   // moveToInfinity
 
 // ----------------------------------------------------------------------------
-BareNetworkString* Flyable::saveState(std::vector<std::string>* ru)
+bool Flyable::saveState(BareNetworkString *buffer,
+                        std::vector<std::string>* ru)
 {
     if (m_has_hit_something)
-        return NULL;
+        return false;
 
     ru->push_back(getUniqueIdentity());
 
-    BareNetworkString* buffer = new BareNetworkString();
     uint16_t ticks_since_thrown_animation = (m_ticks_since_thrown & 32767) |
         (hasAnimation() ? 32768 : 0);
     buffer->addUInt16(ticks_since_thrown_animation);
@@ -687,7 +687,7 @@ BareNetworkString* Flyable::saveState(std::vector<std::string>* ru)
         CompressNetworkBody::compress(
             m_body.get(), m_motion_state.get(), buffer);
     }
-    return buffer;
+    return true;
 }   // saveState
 
 // ----------------------------------------------------------------------------
@@ -259,8 +259,8 @@ public:
     // ------------------------------------------------------------------------
     virtual void computeError() OVERRIDE;
     // ------------------------------------------------------------------------
-    virtual BareNetworkString* saveState(std::vector<std::string>* ru)
-        OVERRIDE;
+    virtual bool saveState(BareNetworkString *buffer,
+                           std::vector<std::string>* ru) OVERRIDE;
     // ------------------------------------------------------------------------
     virtual void restoreState(BareNetworkString *buffer, int count) OVERRIDE;
     // ------------------------------------------------------------------------
@@ -219,29 +219,19 @@ void NetworkItemManager::setItemConfirmationTime(std::weak_ptr<STKPeer> peer,
  *  to save the initial state, which is the first confirmed state by all
  *  clients.
  */
-BareNetworkString* NetworkItemManager::saveState(std::vector<std::string>* ru)
+bool NetworkItemManager::saveState(BareNetworkString *buffer,
+                                   std::vector<std::string>* ru)
 {
     ru->push_back(getUniqueIdentity());
     // On the server:
     // ==============
     m_item_events.lock();
-    uint16_t n = (uint16_t)m_item_events.getData().size();
-    if(n==0)
-    {
-        BareNetworkString *s = new BareNetworkString();
-        m_item_events.unlock();
-        return s;
-    }
-
-    BareNetworkString *s =
-        new BareNetworkString(n * (  sizeof(int) + sizeof(uint16_t)
-                                   + sizeof(uint8_t)              ) );
     for (auto p : m_item_events.getData())
     {
-        p.saveState(s);
+        p.saveState(buffer);
     }
     m_item_events.unlock();
-    return s;
+    return true;
 }   // saveState
 
 //-----------------------------------------------------------------------------
@@ -876,11 +876,11 @@ bool RubberBall::hit(AbstractKart* kart, PhysicalObject* object)
 }   // hit
 
 // ----------------------------------------------------------------------------
-BareNetworkString* RubberBall::saveState(std::vector<std::string>* ru)
+bool RubberBall::saveState(BareNetworkString *buffer,
+                           std::vector<std::string>* ru)
 {
-    BareNetworkString* buffer = Flyable::saveState(ru);
-    if (!buffer)
-        return NULL;
+    if (!Flyable::saveState(buffer, ru))
+        return false;
 
     buffer->addUInt16((int16_t)m_last_aimed_graph_node);
     buffer->add(m_control_points[0]);
@@ -899,7 +899,7 @@ BareNetworkString* RubberBall::saveState(std::vector<std::string>* ru)
     buffer->addFloat(m_current_max_height);
     buffer->addUInt8(m_tunnel_count | (m_aiming_at_target ? (1 << 7) : 0));
     TrackSector::saveState(buffer);
-    return buffer;
+    return true;
 }   // saveState
 
 // ----------------------------------------------------------------------------
@@ -26,6 +26,7 @@
 #include "karts/controller/ai_properties.hpp"
 #include "karts/kart_properties.hpp"
 #include "karts/rescue_animation.hpp"
+#include "modes/world.hpp"
 #include "tracks/arena_graph.hpp"
 #include "tracks/arena_node.hpp"
 #include "tracks/track.hpp"
@@ -66,11 +67,27 @@ void ArenaAI::reset()
     m_turn_radius = 0.0f;
     m_steering_angle = 0.0f;
     m_on_node.clear();
+    m_target_prepared_ticks = -1;
 
     m_cur_difficulty = RaceManager::get()->getDifficulty();
     AIBaseController::reset();
 }   // reset
 
+//-----------------------------------------------------------------------------
+/** Finds the target in parallel with all other AIs before the karts are
+ *  updated, \ref update will then skip \ref findTarget.
+ *  \param ticks Number of physics time steps - should be 1.
+ */
+void ArenaAI::prepareUpdate(int ticks)
+{
+    m_target_prepared_ticks = -1;
+    if (!m_graph || m_kart->getKartAnimation() || isWaiting())
+        return;
+
+    findTarget();
+    m_target_prepared_ticks = World::getWorld()->getTicksSinceStart();
+}   // prepareUpdate
+
 //-----------------------------------------------------------------------------
 /** This is the main entry point for the AI.
  *  It is called once per frame for each AI and determines the behaviour of
@@ -82,6 +99,11 @@ void ArenaAI::update(int ticks)
     if (!m_graph)
         return;
 
+    // Only use the target from prepareUpdate if it was found for this tick
+    const bool target_prepared =
+        m_target_prepared_ticks == World::getWorld()->getTicksSinceStart();
+    m_target_prepared_ticks = -1;
+
     // This is used to enable firing an item backwards.
     m_controls->setLookBack(false);
     m_controls->setNitro(false);
@@ -127,7 +149,8 @@ void ArenaAI::update(int ticks)
     if (gettingUnstuck(ticks))
         return;
 
-    findTarget();
+    if (!target_prepared)
+        findTarget();
 
     // After found target, convert it to local coordinate, used for skidding or
     // u-turn
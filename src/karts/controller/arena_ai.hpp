@@ -133,6 +133,10 @@ private:
     /** The \ref ArenaNode at which the forward point located on. */
     int m_current_forward_node;
 
+    /** The world tick for which \ref findTarget was already called in
+     *  \ref prepareUpdate, or -1. */
+    int m_target_prepared_ticks;
+
     void          configSpeed();
     // ------------------------------------------------------------------------
     void          configSteering();
@@ -188,6 +192,13 @@ public:
     // ------------------------------------------------------------------------
     virtual void update(int ticks) OVERRIDE;
     // ------------------------------------------------------------------------
+    /** Finding the target only reads the world state by default, sub-class
+     *  should return false if its \ref findTarget depends on anything
+     *  changed in \ref update. */
+    virtual bool canPrepareUpdate() const OVERRIDE             { return true; }
+    // ------------------------------------------------------------------------
+    virtual void prepareUpdate(int ticks) OVERRIDE;
+    // ------------------------------------------------------------------------
     virtual void reset() OVERRIDE;
     // ------------------------------------------------------------------------
     virtual void newLap(int lap) OVERRIDE {}
@@ -62,6 +62,17 @@ public:
     virtual      ~Controller         () {};
     virtual void  reset              () = 0;
     virtual void  update             (int ticks) = 0;
+    // ------------------------------------------------------------------------
+    /** Returns true if this controller can compute parts of its next
+     *  update() in prepareUpdate(). */
+    virtual bool  canPrepareUpdate   () const { return false; }
+    // ------------------------------------------------------------------------
+    /** Computes the expensive, read-only part of the next update() call.
+     *  This is called for all controllers in parallel before any kart is
+     *  updated, so it must only read the world state and only write to
+     *  members of this controller. */
+    virtual void  prepareUpdate      (int ticks) {}
+    // ------------------------------------------------------------------------
     virtual void  handleZipper       (bool play_sound) = 0;
     virtual void  collectedItem      (const ItemState &item,
                                       float previous_energy=0) = 0;
@@ -57,19 +57,38 @@ bool NetworkAIController::isLocalPlayerController() const
     return NetworkConfig::get()->isNetworkAIInstance();
 }   // isLocalPlayerController
 
+// ----------------------------------------------------------------------------
+/** Returns true if the underlying AI will be updated in this tick. */
+bool NetworkAIController::isAIUpdateDue() const
+{
+    if (RewindManager::get()->isRewinding())
+        return false;
+    return World::getWorld()->isStartPhase() ||
+        World::getWorld()->getTicksSinceStart() > m_prev_update_ticks;
+}   // isAIUpdateDue
+
+// ----------------------------------------------------------------------------
+bool NetworkAIController::canPrepareUpdate() const
+{
+    return m_ai_controller->canPrepareUpdate();
+}   // canPrepareUpdate
+
+// ----------------------------------------------------------------------------
+void NetworkAIController::prepareUpdate(int ticks)
+{
+    if (isAIUpdateDue())
+        m_ai_controller->prepareUpdate(m_ai_frequency);
+}   // prepareUpdate
+
 // ----------------------------------------------------------------------------
 void NetworkAIController::update(int ticks)
 {
-    if (!RewindManager::get()->isRewinding())
+    if (isAIUpdateDue())
     {
-        if (World::getWorld()->isStartPhase() ||
-            World::getWorld()->getTicksSinceStart() > m_prev_update_ticks)
-        {
-            m_prev_update_ticks = World::getWorld()->getTicksSinceStart() +
-                m_ai_frequency;
-            m_ai_controller->update(m_ai_frequency);
-            convertAIToPlayerActions();
-        }
+        m_prev_update_ticks = World::getWorld()->getTicksSinceStart() +
+            m_ai_frequency;
+        m_ai_controller->update(m_ai_frequency);
+        convertAIToPlayerActions();
     }
     PlayerController::update(ticks);
 }   // update
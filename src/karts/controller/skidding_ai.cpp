@@ -24,6 +24,8 @@
 #ifdef AI_DEBUG
 #  include "graphics/irr_driver.hpp"
 #endif
+#include "config/user_config.hpp"
+#include "graphics/camera.hpp"
 #include "graphics/show_curve.hpp"
 #include "graphics/slip_stream.hpp"
 #include "items/attachment.hpp"
@@ -33,12 +35,14 @@
 #include "karts/abstract_kart.hpp"
 #include "karts/controller/kart_control.hpp"
 #include "karts/controller/ai_properties.hpp"
+#include "karts/controller/network_ai_controller.hpp"
 #include "karts/kart_properties.hpp"
 #include "karts/max_speed.hpp"
 #include "karts/rescue_animation.hpp"
 #include "karts/skidding.hpp"
 #include "modes/linear_world.hpp"
 #include "modes/profile_world.hpp"
+#include "network/network_config.hpp"
 #include "physics/triangle_mesh.hpp"
 #include "race/race_manager.hpp"
 #include "tracks/drive_graph.hpp"
@@ -75,12 +79,17 @@ SkiddingAI::SkiddingAI(AbstractKart *kart)
 #undef COMPARE_AIS
 #ifdef COMPARE_AIS
     std::string name("");
-    m_point_selection_algorithm = m_kart->getWorldKartId() % 2
-                                ? PSA_DEFAULT : PSA_NEW;
+    switch(m_kart->getWorldKartId() % 3)
+    {
+    case 0 : m_point_selection_algorithm = PSA_DEFAULT;     break;
+    case 1 : m_point_selection_algorithm = PSA_NEW;         break;
+    default: m_point_selection_algorithm = PSA_PRECOMPUTED; break;
+    }
     switch(m_point_selection_algorithm)
     {
-    case PSA_NEW     : name = "New";     break;
-    case PSA_DEFAULT : name = "Default"; break;
+    case PSA_NEW         : name = "New";         break;
+    case PSA_DEFAULT     : name = "Default";     break;
+    case PSA_PRECOMPUTED : name = "Precomputed"; break;
     }
     setControllerName(name);
 #endif
@@ -177,6 +186,10 @@ void SkiddingAI::reset()
     m_skid_probability_state     = SKID_PROBAB_NOT_YET;
     m_last_item_random           = NULL;
     m_burster                    = false;
+    m_prepared_ticks             = -1;
+    m_prepared_last_node         = Graph::UNKNOWN_SECTOR;
+    m_lod_ticks_since_planning   = -1;
+    m_lod_target_heading         = 0.0f;
 
     AIBaseLapController::reset();
     m_track_node               = Graph::UNKNOWN_SECTOR;
@@ -215,6 +228,104 @@ unsigned int SkiddingAI::getNextSector(unsigned int index)
     return m_successor_index[index];
 }   // getNextSector
 
+//-----------------------------------------------------------------------------
+/** Returns true if this kart only needs a reduced planning rate, i.e. it is
+ *  too far away (along the track, or in race position) from all human
+ *  players. If there is no human player at all, all karts use the full
+ *  rate. Unless the deterministic mode is used, a kart followed by a camera
+ *  always uses the full rate.
+ */
+bool SkiddingAI::isReducedLod() const
+{
+    if (!UserConfigParams::m_ai_lod_deterministic &&
+        !NetworkConfig::get()->isNetworking())
+    {
+        for (unsigned int i = 0; i < Camera::getNumCameras(); i++)
+        {
+            if (Camera::getCamera(i)->getKart() == m_kart)
+                return false;
+        }
+    }
+
+    const float max_distance = UserConfigParams::m_ai_lod_distance;
+    const int   max_rank     = UserConfigParams::m_ai_lod_rank;
+    const float distance =
+        m_world->getOverallDistance(m_kart->getWorldKartId());
+    bool has_human = false;
+    for (unsigned int i = 0; i < m_world->getNumKarts(); i++)
+    {
+        const AbstractKart *kart = m_world->getKart(i);
+        const Controller *controller = kart->getController();
+        // The AIs of a network AI instance are player controllers, too
+        if (kart->isEliminated() || !controller->isPlayerController() ||
+            dynamic_cast<const NetworkAIController*>(controller))
+            continue;
+        has_human = true;
+        if (fabsf(m_world->getOverallDistance(i) - distance) > max_distance)
+            continue;
+        if (max_rank > 0 &&
+            std::abs(kart->getPosition() - m_kart->getPosition()) > max_rank)
+            continue;
+        return false;
+    }
+    return has_human;
+}   // isReducedLod
+
+//-----------------------------------------------------------------------------
+/** Returns if a kart with reduced planning rate has to plan in this update.
+ *  In deterministic mode this only depends on the world tick (spread over
+ *  all karts by their id), otherwise on the ticks since the last planning.
+ *  \param ticks Number of physics time steps - should be 1.
+ */
+bool SkiddingAI::isPlanningTick(int ticks) const
+{
+    if (m_lod_ticks_since_planning < 0)
+        return true;
+    const int interval = std::max((int)UserConfigParams::m_ai_lod_interval, 1);
+    if (UserConfigParams::m_ai_lod_deterministic ||
+        NetworkConfig::get()->isNetworking())
+    {
+        const int t = m_world->getTicksSinceStart() + m_kart->getWorldKartId();
+        return t % interval < ticks;
+    }
+    return m_lod_ticks_since_planning + ticks >= interval;
+}   // isPlanningTick
+
+//-----------------------------------------------------------------------------
+bool SkiddingAI::canPrepareUpdate() const
+{
+#ifdef AI_DEBUG
+    // The debug code changes scene nodes, which must be done in main thread
+    return false;
+#else
+    return true;
+#endif
+}   // canPrepareUpdate
+
+//-----------------------------------------------------------------------------
+/** Computes the information gathered at the beginning of update() (nearest
+ *  karts, crashes, track direction and the point to aim at). This only
+ *  reads the world state, so it is called for all AIs in parallel before
+ *  the karts are updated, update() will then use the results.
+ *  \param ticks Number of physics time steps - should be 1.
+ */
+void SkiddingAI::prepareUpdate(int ticks)
+{
+    m_prepared_ticks = -1;
+    // Same conditions as in update(), where these functions are not used
+    if (m_kart->getKartAnimation() || isStuck() || m_world->isStartPhase())
+        return;
+    if (UserConfigParams::m_ai_lod && !isPlanningTick(ticks) &&
+        isReducedLod())
+        return;
+
+    computeNearestKarts();
+    checkCrashes(m_kart->getXYZ());
+    determineTrackDirection();
+    findAimPoint(&m_prepared_aim_point, &m_prepared_last_node);
+    m_prepared_ticks = m_world->getTicksSinceStart();
+}   // prepareUpdate
+
 //-----------------------------------------------------------------------------
 /** This is the main entry point for the AI.
  *  It is called once per frame for each AI and determines the behaviour of
@@ -224,6 +335,10 @@ void SkiddingAI::update(int ticks)
 {
     float dt = stk_config->ticks2Time(ticks);
 
+    // Only use the data from prepareUpdate() if it was done for this tick
+    const bool prepared = m_prepared_ticks == m_world->getTicksSinceStart();
+    m_prepared_ticks = -1;
+
     // Clear stored items if they were deleted (for example a switched nitro)
     if (m_item_to_collect &&
         !m_item_manager->itemExists(m_item_to_collect))
@@ -240,7 +355,10 @@ void SkiddingAI::update(int ticks)
 
     // Don't do anything if there is currently a kart animations shown.
     if(m_kart->getKartAnimation())
+    {
+        m_lod_ticks_since_planning = -1;
         return;
+    }
 
     if (m_superpower == RaceManager::SUPERPOWER_NOLOK_BOSS)
     {
@@ -311,6 +429,7 @@ void SkiddingAI::update(int ticks)
             m_controls->setRescue(true);
         else
             RescueAnimation::create(m_kart);
+        m_lod_ticks_since_planning = -1;
         AIBaseLapController::update(ticks);
         return;
     }
@@ -318,12 +437,31 @@ void SkiddingAI::update(int ticks)
     if( m_world->isStartPhase() )
     {
         handleRaceStart();
+        m_lod_ticks_since_planning = -1;
         AIBaseLapController::update(ticks);
         return;
     }
 
+    if (UserConfigParams::m_ai_lod)
+    {
+        const bool reduced = isReducedLod();
+        m_world->countAILod(reduced);
+        if (reduced && !isPlanningTick(ticks))
+        {
+            // Keep acceleration, braking and items as planned, and only
+            // steer towards the heading that was planned last time.
+            setSteering(normalizeAngle(m_lod_target_heading
+                                       - m_kart->getHeading()), dt);
+            m_lod_ticks_since_planning += ticks;
+            AIBaseLapController::update(ticks);
+            return;
+        }
+        m_lod_ticks_since_planning = 0;
+    }
+
     // Get information that is needed by more than 1 of the handling funcs
-    computeNearestKarts();
+    if (!prepared)
+        computeNearestKarts();
 
     if (!m_enabled_network_ai)
     {
@@ -339,12 +477,15 @@ void SkiddingAI::update(int ticks)
     }
 
     //Detect if we are going to crash with the track and/or kart
-    checkCrashes(m_kart->getXYZ());
-    determineTrackDirection();
+    if (!prepared)
+    {
+        checkCrashes(m_kart->getXYZ());
+        determineTrackDirection();
+    }
 
     /*Response handling functions*/
     handleAccelerationAndBraking(ticks);
-    handleSteering(dt);
+    handleSteering(dt, prepared);
     handleRescue(dt);
 
     // Make sure that not all AI karts use the zipper at the same
@@ -364,8 +505,9 @@ void SkiddingAI::update(int ticks)
  *  avoid item, and potentially adjust the aim-at point, before computing the
  *  steer direction to arrive at the currently aim-at point.
  *  \param dt Time step size.
+ *  \param prepared True if the aim point was computed in prepareUpdate().
  */
-void SkiddingAI::handleSteering(float dt)
+void SkiddingAI::handleSteering(float dt, bool prepared)
 {
     // Special behaviour if we have a bomb attached: try to hit the kart ahead
     // of us.
@@ -467,13 +609,13 @@ void SkiddingAI::handleSteering(float dt)
         Vec3 aim_point;
         int last_node = Graph::UNKNOWN_SECTOR;
 
-        switch(m_point_selection_algorithm)
+        if (prepared)
         {
-        case PSA_NEW:    findNonCrashingPointNew(&aim_point, &last_node);
-                         break;
-        case PSA_DEFAULT:findNonCrashingPoint(&aim_point, &last_node);
-                         break;
+            aim_point = m_prepared_aim_point;
+            last_node = m_prepared_last_node;
         }
+        else
+            findAimPoint(&aim_point, &last_node);
 #ifdef AI_DEBUG
         m_debug_sphere[m_point_selection_algorithm]->setPosition(aim_point.toIrrVector());
 #endif
@@ -2771,6 +2913,54 @@ void SkiddingAI::findNonCrashingPointNew(Vec3 *result, int *last_node)
     *aim_position = DriveGraph::get()->getNode(*last_node)->getCenter();
 }   // findNonCrashingPoint
 
+//-----------------------------------------------------------------------------
+/** Uses the AI data precomputed by the drive graph (see
+ *  DriveGraph::determineAIData): if the kart is close to the center line
+ *  of its node, it aims at the racing line point of the look-ahead node of
+ *  its node, which avoids testing all nodes ahead one by one. Note that
+ *  the look-ahead node is computed from the center of the node and not
+ *  from the position of the kart, and uses a different test for sharp
+ *  turns than findNonCrashingPoint(), so the results are not the same.
+ *  Otherwise findNonCrashingPoint() is used.
+ *  \param aim_position On exit contains the point the AI should aim at.
+ *  \param last_node On exit contais the graph node the AI is aiming at.
+ */
+void SkiddingAI::findNonCrashingPointPrecomputed(Vec3 *aim_position,
+                                                 int *last_node)
+{
+    const DriveNode *dn = DriveGraph::get()->getNode(m_track_node);
+    Vec3 track_coord;
+    DriveGraph::get()->spatialToTrack(&track_coord, m_kart->getXYZ(),
+                                      m_track_node);
+    if (fabsf(track_coord.getX()) < 0.25f * dn->getPathWidth())
+    {
+        *last_node = dn->getLookAheadNode(m_successor_index[m_track_node]);
+        *aim_position = DriveGraph::get()->getNode(*last_node)
+                      ->getRacingLinePoint(m_successor_index[*last_node]);
+        return;
+    }
+    findNonCrashingPoint(aim_position, last_node);
+}   // findNonCrashingPointPrecomputed
+
+//-----------------------------------------------------------------------------
+/** Finds the point to aim at using the selected point selection algorithm.
+ *  \param result On exit contains the point the AI should aim at.
+ *  \param last_node On exit contains the graph node the AI is aiming at.
+ */
+void SkiddingAI::findAimPoint(Vec3 *result, int *last_node)
+{
+    switch(m_point_selection_algorithm)
+    {
+    case PSA_NEW:    findNonCrashingPointNew(result, last_node);
+                     break;
+    case PSA_DEFAULT:findNonCrashingPoint(result, last_node);
+                     break;
+    case PSA_PRECOMPUTED:
+                     findNonCrashingPointPrecomputed(result, last_node);
+                     break;
+    }
+}   // findAimPoint
+
 //-----------------------------------------------------------------------------
 /** Determines the direction of the track ahead of the kart: 0 indicates
  *  straight, +1 right turn, -1 left turn.
@@ -2810,6 +3000,12 @@ void SkiddingAI::determineTrackDirection()
     dg->getNode(next)->getDirectionData(m_successor_index[next],
                                         &m_current_track_direction,
                                         &m_last_direction_node);
+    // With the precomputed AI data use the radius of straights, otherwise
+    // the radius of the last curve is kept (which e.g. prevents using nitro).
+    if(m_point_selection_algorithm==PSA_PRECOMPUTED &&
+       m_current_track_direction==DriveNode::DIR_STRAIGHT)
+        m_current_curve_radius =
+            dg->getNode(next)->getCurveRadius(m_successor_index[next]);
 
 #ifdef AI_DEBUG
     m_curve[CURVE_QG]->clear();
@@ -3026,6 +3222,7 @@ bool SkiddingAI::canSkid(float steer_fraction)
  */
 void SkiddingAI::setSteering(float angle, float dt)
 {
+    m_lod_target_heading = normalizeAngle(m_kart->getHeading() + angle);
     float steer_fraction = angle / m_kart->getMaxSteerAngle();
 
     // Use a simple finite state machine to make sure to randomly decide
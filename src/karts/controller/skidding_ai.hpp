@@ -229,13 +229,36 @@ private:
      *  2. findNonCrashingPointNew() A newly designed algorithm, which is
      *     faster than a fixed version of findNonCrashingPoint, but does not
      *     give as good results as the 'buggy' one.
+     *  3. findNonCrashingPointPrecomputed() uses the look-ahead data
+     *     precomputed by the drive graph where possible. This also uses
+     *     the precomputed radius on straights. It has not been compared
+     *     with the default one yet (see COMPARE_AIS).
      *
      *  So far the default one has by far the best performance, even though
      *  it has bugs. */
-    enum {PSA_DEFAULT, PSA_NEW}
+    enum {PSA_DEFAULT, PSA_NEW, PSA_PRECOMPUTED}
           m_point_selection_algorithm;
 
     ItemManager* m_item_manager;
+
+    /** The world tick for which prepareUpdate() computed the nearest karts,
+     *  crashes, track direction and aim point, or -1 if not prepared. */
+    int m_prepared_ticks;
+
+    /** The point to aim at as computed in prepareUpdate(). */
+    Vec3 m_prepared_aim_point;
+
+    /** The graph node of m_prepared_aim_point. */
+    int m_prepared_last_node;
+
+    /** Number of ticks since the last full planning, used by the AI level
+     *  of detail. -1 if the last plan can not be reused (e.g. after a
+     *  rescue), which forces a planning in the next update. */
+    int m_lod_ticks_since_planning;
+
+    /** The heading the kart should have according to the last steering
+     *  decision. Used to interpolate the steering between two plannings. */
+    float m_lod_target_heading;
 #ifdef AI_DEBUG
     /** For skidding debugging: shows the estimated turn shape. */
     ShowCurve **m_curve;
@@ -257,7 +280,7 @@ private:
      */
     void  handleRaceStart();
     void  handleAccelerationAndBraking(int ticks);
-    void  handleSteering(float dt);
+    void  handleSteering(float dt, bool prepared);
     int   computeSkill(SkillType type);
     void  handleItems(const float dt, const Vec3 *aim_point,
                                 int last_node, int item_skill);
@@ -289,8 +312,12 @@ private:
     void  checkCrashes(const Vec3& pos);
     void  findNonCrashingPointNew(Vec3 *result, int *last_node);
     void  findNonCrashingPoint(Vec3 *result, int *last_node);
+    void  findNonCrashingPointPrecomputed(Vec3 *result, int *last_node);
+    void  findAimPoint(Vec3 *result, int *last_node);
 
     void  determineTrackDirection();
+    bool  isReducedLod() const;
+    bool  isPlanningTick(int ticks) const;
     virtual bool canSkid(float steer_fraction);
     virtual void setSteering(float angle, float dt);
     void handleCurve();
@@ -302,6 +329,8 @@ public:
                  SkiddingAI(AbstractKart *kart);
                 ~SkiddingAI();
     virtual void update      (int ticks);
+    virtual bool canPrepareUpdate() const OVERRIDE;
+    virtual void prepareUpdate(int ticks) OVERRIDE;
     virtual void reset       ();
     virtual const irr::core::stringw& getNamePostfix() const;
 };
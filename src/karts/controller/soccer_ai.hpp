@@ -103,6 +103,9 @@ public:
                 ~SoccerAI();
     virtual void update (int ticks) OVERRIDE;
     virtual void reset() OVERRIDE;
+    /** The target depends on \ref m_front_transform and ball chasing state
+     *  which are only updated in \ref update. */
+    virtual bool canPrepareUpdate() const OVERRIDE { return false; }
 
 };
 
@@ -1341,6 +1341,44 @@ void Kart::eliminate()
         m_node->setVisible(false);
 }   // eliminate
 
+//-----------------------------------------------------------------------------
+/** Returns the start point of the ray used to detect the terrain under the
+ *  kart.
+ *  \param has_animation True if the kart has an animation, in which case
+ *         the wheel positions are not up to date.
+ */
+Vec3 Kart::getTerrainRayStart(bool has_animation) const
+{
+    if (has_animation)
+    {
+        // Use kart transform directly as wheel info is not updated when
+        // there is an animation
+        return getXYZ() + getTrans().getBasis().getColumn(1) * 0.1f;
+    }
+
+    Vec3 from(0.0f, 0.0f, 0.0f);
+    for (unsigned int i = 0; i < 4; i++)
+        from += m_vehicle->getWheelInfo(i).m_raycastInfo.m_hardPointWS;
+
+    // Add a certain epsilon (0.3) to the height of the kart. This avoids
+    // problems of the ray being cast from under the track (which happened
+    // e.g. on tux tollway when jumping down from the ramp, when the chassis
+    // partly tunnels through the track). While tunneling should not be
+    // happening (since Z velocity is clamped), the epsilon is left in place
+    // just to be on the safe side (it will not hit the chassis itself).
+    return from/4 + (getTrans().getBasis() * Vec3(0.0f, 0.3f, 0.0f));
+}   // getTerrainRayStart
+
+// ----------------------------------------------------------------------------
+/** Sets the result of the terrain ray cast in advance against the track,
+ *  see World::prepareTerrainRays().
+ */
+void Kart::setPreparedTerrainHit(const Vec3 &from, const Vec3 &to,
+                                 const TriangleMesh::RayHit &hit)
+{
+    m_terrain_info->setPreparedHit(from, to, hit);
+}   // setPreparedTerrainHit
+
 //-----------------------------------------------------------------------------
 /** Updates the kart in each time step. It updates the physics setting,
  *  particle effects, camera position, etc.
@@ -1539,29 +1577,8 @@ void Kart::update(int ticks)
     // To avoid this problem, we do the raycast for terrain detection from
     // the center of the 4 wheel positions (in world coordinates).
 
-    if (!has_animation_before)
-    {
-        Vec3 from(0.0f, 0.0f, 0.0f);
-        for (unsigned int i = 0; i < 4; i++)
-            from += m_vehicle->getWheelInfo(i).m_raycastInfo.m_hardPointWS;
-
-        // Add a certain epsilon (0.3) to the height of the kart. This avoids
-        // problems of the ray being cast from under the track (which happened
-        // e.g. on tux tollway when jumping down from the ramp, when the chassis
-        // partly tunnels through the track). While tunneling should not be
-        // happening (since Z velocity is clamped), the epsilon is left in place
-        // just to be on the safe side (it will not hit the chassis itself).
-        from = from/4 + (getTrans().getBasis() * Vec3(0.0f, 0.3f, 0.0f));
-
-        m_terrain_info->update(getTrans().getBasis(), from);
-    }
-    else
-    {
-        // Use kart transform directly as wheel info is not updated when
-        // there is an animation
-        m_terrain_info->update(getTrans().getBasis(),
-            getXYZ() + getTrans().getBasis().getColumn(1) * 0.1f);
-    }
+    m_terrain_info->update(getTrans().getBasis(),
+                           getTerrainRayStart(has_animation_before));
 
     if (m_body->getBroadphaseHandle())
         m_body->getBroadphaseHandle()->m_collisionFilterGroup = old_group;
@@ -30,6 +30,7 @@
 
 #include "items/powerup_manager.hpp"    // For PowerupType
 #include "karts/abstract_kart.hpp"
+#include "physics/triangle_mesh.hpp"
 #include "utils/cpp2011.hpp"
 #include "utils/no_copy.hpp"
 
@@ -38,6 +39,7 @@
 class AbstractKartAnimation;
 class Attachment;
 class btKart;
+class btKartRaycaster;
 class btUprightConstraint;
 class Controller;
 class HitEffect;
@@ -115,7 +117,7 @@ protected:
     /** Handles the powerup of a kart. */
     Powerup *m_powerup;
 
-    std::unique_ptr<btVehicleRaycaster> m_vehicle_raycaster;
+    std::unique_ptr<btKartRaycaster> m_vehicle_raycaster;
 
     std::unique_ptr<btKart> m_vehicle;
 
@@ -525,6 +527,11 @@ public:
     // ----------------------------------------------------------------------------------------
     /** Returns the terrain info oject. */
     virtual const TerrainInfo *getTerrainInfo() const OVERRIDE { return m_terrain_info; }
+    // ----------------------------------------------------------------------------------------
+    Vec3 getTerrainRayStart(bool has_animation) const;
+    // ----------------------------------------------------------------------------------------
+    void setPreparedTerrainHit(const Vec3 &from, const Vec3 &to,
+                               const TriangleMesh::RayHit &hit);
 
     // ========================================================================================
     // ----------------------------------------------------------------------------------------
@@ -244,11 +244,6 @@ KartModel::~KartModel()
             assert(!m_is_master);
             m_wheel_node[i]->drop();
         }
-        if(m_is_master && m_wheel_model[i])
-        {
-            irr_driver->dropAllTextures(m_wheel_model[i]);
-            irr_driver->removeMeshFromCache(m_wheel_model[i]);
-        }
     }
 
     for(size_t i=0; i<m_speed_weighted_objects.size(); i++)
@@ -259,15 +254,6 @@ KartModel::~KartModel()
             assert(!m_is_master);
             m_speed_weighted_objects[i].m_node->drop();
         }
-        if (m_is_master && m_speed_weighted_objects[i].m_model)
-        {
-            m_speed_weighted_objects[i].m_model->drop();
-            irr_driver->dropAllTextures(m_speed_weighted_objects[i].m_model);
-            if (m_speed_weighted_objects[i].m_model->getReferenceCount() == 1)
-            {
-                irr_driver->removeMeshFromCache(m_speed_weighted_objects[i].m_model);
-            }
-        }
     }
 
     for (size_t i = 0; i < m_headlight_objects.size(); i++)
@@ -279,7 +265,57 @@ KartModel::~KartModel()
             assert(!m_is_master);
             obj.getLightNode()->drop();
         }
-        if (m_is_master && obj.getModel())
+    }
+
+    if (m_is_master)
+        unloadModels();
+
+    delete m_hat_location;
+#ifdef DEBUG
+#if SKELETON_DEBUG
+    irr_driver->clearDebugMeshes();
+#endif
+#endif
+
+}  // ~KartModel
+
+// ----------------------------------------------------------------------------
+/** Frees the meshes and textures loaded by loadModels() of a master kart
+ *  model. All other information (read from the kart.xml file, and the size
+ *  of the kart) is kept, so loadModels() can be called again later.
+ */
+void KartModel::unloadModels()
+{
+    assert(m_is_master);
+    for(unsigned int i=0; i<4; i++)
+    {
+        if(m_wheel_model[i])
+        {
+            irr_driver->dropAllTextures(m_wheel_model[i]);
+            irr_driver->removeMeshFromCache(m_wheel_model[i]);
+            m_wheel_model[i] = NULL;
+        }
+    }
+
+    for(size_t i=0; i<m_speed_weighted_objects.size(); i++)
+    {
+        scene::IAnimatedMesh *model = m_speed_weighted_objects[i].m_model;
+        if (model)
+        {
+            model->drop();
+            irr_driver->dropAllTextures(model);
+            if (model->getReferenceCount() == 1)
+            {
+                irr_driver->removeMeshFromCache(model);
+            }
+            m_speed_weighted_objects[i].m_model = NULL;
+        }
+    }
+
+    for (size_t i = 0; i < m_headlight_objects.size(); i++)
+    {
+        HeadlightObject& obj = m_headlight_objects[i];
+        if (obj.getModel())
         {
             obj.getModel()->drop();
             irr_driver->dropAllTextures(obj.getModel());
@@ -287,29 +323,56 @@ KartModel::~KartModel()
             {
                 irr_driver->removeMeshFromCache(obj.getModel());
             }
+            obj.setModel(NULL);
         }
     }
 
-    if (m_is_master && m_mesh)
+    if (m_mesh)
     {
         m_mesh->drop();
         // If there is only one copy left, it's the copy in irrlicht's
         // mesh cache, so it can be removed.
-        if (m_mesh && m_mesh->getReferenceCount() == 1)
+        if (m_mesh->getReferenceCount() == 1)
         {
             irr_driver->dropAllTextures(m_mesh);
             irr_driver->removeMeshFromCache(m_mesh);
         }
+        m_mesh = NULL;
     }
+}   // unloadModels
 
-    delete m_hat_location;
-#ifdef DEBUG
-#if SKELETON_DEBUG
-    irr_driver->clearDebugMeshes();
-#endif
-#endif
-
-}  // ~KartModel
+// ----------------------------------------------------------------------------
+/** Returns an estimate of the memory used by the vertices and indices of
+ *  all meshes loaded by loadModels(). Textures are not included, since they
+ *  can be shared with other karts and tracks.
+ */
+size_t KartModel::getMemoryUsage() const
+{
+    std::vector<const scene::IMesh*> meshes;
+    meshes.push_back(m_mesh);
+    for (unsigned int i = 0; i < 4; i++)
+        meshes.push_back(m_wheel_model[i]);
+    for (const SpeedWeightedObject& obj : m_speed_weighted_objects)
+        meshes.push_back(obj.m_model);
+    for (const HeadlightObject& obj : m_headlight_objects)
+        meshes.push_back(obj.getModel());
+
+    size_t size = 0;
+    for (const scene::IMesh* mesh : meshes)
+    {
+        if (!mesh)
+            continue;
+        for (u32 i = 0; i < mesh->getMeshBufferCount(); i++)
+        {
+            const scene::IMeshBuffer* mb = mesh->getMeshBuffer(i);
+            size += mb->getVertexCount() *
+                    video::getVertexPitchFromType(mb->getVertexType());
+            size += mb->getIndexCount() *
+                    (mb->getIndexType() == video::EIT_16BIT ? 2 : 4);
+        }
+    }
+    return size;
+}   // getMemoryUsage
 
 // ----------------------------------------------------------------------------
 /** This function returns a copy of this object. The memory is allocated
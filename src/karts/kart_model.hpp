@@ -346,6 +346,8 @@ public:
     void          reset();
     void          loadInfo(const XMLNode &node);
     bool          loadModels(const KartProperties &kart_properties);
+    void          unloadModels();
+    size_t        getMemoryUsage() const;
     void          setDefaultSuspension();
     void          update(float dt, float distance, float steer, float speed,
                          float current_lean_angle,
@@ -358,6 +360,9 @@ public:
     /** Returns the animated mesh of this kart model. */
     scene::IAnimatedMesh*
                   getModel() const { return m_mesh; }
+    // ------------------------------------------------------------------------
+    /** Returns the file name of the main model of the kart. */
+    const std::string& getModelFilename() const { return m_model_filename; }
 
     // ------------------------------------------------------------------------
     /** Returns the mesh of the wheel for this kart. */
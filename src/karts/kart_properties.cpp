@@ -29,6 +29,7 @@
 #include "graphics/stk_tex_manager.hpp"
 #include "graphics/sp/sp_shader_manager.hpp"
 #include "graphics/sp/sp_texture_manager.hpp"
+#include "guiengine/engine.hpp"
 #include "io/file_manager.hpp"
 #include "karts/cached_characteristic.hpp"
 #include "karts/combined_characteristic.hpp"
@@ -64,6 +65,7 @@ std::tuple<std::string, bool> KartProperties::getIdent(const std::string& filena
 }
 
 float KartProperties::UNDEFINED = -99.9f;
+std::mutex KartProperties::m_models_mutex;
 
 std::string KartProperties::getHandicapAsString(HandicapLevel h)
 {
@@ -81,11 +83,15 @@ std::string KartProperties::getHandicapAsString(HandicapLevel h)
  *  Otherwise the defaults are taken from STKConfig (and since they are all
  *  defined, it is guaranteed that each kart has well defined physics values).
  */
-KartProperties::KartProperties(const std::string &filename)
+KartProperties::KartProperties(const std::string &filename,
+                               const XMLNode *xml)
 {
     m_is_addon = false;
     m_icon_material = NULL;
     m_minimap_icon  = NULL;
+    m_models_on_demand = false;
+    m_models_loaded    = true;
+    m_models_memory    = 0;
     m_name          = "NONAME";
     m_ident         = "NONAME";
     m_icon_file     = "";
@@ -114,7 +120,7 @@ KartProperties::KartProperties(const std::string &filename)
     // The default constructor for stk_config uses filename=""
     if (filename != "")
     {
-        load(filename, "kart");
+        load(filename, "kart", xml);
     }
     else
     {
@@ -153,6 +159,8 @@ KartProperties::~KartProperties()
 void KartProperties::copyForPlayer(const KartProperties *source,
                                    HandicapLevel h)
 {
+    // The copy needs the values which depend on the size of the model
+    source->loadModels();
     *this = *source;
 
     // After the memcpy any pointers will be shared.
@@ -195,13 +203,16 @@ void KartProperties::copyFrom(const KartProperties *source)
 /** Loads the kart properties from a file.
  *  \param filename Filename to load.
  *  \param node Name of the xml node to load the data from
+ *  \param xml The already parsed file (see AssetScanner), or NULL to read
+ *         it here. The kart properties take the ownership.
  */
-void KartProperties::load(const std::string &filename, const std::string &node)
+void KartProperties::load(const std::string &filename, const std::string &node,
+                          const XMLNode *xml)
 {
     // Get the default values from STKConfig. This will also allocate any
     // pointers used in KartProperties
 
-    const XMLNode* root = new XMLNode(filename);
+    const XMLNode* root = xml ? xml : new XMLNode(filename);
     std::string kart_type;
 
     if (root->get("type", &kart_type))
@@ -223,6 +234,10 @@ void KartProperties::load(const std::string &filename, const std::string &node)
     // values from stk_config (otherwise all kart_properties will
     // share the same KartModel
     m_kart_model = std::make_shared<KartModel>(/*is_master*/true);
+    // Without graphics only the metadata is needed until the kart is used
+    m_models_on_demand = GUIEngine::isNoGraphics();
+    m_models_loaded    = false;
+    m_models_memory    = 0;
 
     m_root  = StringUtils::getPath(filename)+"/";
     std::tie(m_ident, m_is_addon) = getIdent(filename);
@@ -308,6 +323,38 @@ void KartProperties::load(const std::string &filename, const std::string &node)
     else
         m_minimap_icon = NULL;
 
+    m_shadow_material = material_manager->getMaterialSPM(m_shadow_file, "",
+        "alphablend");
+
+    STKTexManager::getInstance()->unsetTextureErrorMessage();
+    file_manager->popTextureSearchPath();
+    file_manager->popModelSearchPath();
+
+    if (!m_models_on_demand)
+    {
+        loadKartModels();
+    }
+    else if (m_version >= 1 &&
+             !file_manager->fileExists(m_root +
+                                       m_kart_model->getModelFilename()))
+    {
+        // Still detect karts which can not be used at all
+        throw std::runtime_error("Cannot find kart model");
+    }
+}   // load
+
+// ----------------------------------------------------------------------------
+/** Loads the meshes and textures of the kart model, and sets the values
+ *  which depend on the size of the model.
+ */
+void KartProperties::loadKartModels()
+{
+    std::string unique_id = StringUtils::insertValues("karts/%s", m_ident.c_str());
+    file_manager->pushModelSearchPath(m_root);
+    file_manager->pushTextureSearchPath(m_root, unique_id);
+    STKTexManager::getInstance()
+        ->setTextureErrorMessage("Error while loading kart '%s':", m_name);
+
     // Only load the model if the .kart file has the appropriate version,
     // otherwise warnings are printed.
     if (m_version >= 1)
@@ -315,6 +362,7 @@ void KartProperties::load(const std::string &filename, const std::string &node)
         const bool success = m_kart_model->loadModels(*this);
         if (!success)
         {
+            STKTexManager::getInstance()->unsetTextureErrorMessage();
             file_manager->popTextureSearchPath();
             file_manager->popModelSearchPath();
             throw std::runtime_error("Cannot load kart models");
@@ -336,14 +384,50 @@ void KartProperties::load(const std::string &filename, const std::string &node)
     }
 
     setWheelBase(m_kart_model->getLength());
-    m_shadow_material = material_manager->getMaterialSPM(m_shadow_file, "",
-        "alphablend");
 
     STKTexManager::getInstance()->unsetTextureErrorMessage();
     file_manager->popTextureSearchPath();
     file_manager->popModelSearchPath();
+    size_t memory = m_kart_model->getMemoryUsage();
+    std::lock_guard<std::mutex> lock(m_models_mutex);
+    m_models_loaded = true;
+    m_models_memory = memory;
+}   // loadKartModels
+
+// ----------------------------------------------------------------------------
+/** Makes sure that the meshes of the kart model are loaded. Without graphics
+ *  they are only loaded when they are first needed, i.e. when the kart is
+ *  used in a race (which needs the size of the model for the physics).
+ *  Loading them does not change the values of this kart, so it is treated
+ *  like a cache and done in a const function.
+ */
+void KartProperties::loadModels() const
+{
+    if (m_models_loaded)
+        return;
+    Log::debug("[KartProperties]", "Loading models of kart '%s'.",
+               m_ident.c_str());
+    const_cast<KartProperties*>(this)->loadKartModels();
+}   // loadModels
 
-}   // load
+// ----------------------------------------------------------------------------
+/** Frees the meshes and textures of a kart model which was loaded on demand,
+ *  so that they are loaded again the next time the kart is used. Nothing is
+ *  done if a copy of these kart properties (i.e. a kart) is still using the
+ *  model.
+ *  \return True if the models were unloaded.
+ */
+bool KartProperties::unloadModels()
+{
+    if (!m_models_on_demand || !m_models_loaded ||
+        m_kart_model.use_count() > 1)
+        return false;
+    m_kart_model->unloadModels();
+    std::lock_guard<std::mutex> lock(m_models_mutex);
+    m_models_loaded = false;
+    m_models_memory = 0;
+    return true;
+}   // unloadModels
 
 // ----------------------------------------------------------------------------
 /** Returns a pointer to the KartModel object.
@@ -352,6 +436,7 @@ void KartProperties::load(const std::string &filename, const std::string &node)
  */
 KartModel* KartProperties::getKartModelCopy(std::shared_ptr<RenderInfo> ri) const
 {
+    loadModels();
     return m_kart_model->makeCopy(ri);
 }  // getKartModelCopy
 
@@ -495,7 +580,8 @@ void KartProperties::getAllData(const XMLNode * root)
                 skid_node->get("max_dist", &max_dist);
                 skid_node->get("volume", &gain);
                 SFXManager::get()->addSingleSfx(m_skid_sound, full_path,
-                    true/*positional*/, rolloff, max_dist, gain);
+                    true/*positional*/, rolloff, max_dist, gain,
+                    /*load*/false);
             }
             else if (custom_skid_sound == "default")
             {
@@ -522,7 +608,8 @@ void KartProperties::getAllData(const XMLNode * root)
                 sounds_node->get("max_dist", &max_dist);
                 sounds_node->get("volume", &gain);
                 SFXManager::get()->addSingleSfx(m_engine_sfx_type, full_path,
-                    true/*positional*/, rolloff, max_dist, gain);
+                    true/*positional*/, rolloff, max_dist, gain,
+                    /*load*/false);
             }
             else
             {
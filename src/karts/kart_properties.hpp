@@ -20,6 +20,7 @@
 #define HEADER_KART_PROPERTIES_HPP
 
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -86,6 +87,22 @@ private:
      *  the kart_properties object is const. */
     mutable std::shared_ptr<KartModel> m_kart_model;
 
+    /** True if the meshes of the kart model are only loaded when the kart
+     *  is first used (see loadModels()) and can be unloaded again. This is
+     *  done if the kart is loaded without graphics. */
+    bool m_models_on_demand;
+
+    /** True if the meshes of the kart model are loaded. */
+    bool m_models_loaded;
+
+    /** Memory used by the meshes of the kart model, see
+     *  KartModel::getMemoryUsage(). */
+    size_t m_models_memory;
+
+    /** Protects m_models_loaded and m_models_memory, which are changed in
+     *  the main thread and read by the REST API. */
+    static std::mutex m_models_mutex;
+
     /** List of all groups the kart belongs to. */
     std::vector<std::string> m_groups;
 
@@ -200,7 +217,9 @@ private:
     InterpolationArray m_restitution;
 
     void  load              (const std::string &filename,
-                             const std::string &node);
+                             const std::string &node,
+                             const XMLNode *xml = NULL);
+    void  loadKartModels    ();
     void combineCharacteristics(HandicapLevel h);
 
     void setWheelBase(float kart_length)
@@ -216,7 +235,8 @@ public:
     /** Returns the string representation of a handicap level. */
     static std::string      getHandicapAsString(HandicapLevel h);
 
-          KartProperties    (const std::string &filename="");
+          KartProperties    (const std::string &filename="",
+                             const XMLNode *xml = NULL);
          ~KartProperties    ();
     void  copyForPlayer     (const KartProperties *source,
                              HandicapLevel h = HANDICAP_NONE);
@@ -229,6 +249,8 @@ public:
         setWheelBase(kart_length);
     }
     void  copyFrom          (const KartProperties *source);
+    void  loadModels        () const;
+    bool  unloadModels      ();
     void  getAllData        (const XMLNode * root);
     void  checkAllSet       (const std::string &filename);
     bool  isInGroup         (const std::string &group) const;
@@ -257,7 +279,27 @@ public:
     // ------------------------------------------------------------------------
     /** Returns a pointer to the main KartModel object. This copy
      *  should not be modified, not attachModel be called on it. */
-    const KartModel& getMasterKartModel() const {return *m_kart_model;        }
+    const KartModel& getMasterKartModel() const
+    {
+        loadModels();
+        return *m_kart_model;
+    }   // getMasterKartModel
+    // ------------------------------------------------------------------------
+    /** Returns true if the meshes of the kart model are loaded. Can be
+     *  called from any thread. */
+    bool areModelsLoaded() const
+    {
+        std::lock_guard<std::mutex> lock(m_models_mutex);
+        return m_models_loaded;
+    }   // areModelsLoaded
+    // ------------------------------------------------------------------------
+    /** Returns the memory used by the meshes of the kart model. Can be
+     *  called from any thread. */
+    size_t getModelsMemory() const
+    {
+        std::lock_guard<std::mutex> lock(m_models_mutex);
+        return m_models_memory;
+    }   // getModelsMemory
     // ------------------------------------------------------------------------
     void setHatMeshName(const std::string &hat_name);
     // ------------------------------------------------------------------------
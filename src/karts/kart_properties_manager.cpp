@@ -26,11 +26,13 @@
 #include "config/user_config.hpp"
 #include "graphics/irr_driver.hpp"
 #include "guiengine/engine.hpp"
+#include "io/asset_scanner.hpp"
 #include "io/file_manager.hpp"
 #include "karts/kart_properties.hpp"
 #include "karts/xml_characteristic.hpp"
 #include "utils/log.hpp"
 #include "utils/string_utils.hpp"
+#include "utils/time.hpp"
 
 #include <algorithm>
 #include <ctime>
@@ -47,6 +49,7 @@ std::vector<std::string> KartPropertiesManager::m_kart_search_path;
 KartPropertiesManager::KartPropertiesManager()
 {
     m_all_groups.clear();
+    m_race_count = 0;
 }   // KartPropertiesManager
 
 //-----------------------------------------------------------------------------
@@ -84,6 +87,7 @@ void KartPropertiesManager::unloadAllKarts()
     m_kart_available.clear();
     m_groups_2_indices.clear();
     m_all_groups.clear();
+    m_last_used.clear();
 }   // unloadAllKarts
 
 //-----------------------------------------------------------------------------
@@ -153,31 +157,28 @@ void KartPropertiesManager::removeKart(const std::string &ident)
 void KartPropertiesManager::loadAllKarts(bool loading_icon)
 {
     m_all_kart_dirs.clear();
-    std::vector<std::string>::const_iterator dir;
-    for(dir = m_kart_search_path.begin(); dir!=m_kart_search_path.end(); dir++)
+
+    // Find and parse all kart.xml files in parallel, then load the karts
+    // (including their models) in the order they were found
+    AssetScanner scanner(m_kart_search_path, "/kart.xml", "", "karts.index");
+    uint64_t start = StkTime::getMonoTimeUs();
+    for (unsigned int i = 0; i < scanner.getNumAssets(); i++)
     {
-        // First check if there is a kart in the current directory
-        // -------------------------------------------------------
-        if(loadKart(*dir)) continue;
-
-        // If not, check each subdir of this directory.
-        // --------------------------------------------
-        std::set<std::string> result;
-        file_manager->listFiles(result, *dir);
-        for(std::set<std::string>::const_iterator subdir=result.begin();
-            subdir!=result.end(); subdir++)
+        const bool loaded = loadKart(scanner.getDir(i), scanner.takeXML(i));
+        if (loaded && loading_icon)
         {
-            const bool loaded = loadKart(*dir+*subdir);
+            GUIEngine::addLoadingIcon(irr_driver->getTexture(
+                m_karts_properties[m_karts_properties.size()-1]
+                        .getAbsoluteIconFile()              )
+                                      );
+        }
+    }
 
-            if (loaded && loading_icon)
-            {
-                GUIEngine::addLoadingIcon(irr_driver->getTexture(
-                    m_karts_properties[m_karts_properties.size()-1]
-                            .getAbsoluteIconFile()              )
-                                          );
-            }
-        }   // for all files in the currently handled directory
-    }   // for i
+    Log::info("KartPropertiesManager", "Loaded %d karts (%d from index): "
+              "discovery %.1f ms, parsing %.1f ms, loading %.1f ms.",
+              (int)m_karts_properties.size(), (int)scanner.getNumIndexed(),
+              scanner.getDiscoveryTime(), scanner.getParseTime(),
+              (StkTime::getMonoTimeUs() - start) / 1000.0f);
 }   // loadAllKarts
 
 //-----------------------------------------------------------------------------
@@ -244,23 +245,27 @@ static AlignedArray<KartProperties*>::const_iterator findKartById(const AlignedA
 //-----------------------------------------------------------------------------
 /** Loads a single kart and (if not disabled) the corresponding 3d model.
  *  \param filename Full path to the kart config file.
+ *  \param xml The already parsed kart.xml file, or NULL to read it. Its
+ *         ownership is passed to this function.
  */
-bool KartPropertiesManager::loadKart(const std::string &dir)
+bool KartPropertiesManager::loadKart(const std::string &dir, XMLNode *xml)
 {
     std::string config_filename = dir + "/kart.xml";
-    if(!file_manager->fileExists(config_filename))
+    if(!xml && !file_manager->fileExists(config_filename))
         return false;
 
     auto [ident, addon] = KartProperties::getIdent(config_filename);
     if (findKartById(m_karts_properties.m_contents_vector, ident) != m_karts_properties.m_contents_vector.end())
     {
+        delete xml;
         return false;
     }
 
     std::unique_ptr<KartProperties> kart_properties;
     try
     {
-        kart_properties = std::make_unique<KartProperties>(config_filename);
+        kart_properties = std::make_unique<KartProperties>(config_filename,
+                                                           xml);
     }
     catch (const std::exception& err)
     {
@@ -295,6 +300,54 @@ bool KartPropertiesManager::loadKart(const std::string &dir)
     return true;
 }   // loadKart
 
+//-----------------------------------------------------------------------------
+/** Called before the karts of a new race are created. Marks the given karts
+ *  as used, and unloads the models of all karts which were not used in the
+ *  last UserConfigParams::m_kart_models_races races (if their models were
+ *  loaded on demand, see KartProperties::loadModels()). The models of the
+ *  karts of this race are loaded when the karts are created.
+ *  \param idents The idents of all karts in the race.
+ */
+void KartPropertiesManager::useKarts(const std::vector<std::string> &idents)
+{
+    m_race_count++;
+    for (const std::string &ident : idents)
+        m_last_used[ident] = m_race_count;
+
+    const unsigned int max_age = UserConfigParams::m_kart_models_races;
+    if (max_age == 0)
+        return;
+
+    int num_unloaded = 0;
+    for (KartProperties *kp : m_karts_properties.m_contents_vector)
+    {
+        if (!kp->areModelsLoaded())
+            continue;
+        auto it = m_last_used.find(kp->getIdent());
+        unsigned int last_used = it == m_last_used.end() ? 0 : it->second;
+        if (m_race_count - last_used >= max_age && kp->unloadModels())
+            num_unloaded++;
+    }
+    if (num_unloaded > 0)
+    {
+        Log::info("KartPropertiesManager", "Unloaded models of %d karts, "
+                  "%.1f kB of kart models in memory.", num_unloaded,
+                  getModelsMemory() / 1024.0f);
+    }
+}   // useKarts
+
+//-----------------------------------------------------------------------------
+/** Returns the memory used by the models of all karts, see
+ *  KartModel::getMemoryUsage().
+ */
+size_t KartPropertiesManager::getModelsMemory() const
+{
+    size_t size = 0;
+    for (const KartProperties *kp : m_karts_properties.m_contents_vector)
+        size += kp->getModelsMemory();
+    return size;
+}   // getModelsMemory
+
 //-----------------------------------------------------------------------------
 /** Sets the name of a mesh to use as a hat for all karts.
  *  \param hat_name Name of the hat mash.
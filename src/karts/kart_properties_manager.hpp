@@ -64,6 +64,14 @@ private:
      *  all clients or not. */
     std::vector<bool>        m_kart_available;
 
+    /** Number of races started, used to find karts which were not used
+     *  recently, see useKarts(). */
+    unsigned int             m_race_count;
+
+    /** For each kart ident the value of m_race_count when the kart was last
+     *  used. */
+    std::map<std::string, unsigned int> m_last_used;
+
     std::unique_ptr<AbstractCharacteristic>                         m_base_characteristic;
     std::map<std::string, std::unique_ptr<AbstractCharacteristic> > m_difficulty_characteristics;
     std::map<std::string, std::unique_ptr<AbstractCharacteristic> > m_kart_type_characteristics;
@@ -87,7 +95,8 @@ public:
                                            int i) const;
 
     void                     loadCharacteristics    (const XMLNode *root);
-    bool                     loadKart               (const std::string &dir);
+    bool                     loadKart               (const std::string &dir,
+                                                     XMLNode *xml = NULL);
     void                     loadAllKarts           (bool loading_icon = true);
     void                     unloadAllKarts         ();
     void                     removeKart(const std::string &id);
@@ -101,6 +110,8 @@ public:
                                            RemoteKartInfoList* existing_karts,
                                            std::vector<std::string> *ai_list);
     void                     setHatMeshName(const std::string &hat_name);
+    void                     useKarts(const std::vector<std::string> &idents);
+    size_t                   getModelsMemory() const;
     // ------------------------------------------------------------------------
     /** Get the characteristic that holds the base values. */
     const AbstractCharacteristic* getBaseCharacteristic() const { return m_base_characteristic.get(); }
@@ -95,6 +95,7 @@ void KartRewinder::saveTransform()
 
     m_prev_steering = getSteerPercent();
     m_has_server_state = false;
+    m_predicted_state.reset();
 }   // saveTransform
 
 // ----------------------------------------------------------------------------
@@ -156,21 +157,18 @@ void KartRewinder::computeError()
 }   // computeError
 
 // ----------------------------------------------------------------------------
-/** Saves all state information for a kart in a memory buffer. The memory
- *  is allocated here and the address returned. It will then be managed
- *  by the RewindManager.
+/** Saves all state information for a kart in the state buffer.
+ *  \param buffer The buffer to append the state to.
  *  \param[out] ru The unique identity of rewinder writing to.
- *  \return The address of the memory buffer with the state.
+ *  \return False if the kart is eliminated and has no state.
  */
-BareNetworkString* KartRewinder::saveState(std::vector<std::string>* ru)
+bool KartRewinder::saveState(BareNetworkString *buffer,
+                             std::vector<std::string>* ru)
 {
     if (m_eliminated)
-        return nullptr;
+        return false;
 
     ru->push_back(getUniqueIdentity());
-    const int MEMSIZE = 17*sizeof(float) + 9+3;
-
-    BareNetworkString *buffer = new BareNetworkString(MEMSIZE);
 
     // 1) Steering and other player controls
     // -------------------------------------
@@ -263,17 +261,31 @@ BareNetworkString* KartRewinder::saveState(std::vector<std::string>* ru)
     // -----------
     m_skidding->saveState(buffer);
 
-    return buffer;
+    return true;
 }   // saveState
 
 // ----------------------------------------------------------------------------
 /** Actually rewind to the specified state. 
  *  \param buffer The buffer with the state info.
- *  \param count Number of bytes that must be used up in this function (not
- *         used).
+ *  \param count Number of bytes that must be used up in this function. If
+ *         0 the server left this kart out of the state, and the state this
+ *         client predicted is restored instead.
  */
 void KartRewinder::restoreState(BareNetworkString *buffer, int count)
 {
+    if (count == 0)
+    {
+        // The local state restore function saved the prediction at this
+        // time, it is missing if the local state was not found
+        std::shared_ptr<BareNetworkString> predicted = m_predicted_state;
+        if (predicted && predicted->getTotalSize() > 0)
+        {
+            predicted->reset();
+            restoreState(predicted.get(), predicted->size());
+        }
+        m_has_server_state = true;
+        return;
+    }
     m_has_server_state = true;
 
     // 1) Steering and other controls
@@ -479,10 +491,17 @@ std::function<void()> KartRewinder::getLocalStateRestoreFunction()
     // Skidding local state
     float remaining_jump_time = m_skidding->m_remaining_jump_time;
 
+    // The full state, in case that the server leaves this kart out
+    std::shared_ptr<BareNetworkString> predicted =
+        std::make_shared<BareNetworkString>();
+    std::vector<std::string> ru;
+    saveState(predicted.get(), &ru);
+
     return [brake_ticks, min_nitro_ticks,
         steer_val_l, steer_val_r, current_fraction,
-        max_speed_fraction, remaining_jump_time, this]()
+        max_speed_fraction, remaining_jump_time, predicted, this]()
     {
+        m_predicted_state = predicted;
         m_brake_ticks = brake_ticks;
         m_min_nitro_ticks = min_nitro_ticks;
         PlayerController* pc = dynamic_cast<PlayerController*>(m_controller);
@@ -23,6 +23,8 @@
 #include "network/rewinder.hpp"
 #include "utils/cpp2011.hpp"
 
+#include <memory>
+
 class AbstractKart;
 class BareNetworkString;
 
@@ -32,6 +34,11 @@ private:
     float m_prev_steering, m_steering_smoothing_dt, m_steering_smoothing_time;
 
     bool m_has_server_state;
+
+    /** The full state of this kart predicted by this client at the time
+     *  of the current rewind, restored if the server left this kart out of
+     *  its state (see StateRelevance). */
+    std::shared_ptr<BareNetworkString> m_predicted_state;
 public:
     KartRewinder(const std::string& ident, unsigned int world_kart_id,
                  int position, const btTransform& init_transform,
@@ -40,8 +47,8 @@ public:
     ~KartRewinder() {}
     virtual void saveTransform() OVERRIDE;
     virtual void computeError() OVERRIDE;
-    virtual BareNetworkString* saveState(std::vector<std::string>* ru)
-        OVERRIDE;
+    virtual bool saveState(BareNetworkString *buffer,
+                           std::vector<std::string>* ru) OVERRIDE;
     void reset() OVERRIDE;
     virtual void restoreState(BareNetworkString *p, int count) OVERRIDE;
     virtual void rewindToEvent(BareNetworkString *p) OVERRIDE {}
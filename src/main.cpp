@@ -161,6 +161,12 @@
 #  include <unistd.h>
 #endif
 
+#if !defined(WIN32) && !defined(ANDROID) && !defined(IOS_STK) && \
+    !defined(__SWITCH__)
+#  define SERVER_INSTANCES
+#  include <sys/wait.h>
+#endif
+
 #ifdef ANDROID
 #include <SDL_system.h>
 #include <jni.h>
@@ -230,6 +236,7 @@ extern "C" {
 #include "input/keyboard_device.hpp"
 #include "input/wiimote_manager.hpp"
 #include "io/file_manager.hpp"
+#include "io/file_saver.hpp"
 #include "items/attachment_manager.hpp"
 #include "items/item_manager.hpp"
 #include "items/network_item_manager.hpp"
@@ -247,9 +254,13 @@ extern "C" {
 #include "network/protocols/connect_to_server.hpp"
 #include "network/protocols/client_lobby.hpp"
 #include "network/protocols/server_lobby.hpp"
+#include "network/ip_range_index.hpp"
 #include "network/network.hpp"
+#include "network/network_capture.hpp"
 #include "network/network_config.hpp"
 #include "network/network_string.hpp"
+#include "network/network_string_pool.hpp"
+#include "network/protocol_manager.hpp"
 #include "network/protocols/connect_to_server.hpp"
 #include "network/protocols/client_lobby.hpp"
 #include "network/protocols/server_lobby.hpp"
@@ -264,12 +275,15 @@ extern "C" {
 #include "network/stk_peer.hpp"
 #include "online/profile_manager.hpp"
 #include "online/request_manager.hpp"
+#include "physics/stk_dynamics_world.hpp"
 #include "race/grand_prix_manager.hpp"
 #include "race/highscore_manager.hpp"
 #include "race/history.hpp"
 #include "race/race_manager.hpp"
+#include "replay/indexed_replay.hpp"
 #include "replay/replay_play.hpp"
 #include "replay/replay_recorder.hpp"
+#include "replay/replay_verifier.hpp"
 #include "states_screens/main_menu_screen.hpp"
 #include "states_screens/online/networking_lobby.hpp"
 #include "states_screens/online/register_screen.hpp"
@@ -290,11 +304,26 @@ extern "C" {
 #include "utils/profiler.hpp"
 #include "utils/stk_process.hpp"
 #include "utils/string_utils.hpp"
+#include "utils/thread_pool.hpp"
 #include "utils/translation.hpp"
 #include "io/rich_presence.hpp"
+#include "io/xml_node.hpp"
+#include "io/binary_file.hpp"
 
 static void cleanSuperTuxKart();
 static void cleanUserConfig();
+
+/** Number of server processes to start with --server-instances, or 0. */
+static int g_server_instances = 0;
+/** Index of this server process with --server-instances, or -1. */
+static int g_server_instance = -1;
+/** Files to convert with --convert-history and --convert-replay. */
+static std::string g_convert_history, g_convert_replay;
+/** Replay file or directory to check with --verify-replays. */
+static std::string g_verify_replays;
+
+/** Number of box stacks to simulate with --benchmark-physics. */
+static int g_benchmark_physics = 0;
 void runUnitTests();
 
 // ============================================================================
@@ -586,6 +615,11 @@ void cmdLineHelp()
     "       --trackdir=DIR     A directory from which additional tracks are "
                               "loaded.\n"
     "       --seed=n           Seed for random number generation to provide reproducible behavior.\n"
+    "       --worker-threads=n Number of worker threads for parallel game logic (e.g. AI),\n"
+    "                          0 to disable, -1 to use number of CPU cores minus one.\n"
+    "       --mt-physics       Solve independent physics islands on the worker threads.\n"
+    "       --benchmark-physics=n Compare the physics step time with islands solved\n"
+    "                          serially and in parallel, using n stacks of boxes.\n"
     "       --profile-laps=n   Enable automatic driven profile mode for n "
                               "laps.\n"
     "       --profile-time=n   Enable automatic driven profile mode for n "
@@ -605,9 +639,21 @@ void cmdLineHelp()
     "       --demo-laps=n      Number of laps to use in a demo.\n"
     "       --demo-karts=n     Number of karts to use in a demo.\n"
     "       --history          Replay history file 'history.dat'.\n"
+    "       --convert-history=in,out Convert a history file from text to binary\n"
+    "                          format or the other way round.\n"
+    "       --convert-replay=in,out Convert a replay file from text to binary\n"
+    "                          format or the other way round.\n"
+    "       --verify-replays=path Check a replay file or all replay files in a\n"
+    "                          directory for consistency, and print lap times.\n"
     "       --server-config=file Specify the server_config.xml for server hosting, it will create\n"
     "                            one if not found.\n"
+    "       --server-instances=n Start n servers (without graphics) sharing the loaded assets,\n"
+    "                          each on its own port with its own log file (not on Windows).\n"
     "       --network-console  Enable network console.\n"
+    "       --capture-network=file Record all events received by the server to file.\n"
+    "       --replay-network=file Replay the events captured in file to the server\n"
+    "                          (instead of real clients) as fast as possible, then exit.\n"
+    "       --replay-realtime  Replay captured events with their original timing.\n"
     "       --wan-server=name  Start a Wan server (not a playing client).\n"
     "       --public-server    Allow direct connection to the server (without stk server)\n"
     "       --lan-server=name  Start a LAN server (not a playing client).\n"
@@ -1000,6 +1046,11 @@ int handleCmdLinePreliminary()
         Log::info("main", "STK using random seed (%d)", n);
     }
 
+    if (CommandLine::has("--worker-threads", &n))
+        UserConfigParams::m_worker_threads = n;
+    if (CommandLine::has("--mt-physics"))
+        UserConfigParams::m_mt_physics = true;
+
     return 0;
 }   // handleCmdLinePreliminary
 
@@ -1271,6 +1322,18 @@ int handleCmdLine(bool has_server_config, bool has_parent_process)
         STKHost::m_enable_console = true;
     }
 
+    if (NetworkConfig::get()->isServer())
+    {
+        if (CommandLine::has("--capture-network", &STKHost::m_capture_file) &&
+            g_server_instance >= 0)
+        {
+            STKHost::m_capture_file +=
+                "-" + StringUtils::toString(g_server_instance + 1);
+        }
+        CommandLine::has("--replay-network", &STKHost::m_replay_file);
+        STKHost::m_replay_realtime = CommandLine::has("--replay-realtime");
+    }
+
     if (CommandLine::has("--disable-item-collection"))
         ItemManager::disableItemCollection();
 
@@ -1333,6 +1396,8 @@ int handleCmdLine(bool has_server_config, bool has_parent_process)
     }
     if (CommandLine::has("--server-id-file", &s))
     {
+        if (g_server_instance >= 0)
+            s += "-" + StringUtils::toString(g_server_instance + 1);
         NetworkConfig::get()->setServerIdFile(
             file_manager->getUserConfigFile(s));
         ServerConfig::m_server_configurable = true;
@@ -1363,6 +1428,13 @@ int handleCmdLine(bool has_server_config, bool has_parent_process)
         NetworkConfig::get()->setClientPort(n);
         ServerConfig::m_server_port = n;
     }
+    // Each server of --server-instances uses the next port, if none is given
+    // the port is changed anyway if it is already in use
+    if (g_server_instance > 0 && ServerConfig::m_server_port != 0)
+    {
+        ServerConfig::m_server_port =
+            ServerConfig::m_server_port + g_server_instance;
+    }
     if (CommandLine::has("--public-server"))
     {
         NetworkConfig::get()->setIsPublicServer();
@@ -1723,6 +1795,11 @@ int handleCmdLine(bool has_server_config, bool has_parent_process)
             UserConfigParams::m_no_start_screen = true;
     }   // --history
 
+    CommandLine::has("--convert-history", &g_convert_history);
+    CommandLine::has("--convert-replay", &g_convert_replay);
+    CommandLine::has("--verify-replays", &g_verify_replays);
+    CommandLine::has("--benchmark-physics", &g_benchmark_physics);
+
     // Demo mode
     if(CommandLine::has("--demo-mode", &s))
     {
@@ -1786,6 +1863,7 @@ int handleCmdLine(bool has_server_config, bool has_parent_process)
  */
 void initUserConfig()
 {
+    FileSaver::create();
     file_manager = new FileManager();
     user_config  = new UserConfig();     // needs file_manager
     user_config->loadConfig();
@@ -1915,12 +1993,17 @@ void initRest()
     // The rest will be read later (since the rest needs the unlock- and
     // achievement managers to be created, which can only be created later).
     PlayerManager::create();
-    Online::RequestManager::get()->startNetworkThread();
+    // Threads do not survive fork(), so with --server-instances they are
+    // only started in each server, see forkServerInstances()
+    if (g_server_instances == 0)
+        Online::RequestManager::get()->startNetworkThread();
 #ifndef SERVER_ONLY
     if (!GUIEngine::isNoGraphics())
         NewsManager::get();   // this will create the news manager
 #endif
 
+    if (g_server_instances == 0)
+        ThreadPool::create(UserConfigParams::m_worker_threads);
     music_manager = new MusicManager();
     SFXManager::create();
     // The order here can be important, e.g. KartPropertiesManager needs
@@ -2087,6 +2170,93 @@ void debugLoop()
 }
 #endif
 
+#ifdef SERVER_INSTANCES
+/** Pids of all servers started by forkServerInstances(). */
+static std::vector<pid_t> g_server_pids;
+
+// ----------------------------------------------------------------------------
+/** Starts the servers of --server-instances. All karts, tracks and other
+ *  assets are loaded once before, and then shared copy-on-write by the
+ *  forked servers, so only memory changed by a server (e.g. for its world)
+ *  is duplicated. The launching process only waits for the servers, and
+ *  passes SIGTERM on to them.
+ *  \return True in a forked server, false in the launching process once
+ *          all servers exited.
+ */
+static bool forkServerInstances()
+{
+    // Threads do not survive fork(), each process starts its own file saver
+    FileSaver::destroy();
+    for (int i = 0; i < g_server_instances; i++)
+    {
+        Log::flushBuffers();
+        pid_t pid = fork();
+        if (pid < 0)
+        {
+            Log::error("main", "Can not start server %d: %s", i + 1,
+                       strerror(errno));
+            break;
+        }
+        if (pid > 0)
+        {
+            g_server_pids.push_back(pid);
+            continue;
+        }
+
+        g_server_pids.clear();
+        g_server_instance = i;
+        // Each server gets its own log file
+        Log::closeOutputFiles();
+        FileManager::setStdoutName(StringUtils::removeExtension(
+            FileManager::getStdoutName()) + "-" +
+            StringUtils::toString(i + 1) + ".log");
+        file_manager->redirectOutput();
+        Log::info("main", "Server %d of %d, pid %d.", i + 1,
+                  g_server_instances, (int)getpid());
+        Online::RequestManager::get()->startNetworkThread();
+        ThreadPool::create(UserConfigParams::m_worker_threads);
+        FileSaver::create();
+        return true;
+    }
+    FileSaver::create();
+
+    Log::info("main", "Started %d servers.", (int)g_server_pids.size());
+    signal(SIGTERM, [](int signum)
+        {
+            for (pid_t pid : g_server_pids)
+                kill(pid, SIGTERM);
+        });
+    unsigned running = (unsigned)g_server_pids.size();
+    while (running > 0)
+    {
+        int status = 0;
+        pid_t pid = waitpid(-1, &status, 0);
+        if (pid < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        auto it = std::find(g_server_pids.begin(), g_server_pids.end(), pid);
+        if (it == g_server_pids.end())
+            continue;
+        running--;
+        if (WIFSIGNALED(status))
+        {
+            Log::warn("main", "Server %d was terminated by signal %d.",
+                      int(it - g_server_pids.begin()) + 1, WTERMSIG(status));
+        }
+        else
+        {
+            Log::info("main", "Server %d exited with status %d.",
+                      int(it - g_server_pids.begin()) + 1,
+                      WEXITSTATUS(status));
+        }
+    }
+    return false;
+}   // forkServerInstances
+#endif
+
 // ----------------------------------------------------------------------------
 #if defined(ANDROID)
 int android_main(int argc, char *argv[])
@@ -2243,6 +2413,25 @@ int main(int argc, char *argv[])
             ServerConfig::m_validating_player = false;
         }
 
+#ifdef SERVER_INSTANCES
+        int instances = 0;
+        if (CommandLine::has("--server-instances", &instances) &&
+            instances > 1)
+        {
+            if (NetworkConfig::get()->isServer() &&
+                GUIEngine::isNoGraphics())
+            {
+                g_server_instances = instances;
+                UserConfigParams::m_enable_sound = false;
+            }
+            else
+            {
+                Log::warn("main", "--server-instances is only supported "
+                    "for servers without graphics, ignored.");
+            }
+        }
+#endif
+
         if (!GUIEngine::isNoGraphics())
             profiler.init();
         // Create the story mode timer with empty setting first, it will
@@ -2321,6 +2510,14 @@ int main(int argc, char *argv[])
         GUIEngine::addLoadingIcon( irr_driver->getTexture(FileManager::GUI_ICON,
                                                           "banana.png")    );
 
+#ifdef SERVER_INSTANCES
+        if (g_server_instances > 0 && !forkServerInstances())
+        {
+            Log::flushBuffers();
+            exit(0);
+        }
+#endif
+
         //handleCmdLine() needs InitTuxkart() so it can't be called first
         if (!handleCmdLine(!server_config.empty(), has_parent_process))
             exit(0);
@@ -2358,6 +2555,31 @@ int main(int argc, char *argv[])
             exit(0);
         }
 
+        if (!g_convert_history.empty() || !g_convert_replay.empty())
+        {
+            bool is_history = !g_convert_history.empty();
+            std::vector<std::string> files = StringUtils::split(
+                is_history ? g_convert_history : g_convert_replay, ',');
+            bool ok = false;
+            if (files.size() != 2)
+                Log::error("main", "Use --convert-history=in,out or "
+                                   "--convert-replay=in,out.");
+            else if (is_history)
+                ok = history->convertFile(files[0], files[1]);
+            else
+                ok = ReplayPlay::convert(files[0], files[1]);
+            exit(ok ? 0 : 1);
+        }
+
+        if (!g_verify_replays.empty())
+            exit(ReplayVerifier::verify(g_verify_replays) ? 0 : 1);
+
+        if (g_benchmark_physics > 0)
+        {
+            STKDynamicsWorld::benchmark(g_benchmark_physics, 600);
+            exit(0);
+        }
+
 #ifndef SERVER_ONLY
         if (!GUIEngine::isNoGraphics())
         {
@@ -2737,6 +2959,7 @@ static void cleanSuperTuxKart()
 #endif
 
     ServersManager::deallocate();
+    ThreadPool::destroy();
     cleanUserConfig();
 
     StateManager::deallocate();
@@ -2758,6 +2981,8 @@ static void cleanUserConfig()
         user_config->saveConfig();
         delete user_config;
     }
+    // Write all files still waiting to be saved
+    FileSaver::destroy();
 
     if(irr_driver)              delete irr_driver;
 }   // cleanUserConfig
@@ -2767,16 +2992,32 @@ void runUnitTests()
 {
     Log::info("UnitTest", "Starting unit testing");
     Log::info("UnitTest", "=====================");
+    Log::info("UnitTest", "BinaryFile");
+    BinaryFile::unitTesting();
     Log::info("UnitTest", "MiniGLM");
     MiniGLM::unitTesting();
     Log::info("UnitTest", "GraphicsRestrictions");
     GraphicsRestrictions::unitTesting();
+    Log::info("UnitTest", "IPRangeIndex");
+    IPRangeIndex::unitTesting();
+    Log::info("UnitTest", "IndexedReplay");
+    IndexedReplay::unitTesting();
+    Log::info("UnitTest", "ReplayVerifier");
+    ReplayVerifier::unitTesting();
+    Log::info("UnitTest", "NetworkCapture");
+    NetworkCapture::unitTesting();
     Log::info("UnitTest", "NetworkString");
     NetworkString::unitTesting();
+    Log::info("UnitTest", "NetworkStringPool");
+    NetworkStringPool::unitTesting();
+    Log::info("UnitTest", "ProtocolManager event latency");
+    ProtocolManager::benchmarkEventLatency();
     Log::info("UnitTest", "SocketAddress");
     SocketAddress::unitTesting();
     Log::info("UnitTest", "StringUtils::versionToInt");
     StringUtils::unitTesting();
+    Log::info("UnitTest", "XMLNode");
+    XMLNode::unitTesting();
 
     Log::info("UnitTest", "Easter detection");
     // Test easter mode: in 2015 Easter is 5th of April - check with 0 days
@@ -35,6 +35,7 @@
 #include "guiengine/modaldialog.hpp"
 #include "guiengine/screen_keyboard.hpp"
 #include "input/input_manager.hpp"
+#include "io/file_saver.hpp"
 #include "modes/world.hpp"
 #include "modes/profile_world.hpp"
 #include "network/network_config.hpp"
@@ -145,6 +146,9 @@ extern "C" void pause_mainloop()
     // user_config saves the latest addon time
     if (addons_manager->hasNewAddons())
         user_config->saveConfig();
+    // The app can be killed in background, so write all files now
+    if (FileSaver::get())
+        FileSaver::get()->flush();
     Online::RequestManager::get()->setPaused(true);
     IrrlichtDevice* dev = irr_driver->getDevice();
     if (dev)
@@ -19,10 +19,12 @@
 #include "modes/profile_world.hpp"
 
 #include "main_loop.hpp"
+#include "config/user_config.hpp"
 #include "graphics/camera.hpp"
 #include "graphics/irr_driver.hpp"
 #include "karts/kart_with_stats.hpp"
 #include "karts/controller/controller.hpp"
+#include "physics/physics.hpp"
 #include "tracks/track.hpp"
 
 #include <ISceneManager.h>
@@ -204,6 +206,10 @@ void ProfileWorld::enterRaceOverState()
     float runtime = (irr_driver->getRealTime()-m_start_time)*0.001f;
     Log::verbose("profile", "Number of frames: %d time %f, Average FPS: %f",
                  m_frame_count, runtime, (float)m_frame_count/runtime);
+    Log::verbose("profile", "Average physics step: %f ms (%s solver)",
+                 Physics::get()->getAverageStepTime()*1000.0,
+                 UserConfigParams::m_mt_physics ? "multi-threaded"
+                                                : "single-threaded");
 
     // Print geometry statistics if we're not in no-graphics mode
     if(!GUIEngine::isNoGraphics())
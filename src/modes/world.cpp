@@ -74,6 +74,7 @@
 #include "states_screens/race_result_gui.hpp"
 #include "states_screens/state_manager.hpp"
 #include "tracks/check_manager.hpp"
+#include "tracks/terrain_info.hpp"
 #include "tracks/track.hpp"
 #include "tracks/track_manager.hpp"
 #include "tracks/track_object.hpp"
@@ -82,6 +83,7 @@
 #include "utils/profiler.hpp"
 #include "utils/translation.hpp"
 #include "utils/string_utils.hpp"
+#include "utils/thread_pool.hpp"
 
 #include <algorithm>
 #include <cassert>
@@ -144,6 +146,8 @@ World::World()
 
     m_race_gui           = NULL;
     m_saved_race_gui     = NULL;
+    m_ai_lod_counts[0]   = 0;
+    m_ai_lod_counts[1]   = 0;
     m_use_highscores     = true;
     m_schedule_pause     = false;
     m_schedule_unpause   = false;
@@ -1172,6 +1176,90 @@ void World::updateGraphics(float dt)
     Track::getCurrentTrack()->updateGraphics(dt);
 }   // updateGraphics
 
+//-----------------------------------------------------------------------------
+/** Lets all controllers (i.e. the AIs) of karts which will be updated in
+ *  this tick compute the read-only part of their decision in parallel on
+ *  the thread pool. The actual Kart::update (and so the controller update
+ *  which sets the kart controls) is then still done serially in kart order,
+ *  so the result does not depend on thread scheduling.
+ *  \param ticks Number of physics time steps - should be 1.
+ */
+void World::prepareControllers(int ticks)
+{
+    ThreadPool* tp = ThreadPool::get();
+    if (!tp || tp->getNumThreads() == 0)
+        return;
+
+    m_prepare_controllers.clear();
+    for (unsigned i = 0; i < m_karts.size(); i++)
+    {
+        Controller* c = m_karts[i]->getController();
+        SpareTireAI* sta = dynamic_cast<SpareTireAI*>(c);
+        // Same condition as used in update() to update a kart
+        if (m_karts[i]->isEliminated() && !(sta && sta->isMoving()))
+            continue;
+        if (c->canPrepareUpdate())
+            m_prepare_controllers.push_back(c);
+    }
+    // Nothing to gain from a single controller, it is then fully updated
+    // in its update() call
+    if (m_prepare_controllers.size() < 2)
+        return;
+    tp->parallelFor((unsigned)m_prepare_controllers.size(),
+        [this, ticks](unsigned i)
+        {
+            m_prepare_controllers[i]->prepareUpdate(ticks);
+        });
+}   // prepareControllers
+
+//-----------------------------------------------------------------------------
+/** Casts the terrain rays of all karts that are updated in this tick against
+ *  the track in one batch. Each kart then uses the result in its update if
+ *  its ray is still the same (see TerrainInfo::update).
+ */
+void World::prepareTerrainRays()
+{
+    const TriangleMesh *tm = Track::getCurrentTrack()->getPtrTriangleMesh();
+    if (!tm)
+        return;
+
+    m_terrain_ray_karts.clear();
+    m_terrain_ray_from.clear();
+    m_terrain_ray_to.clear();
+    for (unsigned i = 0; i < m_karts.size(); i++)
+    {
+        Kart* kart = dynamic_cast<Kart*>(m_karts[i].get());
+        if (!kart || dynamic_cast<GhostKart*>(kart))
+            continue;
+        SpareTireAI* sta = dynamic_cast<SpareTireAI*>(kart->getController());
+        // Same condition as used in update() to update a kart
+        if (kart->isEliminated() && !(sta && sta->isMoving()))
+            continue;
+        Vec3 from =
+            kart->getTerrainRayStart(kart->getKartAnimation() != NULL);
+        m_terrain_ray_karts.push_back(kart);
+        m_terrain_ray_from.push_back(from);
+        m_terrain_ray_to.push_back(
+            TerrainInfo::getRayEnd(kart->getTrans().getBasis(), from));
+    }
+    if (m_terrain_ray_karts.empty())
+        return;
+
+    std::vector<btVector3> from(m_terrain_ray_from.begin(),
+                                m_terrain_ray_from.end());
+    std::vector<btVector3> to(m_terrain_ray_to.begin(),
+                              m_terrain_ray_to.end());
+    m_terrain_ray_hits.resize(m_terrain_ray_karts.size());
+    tm->castRays((unsigned)from.size(), from.data(), to.data(),
+                 m_terrain_ray_hits.data(), /*interpolate*/true);
+    for (unsigned i = 0; i < m_terrain_ray_karts.size(); i++)
+    {
+        m_terrain_ray_karts[i]->setPreparedTerrainHit(m_terrain_ray_from[i],
+                                                      m_terrain_ray_to[i],
+                                                      m_terrain_ray_hits[i]);
+    }
+}   // prepareTerrainRays
+
 //-----------------------------------------------------------------------------
 /** Updates the physics, all karts, the track, and projectile manager.
  *  \param ticks Number of physics time steps - should be 1.
@@ -1205,11 +1293,20 @@ void World::update(int ticks)
     Track::getCurrentTrack()->getTrackObjectManager()->update(stk_config->ticks2Time(ticks));
     PROFILER_POP_CPU_MARKER();
 
+    PROFILER_PUSH_CPU_MARKER("World::update (AI prepare)", 0x40, 0x7F, 0x40);
+    prepareControllers(ticks);
+    PROFILER_POP_CPU_MARKER();
+
+    PROFILER_PUSH_CPU_MARKER("World::update (terrain rays)", 0x40, 0x7F, 0x20);
+    prepareTerrainRays();
+    PROFILER_POP_CPU_MARKER();
+
     PROFILER_PUSH_CPU_MARKER("World::update (Kart::upate)", 0x40, 0x7F, 0x00);
 
     // Update all the karts. This in turn will also update the controller,
     // which causes all AI steering commands set. So in the following
     // physics update the new steering is taken into account.
+    m_ai_lod_counts[0] = m_ai_lod_counts[1] = 0;
     const int kart_amount = (int)m_karts.size();
     for (int i = 0 ; i < kart_amount; ++i)
     {
@@ -1221,6 +1318,11 @@ void World::update(int ticks)
         if (isStartPhase())
             m_karts[i]->makeKartRest();
     }
+    if (UserConfigParams::m_ai_lod)
+    {
+        PROFILER_SET_COUNTER("AI LOD full", m_ai_lod_counts[0]);
+        PROFILER_SET_COUNTER("AI LOD reduced", m_ai_lod_counts[1]);
+    }
     PROFILER_POP_CPU_MARKER();
     if(RaceManager::get()->isRecordingRace()) ReplayRecorder::get()->update(ticks);
 
@@ -37,11 +37,13 @@
 
 #include "graphics/weather.hpp"
 #include "modes/world_status.hpp"
+#include "physics/triangle_mesh.hpp"
 #include "race/highscores.hpp"
 #include "states_screens/race_gui_base.hpp"
 #include "states_screens/state_manager.hpp"
 #include "utils/random_generator.hpp"
 #include "utils/stk_process.hpp"
+#include "utils/vec3.hpp"
 
 #include "LinearMath/btTransform.h"
 
@@ -50,6 +52,7 @@ class BareNetworkString;
 class btRigidBody;
 class Controller;
 class ItemState;
+class Kart;
 class PhysicalObject;
 class STKPeer;
 
@@ -188,12 +191,28 @@ protected:
 
     bool m_ended_early;
 
+    /** Controllers which are prepared in parallel in the current tick, kept
+     *  here to avoid allocations in each update. */
+    std::vector<Controller*> m_prepare_controllers;
+
+    /** Karts and terrain rays cast in prepareTerrainRays(). */
+    std::vector<Kart*>                m_terrain_ray_karts;
+    std::vector<Vec3>                 m_terrain_ray_from;
+    std::vector<Vec3>                 m_terrain_ray_to;
+    std::vector<TriangleMesh::RayHit> m_terrain_ray_hits;
+
+    /** Number of AI karts that used the full (index 0) and the reduced
+     *  (index 1) planning rate in the current tick, shown in the profiler. */
+    int m_ai_lod_counts[2];
+
     virtual void  onGo() OVERRIDE;
     /** Returns true if the race is over. Must be defined by all modes. */
     virtual bool  isRaceOver() = 0;
     virtual void  update(int ticks) OVERRIDE;
     virtual void  createRaceGUI();
             void  updateTrack(int ticks);
+            void  prepareControllers(int ticks);
+            void  prepareTerrainRays();
     // ------------------------------------------------------------------------
     /** Used for AI karts that are still racing when all player kart finished.
      *  Generally it should estimate the arrival time for those karts, but as
@@ -251,6 +270,10 @@ public:
     // ------------------------------------------------------------------------
     static void     clear() { memset(m_world, 0, sizeof(m_world)); }
     // ------------------------------------------------------------------------
+    /** Called by an AI in each update to count its planning rate. */
+    void            countAILod(bool reduced)
+                                         { m_ai_lod_counts[reduced ? 1 : 0]++; }
+    // ------------------------------------------------------------------------
 //    Scripting::NetworkEvents* getNetworkEvents();
     // ------------------------------------------------------------------------
 
@@ -21,6 +21,7 @@
 #include "network/crypto_mbedtls.hpp"
 #include "network/network_config.hpp"
 #include "network/network_string.hpp"
+#include "network/network_string_pool.hpp"
 
 #include <mbedtls/base64.h>
 #include <mbedtls/sha256.h>
@@ -150,7 +151,8 @@ ENetPacket* Crypto::encryptSend(BareNetworkString& ns, bool reliable)
 NetworkString* Crypto::decryptRecieve(ENetPacket* p)
 {
     int clen = (int)(p->dataLength - 8);
-    auto ns = std::unique_ptr<NetworkString>(new NetworkString(p->data, clen));
+    std::unique_ptr<NetworkString, NetworkStringPool::Release> ns(
+        NetworkStringPool::get()->getNetworkString(p->data, clen));
 
     std::array<uint8_t, 12> iv = {};
     if (NetworkConfig::get()->isClient())
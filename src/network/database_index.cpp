@@ -0,0 +1,526 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2024 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+
+#ifdef ENABLE_SQLITE3
+
+#include "network/database_index.hpp"
+
+#include "network/stk_ipv6.hpp"
+#include "utils/log.hpp"
+#include "utils/time.hpp"
+#include "utils/vs.hpp"
+
+#include <cstdlib>
+#include <map>
+#include <zlib.h>
+
+namespace
+{
+    /** How often (in ms) the database is checked for changes. */
+    const uint64_t CHECK_INTERVAL = 5000;
+
+    /** How often (in ms) the geolocation tables are checked for changes,
+     *  since counting their entries reads the whole table. */
+    const uint64_t GEOLOCATION_CHECK_INTERVAL = 600000;
+
+    /** Added to the upper 64 bits of IPv6 addresses in geolocation tables,
+     *  which are stored as signed integer, so that they sort the same as
+     *  unsigned keys. */
+    const uint64_t SIGN_BIT = 0x8000000000000000ULL;
+
+    // ------------------------------------------------------------------------
+    /** Returns the range of the upper 64 bits of all addresses inside an
+     *  IPv6 cidr. For prefixes longer than 64 bits the range contains more
+     *  addresses than the cidr, so matches must be checked with
+     *  insideIPv6CIDR.
+     */
+    bool getIPv6CIDRRange(const std::string& cidr, uint64_t* start,
+                          uint64_t* end)
+    {
+        size_t slash = cidr.find('/');
+        if (slash == std::string::npos)
+            return false;
+        int mask_length = atoi(cidr.c_str() + slash + 1);
+        if (mask_length > 128 || mask_length <= 0)
+            return false;
+        uint64_t upper = (uint64_t)upperIPv6(cidr.substr(0, slash).c_str());
+        if (mask_length >= 64)
+        {
+            *start = *end = upper;
+            return true;
+        }
+        uint64_t mask = ~0ULL << (64 - mask_length);
+        *start = upper & mask;
+        *end = *start | ~mask;
+        return true;
+    }   // getIPv6CIDRRange
+
+    // ------------------------------------------------------------------------
+    std::string getColumnText(sqlite3_stmt* stmt, int column)
+    {
+        const char* text = (const char*)sqlite3_column_text(stmt, column);
+        return text ? text : "";
+    }   // getColumnText
+
+    // ------------------------------------------------------------------------
+    int64_t getColumnTime(sqlite3_stmt* stmt, int column)
+    {
+        if (sqlite3_column_type(stmt, column) == SQLITE_NULL)
+            return -1;
+        return sqlite3_column_int64(stmt, column);
+    }   // getColumnTime
+}   // anonymous namespace
+
+// ----------------------------------------------------------------------------
+/** Loads all tables. Empty table names are tables which do not exist in the
+ *  database.
+ */
+DatabaseIndex::DatabaseIndex(sqlite3* db, const std::string& ip_ban_table,
+                             const std::string& ipv6_ban_table,
+                             const std::string& online_id_ban_table,
+                             const std::string& ip_geolocation_table,
+                             const std::string& ipv6_geolocation_table)
+             : m_db(db), m_ip_ban_table(ip_ban_table),
+               m_ipv6_ban_table(ipv6_ban_table),
+               m_online_id_ban_table(online_id_ban_table),
+               m_ip_geolocation_table(ip_geolocation_table),
+               m_ipv6_geolocation_table(ipv6_geolocation_table)
+{
+    m_loading.store(false);
+    m_reload.store(false);
+    m_data_version = getDataVersion();
+    m_last_check_time = StkTime::getMonoTimeMs();
+    m_last_geolocation_check_time = m_last_check_time;
+    m_geolocation_outdated = false;
+    // Loaded now, so that the first connecting players are checked
+    load(true/*geolocation*/);
+    m_changed.store(false);
+}   // DatabaseIndex
+
+// ----------------------------------------------------------------------------
+DatabaseIndex::~DatabaseIndex()
+{
+    if (m_loading_thread.joinable())
+        m_loading_thread.join();
+}   // ~DatabaseIndex
+
+// ----------------------------------------------------------------------------
+/** Returns the data_version of the database, which changes after each
+ *  commit of another connection, or -1 if an error occured. */
+int64_t DatabaseIndex::getDataVersion() const
+{
+    int64_t version = -1;
+    sqlite3_stmt* stmt = NULL;
+    if (sqlite3_prepare_v2(m_db, "PRAGMA data_version;", -1, &stmt, 0) ==
+        SQLITE_OK)
+    {
+        if (sqlite3_step(stmt) == SQLITE_ROW)
+            version = sqlite3_column_int64(stmt, 0);
+    }
+    else
+    {
+        Log::error("DatabaseIndex", "Error reading data version: %s",
+            sqlite3_errmsg(m_db));
+    }
+    sqlite3_finalize(stmt);
+    return version;
+}   // getDataVersion
+
+// ----------------------------------------------------------------------------
+/** Loads a ban table.
+ *  \param table Name of the table, empty if it does not exist.
+ *  \param type Which kind of ban the table contains.
+ *  \param old The table loaded the last time, if any, which is returned if
+ *         no entry changed.
+ */
+std::shared_ptr<const DatabaseIndex::BanList>
+    DatabaseIndex::loadBans(const std::string& table, BanType type,
+                            std::shared_ptr<const BanList> old) const
+{
+    if (table.empty())
+        return nullptr;
+
+    std::string columns = type == BT_IP   ? "ip_start, ip_end" :
+                          type == BT_IPV6 ? "ipv6_cidr" : "online_id";
+    int first = type == BT_IP ? 3 : 2;
+    // Not using insertValues, since it would replace the %s of strftime
+    std::string query = "SELECT rowid, " + columns + ", reason, "
+        "description, CAST(strftime('%s', starting_time) AS INTEGER), "
+        "CAST(strftime('%s', starting_time, '+'||expired_days||' days') "
+        "AS INTEGER), expired_days IS NULL FROM " + table + ";";
+
+    sqlite3_stmt* stmt = NULL;
+    if (sqlite3_prepare_v2(m_db, query.c_str(), -1, &stmt, 0) != SQLITE_OK)
+    {
+        Log::error("DatabaseIndex",
+            "Error preparing database for query %s: %s",
+            query.c_str(), sqlite3_errmsg(m_db));
+        return nullptr;
+    }
+
+    std::shared_ptr<BanList> bans = std::make_shared<BanList>();
+    // The trigger count and time are not loaded, so that the server
+    // updating them does not count as a change
+    uLong fingerprint = crc32(0L, Z_NULL, 0);
+    while (sqlite3_step(stmt) == SQLITE_ROW)
+    {
+        for (int i = 0; i < sqlite3_column_count(stmt); i++)
+        {
+            const unsigned char* text = sqlite3_column_text(stmt, i);
+            // Include the length, so that NULL and empty columns and
+            // moved separators give different checksums
+            int length = text ? sqlite3_column_bytes(stmt, i) : -1;
+            fingerprint = crc32(fingerprint, (const Bytef*)&length,
+                                sizeof(length));
+            if (text)
+                fingerprint = crc32(fingerprint, text, (uInt)length);
+        }
+        Ban ban;
+        ban.m_row_id        = sqlite3_column_int64(stmt, 0);
+        ban.m_ip_start      = 0;
+        ban.m_ip_end        = 0;
+        ban.m_online_id     = 0;
+        ban.m_reason        = getColumnText(stmt, first);
+        ban.m_description   = getColumnText(stmt, first + 1);
+        ban.m_starting_time = getColumnTime(stmt, first + 2);
+        ban.m_expired_time  = getColumnTime(stmt, first + 3);
+        // An invalid number of days is a ban which is never effective
+        if (ban.m_expired_time == -1 && !sqlite3_column_int(stmt, first + 4))
+            ban.m_starting_time = -1;
+
+        unsigned id = (unsigned)bans->m_bans.size();
+        if (type == BT_IP)
+        {
+            ban.m_ip_start = (uint32_t)sqlite3_column_int64(stmt, 1);
+            ban.m_ip_end   = (uint32_t)sqlite3_column_int64(stmt, 2);
+            bans->m_ranges.add(ban.m_ip_start, ban.m_ip_end, id);
+        }
+        else if (type == BT_IPV6)
+        {
+            ban.m_ipv6_cidr = getColumnText(stmt, 1);
+            uint64_t start, end;
+            if (!getIPv6CIDRRange(ban.m_ipv6_cidr, &start, &end))
+                continue;
+            bans->m_ranges.add(start, end, id);
+        }
+        else
+        {
+            ban.m_online_id = (uint32_t)sqlite3_column_int64(stmt, 1);
+            bans->m_online_ids[ban.m_online_id].push_back(id);
+        }
+        bans->m_bans.push_back(ban);
+    }
+    if (sqlite3_finalize(stmt) != SQLITE_OK)
+    {
+        Log::error("DatabaseIndex",
+            "Error finalize database for query %s: %s",
+            query.c_str(), sqlite3_errmsg(m_db));
+        return nullptr;
+    }
+    bans->m_fingerprint = (uint32_t)fingerprint;
+    if (old && old->m_fingerprint == bans->m_fingerprint &&
+        old->m_bans.size() == bans->m_bans.size())
+        return old;
+    bans->m_ranges.finalize();
+    return bans;
+}   // loadBans
+
+// ----------------------------------------------------------------------------
+/** Loads a geolocation table, unless it is the same as when it was loaded
+ *  the last time.
+ *  \param table Name of the table, empty if it does not exist.
+ *  \param ipv6 If the table contains IPv6 ranges.
+ *  \param old The table loaded the last time, if any.
+ */
+std::shared_ptr<const DatabaseIndex::Geolocation>
+    DatabaseIndex::loadGeolocation(const std::string& table, bool ipv6,
+                                   std::shared_ptr<const Geolocation> old)
+                                   const
+{
+    if (table.empty())
+        return nullptr;
+
+    std::string fingerprint;
+    int64_t count = 0;
+    std::string query = "SELECT COUNT(*), MAX(ip_start), MAX(ip_end) FROM " +
+        table + ";";
+    sqlite3_stmt* stmt = NULL;
+    if (sqlite3_prepare_v2(m_db, query.c_str(), -1, &stmt, 0) == SQLITE_OK &&
+        sqlite3_step(stmt) == SQLITE_ROW)
+    {
+        count = sqlite3_column_int64(stmt, 0);
+        fingerprint = getColumnText(stmt, 0) + " " +
+            getColumnText(stmt, 1) + " " + getColumnText(stmt, 2);
+    }
+    sqlite3_finalize(stmt);
+    if (old && !fingerprint.empty() && old->m_fingerprint == fingerprint)
+        return old;
+
+    query = "SELECT ip_start, ip_end, country_code FROM " + table + ";";
+    if (sqlite3_prepare_v2(m_db, query.c_str(), -1, &stmt, 0) != SQLITE_OK)
+    {
+        Log::error("DatabaseIndex",
+            "Error preparing database for query %s: %s",
+            query.c_str(), sqlite3_errmsg(m_db));
+        return old;
+    }
+
+    std::shared_ptr<Geolocation> geolocation =
+        std::make_shared<Geolocation>();
+    geolocation->m_fingerprint = fingerprint;
+    std::map<std::string, unsigned> country_ids;
+    while (sqlite3_step(stmt) == SQLITE_ROW)
+    {
+        uint64_t start = (uint64_t)sqlite3_column_int64(stmt, 0);
+        uint64_t end = (uint64_t)sqlite3_column_int64(stmt, 1);
+        if (ipv6)
+        {
+            start ^= SIGN_BIT;
+            end ^= SIGN_BIT;
+        }
+        std::string country_code = getColumnText(stmt, 2);
+        auto it = country_ids.find(country_code);
+        if (it == country_ids.end())
+        {
+            it = country_ids.emplace(country_code,
+                (unsigned)geolocation->m_country_codes.size()).first;
+            geolocation->m_country_codes.push_back(country_code);
+        }
+        geolocation->m_ranges.add(start, end, it->second);
+    }
+    if (sqlite3_finalize(stmt) != SQLITE_OK)
+    {
+        Log::error("DatabaseIndex",
+            "Error finalize database for query %s: %s",
+            query.c_str(), sqlite3_errmsg(m_db));
+        return old;
+    }
+    geolocation->m_ranges.finalize();
+    Log::info("DatabaseIndex", "Loaded %d ranges of %s.", (int)count,
+        table.c_str());
+    return geolocation;
+}   // loadGeolocation
+
+// ----------------------------------------------------------------------------
+/** Loads all tables which changed, and replaces the ones currently used.
+ *  \param geolocation If the geolocation tables should be checked too.
+ */
+void DatabaseIndex::load(bool geolocation)
+{
+    std::shared_ptr<const BanList> old_ip_bans, old_ipv6_bans,
+        old_online_id_bans;
+    std::shared_ptr<const Geolocation> ip_geolocation, ipv6_geolocation;
+    {
+        std::lock_guard<std::mutex> lock(m_tables_mutex);
+        old_ip_bans = m_ip_bans;
+        old_ipv6_bans = m_ipv6_bans;
+        old_online_id_bans = m_online_id_bans;
+        ip_geolocation = m_ip_geolocation;
+        ipv6_geolocation = m_ipv6_geolocation;
+    }
+    std::shared_ptr<const BanList> ip_bans =
+        loadBans(m_ip_ban_table, BT_IP, old_ip_bans);
+    std::shared_ptr<const BanList> ipv6_bans =
+        loadBans(m_ipv6_ban_table, BT_IPV6, old_ipv6_bans);
+    std::shared_ptr<const BanList> online_id_bans =
+        loadBans(m_online_id_ban_table, BT_ONLINE_ID, old_online_id_bans);
+    if (geolocation)
+    {
+        ip_geolocation = loadGeolocation(m_ip_geolocation_table,
+            false/*ipv6*/, ip_geolocation);
+        ipv6_geolocation = loadGeolocation(m_ipv6_geolocation_table,
+            true/*ipv6*/, ipv6_geolocation);
+    }
+
+    std::lock_guard<std::mutex> lock(m_tables_mutex);
+    m_ip_bans = ip_bans;
+    m_ipv6_bans = ipv6_bans;
+    m_online_id_bans = online_id_bans;
+    m_ip_geolocation = ip_geolocation;
+    m_ipv6_geolocation = ipv6_geolocation;
+    if (ip_bans != old_ip_bans || ipv6_bans != old_ipv6_bans ||
+        online_id_bans != old_online_id_bans)
+        m_changed.store(true);
+}   // load
+
+// ----------------------------------------------------------------------------
+/** Called regularly by the server to check if the database was changed, in
+ *  which case the tables are checked again in a separate thread. Each
+ *  commit of the database worker of this server changes the database too,
+ *  so this happens often while players join or leave; the ban tables are
+ *  small and only replaced if they changed, the geolocation tables are
+ *  only checked every GEOLOCATION_CHECK_INTERVAL.
+ */
+void DatabaseIndex::update()
+{
+    if (m_loading.load())
+        return;
+    if (m_loading_thread.joinable())
+        m_loading_thread.join();
+
+    bool reload = m_reload.exchange(false);
+    uint64_t now = StkTime::getMonoTimeMs();
+    if (!reload && now < m_last_check_time + CHECK_INTERVAL)
+        return;
+    m_last_check_time = now;
+    int64_t version = getDataVersion();
+    if (version != m_data_version)
+    {
+        m_data_version = version;
+        m_geolocation_outdated = true;
+        reload = true;
+    }
+    bool geolocation = m_geolocation_outdated &&
+        now >= m_last_geolocation_check_time + GEOLOCATION_CHECK_INTERVAL;
+    if (!reload && !geolocation)
+        return;
+
+    if (geolocation)
+    {
+        m_geolocation_outdated = false;
+        m_last_geolocation_check_time = now;
+    }
+    m_loading.store(true);
+    m_loading_thread = std::thread([this, geolocation]()
+        {
+            VS::setThreadName("DatabaseIndex");
+            load(geolocation);
+            m_loading.store(false);
+        });
+}   // update
+
+// ----------------------------------------------------------------------------
+/** Finds an effective ban of an IPv4 address.
+ *  \param ip The address.
+ *  \param[out] ban The ban found.
+ *  \return True if the address is banned.
+ */
+bool DatabaseIndex::findIPBan(uint32_t ip, Ban* ban) const
+{
+    std::shared_ptr<const BanList> bans;
+    {
+        std::lock_guard<std::mutex> lock(m_tables_mutex);
+        bans = m_ip_bans;
+    }
+    if (!bans)
+        return false;
+    int64_t now = (int64_t)StkTime::getTimeSinceEpoch();
+    int id = bans->m_ranges.find(ip, [&bans, now](unsigned i)
+        {
+            return bans->m_bans[i].isActive(now);
+        });
+    if (id == -1)
+        return false;
+    *ban = bans->m_bans[id];
+    return true;
+}   // findIPBan
+
+// ----------------------------------------------------------------------------
+/** Finds an effective ban of an IPv6 address.
+ *  \param ipv6 The address as string (without port).
+ *  \param[out] ban The ban found.
+ *  \return True if the address is banned.
+ */
+bool DatabaseIndex::findIPv6Ban(const std::string& ipv6, Ban* ban) const
+{
+    std::shared_ptr<const BanList> bans;
+    {
+        std::lock_guard<std::mutex> lock(m_tables_mutex);
+        bans = m_ipv6_bans;
+    }
+    if (!bans)
+        return false;
+    int64_t now = (int64_t)StkTime::getTimeSinceEpoch();
+    uint64_t upper = (uint64_t)upperIPv6(ipv6.c_str());
+    int id = bans->m_ranges.find(upper, [&bans, &ipv6, now](unsigned i)
+        {
+            const Ban& b = bans->m_bans[i];
+            return b.isActive(now) &&
+                insideIPv6CIDR(b.m_ipv6_cidr.c_str(), ipv6.c_str()) == 1;
+        });
+    if (id == -1)
+        return false;
+    *ban = bans->m_bans[id];
+    return true;
+}   // findIPv6Ban
+
+// ----------------------------------------------------------------------------
+/** Finds an effective ban of an online id.
+ *  \param online_id The online id.
+ *  \param[out] ban The ban found.
+ *  \return True if the online id is banned.
+ */
+bool DatabaseIndex::findOnlineIdBan(uint32_t online_id, Ban* ban) const
+{
+    std::shared_ptr<const BanList> bans;
+    {
+        std::lock_guard<std::mutex> lock(m_tables_mutex);
+        bans = m_online_id_bans;
+    }
+    if (!bans)
+        return false;
+    auto it = bans->m_online_ids.find(online_id);
+    if (it == bans->m_online_ids.end())
+        return false;
+    const int64_t now = (int64_t)StkTime::getTimeSinceEpoch();
+    for (unsigned id : it->second)
+    {
+        if (bans->m_bans[id].isActive(now))
+        {
+            *ban = bans->m_bans[id];
+            return true;
+        }
+    }
+    return false;
+}   // findOnlineIdBan
+
+// ----------------------------------------------------------------------------
+/** Returns the country code of an IPv4 address, or an empty string if it is
+ *  unknown. */
+std::string DatabaseIndex::ip2Country(uint32_t ip) const
+{
+    std::shared_ptr<const Geolocation> geolocation;
+    {
+        std::lock_guard<std::mutex> lock(m_tables_mutex);
+        geolocation = m_ip_geolocation;
+    }
+    if (!geolocation)
+        return "";
+    int id = geolocation->m_ranges.find(ip);
+    return id == -1 ? "" : geolocation->m_country_codes[id];
+}   // ip2Country
+
+// ----------------------------------------------------------------------------
+/** Returns the country code of an IPv6 address (given as string without
+ *  port), or an empty string if it is unknown. */
+std::string DatabaseIndex::ipv62Country(const std::string& ipv6) const
+{
+    std::shared_ptr<const Geolocation> geolocation;
+    {
+        std::lock_guard<std::mutex> lock(m_tables_mutex);
+        geolocation = m_ipv6_geolocation;
+    }
+    if (!geolocation)
+        return "";
+    uint64_t key = (uint64_t)upperIPv6(ipv6.c_str()) ^ SIGN_BIT;
+    int id = geolocation->m_ranges.find(key);
+    return id == -1 ? "" : geolocation->m_country_codes[id];
+}   // ipv62Country
+
+#endif
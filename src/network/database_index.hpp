@@ -0,0 +1,200 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2024 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+
+#ifndef HEADER_DATABASE_INDEX_HPP
+#define HEADER_DATABASE_INDEX_HPP
+
+#ifdef ENABLE_SQLITE3
+
+#include "network/ip_range_index.hpp"
+#include "utils/no_copy.hpp"
+
+#include <sqlite3.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/** Keeps the ban and IP geolocation tables of the server database in
+ *  memory, so that connecting players can be checked without any database
+ *  query. The tables are loaded when the server starts, and later checked
+ *  again in a separate thread whenever the database was changed by another
+ *  connection (e.g. by the server admin adding a ban, another server
+ *  sharing the tables, or the \ref DatabaseWorker of this server). The old
+ *  tables are used until the new ones are loaded. Since most changes are
+ *  statistics written by the database worker, a ban table only replaces
+ *  the old one if the columns used for the bans changed. Geolocation tables
+ *  are big and rarely change, so they are checked at most every few
+ *  minutes, and only loaded again if their number of entries or their last
+ *  entry changed.
+ * \ingroup network
+ */
+class DatabaseIndex : public NoCopy
+{
+public:
+    /** An entry of one of the ban tables. */
+    struct Ban
+    {
+        int64_t     m_row_id;
+        /** Seconds since epoch from which the ban is effective, or -1 if
+         *  the starting time is invalid (then the ban is never effective). */
+        int64_t     m_starting_time;
+        /** Seconds since epoch when the ban expires, or -1 if never. */
+        int64_t     m_expired_time;
+        std::string m_reason;
+        std::string m_description;
+        /** The ip range, IPv6 cidr or online id of the ban, as used to
+         *  update the trigger count in the table. */
+        uint32_t    m_ip_start;
+        uint32_t    m_ip_end;
+        std::string m_ipv6_cidr;
+        uint32_t    m_online_id;
+        // --------------------------------------------------------------------
+        bool isActive(int64_t now) const
+        {
+            return m_starting_time >= 0 && now > m_starting_time &&
+                (m_expired_time == -1 || m_expired_time > now);
+        }
+    };
+
+private:
+    enum BanType { BT_IP, BT_IPV6, BT_ONLINE_ID };
+
+    /** All entries of a ban table. */
+    struct BanList
+    {
+        std::vector<Ban> m_bans;
+        /** Index of the IPv4 or IPv6 ranges of m_bans. */
+        IPRangeIndex     m_ranges;
+        /** Index of m_bans by online id, an online id can have several bans
+         *  (e.g. an expired one and an effective one), in table order. */
+        std::unordered_map<uint32_t, std::vector<unsigned> > m_online_ids;
+        /** Checksum of the loaded columns of all entries, to detect
+         *  changes. */
+        uint32_t         m_fingerprint;
+    };
+
+    /** All entries of a geolocation table. */
+    struct Geolocation
+    {
+        /** All different country codes, the ranges use the index. */
+        std::vector<std::string> m_country_codes;
+        IPRangeIndex             m_ranges;
+        /** Number of entries and last entry, to detect changes. */
+        std::string              m_fingerprint;
+    };
+
+    sqlite3* m_db;
+
+    /** Table names, empty if the table is not used. */
+    std::string m_ip_ban_table;
+    std::string m_ipv6_ban_table;
+    std::string m_online_id_ban_table;
+    std::string m_ip_geolocation_table;
+    std::string m_ipv6_geolocation_table;
+
+    /** Protects the tables below, which are replaced after loading. */
+    mutable std::mutex m_tables_mutex;
+
+    std::shared_ptr<const BanList> m_ip_bans;
+    std::shared_ptr<const BanList> m_ipv6_bans;
+    std::shared_ptr<const BanList> m_online_id_bans;
+    std::shared_ptr<const Geolocation> m_ip_geolocation;
+    std::shared_ptr<const Geolocation> m_ipv6_geolocation;
+
+    /** The thread loading the tables again. */
+    std::thread m_loading_thread;
+
+    /** True while m_loading_thread is running. */
+    std::atomic_bool m_loading;
+
+    /** Set each time a ban table changed, see hasChanged(). */
+    std::atomic_bool m_changed;
+
+    /** Value of sqlite's data_version when the tables were last loaded,
+     *  which changes with each commit of another database connection. */
+    int64_t m_data_version;
+
+    /** Time when data_version was last checked. */
+    uint64_t m_last_check_time;
+
+    /** Time when the geolocation tables were last checked. */
+    uint64_t m_last_geolocation_check_time;
+
+    /** True if the database changed since the geolocation tables were last
+     *  checked. */
+    bool m_geolocation_outdated;
+
+    /** Set if the ban tables should be checked even if no other connection
+     *  changed the database, see requestReload(). */
+    std::atomic_bool m_reload;
+
+    // ------------------------------------------------------------------------
+    int64_t getDataVersion() const;
+    // ------------------------------------------------------------------------
+    std::shared_ptr<const BanList>
+        loadBans(const std::string& table, BanType type,
+                 std::shared_ptr<const BanList> old) const;
+    // ------------------------------------------------------------------------
+    std::shared_ptr<const Geolocation>
+        loadGeolocation(const std::string& table, bool ipv6,
+                        std::shared_ptr<const Geolocation> old) const;
+    // ------------------------------------------------------------------------
+    void load(bool geolocation);
+
+public:
+    // ------------------------------------------------------------------------
+    DatabaseIndex(sqlite3* db, const std::string& ip_ban_table,
+                  const std::string& ipv6_ban_table,
+                  const std::string& online_id_ban_table,
+                  const std::string& ip_geolocation_table,
+                  const std::string& ipv6_geolocation_table);
+    // ------------------------------------------------------------------------
+    ~DatabaseIndex();
+    // ------------------------------------------------------------------------
+    void update();
+    // ------------------------------------------------------------------------
+    /** Checks the ban tables with the next update() instead of waiting until
+     *  the change of data_version is noticed, used after the server itself
+     *  changed a ban table. Can be called from any thread. */
+    void requestReload()                             { m_reload.store(true); }
+    // ------------------------------------------------------------------------
+    /** Returns true once after a ban table changed, so that the caller can
+     *  check all connected players against the new bans. */
+    bool hasChanged()                       { return m_changed.exchange(false); }
+    // ------------------------------------------------------------------------
+    bool findIPBan(uint32_t ip, Ban* ban) const;
+    // ------------------------------------------------------------------------
+    bool findIPv6Ban(const std::string& ipv6, Ban* ban) const;
+    // ------------------------------------------------------------------------
+    bool findOnlineIdBan(uint32_t online_id, Ban* ban) const;
+    // ------------------------------------------------------------------------
+    std::string ip2Country(uint32_t ip) const;
+    // ------------------------------------------------------------------------
+    std::string ipv62Country(const std::string& ipv6) const;
+};   // DatabaseIndex
+
+#endif
+
+#endif
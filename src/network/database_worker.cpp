@@ -0,0 +1,273 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2024 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+
+#ifdef ENABLE_SQLITE3
+
+#include "network/database_worker.hpp"
+
+#include "utils/log.hpp"
+#include "utils/time.hpp"
+#include "utils/vs.hpp"
+
+#include <vector>
+
+namespace
+{
+    /** Maximum number of waiting queries. */
+    const unsigned MAX_QUEUE_SIZE = 4096;
+
+    /** Maximum number of queries run in one transaction. */
+    const unsigned MAX_BATCH_SIZE = 256;
+}   // anonymous namespace
+
+// ----------------------------------------------------------------------------
+/** Creates the worker thread.
+ *  \param db The connection used by the worker, which is closed by the
+ *         worker. It should not be used by any other thread.
+ */
+DatabaseWorker::DatabaseWorker(sqlite3* db) : m_db(db), m_exit(false)
+{
+    m_latency_count.store(0);
+    m_latency_total.store(0);
+    m_latency_max.store(0);
+    m_max_queue_size.store(0);
+    m_dropped_count.store(0);
+    m_thread = std::thread(std::bind(&DatabaseWorker::mainLoop, this));
+}   // DatabaseWorker
+
+// ----------------------------------------------------------------------------
+/** Runs all queries still waiting, and closes the connection of the worker
+ *  before returning. */
+DatabaseWorker::~DatabaseWorker()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_jobs_mutex);
+        m_exit = true;
+    }
+    m_jobs_cv.notify_one();
+    m_thread.join();
+    for (auto& statement : m_statements)
+        sqlite3_finalize(statement.second);
+    sqlite3_close(m_db);
+}   // ~DatabaseWorker
+
+// ----------------------------------------------------------------------------
+/** Adds a query to be run in the worker thread. If too many queries are
+ *  waiting already, the query is dropped and done_function is called with
+ *  false in the calling thread, or, if it can not be dropped, this waits
+ *  until the worker took queries from the queue.
+ *  \param query The query.
+ *  \param bind_function Binds the values of the query, can be empty.
+ *  \param cache If the prepared statement should be kept for the next time
+ *         the same query is added, in which case all values must be bound
+ *         instead of being part of the query.
+ *  \param done_function Called in the worker thread with true if the query
+ *         succeeded, can be empty.
+ *  \param can_drop False for queries which must not be lost, e.g. bans.
+ */
+void DatabaseWorker::addQuery(const std::string& query,
+                              std::function<void(sqlite3_stmt*)> bind_function,
+                              bool cache,
+                              std::function<void(bool)> done_function,
+                              bool can_drop)
+{
+    Job job;
+    job.m_query = query;
+    job.m_bind_function = bind_function;
+    job.m_done_function = done_function;
+    job.m_cache = cache;
+    job.m_queued_time = StkTime::getMonoTimeUs();
+
+    std::unique_lock<std::mutex> lock(m_jobs_mutex);
+    if (!can_drop)
+    {
+        m_space_cv.wait(lock, [this]()
+            {
+                return m_jobs.size() < MAX_QUEUE_SIZE;
+            });
+    }
+    else if (m_jobs.size() >= MAX_QUEUE_SIZE)
+    {
+        lock.unlock();
+        // Only log the first dropped query, until the statistics are shown
+        if (m_dropped_count.fetch_add(1) == 0)
+        {
+            Log::warn("DatabaseWorker", "Too many waiting queries, "
+                "dropping %s", query.c_str());
+        }
+        if (done_function)
+            done_function(false);
+        return;
+    }
+    m_jobs.push_back(std::move(job));
+    unsigned size = (unsigned)m_jobs.size();
+    lock.unlock();
+    m_jobs_cv.notify_one();
+
+    unsigned max = m_max_queue_size.load();
+    while (size > max &&
+           !m_max_queue_size.compare_exchange_weak(max, size)) {}
+}   // addQuery
+
+// ----------------------------------------------------------------------------
+/** Returns the number of queries waiting to be run. */
+unsigned DatabaseWorker::getQueueSize()
+{
+    std::lock_guard<std::mutex> lock(m_jobs_mutex);
+    return (unsigned)m_jobs.size();
+}   // getQueueSize
+
+// ----------------------------------------------------------------------------
+/** Returns the statistics of the worker.
+ *  \param[out] count Number of queries run.
+ *  \param[out] average_ms Average time from adding a query until it was
+ *              committed, in milliseconds.
+ *  \param[out] max_ms Maximum of that time.
+ *  \param[out] max_queue_size Biggest number of waiting queries.
+ *  \param[out] dropped_count Number of queries dropped because too many
+ *              queries were waiting.
+ *  \param reset If the statistics should be reset afterwards.
+ */
+void DatabaseWorker::getStatistics(uint64_t* count, float* average_ms,
+                                   float* max_ms, unsigned* max_queue_size,
+                                   unsigned* dropped_count, bool reset)
+{
+    *count = reset ? m_latency_count.exchange(0) : m_latency_count.load();
+    uint64_t total = reset ? m_latency_total.exchange(0)
+                           : m_latency_total.load();
+    uint64_t max = reset ? m_latency_max.exchange(0) : m_latency_max.load();
+    *average_ms = *count > 0 ? (float)total / (float)*count / 1000.0f : 0.0f;
+    *max_ms = (float)max / 1000.0f;
+    *max_queue_size = reset ? m_max_queue_size.exchange(0)
+                            : m_max_queue_size.load();
+    *dropped_count = reset ? m_dropped_count.exchange(0)
+                           : m_dropped_count.load();
+}   // getStatistics
+
+// ----------------------------------------------------------------------------
+/** Runs a query without result. */
+bool DatabaseWorker::exec(const char* query)
+{
+    if (sqlite3_exec(m_db, query, NULL, NULL, NULL) != SQLITE_OK)
+    {
+        Log::error("DatabaseWorker", "Error running %s: %s", query,
+            sqlite3_errmsg(m_db));
+        return false;
+    }
+    return true;
+}   // exec
+
+// ----------------------------------------------------------------------------
+/** Runs one query.
+ *  \return True if no error occured.
+ */
+bool DatabaseWorker::run(const Job& job)
+{
+    sqlite3_stmt* stmt = NULL;
+    if (job.m_cache)
+    {
+        auto it = m_statements.find(job.m_query);
+        if (it != m_statements.end())
+            stmt = it->second;
+    }
+    if (!stmt &&
+        sqlite3_prepare_v2(m_db, job.m_query.c_str(), -1, &stmt, 0) !=
+        SQLITE_OK)
+    {
+        Log::error("DatabaseWorker",
+            "Error preparing database for query %s: %s",
+            job.m_query.c_str(), sqlite3_errmsg(m_db));
+        sqlite3_finalize(stmt);
+        return false;
+    }
+    if (job.m_bind_function)
+        job.m_bind_function(stmt);
+    int ret = sqlite3_step(stmt);
+    bool ok = ret == SQLITE_DONE || ret == SQLITE_ROW;
+    if (!ok)
+    {
+        Log::error("DatabaseWorker", "Error running query %s: %s",
+            job.m_query.c_str(), sqlite3_errmsg(m_db));
+    }
+    if (job.m_cache)
+    {
+        sqlite3_reset(stmt);
+        sqlite3_clear_bindings(stmt);
+        m_statements[job.m_query] = stmt;
+    }
+    else
+        sqlite3_finalize(stmt);
+    return ok;
+}   // run
+
+// ----------------------------------------------------------------------------
+/** Runs all waiting queries (in batches of up to MAX_BATCH_SIZE queries in
+ *  one transaction) until the worker is destroyed. */
+void DatabaseWorker::mainLoop()
+{
+    VS::setThreadName("DatabaseWorker");
+    std::vector<Job> jobs;
+    std::vector<bool> results;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_jobs_mutex);
+            m_jobs_cv.wait(lock, [this]()
+                {
+                    return m_exit || !m_jobs.empty();
+                });
+            if (m_jobs.empty())
+                return;
+            while (!m_jobs.empty() && jobs.size() < MAX_BATCH_SIZE)
+            {
+                jobs.push_back(std::move(m_jobs.front()));
+                m_jobs.pop_front();
+            }
+        }
+        m_space_cv.notify_all();
+
+        // A single query does not need a transaction, and if the
+        // transaction can not be started each query runs on its own
+        bool transaction = jobs.size() > 1 && exec("BEGIN;");
+        results.clear();
+        for (const Job& job : jobs)
+            results.push_back(run(job));
+        if (transaction && !exec("COMMIT;"))
+        {
+            exec("ROLLBACK;");
+            results.assign(jobs.size(), false);
+        }
+
+        uint64_t now = StkTime::getMonoTimeUs();
+        for (unsigned i = 0; i < jobs.size(); i++)
+        {
+            uint64_t latency = now - jobs[i].m_queued_time;
+            m_latency_count.fetch_add(1);
+            m_latency_total.fetch_add(latency);
+            uint64_t max = m_latency_max.load();
+            while (latency > max &&
+                   !m_latency_max.compare_exchange_weak(max, latency)) {}
+            if (jobs[i].m_done_function)
+                jobs[i].m_done_function(results[i]);
+        }
+        jobs.clear();
+    }
+}   // mainLoop
+
+#endif
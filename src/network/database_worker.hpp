@@ -0,0 +1,126 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2024 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+
+#ifndef HEADER_DATABASE_WORKER_HPP
+#define HEADER_DATABASE_WORKER_HPP
+
+#ifdef ENABLE_SQLITE3
+
+#include "utils/no_copy.hpp"
+
+#include <sqlite3.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <thread>
+
+/** Runs the writes of the server to its database in a separate thread, so
+ *  that slow disks (or a database on network storage) do not stall the
+ *  server, e.g. when all players disconnect at once at the end of a race.
+ *  Queries are run in the order they were added, and all queries waiting
+ *  at the same time are run in one transaction. The queue is bounded: if it
+ *  is full, new queries are dropped (and logged) instead of stalling the
+ *  server, except for queries which must not be lost (e.g. bans), for which
+ *  adding waits until the worker has caught up. The worker has its own database connection, so its transactions
+ *  only contain its own queries.
+ * \ingroup network
+ */
+class DatabaseWorker : public NoCopy
+{
+private:
+    /** A queued query. */
+    struct Job
+    {
+        std::string m_query;
+        /** Binds the values of the query, can be empty. */
+        std::function<void(sqlite3_stmt*)> m_bind_function;
+        /** Called (in the worker thread) with the result, can be empty. */
+        std::function<void(bool)> m_done_function;
+        /** True if the prepared statement should be kept for reuse. */
+        bool m_cache;
+        /** Time in microseconds when the query was added. */
+        uint64_t m_queued_time;
+    };
+
+    /** The connection of the worker, closed when the worker is destroyed. */
+    sqlite3* m_db;
+
+    std::thread m_thread;
+
+    /** Protects m_jobs and m_exit. */
+    std::mutex m_jobs_mutex;
+
+    /** Signalled when a job is added or the worker should exit. */
+    std::condition_variable m_jobs_cv;
+
+    /** Signalled when the worker took jobs from the queue. */
+    std::condition_variable m_space_cv;
+
+    std::deque<Job> m_jobs;
+
+    bool m_exit;
+
+    /** Prepared statements of cached queries, only used by the worker. */
+    std::map<std::string, sqlite3_stmt*> m_statements;
+
+    /** Statistics of the time from adding a query to it being committed,
+     *  in microseconds, see getStatistics(). */
+    std::atomic<uint64_t> m_latency_count, m_latency_total, m_latency_max;
+
+    /** Biggest number of waiting queries, see getStatistics(). */
+    std::atomic<unsigned> m_max_queue_size;
+
+    /** Number of queries dropped because the queue was full. */
+    std::atomic<unsigned> m_dropped_count;
+
+    // ------------------------------------------------------------------------
+    void mainLoop();
+    // ------------------------------------------------------------------------
+    bool run(const Job& job);
+    // ------------------------------------------------------------------------
+    bool exec(const char* query);
+
+public:
+    // ------------------------------------------------------------------------
+    DatabaseWorker(sqlite3* db);
+    // ------------------------------------------------------------------------
+    ~DatabaseWorker();
+    // ------------------------------------------------------------------------
+    void addQuery(const std::string& query,
+                  std::function<void(sqlite3_stmt*)> bind_function = nullptr,
+                  bool cache = false,
+                  std::function<void(bool)> done_function = nullptr,
+                  bool can_drop = true);
+    // ------------------------------------------------------------------------
+    unsigned getQueueSize();
+    // ------------------------------------------------------------------------
+    void getStatistics(uint64_t* count, float* average_ms, float* max_ms,
+                       unsigned* max_queue_size, unsigned* dropped_count,
+                       bool reset);
+};   // DatabaseWorker
+
+#endif
+
+#endif
@@ -29,7 +29,8 @@ class DummyRewinder : public Rewinder, public EventRewinder
 {
 public:
     // -------------------------------------------------------------------------
-    BareNetworkString* saveState(std::vector<std::string>* ru)  { return NULL; }
+    bool saveState(BareNetworkString *buffer, std::vector<std::string>* ru)
+                                                             { return false; }
     // -------------------------------------------------------------------------
     virtual void undoEvent(BareNetworkString* s)                              {}
     // -------------------------------------------------------------------------
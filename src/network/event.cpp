@@ -19,6 +19,7 @@
 #include "network/event.hpp"
 
 #include "network/crypto.hpp"
+#include "network/network_string_pool.hpp"
 #include "network/protocols/client_lobby.hpp"
 #include "network/stk_peer.hpp"
 #include "utils/log.hpp"
@@ -41,7 +42,7 @@ constexpr bool isConnectionRequestPacket(unsigned char* data, size_t length)
 // ============================================================================
 Event::Event(ENetEvent* event, std::shared_ptr<STKPeer> peer)
 {
-    m_arrival_time = StkTime::getMonoTimeMs();
+    m_arrival_time_us = StkTime::getMonoTimeUs();
     m_pdi = PDI_TIMEOUT;
     m_peer = peer;
 
@@ -82,8 +83,8 @@ Event::Event(ENetEvent* event, std::shared_ptr<STKPeer> peer)
         }
         else
         {
-            m_data = new NetworkString(event->packet->data, 
-                (int)event->packet->dataLength);
+            m_data = NetworkStringPool::get()->getNetworkString(
+                event->packet->data, (int)event->packet->dataLength);
         }
     }
     else
@@ -102,6 +103,6 @@ Event::Event(ENetEvent* event, std::shared_ptr<STKPeer> peer)
  */
 Event::~Event()
 {
-    delete m_data;
+    NetworkStringPool::get()->release(m_data);
 }   // ~Event
 
@@ -83,8 +83,9 @@ private:
     /** Pointer to the peer that triggered that event. */
     std::shared_ptr<STKPeer> m_peer;
 
-    /** Arrivial time of the event, for timeouts. */
-    uint64_t m_arrival_time;
+    /** Arrivial time of the event in microseconds, for timeouts and to
+     *  measure the delivery latency. */
+    uint64_t m_arrival_time_us;
 
     /** For disconnection event, a bit more info is provided. */
     PeerDisconnectInfo m_pdi;
@@ -118,8 +119,11 @@ public:
     bool isSynchronous() const { return m_type==EVENT_TYPE_MESSAGE &&
                                         m_data->isSynchronous();     }
     // ------------------------------------------------------------------------
-    /** Returns the arrival time of this event. */
-    uint64_t getArrivalTime() const { return m_arrival_time; }
+    /** Returns the arrival time of this event in milliseconds. */
+    uint64_t getArrivalTime() const      { return m_arrival_time_us / 1000; }
+    // ------------------------------------------------------------------------
+    /** Returns the arrival time of this event in microseconds. */
+    uint64_t getArrivalTimeUs() const           { return m_arrival_time_us; }
     // ------------------------------------------------------------------------
     PeerDisconnectInfo getPeerDisconnectInfo() const { return m_pdi; }
     // ------------------------------------------------------------------------
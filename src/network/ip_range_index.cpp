@@ -0,0 +1,69 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2024 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+
+#include "network/ip_range_index.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+// ----------------------------------------------------------------------------
+/** Sorts the ranges after all were added. */
+void IPRangeIndex::finalize()
+{
+    std::stable_sort(m_ranges.begin(), m_ranges.end());
+    m_max_end.resize(m_ranges.size());
+    uint64_t max_end = 0;
+    for (unsigned i = 0; i < m_ranges.size(); i++)
+    {
+        max_end = std::max(max_end, m_ranges[i].m_end);
+        m_max_end[i] = max_end;
+    }
+}   // finalize
+
+// ----------------------------------------------------------------------------
+void IPRangeIndex::unitTesting()
+{
+    IPRangeIndex index;
+    assert(index.find(5) == -1);
+
+    index.add(100, 200, 0);
+    index.add(10, 20, 1);
+    index.add(150, 160, 2);
+    // A wide range starting early, which contains the others
+    index.add(0, 1000, 3);
+    index.add(30, 10, 4);
+    index.add(0xffffffff00000000ULL, 0xffffffffffffffffULL, 5);
+    index.finalize();
+    assert(index.size() == 5);
+
+    // The range with the biggest start is found first
+    assert(index.find(15) == 1);
+    assert(index.find(155) == 2);
+    assert(index.find(100) == 0);
+    assert(index.find(200) == 0);
+    assert(index.find(201) == 3);
+    assert(index.find(25) == 3);
+    assert(index.find(1001) == -1);
+    assert(index.find(0xffffffffffffffffULL) == 5);
+
+    // Ranges which are not accepted are skipped
+    assert(index.find(155, [](unsigned id) { return id != 2; }) == 0);
+    assert(index.find(155, [](unsigned id) { return id == 3; }) == 3);
+    assert(index.find(15, [](unsigned id) { return false; }) == -1);
+}   // unitTesting
@@ -0,0 +1,107 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2024 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+
+#ifndef HEADER_IP_RANGE_INDEX_HPP
+#define HEADER_IP_RANGE_INDEX_HPP
+
+#include <stdint.h>
+#include <vector>
+
+/** A sorted list of (possibly overlapping) ranges of IP addresses, which
+ *  finds the ranges containing an address with a binary search instead of
+ *  a database query. IPv4 addresses are used directly as key, IPv6
+ *  addresses by their upper 64 bits. Each range has an id, which is the
+ *  index of the data of the range (ban or country) in the caller's list.
+ *  The ranges must be added first, then finalize() must be called before
+ *  find() can be used.
+ * \ingroup network
+ */
+class IPRangeIndex
+{
+private:
+    struct Range
+    {
+        uint64_t m_start;
+        uint64_t m_end;
+        unsigned m_id;
+        bool operator<(const Range& r) const { return m_start < r.m_start; }
+    };
+
+    /** All ranges, sorted by start once finalized. */
+    std::vector<Range> m_ranges;
+
+    /** The biggest end of all ranges up to (and including) each index, so
+     *  that find() knows when no earlier range can contain an address. */
+    std::vector<uint64_t> m_max_end;
+
+public:
+    // ------------------------------------------------------------------------
+    /** Adds a range, both ends are inclusive. */
+    void add(uint64_t start, uint64_t end, unsigned id)
+    {
+        if (start > end)
+            return;
+        Range r;
+        r.m_start = start;
+        r.m_end   = end;
+        r.m_id    = id;
+        m_ranges.push_back(r);
+    }   // add
+    // ------------------------------------------------------------------------
+    void finalize();
+    // ------------------------------------------------------------------------
+    /** Finds the ranges containing an address, starting with the range with
+     *  the biggest start (i.e. the most specific one for nested ranges),
+     *  until accept returns true for the id of a range.
+     *  \return The accepted id, or -1 if none.
+     */
+    template<typename F> int find(uint64_t key, F accept) const
+    {
+        // First range starting after key
+        unsigned lo = 0, hi = (unsigned)m_ranges.size();
+        while (lo < hi)
+        {
+            unsigned mid = (lo + hi) / 2;
+            if (m_ranges[mid].m_start <= key)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        for (unsigned i = lo; i > 0 && m_max_end[i - 1] >= key; i--)
+        {
+            const Range& r = m_ranges[i - 1];
+            if (r.m_end >= key && accept(r.m_id))
+                return (int)r.m_id;
+        }
+        return -1;
+    }   // find
+    // ------------------------------------------------------------------------
+    /** Returns the id of the range containing an address with the biggest
+     *  start, or -1 if no range contains it. */
+    int find(uint64_t key) const
+    {
+        return find(key, [](unsigned id) { return true; });
+    }   // find
+    // ------------------------------------------------------------------------
+    unsigned size() const                { return (unsigned)m_ranges.size(); }
+    // ------------------------------------------------------------------------
+    static void unitTesting();
+};   // IPRangeIndex
+
+#endif
@@ -0,0 +1,294 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2024 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+
+#include "network/network_capture.hpp"
+
+#include "network/event.hpp"
+#include "network/stk_peer.hpp"
+#include "network/socket_address.hpp"
+#include "utils/file_utils.hpp"
+#include "utils/log.hpp"
+#include "utils/time.hpp"
+
+#include <cassert>
+#include <cstring>
+
+namespace
+{
+    const char    MAGIC[4] = { 'S', 'T', 'K', 'C' };
+    const uint8_t VERSION  = 1;
+
+    /** Bigger messages are treated as a corrupted file. */
+    const uint64_t MAX_DATA_SIZE = 16 * 1024 * 1024;
+}   // anonymous namespace
+
+// ----------------------------------------------------------------------------
+NetworkCapture::NetworkCapture(FILE* file, bool writing)
+{
+    m_file       = file;
+    m_has_record = false;
+    m_last_time  = writing ? StkTime::getMonoTimeUs() : 0;
+    // Records are small, so buffer them for fewer system calls
+    setvbuf(m_file, NULL, _IOFBF, 64 * 1024);
+    if (writing)
+    {
+        fwrite(MAGIC, 1, sizeof(MAGIC), m_file);
+        fputc(VERSION, m_file);
+    }
+}   // NetworkCapture
+
+// ----------------------------------------------------------------------------
+NetworkCapture::~NetworkCapture()
+{
+    fclose(m_file);
+}   // ~NetworkCapture
+
+// ----------------------------------------------------------------------------
+/** Creates a new capture file, or returns NULL on error. */
+NetworkCapture* NetworkCapture::create(const std::string& filename)
+{
+    FILE* file = FileUtils::fopenU8Path(filename, "wb");
+    if (!file)
+    {
+        Log::error("NetworkCapture", "Cannot create '%s'.", filename.c_str());
+        return NULL;
+    }
+    return new NetworkCapture(file, true/*writing*/);
+}   // create
+
+// ----------------------------------------------------------------------------
+/** Opens a capture file for replaying, or returns NULL on error. */
+NetworkCapture* NetworkCapture::open(const std::string& filename)
+{
+    FILE* file = FileUtils::fopenU8Path(filename, "rb");
+    if (!file)
+    {
+        Log::error("NetworkCapture", "Cannot open '%s'.", filename.c_str());
+        return NULL;
+    }
+    NetworkCapture* capture = new NetworkCapture(file, false/*writing*/);
+    if (!capture->readHeader())
+    {
+        Log::error("NetworkCapture", "'%s' is not a supported network "
+            "capture.", filename.c_str());
+        delete capture;
+        return NULL;
+    }
+    capture->nextRecord();
+    return capture;
+}   // open
+
+// ----------------------------------------------------------------------------
+/** Checks the magic number and version at the start of the file. */
+bool NetworkCapture::readHeader()
+{
+    char magic[sizeof(MAGIC)];
+    return fread(magic, 1, sizeof(magic), m_file) == sizeof(magic) &&
+        memcmp(magic, MAGIC, sizeof(MAGIC)) == 0 &&
+        fgetc(m_file) == VERSION;
+}   // readHeader
+
+// ----------------------------------------------------------------------------
+/** Writes an unsigned integer with 7 bits per byte, the highest bit is set
+ *  if more bytes follow. */
+void NetworkCapture::writeVarInt(uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        fputc((int)(value & 0x7f) | 0x80, m_file);
+        value >>= 7;
+    }
+    fputc((int)value, m_file);
+}   // writeVarInt
+
+// ----------------------------------------------------------------------------
+/** Reads an integer written by writeVarInt(), returns false at the end of
+ *  the file. */
+bool NetworkCapture::readVarInt(uint64_t* value)
+{
+    *value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7)
+    {
+        int c = fgetc(m_file);
+        if (c == EOF)
+            return false;
+        *value |= (uint64_t)(c & 0x7f) << shift;
+        if ((c & 0x80) == 0)
+            return true;
+    }
+    return false;
+}   // readVarInt
+
+// ----------------------------------------------------------------------------
+void NetworkCapture::write(uint64_t time, uint32_t host_id, uint8_t type,
+                           uint8_t channel, uint32_t disconnect_info,
+                           const std::string& address, const uint8_t* data,
+                           unsigned size)
+{
+    writeVarInt(time > m_last_time ? time - m_last_time : 0);
+    if (time > m_last_time)
+        m_last_time = time;
+    writeVarInt(host_id);
+    fputc(type, m_file);
+    switch (type)
+    {
+    case EVENT_TYPE_CONNECTED:
+        writeVarInt(address.size());
+        fwrite(address.data(), 1, address.size(), m_file);
+        break;
+    case EVENT_TYPE_DISCONNECTED:
+        writeVarInt(disconnect_info);
+        break;
+    case EVENT_TYPE_MESSAGE:
+        fputc(channel, m_file);
+        writeVarInt(size);
+        fwrite(data, 1, size, m_file);
+        break;
+    }
+}   // write
+
+// ----------------------------------------------------------------------------
+/** Adds a received event to the capture. Only called from the listening
+ *  thread of STKHost.
+ *  \param channel The ENet channel of a message.
+ */
+void NetworkCapture::addEvent(const Event& event, uint8_t channel)
+{
+    const STKPeer* peer = event.getPeer();
+    switch (event.getType())
+    {
+    case EVENT_TYPE_CONNECTED:
+        write(event.getArrivalTimeUs(), peer->getHostId(),
+            EVENT_TYPE_CONNECTED, 0, 0, peer->getAddress().toString(),
+            NULL, 0);
+        break;
+    case EVENT_TYPE_DISCONNECTED:
+        write(event.getArrivalTimeUs(), peer->getHostId(),
+            EVENT_TYPE_DISCONNECTED, 0, event.getPeerDisconnectInfo(), "",
+            NULL, 0);
+        break;
+    case EVENT_TYPE_MESSAGE:
+        write(event.getArrivalTimeUs(), peer->getHostId(),
+            EVENT_TYPE_MESSAGE, channel, 0, "",
+            (const uint8_t*)event.data().getData(),
+            event.data().getTotalSize());
+        break;
+    }
+}   // addEvent
+
+// ----------------------------------------------------------------------------
+/** Reads the next record into m_record, returns false at the end of the
+ *  file or if the file is corrupted. */
+bool NetworkCapture::readRecord()
+{
+    uint64_t value;
+    if (!readVarInt(&value))
+        return false;
+    m_last_time += value;
+    m_record.m_time = m_last_time;
+    if (!readVarInt(&value))
+        return false;
+    m_record.m_host_id = (uint32_t)value;
+    int type = fgetc(m_file);
+    m_record.m_type = (uint8_t)type;
+    m_record.m_channel = 0;
+    m_record.m_disconnect_info = 0;
+    m_record.m_address.clear();
+    m_record.m_data.clear();
+    switch (type)
+    {
+    case EVENT_TYPE_CONNECTED:
+        if (!readVarInt(&value) || value > 256)
+            break;
+        m_record.m_address.resize((size_t)value);
+        if (fread(&m_record.m_address[0], 1, (size_t)value, m_file) != value)
+            break;
+        return true;
+    case EVENT_TYPE_DISCONNECTED:
+        if (!readVarInt(&value))
+            break;
+        m_record.m_disconnect_info = (uint32_t)value;
+        return true;
+    case EVENT_TYPE_MESSAGE:
+    {
+        int channel = fgetc(m_file);
+        if (channel == EOF || !readVarInt(&value) || value == 0 ||
+            value > MAX_DATA_SIZE)
+            break;
+        m_record.m_channel = (uint8_t)channel;
+        m_record.m_data.resize((size_t)value);
+        if (fread(m_record.m_data.data(), 1, (size_t)value, m_file) != value)
+            break;
+        return true;
+    }
+    default:
+        break;
+    }
+    if (!feof(m_file))
+        Log::error("NetworkCapture", "Corrupted network capture.");
+    return false;
+}   // readRecord
+
+// ----------------------------------------------------------------------------
+void NetworkCapture::unitTesting()
+{
+    FILE* file = tmpfile();
+    if (!file)
+        return;
+    NetworkCapture capture(file, true/*writing*/);
+    const uint64_t start = capture.m_last_time;
+    const uint8_t data[] = { 1, 2, 3, 200 };
+    capture.write(start + 5, 1, EVENT_TYPE_CONNECTED, 0, 0, "1.2.3.4:5",
+        NULL, 0);
+    capture.write(start + 300, 1, EVENT_TYPE_MESSAGE, 2, 0, "", data,
+        sizeof(data));
+    // Times going backwards are stored as no difference
+    capture.write(start + 200, 70000, EVENT_TYPE_MESSAGE, 0, 0, "", data, 1);
+    capture.write(start + 1000000, 1, EVENT_TYPE_DISCONNECTED, 0, 3, "",
+        NULL, 0);
+
+    // Read the file back with the same object
+    fflush(file);
+    rewind(file);
+    capture.m_last_time = 0;
+    bool header = capture.readHeader();
+    assert(header);
+    capture.nextRecord();
+
+    const Record* r = capture.getRecord();
+    assert(r && r->m_time == 5 && r->m_host_id == 1 &&
+        r->m_type == EVENT_TYPE_CONNECTED && r->m_address == "1.2.3.4:5");
+    capture.nextRecord();
+    r = capture.getRecord();
+    assert(r && r->m_time == 300 && r->m_type == EVENT_TYPE_MESSAGE &&
+        r->m_channel == 2 && r->m_data.size() == sizeof(data) &&
+        memcmp(r->m_data.data(), data, sizeof(data)) == 0);
+    capture.nextRecord();
+    r = capture.getRecord();
+    assert(r && r->m_time == 300 && r->m_host_id == 70000 &&
+        r->m_data.size() == 1);
+    capture.nextRecord();
+    r = capture.getRecord();
+    assert(r && r->m_time == 1000000 &&
+        r->m_type == EVENT_TYPE_DISCONNECTED && r->m_disconnect_info == 3);
+    capture.nextRecord();
+    assert(capture.getRecord() == NULL);
+    (void)header;
+    (void)r;
+}   // unitTesting
@@ -0,0 +1,114 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2024 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+
+#ifndef HEADER_NETWORK_CAPTURE_HPP
+#define HEADER_NETWORK_CAPTURE_HPP
+
+#include "utils/no_copy.hpp"
+
+#include <cstdio>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+class Event;
+
+/** A file of all events received by a server (connections, disconnections
+ *  and messages), which can be replayed to a server later as a repeatable
+ *  benchmark without real clients, see STKHost::m_replay_file.
+ *  Messages are stored decrypted, so a capture can be replayed to a server
+ *  without the keys of the clients. The file starts with a magic number and
+ *  version, followed by one record for each event:
+ *  - time since the previous record in microseconds (variable length int),
+ *  - host id of the peer (variable length int),
+ *  - event type (1 byte),
+ *  - for connections the address of the peer (length and string),
+ *  - for disconnections the disconnect info (variable length int),
+ *  - for messages the channel (1 byte) and the data (length and bytes).
+ * \ingroup network
+ */
+class NetworkCapture : public NoCopy
+{
+public:
+    /** A captured event. */
+    struct Record
+    {
+        /** Time since the start of the capture in microseconds. */
+        uint64_t             m_time;
+        uint32_t             m_host_id;
+        /** The EVENT_TYPE of the event. */
+        uint8_t              m_type;
+        uint8_t              m_channel;
+        uint32_t             m_disconnect_info;
+        std::string          m_address;
+        std::vector<uint8_t> m_data;
+    };
+
+private:
+    FILE* m_file;
+
+    /** Time of the last record, to store only the difference. When writing
+     *  it is the absolute time in microseconds, when reading the time since
+     *  the start of the capture. */
+    uint64_t m_last_time;
+
+    /** The next record when reading. */
+    Record m_record;
+
+    /** False when reading reached the end of the file. */
+    bool m_has_record;
+
+    // ------------------------------------------------------------------------
+    NetworkCapture(FILE* file, bool writing);
+    // ------------------------------------------------------------------------
+    void writeVarInt(uint64_t value);
+    // ------------------------------------------------------------------------
+    bool readVarInt(uint64_t* value);
+    // ------------------------------------------------------------------------
+    bool readHeader();
+    // ------------------------------------------------------------------------
+    void write(uint64_t time, uint32_t host_id, uint8_t type,
+               uint8_t channel, uint32_t disconnect_info,
+               const std::string& address, const uint8_t* data,
+               unsigned size);
+    // ------------------------------------------------------------------------
+    bool readRecord();
+
+public:
+    // ------------------------------------------------------------------------
+    static NetworkCapture* create(const std::string& filename);
+    // ------------------------------------------------------------------------
+    static NetworkCapture* open(const std::string& filename);
+    // ------------------------------------------------------------------------
+    static void unitTesting();
+    // ------------------------------------------------------------------------
+    ~NetworkCapture();
+    // ------------------------------------------------------------------------
+    void addEvent(const Event& event, uint8_t channel);
+    // ------------------------------------------------------------------------
+    /** Returns the next record when reading, or NULL at the end of the
+     *  file. */
+    const Record* getRecord() const
+                                  { return m_has_record ? &m_record : NULL; }
+    // ------------------------------------------------------------------------
+    /** Reads the record after the current one. */
+    void nextRecord()                          { m_has_record = readRecord(); }
+};   // NetworkCapture
+
+#endif
@@ -18,6 +18,7 @@
 
 #include "network/network_config.hpp"
 #include "network/network_player_profile.hpp"
+#include "network/protocol_manager.hpp"
 #include "network/server_config.hpp"
 #include "network/socket_address.hpp"
 #include "network/stk_host.hpp"
@@ -53,6 +54,10 @@ void showHelp()
     std::cout << "listpeers, List all peers with host ID and IP." << std::endl;
     std::cout << "listban, List IP ban list of server." << std::endl;
     std::cout << "speedstats, Show upload and download speed." << std::endl;
+    std::cout << "latencystats, Show time from receiving to handling "
+        "messages since last call." << std::endl;
+    std::cout << "dbstats, Show queued database writes and their latency "
+        "since last call." << std::endl;
 }   // showHelp
 
 // ----------------------------------------------------------------------------
@@ -171,6 +176,12 @@ void mainLoop(STKHost* host)
             if (sl)
                 sl->listBanTable();
         }
+        else if (str == "dbstats")
+        {
+            auto sl = LobbyProtocol::get<ServerLobby>();
+            if (sl)
+                sl->showDatabaseStatistics();
+        }
         else if (str == "speedstats")
         {
             std::cout << "Upload speed (KBps): " <<
@@ -178,6 +189,20 @@ void mainLoop(STKHost* host)
                 "   Download speed (KBps): " <<
                 (float)host->getDownloadSpeed() / 1024.0f  << std::endl;
         }
+        else if (str == "latencystats")
+        {
+            auto pm = ProtocolManager::lock();
+            if (pm)
+            {
+                uint64_t count;
+                float average_ms, max_ms;
+                pm->getEventLatency(&count, &average_ms, &max_ms,
+                    /*reset*/true);
+                std::cout << "Messages: " << count << "   Average latency "
+                    "(ms): " << average_ms << "   Maximum latency (ms): " <<
+                    max_ms << std::endl;
+            }
+        }
         else
         {
             std::cout << "Unknown command: " << str << std::endl;
@@ -266,6 +266,20 @@ public:
         return *this;
     }   // addUInt64
 
+    // ------------------------------------------------------------------------
+    /** Adds an unsigned integer with 7 bits per byte (the highest bit marks
+     *  that more bytes follow), so values below 128 only need one byte. */
+    BareNetworkString& addVarUInt(uint32_t value)
+    {
+        while (value >= 0x80)
+        {
+            m_buffer.push_back((uint8_t)(value | 0x80));
+            value >>= 7;
+        }
+        m_buffer.push_back((uint8_t)value);
+        return *this;
+    }   // addVarUInt
+
     // ------------------------------------------------------------------------
     /** Adds a 4 byte floating point value. */
     BareNetworkString& addFloat(const float value)
@@ -348,6 +362,20 @@ public:
         return m_buffer.at(m_current_offset++);
     }   // getUInt8
     // ------------------------------------------------------------------------
+    /** Returns an unsigned integer added with addVarUInt. */
+    uint32_t getVarUInt() const
+    {
+        uint32_t value = 0;
+        for (int shift = 0; shift < 35; shift += 7)
+        {
+            uint8_t byte = getUInt8();
+            value |= uint32_t(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0)
+                return value;
+        }
+        throw std::out_of_range("getVarUInt too many bytes.");
+    }   // getVarUInt
+    // ------------------------------------------------------------------------
     /** Returns an unsigned 8-bit integer. */
     inline int8_t getInt8() const
     {
@@ -442,6 +470,16 @@ public:
         m_current_offset = 1;   // ignore type
     }   // NetworkString
 
+    // ------------------------------------------------------------------------
+    /** Sets the content to a received message, reusing the allocated memory
+     *  (see NetworkStringPool). Like the constructor for received messages
+     *  the type is skipped. */
+    void setReceivedData(const uint8_t *data, int len)
+    {
+        m_buffer.assign(data, data + len);
+        m_current_offset = 1;
+    }   // setReceivedData
+
     // ------------------------------------------------------------------------
     /** Empties the string, but does not reset the pre-allocated size. */
     void clear()
@@ -0,0 +1,184 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2024 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#include "network/network_string_pool.hpp"
+
+#include "network/network_string.hpp"
+#include "utils/mpsc_queue.hpp"
+
+#include <cassert>
+
+// ----------------------------------------------------------------------------
+/** Returns the pool. It is never deleted, since strings can still be
+ *  released while static objects are destroyed when STK exits. */
+NetworkStringPool* NetworkStringPool::get()
+{
+    static NetworkStringPool* pool = new NetworkStringPool();
+    return pool;
+}   // get
+
+// ----------------------------------------------------------------------------
+NetworkStringPool::NetworkStringPool()
+{
+    m_num_allocations.store(0);
+    m_free_network_strings.reserve(MAX_FREE);
+    m_free_bare_strings.reserve(MAX_FREE);
+}   // NetworkStringPool
+
+// ----------------------------------------------------------------------------
+NetworkStringPool::~NetworkStringPool()
+{
+    for (NetworkString* s : m_free_network_strings)
+        delete s;
+    for (BareNetworkString* s : m_free_bare_strings)
+        delete s;
+}   // ~NetworkStringPool
+
+// ----------------------------------------------------------------------------
+/** Returns a network string with the content of a received message. Like
+ *  the NetworkString constructor for received messages the protocol type
+ *  is skipped.
+ *  \param data The received data.
+ *  \param len Length of the data.
+ */
+NetworkString* NetworkStringPool::getNetworkString(const uint8_t* data,
+                                                   int len)
+{
+    std::unique_lock<std::mutex> ul(m_mutex);
+    if (m_free_network_strings.empty())
+    {
+        ul.unlock();
+        m_num_allocations.fetch_add(1);
+        return new NetworkString(data, len);
+    }
+    NetworkString* s = m_free_network_strings.back();
+    m_free_network_strings.pop_back();
+    ul.unlock();
+    s->setReceivedData(data, len);
+    return s;
+}   // getNetworkString
+
+// ----------------------------------------------------------------------------
+/** Returns an empty BareNetworkString. */
+BareNetworkString* NetworkStringPool::getBareNetworkString()
+{
+    std::unique_lock<std::mutex> ul(m_mutex);
+    if (m_free_bare_strings.empty())
+    {
+        ul.unlock();
+        m_num_allocations.fetch_add(1);
+        return new BareNetworkString();
+    }
+    BareNetworkString* s = m_free_bare_strings.back();
+    m_free_bare_strings.pop_back();
+    ul.unlock();
+    s->getBuffer().clear();
+    s->reset();
+    return s;
+}   // getBareNetworkString
+
+// ----------------------------------------------------------------------------
+/** Gives a string back to the pool. If enough strings are unused already,
+ *  the string is deleted. NULL is ignored. */
+void NetworkStringPool::release(NetworkString* s)
+{
+    if (!s)
+        return;
+    std::unique_lock<std::mutex> ul(m_mutex);
+    if (m_free_network_strings.size() < MAX_FREE)
+    {
+        m_free_network_strings.push_back(s);
+        return;
+    }
+    ul.unlock();
+    delete s;
+}   // release(NetworkString)
+
+// ----------------------------------------------------------------------------
+/** Gives a string back to the pool. If enough strings are unused already,
+ *  the string is deleted. NULL is ignored. */
+void NetworkStringPool::release(BareNetworkString* s)
+{
+    if (!s)
+        return;
+    std::unique_lock<std::mutex> ul(m_mutex);
+    if (m_free_bare_strings.size() < MAX_FREE)
+    {
+        m_free_bare_strings.push_back(s);
+        return;
+    }
+    ul.unlock();
+    delete s;
+}   // release(BareNetworkString)
+
+// ----------------------------------------------------------------------------
+/** Checks that strings and event queue nodes are reused, i.e. that a
+ *  steady stream of messages does not allocate any new strings or nodes. */
+void NetworkStringPool::unitTesting()
+{
+    NetworkStringPool* pool = get();
+    const uint8_t data[] = { PROTOCOL_CONTROLLER_EVENTS, 1, 2, 3 };
+
+    // Warm up: the first strings are allocated
+    NetworkString* ns = pool->getNetworkString(data, 4);
+    BareNetworkString* bns = pool->getBareNetworkString();
+    pool->release(ns);
+    pool->release(bns);
+    const unsigned allocations = pool->getNumAllocations();
+
+    for (unsigned i = 0; i < 1000; i++)
+    {
+        ns = pool->getNetworkString(data, 4);
+        assert(ns->getProtocolType() == PROTOCOL_CONTROLLER_EVENTS);
+        assert(ns->size() == 3 && ns->getUInt8() == 1);
+        bns = pool->getBareNetworkString();
+        assert(bns->size() == 0);
+        bns->addUInt32(i);
+        pool->release(ns);
+        pool->release(bns);
+    }
+    assert(pool->getNumAllocations() == allocations);
+
+    // One server tick: the received messages of all peers are queued for
+    // the main thread, which handles and releases them. After the first
+    // tick neither the strings nor the queue nodes are allocated again.
+    MPSCQueue<NetworkString*> queue;
+    unsigned string_allocations = 0, queue_allocations = 0;
+    for (unsigned tick = 0; tick < 10; tick++)
+    {
+        for (unsigned peer = 0; peer < 8; peer++)
+            queue.push(pool->getNetworkString(data, 4));
+        while (queue.pop(&ns))
+        {
+            assert(ns->getUInt8() == 1);
+            pool->release(ns);
+        }
+        if (tick == 0)
+        {
+            string_allocations = pool->getNumAllocations();
+            queue_allocations = queue.getNumAllocations();
+        }
+        assert(pool->getNumAllocations() == string_allocations);
+        assert(queue.getNumAllocations() == queue_allocations);
+    }
+    assert(queue.empty());
+    (void)allocations;
+    (void)string_allocations;
+    (void)queue_allocations;
+    pool->release((NetworkString*)NULL);
+}   // unitTesting
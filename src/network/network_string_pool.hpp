@@ -0,0 +1,83 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2024 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#ifndef HEADER_NETWORK_STRING_POOL_HPP
+#define HEADER_NETWORK_STRING_POOL_HPP
+
+#include "utils/no_copy.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <stdint.h>
+#include <vector>
+
+class BareNetworkString;
+class NetworkString;
+
+/** A thread-safe pool of network strings for the messages and events
+ *  created all the time during a race (each received message and each
+ *  controller action), so that they reuse the memory of earlier strings
+ *  instead of allocating new ones. Strings returned by the pool must be
+ *  given back with release() instead of being deleted.
+ * \ingroup network
+ */
+class NetworkStringPool : public NoCopy
+{
+private:
+    /** Maximum number of unused strings kept of each type. */
+    static const unsigned MAX_FREE = 256;
+
+    std::mutex m_mutex;
+
+    /** Unused strings of each type. */
+    std::vector<NetworkString*>     m_free_network_strings;
+    std::vector<BareNetworkString*> m_free_bare_strings;
+
+    /** Number of strings allocated by the pool, when the pool works as
+     *  intended this stops increasing once a race is running. */
+    std::atomic<unsigned> m_num_allocations;
+
+    NetworkStringPool();
+    ~NetworkStringPool();
+
+public:
+    /** Deleter for std::unique_ptr which gives the string back to the pool
+     *  instead of deleting it. */
+    struct Release
+    {
+        void operator()(NetworkString* s) const { get()->release(s); }
+    };   // Release
+
+    // ------------------------------------------------------------------------
+    static NetworkStringPool* get();
+    // ------------------------------------------------------------------------
+    static void unitTesting();
+    // ------------------------------------------------------------------------
+    NetworkString* getNetworkString(const uint8_t* data, int len);
+    // ------------------------------------------------------------------------
+    BareNetworkString* getBareNetworkString();
+    // ------------------------------------------------------------------------
+    void release(NetworkString* s);
+    // ------------------------------------------------------------------------
+    void release(BareNetworkString* s);
+    // ------------------------------------------------------------------------
+    /** Returns how many strings were allocated so far. */
+    unsigned getNumAllocations() const      { return m_num_allocations.load(); }
+};   // NetworkStringPool
+
+#endif
@@ -36,6 +36,41 @@
 #include <functional>
 #include <typeinfo>
 
+namespace
+{
+    /** Maximum time in milliseconds the asynchronous update thread sleeps
+     *  if no event arrives, so that protocols are still updated regularly.
+     */
+    const int ASYNC_UPDATE_INTERVAL = 10;
+
+    // ------------------------------------------------------------------------
+    /** Protocol used by ProtocolManager::benchmarkEventLatency(), which
+     *  counts the connect events delivered to it. */
+    class LatencyBenchmarkProtocol : public Protocol
+    {
+    public:
+        std::atomic<unsigned> m_handled;
+        // --------------------------------------------------------------------
+        LatencyBenchmarkProtocol() : Protocol(PROTOCOL_LOBBY_ROOM)
+        {
+            m_handled.store(0);
+            setHandleConnections(true);
+        }   // LatencyBenchmarkProtocol
+        // --------------------------------------------------------------------
+        virtual bool notifyEventAsynchronous(Event* event) OVERRIDE
+        {
+            m_handled.fetch_add(1);
+            return true;
+        }   // notifyEventAsynchronous
+        // --------------------------------------------------------------------
+        virtual void setup() OVERRIDE {}
+        // --------------------------------------------------------------------
+        virtual void update(int ticks) OVERRIDE {}
+        // --------------------------------------------------------------------
+        virtual void asynchronousUpdate() OVERRIDE {}
+    };   // LatencyBenchmarkProtocol
+}   // anonymous namespace
+
 // ============================================================================
 std::weak_ptr<ProtocolManager> ProtocolManager::m_protocol_manager[PT_COUNT];
 // ============================================================================
@@ -62,7 +97,7 @@ std::shared_ptr<ProtocolManager> ProtocolManager::createInstance()
             {
                 pm->asynchronousUpdate();
                 PROFILER_PUSH_CPU_MARKER("sleep", 0, 255, 255);
-                StkTime::sleep(2);
+                pm->waitForAsynchronousEvents();
                 PROFILER_POP_CPU_MARKER();
             }
         });
@@ -97,7 +132,10 @@ std::shared_ptr<ProtocolManager> ProtocolManager::createInstance()
                     }
                     auto gp = GameProtocol::lock();
                     if (gp)
+                    {
                         gp->notifyEventAsynchronous(event_top);
+                        pm->addEventLatency(event_top);
+                    }
                     delete event_top;
                 }
             });
@@ -110,6 +148,11 @@ std::shared_ptr<ProtocolManager> ProtocolManager::createInstance()
 ProtocolManager::ProtocolManager()
 {
     m_exit.store(false);
+    m_async_waiting.store(false);
+    m_async_wakeup.store(false);
+    m_latency_count.store(0);
+    m_latency_total.store(0);
+    m_latency_max.store(0);
 }   // ProtocolManager
 
 // ----------------------------------------------------------------------------
@@ -121,19 +164,20 @@ ProtocolManager::~ProtocolManager()
         m_all_protocols[i].abort();
     }
 
-    m_sync_events_to_process.lock();
-    for (EventList::iterator i =m_sync_events_to_process.getData().begin();
-                             i!=m_sync_events_to_process.getData().end(); ++i)
+    Event* event;
+    while (m_sync_events_to_process.pop(&event))
+        delete event;
+    for (EventList::iterator i = m_sync_events.begin();
+                             i!= m_sync_events.end(); ++i)
         delete *i;
-    m_sync_events_to_process.getData().clear();
-    m_sync_events_to_process.unlock();
+    m_sync_events.clear();
 
-    m_async_events_to_process.lock();
-    for (EventList::iterator i = m_async_events_to_process.getData().begin();
-                             i!= m_async_events_to_process.getData().end(); ++i)
+    while (m_async_events_to_process.pop(&event))
+        delete event;
+    for (EventList::iterator i = m_async_events.begin();
+                             i!= m_async_events.end(); ++i)
         delete *i;
-    m_async_events_to_process.getData().clear();
-    m_async_events_to_process.unlock();
+    m_async_events.clear();
 
     for (EventList::iterator i = m_controller_events_list.begin();
                              i!= m_controller_events_list.end(); ++i)
@@ -160,6 +204,7 @@ void ProtocolManager::OneProtocolType::abort()
 void ProtocolManager::abort()
 {
     m_exit.store(true);
+    wakeUpAsynchronousThread();
     if (NetworkConfig::get()->isServer())
     {
         std::unique_lock<std::mutex> ul(m_game_protocol_mutex);
@@ -191,18 +236,49 @@ void ProtocolManager::propagateEvent(Event* event)
     }
     if (event->isSynchronous())
     {
-        m_sync_events_to_process.lock();
-        m_sync_events_to_process.getData().push_back(event);
-        m_sync_events_to_process.unlock();
+        m_sync_events_to_process.push(event);
     }
     else
     {
-        m_async_events_to_process.lock();
-        m_async_events_to_process.getData().push_back(event);
-        m_async_events_to_process.unlock();
+        m_async_events_to_process.push(event);
+        wakeUpAsynchronousThread();
     }
 }   // propagateEvent
 
+// ----------------------------------------------------------------------------
+/** Wakes up the asynchronous update thread, e.g. after adding an event.
+ *  The condition variable is only notified (which needs the mutex) if the
+ *  thread is actually waiting.
+ */
+void ProtocolManager::wakeUpAsynchronousThread()
+{
+    m_async_wakeup.store(true);
+    if (m_async_waiting.load())
+    {
+        std::lock_guard<std::mutex> lock(m_async_mutex);
+        m_async_cv.notify_one();
+    }
+}   // wakeUpAsynchronousThread
+
+// ----------------------------------------------------------------------------
+/** Called in the asynchronous update thread after each update. Waits until
+ *  the thread is woken up or ASYNC_UPDATE_INTERVAL milliseconds passed.
+ */
+void ProtocolManager::waitForAsynchronousEvents()
+{
+    std::unique_lock<std::mutex> ul(m_async_mutex);
+    // Set before testing m_async_wakeup, so that any thread setting
+    // m_async_wakeup afterwards will notify
+    m_async_waiting.store(true);
+    m_async_cv.wait_for(ul, std::chrono::milliseconds(ASYNC_UPDATE_INTERVAL),
+        [this]()
+        {
+            return m_exit.load() || m_async_wakeup.load();
+        });
+    m_async_waiting.store(false);
+    m_async_wakeup.store(false);
+}   // waitForAsynchronousEvents
+
 // ----------------------------------------------------------------------------
 /** \brief Asks the manager to start a protocol.
  *  Add the protocol to the protocols vector.
@@ -212,9 +288,12 @@ void ProtocolManager::requestStart(std::shared_ptr<Protocol> protocol)
 {
     if (!protocol)
         return;
-    std::lock_guard<std::mutex> lock(m_protocols_mutex);
+    std::unique_lock<std::mutex> ul(m_protocols_mutex);
     OneProtocolType &opt = m_all_protocols[protocol->getProtocolType()];
     opt.addProtocol(protocol);
+    ul.unlock();
+    // Update the new protocol without delay
+    wakeUpAsynchronousThread();
 }   // requestStart
 
 // ----------------------------------------------------------------------------
@@ -335,11 +414,89 @@ bool ProtocolManager::sendEvent(Event* event,
             can_be_deleted |= protocols.at(i).notifyEvent(event);
         }
     }
+    if (can_be_deleted)
+        addEventLatency(event);
     const uint64_t TIME_TO_KEEP_EVENTS = 1000;
     return can_be_deleted || StkTime::getMonoTimeMs() - event->getArrivalTime()
                               >= TIME_TO_KEEP_EVENTS;
 }   // sendEvent
 
+// ----------------------------------------------------------------------------
+/** Adds the time from receiving an event until now (when it was handled)
+ *  to the latency statistics.
+ */
+void ProtocolManager::addEventLatency(const Event* event)
+{
+    const uint64_t latency = StkTime::getMonoTimeUs() -
+        event->getArrivalTimeUs();
+    m_latency_count.fetch_add(1);
+    m_latency_total.fetch_add(latency);
+    uint64_t max = m_latency_max.load();
+    while (latency > max &&
+           !m_latency_max.compare_exchange_weak(max, latency)) {}
+}   // addEventLatency
+
+// ----------------------------------------------------------------------------
+/** Returns the statistics of the time from receiving an event (in the
+ *  network thread) until it was handled by a protocol.
+ *  \param[out] count Number of handled events.
+ *  \param[out] average_ms Average latency in milliseconds.
+ *  \param[out] max_ms Maximum latency in milliseconds.
+ *  \param reset If the statistics should be reset afterwards.
+ */
+void ProtocolManager::getEventLatency(uint64_t* count, float* average_ms,
+                                      float* max_ms, bool reset)
+{
+    *count = reset ? m_latency_count.exchange(0) : m_latency_count.load();
+    const uint64_t total = reset ? m_latency_total.exchange(0)
+                                 : m_latency_total.load();
+    const uint64_t max = reset ? m_latency_max.exchange(0)
+                               : m_latency_max.load();
+    *average_ms = *count > 0 ? float(total) / float(*count) / 1000.0f : 0.0f;
+    *max_ms = float(max) / 1000.0f;
+}   // getEventLatency
+
+// ----------------------------------------------------------------------------
+/** Measures the time from an event being added by the network thread until
+ *  it is handled by a protocol in the asynchronous update thread, and
+ *  prints the result. Events are added with a short pause in between, like
+ *  messages arriving from clients, so that the thread has to wake up for
+ *  each of them.
+ */
+void ProtocolManager::benchmarkEventLatency()
+{
+    const unsigned NUM_EVENTS = 200;
+    std::shared_ptr<ProtocolManager> pm = createInstance();
+    if (!pm)
+        return;
+    auto protocol = std::make_shared<LatencyBenchmarkProtocol>();
+    pm->requestStart(protocol);
+
+    std::thread network_thread([pm]()
+        {
+            ENetEvent enet_event = {};
+            enet_event.type = ENET_EVENT_TYPE_CONNECT;
+            for (unsigned i = 0; i < NUM_EVENTS; i++)
+            {
+                pm->propagateEvent(new Event(&enet_event, nullptr));
+                StkTime::sleep(3);
+            }
+        });
+    network_thread.join();
+    const uint64_t start = StkTime::getMonoTimeMs();
+    while (protocol->m_handled.load() < NUM_EVENTS &&
+           StkTime::getMonoTimeMs() - start < 5000)
+        StkTime::sleep(1);
+
+    uint64_t count;
+    float average_ms, max_ms;
+    pm->getEventLatency(&count, &average_ms, &max_ms, /*reset*/true);
+    Log::info("ProtocolManager", "Latency of %u events: average %f ms, "
+        "maximum %f ms.", (unsigned)count, average_ms, max_ms);
+    assert(count == NUM_EVENTS);
+    pm->abort();
+}   // benchmarkEventLatency
+
 // ----------------------------------------------------------------------------
 /** Calls either the synchronous update or asynchronous update function in all
  *  protocols of this type.
@@ -378,12 +535,13 @@ void ProtocolManager::update(int ticks)
     ul.unlock();
 
     // before updating, notify protocols that they have received events
-    m_sync_events_to_process.lock();
-    EventList::iterator i = m_sync_events_to_process.getData().begin();
+    Event* event;
+    while (m_sync_events_to_process.pop(&event))
+        m_sync_events.push_back(event);
+    EventList::iterator i = m_sync_events.begin();
 
-    while (i != m_sync_events_to_process.getData().end())
+    while (i != m_sync_events.end())
     {
-        m_sync_events_to_process.unlock();
         bool can_be_deleted = true;
         try
         {
@@ -396,11 +554,10 @@ void ProtocolManager::update(int ticks)
                 "Synchronous event error from %s: %s", name.c_str(), e.what());
             Log::error("ProtocolManager", (*i)->data().getLogMessage().c_str());
         }
-        m_sync_events_to_process.lock();
         if (can_be_deleted)
         {
             delete *i;
-            i = m_sync_events_to_process.getData().erase(i);
+            i = m_sync_events.erase(i);
         }
         else
         {
@@ -408,7 +565,6 @@ void ProtocolManager::update(int ticks)
             ++i;
         }
     }
-    m_sync_events_to_process.unlock();
 
     // Now update all protocols.
     for (unsigned int i = 0; i < all_protocols.size(); i++)
@@ -437,12 +593,12 @@ void ProtocolManager::asynchronousUpdate()
     auto all_protocols = m_all_protocols;
     ul.unlock();
 
-    m_async_events_to_process.lock();
-    EventList::iterator i = m_async_events_to_process.getData().begin();
-    while (i != m_async_events_to_process.getData().end())
+    Event* event;
+    while (m_async_events_to_process.pop(&event))
+        m_async_events.push_back(event);
+    EventList::iterator i = m_async_events.begin();
+    while (i != m_async_events.end())
     {
-        m_async_events_to_process.unlock();
-
         bool result = true;
         try
         {
@@ -457,11 +613,10 @@ void ProtocolManager::asynchronousUpdate()
                 (*i)->data().getLogMessage().c_str());
         }
 
-        m_async_events_to_process.lock();
         if (result)
         {
             delete *i;
-            i = m_async_events_to_process.getData().erase(i);
+            i = m_async_events.erase(i);
         }
         else
         {
@@ -469,8 +624,7 @@ void ProtocolManager::asynchronousUpdate()
             // or already terminated (e.g. late ping answer)
             ++i;
         }
-    }   // while i != m_events_to_process.end()
-    m_async_events_to_process.unlock();
+    }   // while i != m_async_events.end()
 
     PROFILER_POP_CPU_MARKER();
     PROFILER_PUSH_CPU_MARKER("Message delivery", 255, 0, 0);
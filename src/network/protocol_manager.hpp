@@ -25,10 +25,10 @@
 
 #include "network/network_string.hpp"
 #include "network/protocol.hpp"
+#include "utils/mpsc_queue.hpp"
 #include "utils/no_copy.hpp"
 #include "utils/singleton.hpp"
 #include "utils/stk_process.hpp"
-#include "utils/synchronised.hpp"
 #include "utils/types.hpp"
 
 #include <array>
@@ -70,7 +70,9 @@ class STKPeer;
  *  The sender selects if a message is synchronous or asynchronous. The
  *  network layer (separate thread) calls propagateEvent in the
  *  ProtocolManager, which will add the event to the synchronous or
- *  asynchornous queue.
+ *  asynchornous (lock-free) queue. The asynchronous thread sleeps until an
+ *  event is added, or at most ASYNC_UPDATE_INTERVAL milliseconds so that
+ *  the protocols are still updated regularly.
  *  Protocol start/pause/... requests are also stored in a separate queue,
  *  which is thread-safe, and requests will be handled by the ProtocolManager
  *  thread, to ensure that they are processed independently from the
@@ -152,11 +154,35 @@ private:
 
     /** Contains the network events to pass synchronously to protocols
      *  (i.e. from the main thread). */
-    Synchronised<EventList> m_sync_events_to_process;
+    MPSCQueue<Event*> m_sync_events_to_process;
+
+    /** Synchronous events taken from m_sync_events_to_process which could
+     *  not be delivered yet. Only used in the main thread. */
+    EventList m_sync_events;
 
     /** Contains the network events to pass asynchronously to protocols
     *  (i.e. from the separate ProtocolManager thread). */
-    Synchronised<EventList> m_async_events_to_process;
+    MPSCQueue<Event*> m_async_events_to_process;
+
+    /** Asynchronous events which could not be delivered yet. Only used in
+     *  the asynchronous update thread. */
+    EventList m_async_events;
+
+    /** Used to wake up the asynchronous update thread. */
+    std::condition_variable m_async_cv;
+
+    std::mutex m_async_mutex;
+
+    /** True while the asynchronous update thread is waiting, so that it
+     *  only needs to be notified then. */
+    std::atomic_bool m_async_waiting;
+
+    /** Set to wake up the asynchronous update thread without an event. */
+    std::atomic_bool m_async_wakeup;
+
+    /** Number, total and maximum time in microseconds from receiving a
+     *  message to it being handled, see getEventLatency(). */
+    std::atomic<uint64_t> m_latency_count, m_latency_total, m_latency_max;
 
     /** When set to true, the main thread will exit. */
     std::atomic_bool m_exit;
@@ -182,6 +208,12 @@ private:
 
     void asynchronousUpdate();
 
+    void waitForAsynchronousEvents();
+
+    void wakeUpAsynchronousThread();
+
+    void addEventLatency(const Event* event);
+
 public:
     // ===========================================
     // Public constructor is required for shared_ptr
@@ -194,6 +226,9 @@ public:
     void      requestTerminate(std::shared_ptr<Protocol> protocol);
     void      findAndTerminate(ProtocolType type);
     void      update(int ticks);
+    void      getEventLatency(uint64_t* count, float* average_ms,
+                              float* max_ms, bool reset);
+    static void benchmarkEventLatency();
     // ------------------------------------------------------------------------
     bool isExiting() const                            { return m_exit.load(); }
     // ------------------------------------------------------------------------
@@ -28,9 +28,11 @@
 #include "network/network.hpp"
 #include "network/network_config.hpp"
 #include "network/network_string.hpp"
+#include "network/network_string_pool.hpp"
 #include "network/protocol_manager.hpp"
 #include "network/rewind_info.hpp"
 #include "network/rewind_manager.hpp"
+#include "network/rewinder.hpp"
 #include "network/socket_address.hpp"
 #include "network/stk_host.hpp"
 #include "network/stk_peer.hpp"
@@ -39,6 +41,116 @@
 #include "utils/time.hpp"
 #include "main_loop.hpp"
 
+#include <algorithm>
+
+namespace
+{
+    /** Number of sent states the server keeps as possible baselines for
+     *  deltas, at the default state frequency this is about 3 seconds. */
+    const unsigned MAX_SENT_STATES = 32;
+
+    /** Number of received states a client keeps. This is more than the
+     *  server keeps, so every baseline the server can still refer to is
+     *  available on the client. */
+    const unsigned MAX_RECEIVED_STATES = 64;
+
+    /** Capability of servers and clients that support GP_STATE_DELTA and
+     *  GP_REWINDER_IDS. */
+    const char* STATE_DELTA_CAPABILITY = "state_delta";
+
+    /** Capability of clients which restore their own prediction of a kart
+     *  the server sent with an empty state, see StateRelevance. */
+    const char* KART_RELEVANCE_CAPABILITY = "kart_relevance";
+
+    /** Baseline ticks of a GP_STATE_DELTA that is not a delta. */
+    const uint32_t NO_BASELINE = 0xffffffff;
+
+    /** Largest number of rewinder ids a client accepts, far more than any
+     *  race has, so that a broken message can't allocate arbitrary memory. */
+    const uint32_t MAX_REWINDER_IDS = 65536;
+
+    // ------------------------------------------------------------------------
+    /** Returns the index of the rewinder with the given name in a state, or
+     *  -1 if it is not included.
+     */
+    int findRewinderState(const std::vector<std::string>& names,
+                          const std::string& name)
+    {
+        for (unsigned i = 0; i < names.size(); i++)
+        {
+            if (names[i] == name)
+                return (int)i;
+        }
+        return -1;
+    }   // findRewinderState
+
+    // ------------------------------------------------------------------------
+    /** Appends the difference between a rewinder state and its baseline
+     *  (which must have the same size) to out. Most bytes do not change
+     *  between two states (CompressNetworkBody quantizes all positions and
+     *  velocities), so the delta is a sequence of
+     *  [uint8 unchanged bytes][uint8 n][n changed bytes XOR baseline].
+     */
+    void encodeXorDelta(const uint8_t* baseline, const uint8_t* state,
+                        unsigned size, BareNetworkString* out)
+    {
+        unsigned i = 0;
+        while (i < size)
+        {
+            uint8_t unchanged = 0;
+            while (i < size && unchanged < 255 && state[i] == baseline[i])
+            {
+                unchanged++;
+                i++;
+            }
+            unsigned start = i;
+            uint8_t changed = 0;
+            while (i < size && changed < 255 && state[i] != baseline[i])
+            {
+                changed++;
+                i++;
+            }
+            out->addUInt8(unchanged).addUInt8(changed);
+            for (unsigned j = start; j < i; j++)
+                out->addUInt8(state[j] ^ baseline[j]);
+        }
+    }   // encodeXorDelta
+
+    // ------------------------------------------------------------------------
+    /** Reverses encodeXorDelta.
+     *  \param baseline The state the delta was computed against.
+     *  \param baseline_size Size of the baseline (and the decoded state).
+     *  \param in The network string to read the delta from.
+     *  \param size Size of the encoded delta.
+     *  \param out The decoded state is appended to this buffer.
+     *  \return False if the delta is invalid.
+     */
+    bool decodeXorDelta(const uint8_t* baseline, unsigned baseline_size,
+                        const BareNetworkString& in, unsigned size,
+                        std::vector<uint8_t>* out)
+    {
+        const uint8_t* delta = (const uint8_t*)in.getCurrentData();
+        const size_t start = out->size();
+        unsigned pos = 0;
+        while (out->size() - start < baseline_size)
+        {
+            if (pos + 2 > size)
+                return false;
+            unsigned unchanged = delta[pos++];
+            unsigned changed = delta[pos++];
+            size_t i = out->size() - start;
+            if (i + unchanged + changed > baseline_size ||
+                pos + changed > size)
+                return false;
+            out->insert(out->end(), baseline + i, baseline + i + unchanged);
+            i += unchanged;
+            for (unsigned j = 0; j < changed; j++)
+                out->push_back(baseline[i + j] ^ delta[pos++]);
+        }
+        return pos == size;
+    }   // decodeXorDelta
+}   // anonymous namespace
+
 // ============================================================================
 std::weak_ptr<GameProtocol> GameProtocol::m_game_protocol[PT_COUNT];
 // ============================================================================
@@ -63,12 +175,17 @@ GameProtocol::GameProtocol()
     m_network_item_manager = static_cast<NetworkItemManager*>
         (Track::getCurrentTrack()->getItemManager());
     m_data_to_send = getNetworkString();
+    m_state_message = getNetworkString();
+    m_ack_message = getNetworkString(4);
+    m_received_states = StateHistory(MAX_RECEIVED_STATES);
 }   // GameProtocol
 
 //-----------------------------------------------------------------------------
 GameProtocol::~GameProtocol()
 {
     delete m_data_to_send;
+    delete m_state_message;
+    delete m_ack_message;
 }   // ~GameProtocol
 
 //-----------------------------------------------------------------------------
@@ -131,6 +248,9 @@ bool GameProtocol::notifyEventAsynchronous(Event* event)
     {
     case GP_CONTROLLER_ACTION: handleControllerAction(event); break;
     case GP_STATE:             handleState(event);            break;
+    case GP_STATE_DELTA:       handleStateDelta(event);       break;
+    case GP_STATE_ACK:         handleStateAck(event);         break;
+    case GP_REWINDER_IDS:      handleRewinderIds(event);      break;
     case GP_ITEM_CONFIRMATION: handleItemEventConfirmation(event); break;
     case GP_ADJUST_TIME:
     case GP_ITEM_UPDATE:
@@ -167,8 +287,8 @@ void GameProtocol::controllerAction(int kart_id, PlayerAction action,
     m_all_actions.push_back(a);
     const auto& c = compressAction(a);
     // Store the event in the rewind manager, which is responsible
-    // for freeing the allocated memory
-    BareNetworkString *s = new BareNetworkString(4);
+    // for giving the string back to the pool
+    BareNetworkString *s = NetworkStringPool::get()->getBareNetworkString();
     s->addUInt8(kart_id).addUInt8(std::get<0>(c)).addUInt16(std::get<1>(c))
         .addUInt16(std::get<2>(c)).addUInt16(std::get<3>(c));
 
@@ -227,7 +347,8 @@ void GameProtocol::handleControllerAction(Event *event)
                 cur_ticks, kart_id, std::get<0>(a), std::get<1>(a),
                 std::get<2>(a), std::get<3>(a));
         }
-        BareNetworkString *s = new BareNetworkString(3);
+        BareNetworkString *s =
+            NetworkStringPool::get()->getBareNetworkString();
         s->addUInt8(kart_id).addUInt8(w).addUInt16(x).addUInt16(y)
             .addUInt16(z);
         RewindManager::get()->addNetworkEvent(this, s, cur_ticks);
@@ -281,61 +402,332 @@ void GameProtocol::handleItemEventConfirmation(Event *event)
 // ----------------------------------------------------------------------------
 /** Called by the server before assembling a new message containing the full
  *  state of the race to be sent to a client.
+ *  \return The buffer all rewinders save their state to. Its memory is
+ *          reused for each state.
  */
-void GameProtocol::startNewState()
+BareNetworkString* GameProtocol::startNewState()
 {
     assert(NetworkConfig::get()->isServer());
-    m_data_to_send->clear();
-    m_data_to_send->addUInt8(GP_STATE)
-        .addUInt32(World::getWorld()->getTicksSinceStart());
+    m_current_state.clear(World::getWorld()->getTicksSinceStart());
+    m_state_buffer.getBuffer().clear();
+    m_state_buffer.reset();
+    return &m_state_buffer;
 }   // startNewState
 
 // ----------------------------------------------------------------------------
-/** Called by a server to add data to the current state. The data in buffer
- *  is copied, so the data can be freed after this call/.
- *  \param buffer Adds the data in the buffer to the current state.
+/** Called by a server after a rewinder saved its state to the buffer
+ *  returned by startNewState().
+ *  \param start Offset in the buffer at which the state of the rewinder
+ *         starts.
  */
-void GameProtocol::addState(BareNetworkString *buffer)
+void GameProtocol::addState(unsigned start)
 {
     assert(NetworkConfig::get()->isServer());
-    m_data_to_send->addUInt16(buffer->size());
-    (*m_data_to_send) += *buffer;
+    assert(start == m_current_state.m_offsets.back());
+    m_current_state.m_offsets.push_back(m_state_buffer.getTotalSize());
 }   // addState
 
 // ----------------------------------------------------------------------------
-/** Called by a server to finalize the current state, which add updated
- *  names of rewinder using to the beginning of state buffer
+/** Called by a server to finalize the current state, which sets the names
+ *  of the rewinders used, and assigns a numeric id to each rewinder which
+ *  did not have one yet. The ids are sent to the clients together with the
+ *  next state, see sendRewinderIds().
  *  \param cur_rewinder List of current rewinder using.
  */
 void GameProtocol::finalizeState(std::vector<std::string>& cur_rewinder)
 {
     assert(NetworkConfig::get()->isServer());
-    auto& buffer = m_data_to_send->getBuffer();
-    auto pos = buffer.begin() + 1/*protocol type*/ + 1 /*gp event type*/+
-        4/*time*/;
-
-    m_data_to_send->reset();
-    std::vector<uint8_t> names;
-    names.push_back((uint8_t)cur_rewinder.size());
-    for (std::string& name : cur_rewinder)
+    assert(cur_rewinder.size() + 1 == m_current_state.m_offsets.size());
+    std::swap(m_current_state.m_buffer, m_state_buffer.getBuffer());
+    m_current_state.m_names = cur_rewinder;
+    for (const std::string& name : cur_rewinder)
+        m_current_state.m_ids.push_back(getRewinderId(name));
+}   // finalizeState
+
+// ----------------------------------------------------------------------------
+/** Returns the numeric id of a rewinder on the server, assigning a new one if
+ *  needed. Ids are never reused during a race, so a rewinder being removed
+ *  does not need to be told to the clients.
+ *  \param name Unique identity of the rewinder.
+ */
+uint32_t GameProtocol::getRewinderId(const std::string& name)
+{
+    auto it = m_rewinder_ids.find(name);
+    if (it != m_rewinder_ids.end())
+        return it->second;
+    uint32_t id = (uint32_t)m_rewinder_names.size();
+    m_rewinder_ids[name] = id;
+    m_rewinder_names.push_back(name);
+    return id;
+}   // getRewinderId
+
+// ----------------------------------------------------------------------------
+/** Sends the ids of all rewinders a client does not know yet reliably to
+ *  it, which is at the beginning of a race (or after live join) all of
+ *  them, and later only the ones created since the last state. Since the
+ *  message is sent before the state on the same channel, enet will deliver
+ *  it first.
+ *  \param peer The client.
+ */
+void GameProtocol::sendRewinderIds(STKPeer* peer)
+{
+    unsigned& known = m_peer_known_ids[peer->getHostId()];
+    if (known >= m_rewinder_names.size())
+        return;
+    NetworkString* ns = getNetworkString();
+    ns->addUInt8(GP_REWINDER_IDS).addVarUInt(known)
+        .addVarUInt((uint32_t)m_rewinder_names.size() - known);
+    for (unsigned i = known; i < m_rewinder_names.size(); i++)
+        ns->encodeString(m_rewinder_names[i]);
+    peer->sendPacket(ns, /*reliable*/true);
+    delete ns;
+    known = (unsigned)m_rewinder_names.size();
+}   // sendRewinderIds
+
+// ----------------------------------------------------------------------------
+/** Receives the ids of new rewinders on a client.
+ *  \param event The data from the server.
+ */
+void GameProtocol::handleRewinderIds(Event *event)
+{
+    if (!NetworkConfig::get()->isClient())
+        return;
+    NetworkString &data = event->data();
+    uint32_t first = data.getVarUInt();
+    uint32_t count = data.getVarUInt();
+    // The ids are sent in order, and each one needs at least one byte
+    if (first > m_rewinder_names.size() || count > data.size() ||
+        count > MAX_REWINDER_IDS - first)
     {
-        names.push_back((uint8_t)name.size());
-        std::vector<uint8_t> rewinder(name.begin(), name.end());
-        names.insert(names.end(), rewinder.begin(), rewinder.end());
+        Log::warn("GameProtocol", "Invalid rewinder ids %u + %u.", first,
+                  count);
+        return;
     }
-    buffer.insert(pos, names.begin(), names.end());
-}   // finalizeState
+    if (m_rewinder_names.size() < first + count)
+        m_rewinder_names.resize(first + count);
+    for (uint32_t i = first; i < first + count; i++)
+        data.decodeString(&m_rewinder_names[i]);
+}   // handleRewinderIds
 
 // ----------------------------------------------------------------------------
 /** Called when the last state information has been added and the message
- *  can be sent to the clients.
+ *  can be sent to the clients. Each client only gets the rewinders selected
+ *  by \ref StateRelevance for it, karts left out are sent with an empty
+ *  state. Clients supporting state deltas which have acknowledged a state
+ *  that is still kept get only the difference to that state, all other
+ *  clients (or after packet loss made the acknowledged state too old) get
+ *  the full state.
  */
 void GameProtocol::sendState()
 {
     assert(NetworkConfig::get()->isServer());
-    sendMessageToPeers(m_data_to_send, /*reliable*/false);
+    const StateSnapshot& state = m_current_state;
+    for (unsigned i = 0; i < state.size(); i++)
+    {
+        if (state.m_names[i][0] == RN_PHYSICAL_OBJ)
+        {
+            m_object_states[state.m_names[i]].assign(state.getData(i),
+                state.getData(i) + state.getSize(i));
+        }
+    }
+    m_relevance.startState();
+    bool legacy_state_encoded = false;
+
+    m_host_ids.clear();
+    STKHost::get()->getPeers(&m_peers);
+    for (auto& peer : m_peers)
+    {
+        if (!peer->isValidated() || peer->isWaitingForGame())
+            continue;
+        m_host_ids.insert(peer->getHostId());
+
+        // Physical objects only save a state when they move, so an object
+        // which was left out for this client and stopped moving since then
+        // is added with its last state.
+        m_send_names = state.m_names;
+        m_send_ids = state.m_ids;
+        m_send_data.clear();
+        for (unsigned i = 0; i < state.size(); i++)
+            m_send_data.emplace_back(state.getData(i), state.getSize(i));
+        m_relevance.getSkipped(peer.get(), &m_skipped);
+        for (const std::string* name : m_skipped)
+        {
+            auto object = m_object_states.find(*name);
+            if (object != m_object_states.end() &&
+                findRewinderState(state.m_names, *name) == -1)
+            {
+                m_send_names.push_back(*name);
+                m_send_ids.push_back(getRewinderId(*name));
+                m_send_data.emplace_back(object->second.data(),
+                                         (unsigned)object->second.size());
+            }
+        }
+        m_send_sizes.clear();
+        for (auto& d : m_send_data)
+            m_send_sizes.push_back(d.second);
+        const std::set<std::string>& caps = peer->getClientCapabilities();
+        const bool skip_karts =
+            caps.find(KART_RELEVANCE_CAPABILITY) != caps.end();
+        m_relevance.select(peer.get(), state.m_ticks, m_send_names,
+                           m_send_sizes, skip_karts, &m_send_selected);
+
+        const bool send_all = m_send_names.size() == state.size() &&
+            std::find(m_send_selected.begin(), m_send_selected.end(),
+                      false) == m_send_selected.end();
+        const bool use_delta =
+            caps.find(STATE_DELTA_CAPABILITY) != caps.end();
+        if (send_all && !use_delta)
+        {
+            // Encoded at most once for all clients getting everything
+            if (!legacy_state_encoded)
+            {
+                encodeState(state, m_data_to_send);
+                legacy_state_encoded = true;
+            }
+            peer->sendPacket(m_data_to_send, /*reliable*/false);
+            continue;
+        }
+
+        StateSnapshot& peer_state = m_next_state;
+        peer_state.clear(state.m_ticks);
+        for (unsigned i = 0; i < m_send_names.size(); i++)
+        {
+            if (m_send_selected[i])
+            {
+                peer_state.add(m_send_names[i], m_send_ids[i],
+                               m_send_data[i].first, m_send_data[i].second);
+            }
+            else if (m_send_names[i][0] == RN_KART)
+            {
+                // An empty state tells the client that the kart is still
+                // in the game, and that it should use its own prediction
+                peer_state.add(m_send_names[i], m_send_ids[i], NULL, 0);
+            }
+        }
+        if (!use_delta)
+        {
+            encodeState(peer_state, m_state_message);
+            peer->sendPacket(m_state_message, /*reliable*/false);
+            continue;
+        }
+
+        int acked_ticks = -1;
+        {
+            std::lock_guard<std::mutex> lock(m_peer_acked_mutex);
+            auto it = m_peer_acked_ticks.find(peer->getHostId());
+            if (it != m_peer_acked_ticks.end())
+                acked_ticks = it->second;
+        }
+        auto sent = m_peer_sent_states.find(peer->getHostId());
+        if (sent == m_peer_sent_states.end())
+        {
+            sent = m_peer_sent_states.emplace(peer->getHostId(),
+                StateHistory(MAX_SENT_STATES)).first;
+        }
+        sendRewinderIds(peer.get());
+        encodeStateDelta(sent->second.find(acked_ticks), peer_state,
+                         m_state_message);
+        peer->sendPacket(m_state_message, /*reliable*/false);
+        sent->second.store(&peer_state);
+    }
+    m_peers.clear();
+
+    // Forget about disconnected clients
+    for (auto it = m_peer_sent_states.begin();
+         it != m_peer_sent_states.end();)
+    {
+        if (m_host_ids.find(it->first) == m_host_ids.end())
+            it = m_peer_sent_states.erase(it);
+        else
+            it++;
+    }
+    for (auto it = m_peer_known_ids.begin(); it != m_peer_known_ids.end();)
+    {
+        if (m_host_ids.find(it->first) == m_host_ids.end())
+            it = m_peer_known_ids.erase(it);
+        else
+            it++;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_peer_acked_mutex);
+        for (auto it = m_peer_acked_ticks.begin();
+             it != m_peer_acked_ticks.end();)
+        {
+            if (m_host_ids.find(it->first) == m_host_ids.end())
+                it = m_peer_acked_ticks.erase(it);
+            else
+                it++;
+        }
+    }
+    m_relevance.removeOtherPeers(m_host_ids);
 }   // sendState
 
+// ----------------------------------------------------------------------------
+/** Encodes a full state for clients without the state delta capability,
+ *  which identify each rewinder by its name: the names of all rewinders are
+ *  followed by the size and data of each rewinder.
+ *  \param state The state to send.
+ *  \param ns The message to encode the state in, its content is replaced.
+ */
+void GameProtocol::encodeState(const StateSnapshot& state, NetworkString* ns)
+{
+    ns->clear();
+    ns->addUInt8(GP_STATE).addUInt32(state.m_ticks)
+        .addUInt8((uint8_t)state.size());
+    for (const std::string& name : state.m_names)
+        ns->encodeString(name);
+    for (unsigned i = 0; i < state.size(); i++)
+    {
+        ns->addUInt16((uint16_t)state.getSize(i));
+        ns->getBuffer().insert(ns->getBuffer().end(), state.getData(i),
+                               state.getData(i) + state.getSize(i));
+    }
+}   // encodeState
+
+// ----------------------------------------------------------------------------
+/** Encodes a state for clients with the state delta capability, optionally
+ *  as delta against an earlier state. The message contains the ticks of the
+ *  state and of the baseline (NO_BASELINE if there is none), the number of
+ *  rewinders, and then for each rewinder its numeric id shifted left by one
+ *  with the lowest bit set if the data is a delta, the size of the data and
+ *  the data. Rewinders are only encoded as delta if that is smaller.
+ *  \param baseline The state to compute the delta against, or NULL.
+ *  \param state The state to send.
+ *  \param ns The message to encode the state in, its content is replaced.
+ */
+void GameProtocol::encodeStateDelta(const StateSnapshot* baseline,
+                                    const StateSnapshot& state,
+                                    NetworkString* ns)
+{
+    ns->clear();
+    ns->addUInt8(GP_STATE_DELTA).addUInt32(state.m_ticks)
+        .addUInt32(baseline ? baseline->m_ticks : NO_BASELINE)
+        .addVarUInt(state.size());
+
+    for (unsigned i = 0; i < state.size(); i++)
+    {
+        const uint8_t* data = state.getData(i);
+        const unsigned size = state.getSize(i);
+        const int base = baseline ?
+            findRewinderState(baseline->m_names, state.m_names[i]) : -1;
+        m_delta.getBuffer().clear();
+        m_delta.reset();
+        if (base != -1 && baseline->getSize(base) == size)
+        {
+            encodeXorDelta(baseline->getData(base), data, size, &m_delta);
+            if (m_delta.size() < size)
+            {
+                ns->addVarUInt(state.m_ids[i] << 1 | 1)
+                    .addVarUInt(m_delta.size());
+                (*ns) += m_delta;
+                continue;
+            }
+        }
+        ns->addVarUInt(state.m_ids[i] << 1).addVarUInt(size);
+        ns->getBuffer().insert(ns->getBuffer().end(), data, data + size);
+    }
+}   // encodeStateDelta
+
 // ----------------------------------------------------------------------------
 /** Called when a new full state is received form the server.
  */
@@ -356,12 +748,151 @@ void GameProtocol::handleState(Event *event)
         rewinder_using.push_back(name);
     }
 
+    // Keep a copy of the state if the server can send deltas against it
+    const std::set<std::string>& caps =
+        NetworkConfig::get()->getServerCapabilities();
+    StateSnapshot& state = m_next_state;
+    bool keep_state = caps.find(STATE_DELTA_CAPABILITY) != caps.end();
+    if (keep_state)
+    {
+        const int offset = data.getCurrentOffset();
+        state.clear(ticks);
+        for (unsigned i = 0; i < rewinder_size; i++)
+        {
+            const uint16_t size = data.getUInt16();
+            if (size > data.size())
+            {
+                keep_state = false;
+                break;
+            }
+            state.add(rewinder_using[i], 0,
+                      (const uint8_t*)data.getCurrentData(), size);
+            data.skip(size);
+        }
+        data.reset();
+        data.skip(offset);
+    }
+
     // The memory for bns will be handled in the RewindInfoState object
     RewindInfoState* ris = new RewindInfoState(ticks, data.getCurrentOffset(),
         rewinder_using, data.getBuffer());
     RewindManager::get()->addNetworkRewindInfo(ris);
+
+    if (keep_state)
+    {
+        m_received_states.store(&state);
+        sendStateAck(ticks);
+    }
 }   // handleState
 
+// ----------------------------------------------------------------------------
+/** Called when a state encoded as delta against an earlier state is received
+ *  from the server. The full state is reconstructed and then handled like a
+ *  full state. If the baseline is not known (or the message is invalid) the
+ *  state is dropped and not acknowledged, so the server will send a full
+ *  state again.
+ */
+void GameProtocol::handleStateDelta(Event *event)
+{
+    if (!NetworkConfig::get()->isClient())
+        return;
+    NetworkString &data = event->data();
+    StateSnapshot& state = m_next_state;
+    state.clear(data.getUInt32());
+    const uint32_t baseline_ticks = data.getUInt32();
+    const StateSnapshot* baseline = baseline_ticks == NO_BASELINE ? NULL :
+        m_received_states.find((int)baseline_ticks);
+    if (baseline_ticks != NO_BASELINE && !baseline)
+    {
+        Log::warn("GameProtocol", "Missing baseline %d for state %d.",
+            (int)baseline_ticks, state.m_ticks);
+        return;
+    }
+
+    // The buffer is given to the RewindInfoState, so it is not reused
+    BareNetworkString full_state;
+    const uint32_t rewinder_size = data.getVarUInt();
+    for (uint32_t n = 0; n < rewinder_size; n++)
+    {
+        const uint32_t id_delta = data.getVarUInt();
+        const uint32_t id = id_delta >> 1;
+        const bool is_delta = (id_delta & 1) == 1;
+        const uint32_t size = data.getVarUInt();
+        if (id >= m_rewinder_names.size() || m_rewinder_names[id].empty() ||
+            size > data.size() || (is_delta && !baseline))
+        {
+            Log::warn("GameProtocol", "Invalid state %d.", state.m_ticks);
+            return;
+        }
+        const std::string& name = m_rewinder_names[id];
+        if (is_delta)
+        {
+            const int base = findRewinderState(baseline->m_names, name);
+            if (base == -1 || !decodeXorDelta(baseline->getData(base),
+                baseline->getSize(base), data, size, &state.m_buffer))
+            {
+                Log::warn("GameProtocol", "Invalid state delta %d for %s.",
+                    state.m_ticks, name.c_str());
+                return;
+            }
+        }
+        else
+        {
+            const uint8_t* p = (const uint8_t*)data.getCurrentData();
+            state.m_buffer.insert(state.m_buffer.end(), p, p + size);
+        }
+        data.skip(size);
+        state.m_names.push_back(name);
+        state.m_ids.push_back(id);
+        state.m_offsets.push_back((unsigned)state.m_buffer.size());
+        const unsigned i = state.size() - 1;
+        full_state.addUInt16((uint16_t)state.getSize(i));
+        full_state.getBuffer().insert(full_state.getBuffer().end(),
+            state.getData(i), state.getData(i) + state.getSize(i));
+    }
+
+    std::vector<std::string> rewinder_using = state.m_names;
+    RewindInfoState* ris = new RewindInfoState(state.m_ticks, 0,
+        rewinder_using, full_state.getBuffer());
+    RewindManager::get()->addNetworkRewindInfo(ris);
+    const int ticks = state.m_ticks;
+    m_received_states.store(&state);
+    sendStateAck(ticks);
+}   // handleStateDelta
+
+// ----------------------------------------------------------------------------
+/** Tells the server that the state at the given time was received, so that
+ *  it can be used as baseline for the next states.
+ *  \param ticks Time of the received state.
+ */
+void GameProtocol::sendStateAck(int ticks)
+{
+    assert(NetworkConfig::get()->isClient());
+    m_ack_message->clear();
+    m_ack_message->addUInt8(GP_STATE_ACK).addUInt32(ticks);
+    // A lost acknowledgement only means that an older baseline is used
+    sendToServer(m_ack_message, /*reliable*/false);
+}   // sendStateAck
+
+// ----------------------------------------------------------------------------
+/** Handles a state acknowledgement from a client on the server. Since the
+ *  messages are unreliable they can arrive out of order, so only a newer
+ *  state replaces the baseline of this client.
+ *  \param event The data from the client.
+ */
+void GameProtocol::handleStateAck(Event *event)
+{
+    if (!NetworkConfig::get()->isServer() || !checkDataSize(event, 4))
+        return;
+    int ticks = event->data().getUInt32();
+    std::lock_guard<std::mutex> lock(m_peer_acked_mutex);
+    auto it = m_peer_acked_ticks.find(event->getPeer()->getHostId());
+    if (it == m_peer_acked_ticks.end())
+        m_peer_acked_ticks[event->getPeer()->getHostId()] = ticks;
+    else if (ticks > it->second)
+        it->second = ticks;
+}   // handleStateAck
+
 // ----------------------------------------------------------------------------
 /** Called from the RewindManager when rolling back.
  *  \param buffer Pointer to the saved state information.
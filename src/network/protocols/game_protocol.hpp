@@ -20,20 +20,24 @@
 #define GAME_PROTOCOL_HPP
 
 #include "network/event_rewinder.hpp"
+#include "network/network_string.hpp"
 #include "network/protocol.hpp"
+#include "network/state_relevance.hpp"
 
 #include "input/input.hpp"                // for PlayerAction
 #include "utils/cpp2011.hpp"
 #include "utils/stk_process.hpp"
 
 #include <cstdlib>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <set>
+#include <string>
 #include <vector>
 #include <tuple>
 
-class BareNetworkString;
 class NetworkItemManager;
-class NetworkString;
 class STKPeer;
 
 class GameProtocol : public Protocol
@@ -49,9 +53,95 @@ private:
            GP_STATE,
            GP_ITEM_UPDATE,
            GP_ITEM_CONFIRMATION,
-           GP_ADJUST_TIME
+           GP_ADJUST_TIME,
+           GP_STATE_DELTA,
+           GP_STATE_ACK,
+           GP_REWINDER_IDS
     };
 
+    /** The state of all rewinders at one time, kept by the server to encode
+     *  later states as a delta against it, and by the client to decode such
+     *  deltas. The data of all rewinders is stored in one buffer, so that
+     *  reusing a snapshot for a later state does not allocate memory.
+     */
+    struct StateSnapshot
+    {
+        int                      m_ticks;
+        /** Unique identities of the rewinders in this state. */
+        std::vector<std::string> m_names;
+        /** Server: numeric ids of the rewinders in m_names. */
+        std::vector<uint32_t>    m_ids;
+        /** The state of all rewinders in m_names, one after another. */
+        std::vector<uint8_t>     m_buffer;
+        /** Offset of the state of each rewinder in m_buffer, followed by
+         *  the size of m_buffer. */
+        std::vector<unsigned>    m_offsets;
+        // --------------------------------------------------------------------
+        StateSnapshot() : m_ticks(-1), m_offsets(1, 0) {}
+        // --------------------------------------------------------------------
+        void clear(int ticks)
+        {
+            m_ticks = ticks;
+            m_names.clear();
+            m_ids.clear();
+            m_buffer.clear();
+            m_offsets.assign(1, 0);
+        }   // clear
+        // --------------------------------------------------------------------
+        void add(const std::string& name, uint32_t id, const uint8_t* data,
+                 unsigned size)
+        {
+            m_names.push_back(name);
+            m_ids.push_back(id);
+            m_buffer.insert(m_buffer.end(), data, data + size);
+            m_offsets.push_back((unsigned)m_buffer.size());
+        }   // add
+        // --------------------------------------------------------------------
+        unsigned size() const               { return (unsigned)m_names.size(); }
+        // --------------------------------------------------------------------
+        const uint8_t* getData(unsigned i) const
+                                       { return m_buffer.data() + m_offsets[i]; }
+        // --------------------------------------------------------------------
+        unsigned getSize(unsigned i) const
+                                   { return m_offsets[i + 1] - m_offsets[i]; }
+    };   // struct StateSnapshot
+
+    /** The most recent states sent to a client or received from the server,
+     *  in a ring of snapshots which are reused. A new state is assembled in
+     *  a separate snapshot and swapped into the ring with store(), since it
+     *  can be a delta against the oldest state in the ring. */
+    class StateHistory
+    {
+    private:
+        std::vector<StateSnapshot> m_states;
+        /** Index of the snapshot to be replaced by the next state. */
+        unsigned m_next;
+    public:
+        // --------------------------------------------------------------------
+        StateHistory(unsigned size = 1) : m_states(size), m_next(0) {}
+        // --------------------------------------------------------------------
+        /** Returns the state at the given time, or NULL if it is not kept. */
+        const StateSnapshot* find(int ticks) const
+        {
+            if (ticks < 0)
+                return NULL;
+            for (const StateSnapshot& s : m_states)
+            {
+                if (s.m_ticks == ticks)
+                    return &s;
+            }
+            return NULL;
+        }   // find
+        // --------------------------------------------------------------------
+        /** Adds a state, replacing the oldest one. The content of state is
+         *  swapped with the replaced snapshot, so it can be reused. */
+        void store(StateSnapshot* state)
+        {
+            std::swap(m_states[m_next], *state);
+            m_next = (m_next + 1) % m_states.size();
+        }   // store
+    };   // class StateHistory
+
     /** A network string that collects all information from the server to be sent
      *  next. */
     NetworkString *m_data_to_send;
@@ -74,8 +164,76 @@ private:
     // List of all kart actions to send to the server
     std::vector<Action> m_all_actions;
 
+    /** Server: the state currently being assembled. */
+    StateSnapshot m_current_state;
+
+    /** Server: the buffer the rewinders save their state to, swapped into
+     *  m_current_state by finalizeState(). */
+    BareNetworkString m_state_buffer;
+
+    /** Server: for each peer (by host id) the most recently sent states. */
+    std::map<uint32_t, StateHistory> m_peer_sent_states;
+
+    /** The state sent to a client or received from the server before it is
+     *  stored in a StateHistory. */
+    StateSnapshot m_next_state;
+
+    /** Server: the message a state for a client is encoded in. */
+    NetworkString* m_state_message;
+
+    /** Delta of one rewinder state, see encodeStateDelta(). */
+    BareNetworkString m_delta;
+
+    /** Server: temporary data of sendState(), kept to reuse the memory. */
+    std::vector<std::shared_ptr<STKPeer> > m_peers;
+    std::set<uint32_t> m_host_ids;
+    std::vector<std::string> m_send_names;
+    std::vector<uint32_t> m_send_ids;
+    std::vector<std::pair<const uint8_t*, unsigned> > m_send_data;
+    std::vector<unsigned> m_send_sizes;
+    std::vector<bool> m_send_selected;
+    std::vector<const std::string*> m_skipped;
+
+    /** Server: the last saved state of each physical object. */
+    std::map<std::string, std::vector<uint8_t> > m_object_states;
+
+    /** Server: selects the rewinders sent to each peer. */
+    StateRelevance m_relevance;
+
+    /** Server: numeric id of each rewinder used in a state so far. */
+    std::map<std::string, uint32_t> m_rewinder_ids;
+
+    /** Unique identity of each rewinder by numeric id. On the client this
+     *  is received from the server. */
+    std::vector<std::string> m_rewinder_names;
+
+    /** Server: for each peer (by host id) the number of rewinder ids sent
+     *  to it, see sendRewinderIds(). */
+    std::map<uint32_t, unsigned> m_peer_known_ids;
+
+    /** Client: the most recently received (and decoded) states. */
+    StateHistory m_received_states;
+
+    /** Client: the message state acknowledgements are sent in. */
+    NetworkString* m_ack_message;
+
+    /** Server: for each peer (by host id) the newest state it acknowledged.
+     *  Written in the network thread, read when sending states. */
+    std::map<uint32_t, int> m_peer_acked_ticks;
+
+    std::mutex m_peer_acked_mutex;
+
     void handleControllerAction(Event *event);
     void handleState(Event *event);
+    void handleStateDelta(Event *event);
+    void handleStateAck(Event *event);
+    void handleRewinderIds(Event *event);
+    uint32_t getRewinderId(const std::string& name);
+    void sendRewinderIds(STKPeer* peer);
+    void sendStateAck(int ticks);
+    void encodeState(const StateSnapshot& state, NetworkString* ns);
+    void encodeStateDelta(const StateSnapshot* baseline,
+                          const StateSnapshot& state, NetworkString* ns);
     void handleAdjustTime(Event *event);
     void handleItemEventConfirmation(Event *event);
     static std::weak_ptr<GameProtocol> m_game_protocol[PT_COUNT];
@@ -111,8 +269,8 @@ public:
     void sendActions();
     void controllerAction(int kart_id, PlayerAction action,
                           int value, int val_l, int val_r);
-    void startNewState();
-    void addState(BareNetworkString *buffer);
+    BareNetworkString* startNewState();
+    void addState(unsigned start);
     void sendState();
     void finalizeState(std::vector<std::string>& cur_rewinder);
     void sendItemEventConfirmation(int ticks);
@@ -138,9 +296,6 @@ public:
         return m_game_protocol[pt].lock();
     }   // lock
     // ------------------------------------------------------------------------
-    /** Returns the NetworkString in which a state was saved. */
-    NetworkString* getState() const { return m_data_to_send;  }
-    // ------------------------------------------------------------------------
     std::unique_lock<std::mutex> acquireWorldDeletingMutex() const
                { return std::unique_lock<std::mutex>(m_world_deleting_mutex); }
 };   // class GameProtocol
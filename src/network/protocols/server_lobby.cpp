@@ -30,6 +30,8 @@
 #include "modes/capture_the_flag.hpp"
 #include "modes/linear_world.hpp"
 #include "network/crypto.hpp"
+#include "network/database_index.hpp"
+#include "network/database_worker.hpp"
 #include "network/event.hpp"
 #include "network/game_setup.hpp"
 #include "network/network.hpp"
@@ -163,6 +165,58 @@ sqlite3_extension_init(sqlite3* db, char** pzErrMsg,
 }   // sqlite3_extension_init
 */
 
+// ----------------------------------------------------------------------------
+/** Opens a connection to the server database, and sets it up for the
+ *  server.
+ *  \param path Full path of the database file.
+ *  \return The connection, or NULL if the database could not be opened.
+ */
+static sqlite3* openDatabase(const std::string& path)
+{
+    sqlite3* db = NULL;
+    // No shared cache: the connections of the server and of the database
+    // worker would then lock tables for each other, without waiting in the
+    // busy handler
+    int ret = sqlite3_open_v2(path.c_str(), &db,
+        SQLITE_OPEN_FULLMUTEX | SQLITE_OPEN_READWRITE, NULL);
+    if (ret != SQLITE_OK)
+    {
+        Log::error("ServerLobby", "Cannot open database: %s.",
+            sqlite3_errmsg(db));
+        sqlite3_close(db);
+        return NULL;
+    }
+    sqlite3_busy_handler(db, [](void* data, int retry)
+        {
+            int retry_count = ServerConfig::m_database_timeout / 100;
+            if (retry < retry_count)
+            {
+                sqlite3_sleep(100);
+                // Return non-zero to let caller retry again
+                return 1;
+            }
+            // Return zero to let caller return SQLITE_BUSY immediately
+            return 0;
+        }, NULL);
+    // Readers (like other servers sharing the database) no longer block
+    // writers with write-ahead logging, and commits only need to sync the
+    // log. The journal mode is stored in the database file, so it is set
+    // back if write-ahead logging was disabled.
+    const char* pragmas = ServerConfig::m_database_wal ?
+        "PRAGMA journal_mode=WAL; PRAGMA synchronous=NORMAL;" :
+        "PRAGMA journal_mode=DELETE;";
+    if (sqlite3_exec(db, pragmas, NULL, NULL, NULL) != SQLITE_OK)
+    {
+        Log::error("ServerLobby", "Error running %s: %s", pragmas,
+            sqlite3_errmsg(db));
+    }
+    sqlite3_create_function(db, "insideIPv6CIDR", 2, SQLITE_UTF8, NULL,
+        &insideIPv6CIDRSQL, NULL, NULL);
+    sqlite3_create_function(db, "upperIPv6", 1, SQLITE_UTF8, NULL,
+        &upperIPv6SQL, NULL, NULL);
+    return db;
+}   // openDatabase
+
 #endif
 
 /** This is the central game setup protocol running in the server. It is
@@ -284,33 +338,9 @@ void ServerLobby::initDatabase()
         return;
     const std::string& path = ServerConfig::getConfigDirectory() + "/" +
         ServerConfig::m_database_file.c_str();
-    int ret = sqlite3_open_v2(path.c_str(), &m_db,
-        SQLITE_OPEN_SHAREDCACHE | SQLITE_OPEN_FULLMUTEX |
-        SQLITE_OPEN_READWRITE, NULL);
-    if (ret != SQLITE_OK)
-    {
-        Log::error("ServerLobby", "Cannot open database: %s.",
-            sqlite3_errmsg(m_db));
-        sqlite3_close(m_db);
-        m_db = NULL;
+    m_db = openDatabase(path);
+    if (!m_db)
         return;
-    }
-    sqlite3_busy_handler(m_db, [](void* data, int retry)
-        {
-            int retry_count = ServerConfig::m_database_timeout / 100;
-            if (retry < retry_count)
-            {
-                sqlite3_sleep(100);
-                // Return non-zero to let caller retry again
-                return 1;
-            }
-            // Return zero to let caller return SQLITE_BUSY immediately
-            return 0;
-        }, NULL);
-    sqlite3_create_function(m_db, "insideIPv6CIDR", 2, SQLITE_UTF8, NULL,
-        &insideIPv6CIDRSQL, NULL, NULL);
-    sqlite3_create_function(m_db, "upperIPv6", 1, SQLITE_UTF8, NULL,
-        &upperIPv6SQL, NULL, NULL);
     checkTableExists(ServerConfig::m_ip_ban_table, m_ip_ban_table_exists);
     checkTableExists(ServerConfig::m_ipv6_ban_table, m_ipv6_ban_table_exists);
     checkTableExists(ServerConfig::m_online_id_ban_table,
@@ -321,6 +351,27 @@ void ServerLobby::initDatabase()
         m_ip_geolocation_table_exists);
     checkTableExists(ServerConfig::m_ipv6_geolocation_table,
         m_ipv6_geolocation_table_exists);
+
+    auto table = [](bool exists, const std::string& name)
+        {
+            return exists ? name : std::string();
+        };
+    m_db_index.reset(new DatabaseIndex(m_db,
+        table(m_ip_ban_table_exists, ServerConfig::m_ip_ban_table),
+        table(m_ipv6_ban_table_exists, ServerConfig::m_ipv6_ban_table),
+        table(m_online_id_ban_table_exists,
+        ServerConfig::m_online_id_ban_table),
+        table(m_ip_geolocation_table_exists,
+        ServerConfig::m_ip_geolocation_table),
+        table(m_ipv6_geolocation_table_exists,
+        ServerConfig::m_ipv6_geolocation_table)));
+    // The worker has its own connection, so that its transactions do not
+    // include the queries of the server. Its commits look like changes of
+    // another connection to the index, which only replaces the tables that
+    // actually changed.
+    sqlite3* worker_db = openDatabase(path);
+    if (worker_db)
+        m_db_worker.reset(new DatabaseWorker(worker_db));
 #endif
 }   // initDatabase
 
@@ -541,6 +592,9 @@ void ServerLobby::destroyDatabase()
     auto peers = STKHost::get()->getPeers();
     for (auto& peer : peers)
         writeDisconnectInfoTable(peer.get());
+    // Waits for all queued writes
+    m_db_worker.reset();
+    m_db_index.reset();
     if (m_db != NULL)
         sqlite3_close(m_db);
 #endif
@@ -554,11 +608,17 @@ void ServerLobby::writeDisconnectInfoTable(STKPeer* peer)
         return;
     std::string query = StringUtils::insertValues(
         "UPDATE %s SET disconnected_time = datetime('now'), "
-        "ping = %d, packet_loss = %d "
-        "WHERE host_id = %u;", m_server_stats_table.c_str(),
-        peer->getAveragePing(), peer->getPacketLoss(),
-        peer->getHostId());
-    easySQLQuery(query);
+        "ping = ?, packet_loss = ? "
+        "WHERE host_id = ?;", m_server_stats_table.c_str());
+    uint32_t ping = peer->getAveragePing();
+    int packet_loss = peer->getPacketLoss();
+    uint32_t host_id = peer->getHostId();
+    queueSQLQuery(query, [ping, packet_loss, host_id](sqlite3_stmt* stmt)
+        {
+            sqlite3_bind_int64(stmt, 1, ping);
+            sqlite3_bind_int(stmt, 2, packet_loss);
+            sqlite3_bind_int64(stmt, 3, host_id);
+        }, true/*cache*/);
 #endif
 }   // writeDisconnectInfoTable
 
@@ -960,128 +1020,24 @@ bool ServerLobby::notifyEventAsynchronous(Event* event)
  * 1. Set disconnected time to now for non-exists host.
  * 2. Clear expired player reports if necessary
  * 3. Kick active peer from ban list
+ * Active peers are also checked against the ban list as soon as the ban
+ * tables were changed, see DatabaseIndex.
  */
 void ServerLobby::pollDatabase()
 {
     if (!ServerConfig::m_sql_management || !m_db)
         return;
 
-    if (StkTime::getMonoTimeMs() < m_last_poll_db_time + 60000)
+    m_db_index->update();
+    bool bans_changed = m_db_index->hasChanged();
+    bool poll = StkTime::getMonoTimeMs() >= m_last_poll_db_time + 60000;
+    if (bans_changed || poll)
+        kickBannedPeers();
+    if (!poll)
         return;
 
     m_last_poll_db_time = StkTime::getMonoTimeMs();
 
-    if (m_ip_ban_table_exists)
-    {
-        std::string query =
-            "SELECT ip_start, ip_end, reason, description FROM ";
-        query += ServerConfig::m_ip_ban_table;
-        query += " WHERE datetime('now') > datetime(starting_time) AND "
-            "(expired_days is NULL OR datetime"
-            "(starting_time, '+'||expired_days||' days') > datetime('now'));";
-        auto peers = STKHost::get()->getPeers();
-        sqlite3_exec(m_db, query.c_str(),
-            [](void* ptr, int count, char** data, char** columns)
-            {
-                std::vector<std::shared_ptr<STKPeer> >* peers_ptr =
-                    (std::vector<std::shared_ptr<STKPeer> >*)ptr;
-                for (std::shared_ptr<STKPeer>& p : *peers_ptr)
-                {
-                    // IPv4 ban list atm
-                    if (p->isAIPeer() || p->getAddress().isIPv6())
-                        continue;
-
-                    uint32_t ip_start = 0;
-                    uint32_t ip_end = 0;
-                    if (!StringUtils::fromString(data[0], ip_start))
-                        continue;
-                    if (!StringUtils::fromString(data[1], ip_end))
-                        continue;
-                    uint32_t peer_addr = p->getAddress().getIP();
-                    if (ip_start <= peer_addr && ip_end >= peer_addr)
-                    {
-                        Log::info("ServerLobby",
-                            "Kick %s, reason: %s, description: %s",
-                            p->getAddress().toString().c_str(),
-                            data[2], data[3]);
-                        p->kick();
-                    }
-                }
-                return 0;
-            }, &peers, NULL);
-    }
-
-    if (m_ipv6_ban_table_exists)
-    {
-        std::string query =
-            "SELECT ipv6_cidr, reason, description FROM ";
-        query += ServerConfig::m_ipv6_ban_table;
-        query += " WHERE datetime('now') > datetime(starting_time) AND "
-            "(expired_days is NULL OR datetime"
-            "(starting_time, '+'||expired_days||' days') > datetime('now'));";
-        auto peers = STKHost::get()->getPeers();
-        sqlite3_exec(m_db, query.c_str(),
-            [](void* ptr, int count, char** data, char** columns)
-            {
-                std::vector<std::shared_ptr<STKPeer> >* peers_ptr =
-                    (std::vector<std::shared_ptr<STKPeer> >*)ptr;
-                for (std::shared_ptr<STKPeer>& p : *peers_ptr)
-                {
-                    std::string ipv6;
-                    if (p->getAddress().isIPv6())
-                        ipv6 = p->getAddress().toString(false);
-                    // IPv6 ban list atm
-                    if (p->isAIPeer() || ipv6.empty())
-                        continue;
-
-                    char* ipv6_cidr = data[0];
-                    if (insideIPv6CIDR(ipv6_cidr, ipv6.c_str()) == 1)
-                    {
-                        Log::info("ServerLobby",
-                            "Kick %s, reason: %s, description: %s",
-                            ipv6.c_str(), data[1], data[2]);
-                        p->kick();
-                    }
-                }
-                return 0;
-            }, &peers, NULL);
-    }
-
-    if (m_online_id_ban_table_exists)
-    {
-        std::string query = "SELECT online_id, reason, description FROM ";
-        query += ServerConfig::m_online_id_ban_table;
-        query += " WHERE datetime('now') > datetime(starting_time) AND "
-            "(expired_days is NULL OR datetime"
-            "(starting_time, '+'||expired_days||' days') > datetime('now'));";
-        auto peers = STKHost::get()->getPeers();
-        sqlite3_exec(m_db, query.c_str(),
-            [](void* ptr, int count, char** data, char** columns)
-            {
-                std::vector<std::shared_ptr<STKPeer> >* peers_ptr =
-                    (std::vector<std::shared_ptr<STKPeer> >*)ptr;
-                for (std::shared_ptr<STKPeer>& p : *peers_ptr)
-                {
-                    if (p->isAIPeer()
-                        || p->getPlayerProfiles().empty())
-                        continue;
-
-                    uint32_t online_id = 0;
-                    if (!StringUtils::fromString(data[0], online_id))
-                        continue;
-                    if (online_id == p->getPlayerProfiles()[0]->getOnlineId())
-                    {
-                        Log::info("ServerLobby",
-                            "Kick %s, reason: %s, description: %s",
-                            p->getAddress().toString().c_str(),
-                            data[1], data[2]);
-                        p->kick();
-                    }
-                }
-                return 0;
-            }, &peers, NULL);
-    }
-
     if (m_player_reports_table_exists &&
         ServerConfig::m_player_reports_expired_days != 0.0f)
     {
@@ -1091,7 +1047,7 @@ void ServerLobby::pollDatabase()
             "(reported_time, '+%f days') < datetime('now');",
             ServerConfig::m_player_reports_table.c_str(),
             ServerConfig::m_player_reports_expired_days);
-        easySQLQuery(query);
+        queueSQLQuery(query);
     }
     if (m_server_stats_table.empty())
         return;
@@ -1131,9 +1087,47 @@ void ServerLobby::pollDatabase()
         oss << ");";
         query = oss.str();
     }
-    easySQLQuery(query);
+    queueSQLQuery(query);
 }   // pollDatabase
 
+//-----------------------------------------------------------------------------
+/** Kicks all active peers which are in one of the ban lists. */
+void ServerLobby::kickBannedPeers()
+{
+    auto peers = STKHost::get()->getPeers();
+    DatabaseIndex::Ban ban;
+    for (std::shared_ptr<STKPeer>& p : peers)
+    {
+        if (p->isAIPeer())
+            continue;
+        bool banned = false;
+        if (!p->getAddress().isIPv6())
+        {
+            banned = m_ip_ban_table_exists &&
+                m_db_index->findIPBan(p->getAddress().getIP(), &ban);
+        }
+        else
+        {
+            banned = m_ipv6_ban_table_exists && m_db_index->findIPv6Ban(
+                p->getAddress().toString(false), &ban);
+        }
+        if (!banned && m_online_id_ban_table_exists &&
+            !p->getPlayerProfiles().empty())
+        {
+            banned = m_db_index->findOnlineIdBan(
+                p->getPlayerProfiles()[0]->getOnlineId(), &ban);
+        }
+        if (banned)
+        {
+            Log::info("ServerLobby",
+                "Kick %s, reason: %s, description: %s",
+                p->getAddress().toString().c_str(), ban.m_reason.c_str(),
+                ban.m_description.c_str());
+            p->kick();
+        }
+    }
+}   // kickBannedPeers
+
 //-----------------------------------------------------------------------------
 /** Run simple query with write lock waiting and optional function, this
  *  function has no callback for the return (if any) by the query.
@@ -1170,6 +1164,33 @@ bool ServerLobby::easySQLQuery(const std::string& query,
     return true;
 }   // easySQLQuery
 
+//-----------------------------------------------------------------------------
+/** Runs a query which writes to the database in the database worker thread,
+ *  so that slow database I/O does not stall the server.
+ *  \param cache If the prepared statement should be reused for the same
+ *         query, in which case all values must be bound by bind_function
+ *         instead of being part of the query.
+ *  \param done_function Called in the worker thread with true if the query
+ *         succeeded.
+ *  \param can_drop If the query can be dropped when too many queries are
+ *         waiting. Otherwise this waits for the worker, so it must only be
+ *         false for rare queries which must not be lost, e.g. bans.
+ */
+void ServerLobby::queueSQLQuery(const std::string& query,
+                   std::function<void(sqlite3_stmt* stmt)> bind_function,
+                   bool cache, std::function<void(bool)> done_function,
+                   bool can_drop) const
+{
+    if (!m_db_worker)
+    {
+        if (done_function)
+            done_function(false);
+        return;
+    }
+    m_db_worker->addQuery(query, bind_function, cache, done_function,
+                          can_drop);
+}   // queueSQLQuery
+
 //-----------------------------------------------------------------------------
 /* Write true to result if table name exists in database. */
 void ServerLobby::checkTableExists(const std::string& table, bool& result)
@@ -1218,40 +1239,7 @@ std::string ServerLobby::ip2Country(const SocketAddress& addr) const
 {
     if (!m_db || !m_ip_geolocation_table_exists || addr.isLAN())
         return "";
-
-    std::string cc_code;
-    std::string query = StringUtils::insertValues(
-        "SELECT country_code FROM %s "
-        "WHERE `ip_start` <= %d AND `ip_end` >= %d "
-        "ORDER BY `ip_start` DESC LIMIT 1;",
-        ServerConfig::m_ip_geolocation_table.c_str(), addr.getIP(),
-        addr.getIP());
-
-    sqlite3_stmt* stmt = NULL;
-    int ret = sqlite3_prepare_v2(m_db, query.c_str(), -1, &stmt, 0);
-    if (ret == SQLITE_OK)
-    {
-        ret = sqlite3_step(stmt);
-        if (ret == SQLITE_ROW)
-        {
-            const char* country_code = (char*)sqlite3_column_text(stmt, 0);
-            cc_code = country_code;
-        }
-        ret = sqlite3_finalize(stmt);
-        if (ret != SQLITE_OK)
-        {
-            Log::error("ServerLobby",
-                "Error finalize database for query %s: %s",
-                query.c_str(), sqlite3_errmsg(m_db));
-        }
-    }
-    else
-    {
-        Log::error("ServerLobby", "Error preparing database for query %s: %s",
-            query.c_str(), sqlite3_errmsg(m_db));
-        return "";
-    }
-    return cc_code;
+    return m_db_index->ip2Country(addr.getIP());
 }   // ip2Country
 
 //-----------------------------------------------------------------------------
@@ -1259,41 +1247,7 @@ std::string ServerLobby::ipv62Country(const SocketAddress& addr) const
 {
     if (!m_db || !m_ipv6_geolocation_table_exists)
         return "";
-
-    std::string cc_code;
-    const std::string& ipv6 = addr.toString(false/*show_port*/);
-    std::string query = StringUtils::insertValues(
-        "SELECT country_code FROM %s "
-        "WHERE `ip_start` <= upperIPv6(\"%s\") AND `ip_end` >= upperIPv6(\"%s\") "
-        "ORDER BY `ip_start` DESC LIMIT 1;",
-        ServerConfig::m_ipv6_geolocation_table.c_str(), ipv6.c_str(),
-        ipv6.c_str());
-
-    sqlite3_stmt* stmt = NULL;
-    int ret = sqlite3_prepare_v2(m_db, query.c_str(), -1, &stmt, 0);
-    if (ret == SQLITE_OK)
-    {
-        ret = sqlite3_step(stmt);
-        if (ret == SQLITE_ROW)
-        {
-            const char* country_code = (char*)sqlite3_column_text(stmt, 0);
-            cc_code = country_code;
-        }
-        ret = sqlite3_finalize(stmt);
-        if (ret != SQLITE_OK)
-        {
-            Log::error("ServerLobby",
-                "Error finalize database for query %s: %s",
-                query.c_str(), sqlite3_errmsg(m_db));
-        }
-    }
-    else
-    {
-        Log::error("ServerLobby", "Error preparing database for query %s: %s",
-            query.c_str(), sqlite3_errmsg(m_db));
-        return "";
-    }
-    return cc_code;
+    return m_db_index->ipv62Country(addr.toString(false/*show_port*/));
 }   // ipv62Country
 
 #endif
@@ -1347,47 +1301,53 @@ void ServerLobby::writePlayerReport(Event* event)
             reporter->getAddress().getIP(), reporter_npp->getOnlineId(),
             reporting_peer->getAddress().getIP(), reporting_npp->getOnlineId());
     }
-    bool written = easySQLQuery(query,
-        [reporter_npp, reporting_npp, info](sqlite3_stmt* stmt)
+    std::string reporter_name =
+        StringUtils::wideToUtf8(reporter_npp->getName());
+    std::string reporting_name =
+        StringUtils::wideToUtf8(reporting_npp->getName());
+    std::string info_utf8 = StringUtils::wideToUtf8(info);
+    std::string server_uid = ServerConfig::m_server_uid;
+
+    NetworkString* success = getNetworkString();
+    success->setSynchronous(true);
+    success->addUInt8(LE_REPORT_PLAYER).addUInt8(1)
+        .encodeString(reporting_npp->getName());
+    std::shared_ptr<STKPeer> reporter_peer = event->getPeerSP();
+    queueSQLQuery(query,
+        [server_uid, reporter_name, info_utf8, reporting_name]
+        (sqlite3_stmt* stmt)
         {
             // SQLITE_TRANSIENT to copy string
-            if (sqlite3_bind_text(stmt, 1, ServerConfig::m_server_uid.c_str(),
+            if (sqlite3_bind_text(stmt, 1, server_uid.c_str(),
                 -1, SQLITE_TRANSIENT) != SQLITE_OK)
             {
-                Log::error("easySQLQuery", "Failed to bind %s.",
-                    ServerConfig::m_server_uid.c_str());
+                Log::error("queueSQLQuery", "Failed to bind %s.",
+                    server_uid.c_str());
             }
-            if (sqlite3_bind_text(stmt, 2,
-                StringUtils::wideToUtf8(reporter_npp->getName()).c_str(),
+            if (sqlite3_bind_text(stmt, 2, reporter_name.c_str(),
                 -1, SQLITE_TRANSIENT) != SQLITE_OK)
             {
-                Log::error("easySQLQuery", "Failed to bind %s.",
-                    StringUtils::wideToUtf8(reporter_npp->getName()).c_str());
+                Log::error("queueSQLQuery", "Failed to bind %s.",
+                    reporter_name.c_str());
             }
-            if (sqlite3_bind_text(stmt, 3,
-                StringUtils::wideToUtf8(info).c_str(),
+            if (sqlite3_bind_text(stmt, 3, info_utf8.c_str(),
                 -1, SQLITE_TRANSIENT) != SQLITE_OK)
             {
-                Log::error("easySQLQuery", "Failed to bind %s.",
-                    StringUtils::wideToUtf8(info).c_str());
+                Log::error("queueSQLQuery", "Failed to bind %s.",
+                    info_utf8.c_str());
             }
-            if (sqlite3_bind_text(stmt, 4,
-                StringUtils::wideToUtf8(reporting_npp->getName()).c_str(),
+            if (sqlite3_bind_text(stmt, 4, reporting_name.c_str(),
                 -1, SQLITE_TRANSIENT) != SQLITE_OK)
             {
-                Log::error("easySQLQuery", "Failed to bind %s.",
-                    StringUtils::wideToUtf8(reporting_npp->getName()).c_str());
+                Log::error("queueSQLQuery", "Failed to bind %s.",
+                    reporting_name.c_str());
             }
+        }, false/*cache*/, [success, reporter_peer](bool written)
+        {
+            if (written)
+                reporter_peer->sendPacket(success, true/*reliable*/);
+            delete success;
         });
-    if (written)
-    {
-        NetworkString* success = getNetworkString();
-        success->setSynchronous(true);
-        success->addUInt8(LE_REPORT_PLAYER).addUInt8(1)
-            .encodeString(reporting_npp->getName());
-        event->getPeer()->sendPacket(success, true/*reliable*/);
-        delete success;
-    }
 #endif
 }   // writePlayerReport
 
@@ -3405,7 +3365,14 @@ void ServerLobby::saveIPBanTable(const SocketAddress& addr)
         "INSERT INTO %s (ip_start, ip_end) "
         "VALUES (%u, %u);",
         ServerConfig::m_ip_ban_table.c_str(), addr.getIP(), addr.getIP());
-    easySQLQuery(query);
+    DatabaseIndex* index = m_db_index.get();
+    // The index notices the change of the database with the next check,
+    // but the new ban should be effective as soon as it is written
+    queueSQLQuery(query, nullptr, false, [index](bool written)
+        {
+            if (written)
+                index->requestReload();
+        }, false/*can_drop*/);
 #endif
 }   // saveIPBanTable
 
@@ -3888,17 +3855,18 @@ void ServerLobby::handleUnencryptedConnection(std::shared_ptr<STKPeer> peer,
 #ifdef ENABLE_SQLITE3
     if (m_server_stats_table.empty() || peer->isAIPeer())
         return;
+    // All values are bound, so that the prepared statement can be reused
     std::string query;
+    std::string ipv6;
     if (ServerConfig::m_ipv6_connection && peer->getAddress().isIPv6())
     {
+        ipv6 = peer->getAddress().toString(false);
         query = StringUtils::insertValues(
             "INSERT INTO %s "
             "(host_id, ip, ipv6 ,port, online_id, username, player_num, "
             "country_code, version, os, ping) "
-            "VALUES (%u, 0, \"%s\" ,%u, %u, ?, %u, ?, ?, ?, %u);",
-            m_server_stats_table.c_str(), peer->getHostId(),
-            peer->getAddress().toString(false), peer->getAddress().getPort(),
-            online_id, player_count, peer->getAveragePing());
+            "VALUES (?, 0, ? ,?, ?, ?, ?, ?, ?, ?, ?);",
+            m_server_stats_table.c_str());
     }
     else
     {
@@ -3906,54 +3874,70 @@ void ServerLobby::handleUnencryptedConnection(std::shared_ptr<STKPeer> peer,
             "INSERT INTO %s "
             "(host_id, ip, port, online_id, username, player_num, "
             "country_code, version, os, ping) "
-            "VALUES (%u, %u, %u, %u, ?, %u, ?, ?, ?, %u);",
-            m_server_stats_table.c_str(), peer->getHostId(),
-            peer->getAddress().getIP(), peer->getAddress().getPort(),
-            online_id, player_count, peer->getAveragePing());
+            "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?);",
+            m_server_stats_table.c_str());
     }
-    easySQLQuery(query, [peer, country_code](sqlite3_stmt* stmt)
-        {
-            if (sqlite3_bind_text(stmt, 1, StringUtils::wideToUtf8(
-                peer->getPlayerProfiles()[0]->getName()).c_str(),
+    // The query runs in the database thread, so copy everything from peer
+    uint32_t host_id = peer->getHostId();
+    uint32_t ip = peer->getAddress().getIP();
+    uint16_t port = peer->getAddress().getPort();
+    std::string name = StringUtils::wideToUtf8(
+        peer->getPlayerProfiles()[0]->getName());
+    auto version_os = StringUtils::extractVersionOS(peer->getUserVersion());
+    uint32_t ping = peer->getAveragePing();
+    queueSQLQuery(query, [host_id, ip, port, name, country_code, ipv6,
+        online_id, player_count, version_os, ping](sqlite3_stmt* stmt)
+        {
+            int i = 1;
+            sqlite3_bind_int64(stmt, i++, host_id);
+            if (ipv6.empty())
+                sqlite3_bind_int64(stmt, i++, ip);
+            else if (sqlite3_bind_text(stmt, i++, ipv6.c_str(), -1,
+                SQLITE_TRANSIENT) != SQLITE_OK)
+            {
+                Log::error("queueSQLQuery", "Failed to bind %s.",
+                    ipv6.c_str());
+            }
+            sqlite3_bind_int64(stmt, i++, port);
+            sqlite3_bind_int64(stmt, i++, online_id);
+            if (sqlite3_bind_text(stmt, i++, name.c_str(),
                 -1, SQLITE_TRANSIENT) != SQLITE_OK)
             {
-                Log::error("easySQLQuery", "Failed to bind %s.",
-                    StringUtils::wideToUtf8(
-                    peer->getPlayerProfiles()[0]->getName()).c_str());
+                Log::error("queueSQLQuery", "Failed to bind %s.",
+                    name.c_str());
             }
+            sqlite3_bind_int64(stmt, i++, player_count);
             if (country_code.empty())
             {
-                if (sqlite3_bind_null(stmt, 2) != SQLITE_OK)
+                if (sqlite3_bind_null(stmt, i++) != SQLITE_OK)
                 {
-                    Log::error("easySQLQuery",
+                    Log::error("queueSQLQuery",
                         "Failed to bind NULL for country code.");
                 }
             }
             else
             {
-                if (sqlite3_bind_text(stmt, 2, country_code.c_str(),
+                if (sqlite3_bind_text(stmt, i++, country_code.c_str(),
                     -1, SQLITE_TRANSIENT) != SQLITE_OK)
                 {
-                    Log::error("easySQLQuery", "Failed to bind country: %s.",
+                    Log::error("queueSQLQuery", "Failed to bind country: %s.",
                         country_code.c_str());
                 }
             }
-            auto version_os =
-                StringUtils::extractVersionOS(peer->getUserVersion());
-            if (sqlite3_bind_text(stmt, 3, version_os.first.c_str(),
+            if (sqlite3_bind_text(stmt, i++, version_os.first.c_str(),
                 -1, SQLITE_TRANSIENT) != SQLITE_OK)
             {
-                Log::error("easySQLQuery", "Failed to bind %s.",
+                Log::error("queueSQLQuery", "Failed to bind %s.",
                     version_os.first.c_str());
             }
-            if (sqlite3_bind_text(stmt, 4, version_os.second.c_str(),
+            if (sqlite3_bind_text(stmt, i++, version_os.second.c_str(),
                 -1, SQLITE_TRANSIENT) != SQLITE_OK)
             {
-                Log::error("easySQLQuery", "Failed to bind %s.",
+                Log::error("queueSQLQuery", "Failed to bind %s.",
                     version_os.second.c_str());
             }
-        }
-    );
+            sqlite3_bind_int64(stmt, i++, ping);
+        }, true/*cache*/);
 #endif
 }   // handleUnencryptedConnection
 
@@ -4798,59 +4782,27 @@ void ServerLobby::testBannedForIP(STKPeer* peer) const
     if (peer->getAddress().isIPv6())
         return;
 
-    int row_id = -1;
-    unsigned ip_start = 0;
-    unsigned ip_end = 0;
-    std::string query = StringUtils::insertValues(
-        "SELECT rowid, ip_start, ip_end, reason, description FROM %s "
-        "WHERE ip_start <= %u AND ip_end >= %u "
-        "AND datetime('now') > datetime(starting_time) AND "
-        "(expired_days is NULL OR datetime"
-        "(starting_time, '+'||expired_days||' days') > datetime('now')) "
-        "LIMIT 1;",
-        ServerConfig::m_ip_ban_table.c_str(),
-        peer->getAddress().getIP(), peer->getAddress().getIP());
-
-    sqlite3_stmt* stmt = NULL;
-    int ret = sqlite3_prepare_v2(m_db, query.c_str(), -1, &stmt, 0);
-    if (ret == SQLITE_OK)
-    {
-        ret = sqlite3_step(stmt);
-        if (ret == SQLITE_ROW)
-        {
-            row_id = sqlite3_column_int(stmt, 0);
-            ip_start = (unsigned)sqlite3_column_int64(stmt, 1);
-            ip_end = (unsigned)sqlite3_column_int64(stmt, 2);
-            const char* reason = (char*)sqlite3_column_text(stmt, 3);
-            const char* desc = (char*)sqlite3_column_text(stmt, 4);
-            Log::info("ServerLobby", "%s banned by IP: %s "
-                "(rowid: %d, description: %s).",
-                peer->getAddress().toString().c_str(), reason, row_id, desc);
-            kickPlayerWithReason(peer, reason);
-        }
-        ret = sqlite3_finalize(stmt);
-        if (ret != SQLITE_OK)
-        {
-            Log::error("ServerLobby",
-                "Error finalize database for query %s: %s",
-                query.c_str(), sqlite3_errmsg(m_db));
-        }
-    }
-    else
-    {
-        Log::error("ServerLobby", "Error preparing database for query %s: %s",
-            query.c_str(), sqlite3_errmsg(m_db));
+    DatabaseIndex::Ban ban;
+    if (!m_db_index->findIPBan(peer->getAddress().getIP(), &ban))
         return;
-    }
-    if (row_id != -1)
-    {
-        query = StringUtils::insertValues(
-            "UPDATE %s SET trigger_count = trigger_count + 1, "
-            "last_trigger = datetime('now') "
-            "WHERE ip_start = %u AND ip_end = %u;",
-            ServerConfig::m_ip_ban_table.c_str(), ip_start, ip_end);
-        easySQLQuery(query);
-    }
+    Log::info("ServerLobby", "%s banned by IP: %s "
+        "(rowid: %d, description: %s).",
+        peer->getAddress().toString().c_str(), ban.m_reason.c_str(),
+        (int)ban.m_row_id, ban.m_description.c_str());
+    kickPlayerWithReason(peer, ban.m_reason.c_str());
+
+    std::string query = StringUtils::insertValues(
+        "UPDATE %s SET trigger_count = trigger_count + 1, "
+        "last_trigger = datetime('now') "
+        "WHERE ip_start = ? AND ip_end = ?;",
+        ServerConfig::m_ip_ban_table.c_str());
+    uint32_t ip_start = ban.m_ip_start;
+    uint32_t ip_end = ban.m_ip_end;
+    queueSQLQuery(query, [ip_start, ip_end](sqlite3_stmt* stmt)
+        {
+            sqlite3_bind_int64(stmt, 1, ip_start);
+            sqlite3_bind_int64(stmt, 2, ip_end);
+        }, true/*cache*/);
 #endif
 }   // testBannedForIP
 
@@ -4865,71 +4817,29 @@ void ServerLobby::testBannedForIPv6(STKPeer* peer) const
     if (!peer->getAddress().isIPv6())
         return;
 
-    int row_id = -1;
-    std::string ipv6_cidr;
-    std::string query = StringUtils::insertValues(
-        "SELECT rowid, ipv6_cidr, reason, description FROM %s "
-        "WHERE insideIPv6CIDR(ipv6_cidr, ?) = 1 "
-        "AND datetime('now') > datetime(starting_time) AND "
-        "(expired_days is NULL OR datetime"
-        "(starting_time, '+'||expired_days||' days') > datetime('now')) "
-        "LIMIT 1;",
-        ServerConfig::m_ipv6_ban_table.c_str());
-
-    sqlite3_stmt* stmt = NULL;
-    int ret = sqlite3_prepare_v2(m_db, query.c_str(), -1, &stmt, 0);
-    if (ret == SQLITE_OK)
-    {
-        if (sqlite3_bind_text(stmt, 1,
-            peer->getAddress().toString(false).c_str(), -1, SQLITE_TRANSIENT)
-            != SQLITE_OK)
-        {
-            Log::error("ServerLobby", "Error binding ipv6 addr for query: %s",
-                sqlite3_errmsg(m_db));
-        }
+    DatabaseIndex::Ban ban;
+    if (!m_db_index->findIPv6Ban(peer->getAddress().toString(false), &ban))
+        return;
+    Log::info("ServerLobby", "%s banned by IP: %s "
+        "(rowid: %d, description: %s).",
+        peer->getAddress().toString().c_str(), ban.m_reason.c_str(),
+        (int)ban.m_row_id, ban.m_description.c_str());
+    kickPlayerWithReason(peer, ban.m_reason.c_str());
 
-        ret = sqlite3_step(stmt);
-        if (ret == SQLITE_ROW)
-        {
-            row_id = sqlite3_column_int(stmt, 0);
-            ipv6_cidr = (char*)sqlite3_column_text(stmt, 1);
-            const char* reason = (char*)sqlite3_column_text(stmt, 2);
-            const char* desc = (char*)sqlite3_column_text(stmt, 3);
-            Log::info("ServerLobby", "%s banned by IP: %s "
-                "(rowid: %d, description: %s).",
-                peer->getAddress().toString().c_str(), reason, row_id, desc);
-            kickPlayerWithReason(peer, reason);
-        }
-        ret = sqlite3_finalize(stmt);
-        if (ret != SQLITE_OK)
+    std::string query = StringUtils::insertValues(
+        "UPDATE %s SET trigger_count = trigger_count + 1, "
+        "last_trigger = datetime('now') "
+        "WHERE ipv6_cidr = ?;", ServerConfig::m_ipv6_ban_table.c_str());
+    std::string cidr = ban.m_ipv6_cidr;
+    queueSQLQuery(query, [cidr](sqlite3_stmt* stmt)
         {
-            Log::error("ServerLobby",
-                "Error finalize database for query %s: %s",
-                query.c_str(), sqlite3_errmsg(m_db));
-        }
-    }
-    else
-    {
-        Log::error("ServerLobby", "Error preparing database for query %s: %s",
-            query.c_str(), sqlite3_errmsg(m_db));
-        return;
-    }
-    if (row_id != -1)
-    {
-        query = StringUtils::insertValues(
-            "UPDATE %s SET trigger_count = trigger_count + 1, "
-            "last_trigger = datetime('now') "
-            "WHERE ipv6_cidr = ?;", ServerConfig::m_ipv6_ban_table.c_str());
-        easySQLQuery(query, [ipv6_cidr](sqlite3_stmt* stmt)
+            if (sqlite3_bind_text(stmt, 1, cidr.c_str(),
+                -1, SQLITE_TRANSIENT) != SQLITE_OK)
             {
-                if (sqlite3_bind_text(stmt, 1, ipv6_cidr.c_str(),
-                    -1, SQLITE_TRANSIENT) != SQLITE_OK)
-                {
-                    Log::error("easySQLQuery", "Failed to bind %s.",
-                        ipv6_cidr.c_str());
-                }
-            });
-    }
+                Log::error("queueSQLQuery", "Failed to bind %s.",
+                    cidr.c_str());
+            }
+        }, true/*cache*/);
 #endif
 }   // testBannedForIPv6
 
@@ -4941,54 +4851,24 @@ void ServerLobby::testBannedForOnlineId(STKPeer* peer,
     if (!m_db || !m_online_id_ban_table_exists)
         return;
 
-    int row_id = -1;
-    std::string query = StringUtils::insertValues(
-        "SELECT rowid, reason, description FROM %s "
-        "WHERE online_id = %u "
-        "AND datetime('now') > datetime(starting_time) AND "
-        "(expired_days is NULL OR datetime"
-        "(starting_time, '+'||expired_days||' days') > datetime('now')) "
-        "LIMIT 1;",
-        ServerConfig::m_online_id_ban_table.c_str(), online_id);
-
-    sqlite3_stmt* stmt = NULL;
-    int ret = sqlite3_prepare_v2(m_db, query.c_str(), -1, &stmt, 0);
-    if (ret == SQLITE_OK)
-    {
-        ret = sqlite3_step(stmt);
-        if (ret == SQLITE_ROW)
-        {
-            row_id = sqlite3_column_int(stmt, 0);
-            const char* reason = (char*)sqlite3_column_text(stmt, 1);
-            const char* desc = (char*)sqlite3_column_text(stmt, 2);
-            Log::info("ServerLobby", "%s banned by online id: %s "
-                "(online id: %u rowid: %d, description: %s).",
-                peer->getAddress().toString().c_str(), reason, online_id,
-                row_id, desc);
-            kickPlayerWithReason(peer, reason);
-        }
-        ret = sqlite3_finalize(stmt);
-        if (ret != SQLITE_OK)
-        {
-            Log::error("ServerLobby", "Error finalize database: %s",
-                sqlite3_errmsg(m_db));
-        }
-    }
-    else
-    {
-        Log::error("ServerLobby", "Error preparing database: %s",
-            sqlite3_errmsg(m_db));
+    DatabaseIndex::Ban ban;
+    if (!m_db_index->findOnlineIdBan(online_id, &ban))
         return;
-    }
-    if (row_id != -1)
-    {
-        query = StringUtils::insertValues(
-            "UPDATE %s SET trigger_count = trigger_count + 1, "
-            "last_trigger = datetime('now') "
-            "WHERE online_id = %u;",
-            ServerConfig::m_online_id_ban_table.c_str(), online_id);
-        easySQLQuery(query);
-    }
+    Log::info("ServerLobby", "%s banned by online id: %s "
+        "(online id: %u rowid: %d, description: %s).",
+        peer->getAddress().toString().c_str(), ban.m_reason.c_str(),
+        online_id, (int)ban.m_row_id, ban.m_description.c_str());
+    kickPlayerWithReason(peer, ban.m_reason.c_str());
+
+    std::string query = StringUtils::insertValues(
+        "UPDATE %s SET trigger_count = trigger_count + 1, "
+        "last_trigger = datetime('now') "
+        "WHERE online_id = ?;",
+        ServerConfig::m_online_id_ban_table.c_str());
+    queueSQLQuery(query, [online_id](sqlite3_stmt* stmt)
+        {
+            sqlite3_bind_int64(stmt, 1, online_id);
+        }, true/*cache*/);
 #endif
 }   // testBannedForOnlineId
 
@@ -5027,6 +4907,30 @@ void ServerLobby::listBanTable()
 #endif
 }   // listBanTable
 
+//-----------------------------------------------------------------------------
+/** Prints the number of queued writes and the time they took since the last
+ *  call. */
+void ServerLobby::showDatabaseStatistics()
+{
+#ifdef ENABLE_SQLITE3
+    if (!m_db_worker)
+    {
+        std::cout << "No database" << std::endl;
+        return;
+    }
+    uint64_t count;
+    float average_ms, max_ms;
+    unsigned max_queue_size, dropped_count;
+    m_db_worker->getStatistics(&count, &average_ms, &max_ms, &max_queue_size,
+        &dropped_count, /*reset*/true);
+    std::cout << "Queued queries: " << m_db_worker->getQueueSize() <<
+        "   Maximum queued: " << max_queue_size << "   Dropped: " <<
+        dropped_count << "\nQueries: " << count <<
+        "   Average latency (ms): " << average_ms <<
+        "   Maximum latency (ms): " << max_ms << std::endl;
+#endif
+}   // showDatabaseStatistics
+
 //-----------------------------------------------------------------------------
 float ServerLobby::getStartupBoostOrPenaltyForKart(uint32_t ping,
                                                    unsigned kart_id)
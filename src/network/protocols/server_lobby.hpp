@@ -39,6 +39,8 @@
 #endif
 
 class BareNetworkString;
+class DatabaseIndex;
+class DatabaseWorker;
 class NetworkItemManager;
 class NetworkString;
 class NetworkPlayerProfile;
@@ -97,11 +99,25 @@ private:
 
     uint64_t m_last_poll_db_time;
 
+    /* Ban and geolocation tables kept in memory. */
+    std::unique_ptr<DatabaseIndex> m_db_index;
+
+    /* Runs all writes to the database in a separate thread. */
+    std::unique_ptr<DatabaseWorker> m_db_worker;
+
     void pollDatabase();
 
+    void kickBannedPeers();
+
     bool easySQLQuery(const std::string& query,
         std::function<void(sqlite3_stmt* stmt)> bind_function = nullptr) const;
 
+    void queueSQLQuery(const std::string& query,
+        std::function<void(sqlite3_stmt* stmt)> bind_function = nullptr,
+        bool cache = false,
+        std::function<void(bool)> done_function = nullptr,
+        bool can_drop = true) const;
+
     void checkTableExists(const std::string& table, bool& result);
 
     std::string ip2Country(const SocketAddress& addr) const;
@@ -404,6 +420,7 @@ public:
     void saveInitialItems(std::shared_ptr<NetworkItemManager> nim);
     void saveIPBanTable(const SocketAddress& addr);
     void listBanTable();
+    void showDatabaseStatistics();
     void initServerStatsTable();
     bool isAIProfile(const std::shared_ptr<NetworkPlayerProfile>& npp) const
     {
@@ -21,6 +21,7 @@
 
 #include "network/event_rewinder.hpp"
 #include "network/network_string.hpp"
+#include "network/network_string_pool.hpp"
 #include "utils/cpp2011.hpp"
 #include "utils/leak_check.hpp"
 #include "utils/ptr_vector.hpp"
@@ -114,6 +115,13 @@ public:
     /** Returns a pointer to the state buffer. */
     BareNetworkString *getBuffer() const { return m_buffer; }
     // ------------------------------------------------------------------------
+    /** Returns the names of the rewinders in this state. */
+    const std::vector<std::string>& getRewinderUsing() const
+                                                   { return m_rewinder_using; }
+    // ------------------------------------------------------------------------
+    /** Returns the offset of the first rewinder's data in the buffer. */
+    int getStartOffset() const { return m_start_offset; }
+    // ------------------------------------------------------------------------
     virtual bool isState() const { return true; }
     // ------------------------------------------------------------------------
     /** Called when going back in time to undo any rewind information.
@@ -145,7 +153,7 @@ public:
                              BareNetworkString *buffer, bool is_confirmed);
     virtual ~RewindInfoEvent()
     {
-        delete m_buffer;
+        NetworkStringPool::get()->release(m_buffer);
     }   // ~RewindInfoEvent
 
     // ------------------------------------------------------------------------
@@ -18,6 +18,7 @@
 
 #include "network/rewind_manager.hpp"
 
+#include "config/user_config.hpp"
 #include "graphics/irr_driver.hpp"
 #include "modes/soccer_world.hpp"
 #include "network/network_config.hpp"
@@ -36,6 +37,14 @@
 #include "utils/profiler.hpp"
 
 #include <algorithm>
+#include <cstring>
+
+namespace
+{
+    /** Number of predicted states kept on a client. States from the server
+     *  older than that (i.e. with a very high ping) always cause a rewind. */
+    const unsigned PREDICTED_STATES = 32;
+}   // anonymous namespace
 
 RewindManager* RewindManager::m_rewind_manager[PT_COUNT];
 std::atomic_bool RewindManager::m_enable_rewind_manager(false);
@@ -64,6 +73,9 @@ void RewindManager::destroy()
  */
 RewindManager::RewindManager()
 {
+    m_rewind_count = 0;
+    m_skipped_rewind_count = 0;
+    m_rewound_ticks = 0;
     reset();
 }   // RewindManager
 
@@ -90,6 +102,20 @@ void RewindManager::reset()
     m_state_frequency = stk_config->getPhysicsFPS() /
         NetworkConfig::get()->getStateFrequency();
 
+    if (m_rewind_count > 0 || m_skipped_rewind_count > 0)
+    {
+        Log::info("RewindManager", "%d rewinds (%d ticks simulated again), "
+            "%d rewinds skipped.", m_rewind_count, m_rewound_ticks,
+            m_skipped_rewind_count);
+    }
+    m_rewind_count = 0;
+    m_skipped_rewind_count = 0;
+    m_rewound_ticks = 0;
+    m_predicted_states.resize(PREDICTED_STATES);
+    for (PredictedState& ps : m_predicted_states)
+        ps.m_ticks = -1;
+    m_next_predicted_state = 0;
+
     if (!m_enable_rewind_manager) return;
 
     clearExpiredRewinder();
@@ -149,7 +175,9 @@ void RewindManager::addNetworkState(BareNetworkString *buffer, int ticks)
 
 // ----------------------------------------------------------------------------
 /** Saves a state using the GameProtocol function to combine several
- *  independent rewinders to write one state.
+ *  independent rewinders to write one state. All rewinders write directly
+ *  into the state buffer of the GameProtocol, whose memory is reused for
+ *  each state.
  */
 void RewindManager::saveState()
 {
@@ -157,26 +185,22 @@ void RewindManager::saveState()
     auto gp = GameProtocol::lock();
     if (!gp)
         return;
-    gp->startNewState();
+    BareNetworkString* buffer = gp->startNewState();
 
     m_overall_state_size = 0;
-    std::vector<std::string> rewinder_using;
+    m_rewinder_using.clear();
 
     for (auto& p : m_all_rewinder)
     {
-        // TODO: check if it's worth passing in a sufficiently large buffer from
-        // GameProtocol - this would save the copy operation.
-        BareNetworkString* buffer = NULL;
-        if (auto r = p.second.lock())
-            buffer = r->saveState(&rewinder_using);
-        if (buffer != NULL)
+        const unsigned start = buffer->getTotalSize();
+        auto r = p.second.lock();
+        if (r && r->saveState(buffer, &m_rewinder_using))
         {
-            m_overall_state_size += buffer->size();
-            gp->addState(buffer);
+            m_overall_state_size += buffer->getTotalSize() - start;
+            gp->addState(start);
         }
-        delete buffer;    // buffer can be freed
     }
-    gp->finalizeState(rewinder_using);
+    gp->finalizeState(m_rewinder_using);
     PROFILER_POP_CPU_MARKER();
 }   // saveState
 
@@ -209,6 +233,7 @@ void RewindManager::update(int ticks_not_used)
             if (auto r = p.second.lock())
                 ret.push_back(r->getLocalStateRestoreFunction());
         }
+        savePredictedState(ticks);
     }
     else
     {
@@ -220,6 +245,106 @@ void RewindManager::update(int ticks_not_used)
     PROFILER_POP_CPU_MARKER();
 }   // update
 
+// ----------------------------------------------------------------------------
+/** Saves the state of all rewinders as predicted by this client, so that it
+ *  can be compared with the confirmed state from the server later. The slot
+ *  of an already saved state at the same time (i.e. before a rewind) is
+ *  overwritten.
+ *  \param ticks Current world time.
+ */
+void RewindManager::savePredictedState(int ticks)
+{
+    if (!UserConfigParams::m_incremental_rewind)
+        return;
+
+    PredictedState* ps = NULL;
+    for (PredictedState& p : m_predicted_states)
+    {
+        if (p.m_ticks == ticks)
+        {
+            ps = &p;
+            break;
+        }
+    }
+    if (!ps)
+    {
+        ps = &m_predicted_states[m_next_predicted_state];
+        m_next_predicted_state =
+            (m_next_predicted_state + 1) % m_predicted_states.size();
+    }
+
+    ps->m_ticks = ticks;
+    ps->m_names.clear();
+    ps->m_offsets.clear();
+    ps->m_buffer.getBuffer().clear();
+    for (auto& p : m_all_rewinder)
+    {
+        const unsigned start = ps->m_buffer.getTotalSize();
+        auto r = p.second.lock();
+        if (r && r->savePredictedState(&ps->m_buffer, &ps->m_names))
+            ps->m_offsets.push_back(start);
+    }
+    ps->m_offsets.push_back(ps->m_buffer.getTotalSize());
+}   // savePredictedState
+
+// ----------------------------------------------------------------------------
+/** Checks if a rewind to the given time can be skipped, which is the case
+ *  if the confirmed states from the server at that time contain exactly the
+ *  data this client predicted, and no events were received since then.
+ *  Since the client rounds all values at the time states are saved (see
+ *  NetworkConfig::roundValuesNow), a state is the same as the prediction if
+ *  it differs by less than the network precision.
+ *  \param rewind_ticks Time of the states received.
+ */
+bool RewindManager::canSkipRewind(int rewind_ticks)
+{
+    if (!UserConfigParams::m_incremental_rewind ||
+        m_rewind_queue.getLatestPastEvent() > rewind_ticks)
+        return false;
+
+    const PredictedState* ps = NULL;
+    for (const PredictedState& p : m_predicted_states)
+    {
+        if (p.m_ticks == rewind_ticks)
+        {
+            ps = &p;
+            break;
+        }
+    }
+    if (!ps)
+        return false;
+
+    std::vector<RewindInfoState*> states;
+    m_rewind_queue.getConfirmedStates(rewind_ticks, &states);
+    if (states.empty())
+        return false;
+
+    for (RewindInfoState* state : states)
+    {
+        BareNetworkString* buffer = state->getBuffer();
+        buffer->reset();
+        buffer->skip(state->getStartOffset());
+        for (const std::string& name : state->getRewinderUsing())
+        {
+            const uint16_t size = buffer->getUInt16();
+            // A kart left out by the server keeps the prediction anyway
+            if (size == 0)
+                continue;
+            auto it = std::find(ps->m_names.begin(), ps->m_names.end(), name);
+            if (it == ps->m_names.end())
+                return false;
+            const unsigned i = (unsigned)(it - ps->m_names.begin());
+            const unsigned start = ps->m_offsets[i];
+            if (ps->m_offsets[i + 1] - start != size || size > buffer->size() ||
+                memcmp(ps->m_buffer.getData() + start,
+                       buffer->getCurrentData(), size) != 0)
+                return false;
+            buffer->skip(size);
+        }
+    }
+    return true;
+}   // canSkipRewind
+
 // ----------------------------------------------------------------------------
 /** Replays all events from the last event played till the specified time.
  *  \param world_ticks Up to (and inclusive) which time events will be replayed.
@@ -241,7 +366,22 @@ void RewindManager::playEventsTill(int world_ticks, bool fast_forward)
     // be getTime()+dt - world time has not been updated yet).
     m_rewind_queue.mergeNetworkData(world_ticks, &needs_rewind, &rewind_ticks);
 
-    if (needs_rewind)
+    if (needs_rewind && !fast_forward && canSkipRewind(rewind_ticks))
+    {
+        // The prediction was correct, so the local simulation is already
+        // where the rewind would end
+        m_rewind_queue.skipUntil(world_ticks);
+        for (auto it = m_local_state.begin(); it != m_local_state.end();)
+        {
+            if (it->first <= rewind_ticks)
+                it = m_local_state.erase(it);
+            else
+                break;
+        }
+        m_skipped_rewind_count++;
+        PROFILER_SET_COUNTER("Rewinds skipped", m_skipped_rewind_count);
+    }
+    else if (needs_rewind)
     {
         Log::setPrefix("Rewind");
         PROFILER_PUSH_CPU_MARKER("Rewind", 128, 128, 128);
@@ -251,6 +391,8 @@ void RewindManager::playEventsTill(int world_ticks, bool fast_forward)
         PROFILER_POP_CPU_MARKER();
         Log::setPrefix("");
     }
+    if (needs_rewind)
+        m_rewind_queue.clearPastEvents();
 
     assert(!m_is_rewinding);
     if (m_rewind_queue.isEmpty()) return;
@@ -378,11 +520,21 @@ void RewindManager::rewindTo(int rewind_ticks, int now_ticks,
         world->setTicksForRewind(exact_rewind_ticks);
     }
 
+    m_rewind_count++;
+    m_rewound_ticks += now_ticks - exact_rewind_ticks;
+    PROFILER_SET_COUNTER("Rewinds", m_rewind_count);
+    PROFILER_SET_COUNTER("Rewound ticks", m_rewound_ticks);
+
     // Now go forward through the list of rewind infos till we reach 'now':
     while (world->getTicksSinceStart() < now_ticks)
     { 
         m_rewind_queue.replayAllEvents(world->getTicksSinceStart());
 
+        // Update the prediction with the corrected simulation, at the same
+        // point update() saves it
+        if (!fast_forward && shouldSaveState(world->getTicksSinceStart()))
+            savePredictedState(world->getTicksSinceStart());
+
         // Now simulate the next time step
         if (!fast_forward)
             world->updateWorld(1);
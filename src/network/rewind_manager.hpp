@@ -19,6 +19,7 @@
 #ifndef HEADER_REWIND_MANAGER_HPP
 #define HEADER_REWIND_MANAGER_HPP
 
+#include "network/network_string.hpp"
 #include "network/rewind_queue.hpp"
 #include "utils/stk_process.hpp"
 
@@ -102,6 +103,10 @@ private:
     /** Overall amount of memory allocated by states. */
     unsigned int m_overall_state_size;
 
+    /** Names of the rewinders in the state being saved, kept to reuse its
+     *  memory. */
+    std::vector<std::string> m_rewinder_using;
+
     /** Indicates if currently a rewind is happening. */
     bool m_is_rewinding;
 
@@ -117,6 +122,38 @@ private:
 
     bool m_schedule_reset_network_body;
 
+    /** The state of all rewinders as predicted by this client at a state
+     *  time, used to detect if a confirmed state from the server changes
+     *  anything (see canSkipRewind). */
+    struct PredictedState
+    {
+        /** Time of the state, or -1 if the slot is unused. */
+        int m_ticks;
+        /** Names of the rewinders in the state. */
+        std::vector<std::string> m_names;
+        /** Start of the data of each rewinder in m_buffer, followed by the
+         *  end of the data of the last rewinder. */
+        std::vector<unsigned> m_offsets;
+        BareNetworkString m_buffer;
+    };
+
+    /** Ring buffer of the predicted states, the memory of each slot is
+     *  reused. */
+    std::vector<PredictedState> m_predicted_states;
+
+    /** Slot in m_predicted_states to be used for the next new state. */
+    unsigned m_next_predicted_state;
+
+    /** Number of rewinds done since the last reset. */
+    int m_rewind_count;
+
+    /** Number of rewinds skipped since the last reset, because the confirmed
+     *  state matched the predicted one. */
+    int m_skipped_rewind_count;
+
+    /** Number of ticks simulated again in rewinds since the last reset. */
+    int m_rewound_ticks;
+
     RewindManager();
    ~RewindManager();
     // ------------------------------------------------------------------------
@@ -134,6 +171,10 @@ private:
     }
     // ------------------------------------------------------------------------
     void mergeRewindInfoEventFunction();
+    // ------------------------------------------------------------------------
+    void savePredictedState(int ticks);
+    // ------------------------------------------------------------------------
+    bool canSkipRewind(int rewind_ticks);
 
 public:
     // First static functions to manage rewinding.
@@ -81,6 +81,7 @@ void RewindQueue::reset()
     m_all_rewind_info.clear();
     m_current = m_all_rewind_info.end();
     m_latest_confirmed_state_time = -1;
+    m_latest_past_event_time = -1;
 }   // reset
 
 // ----------------------------------------------------------------------------
@@ -282,6 +283,12 @@ void RewindQueue::mergeNetworkData(int world_ticks, bool *needs_rewind,
             if ((*i)->getTicks() > *rewind_ticks)
                 *rewind_ticks = (*i)->getTicks();
         }   // if client and ticks < world_ticks
+        else if (NetworkConfig::get()->isClient() &&
+                 (*i)->getTicks() < world_ticks && (*i)->isEvent() &&
+                 (*i)->getTicks() > m_latest_past_event_time)
+        {
+            m_latest_past_event_time = (*i)->getTicks();
+        }
 
         if ((*i)->isState() && (*i)->getTicks() > latest_confirmed_state &&
             (*i)->isConfirmed())
@@ -390,6 +397,38 @@ int RewindQueue::undoUntil(int undo_ticks)
     return (*m_current)->getTicks();
 }   // undoUntil
 
+// ----------------------------------------------------------------------------
+/** Moves the internal 'current' pointer past all rewind infos before the
+ *  given time without replaying them. Used instead of a rewind if the
+ *  states received in the past do not change the local simulation.
+ *  \param ticks Time in ticks.
+ */
+void RewindQueue::skipUntil(int ticks)
+{
+    while (hasMoreRewindInfo() && (*m_current)->getTicks() < ticks)
+        m_current++;
+}   // skipUntil
+
+// ----------------------------------------------------------------------------
+/** Returns all confirmed states at the given time.
+ *  \param ticks Time in ticks.
+ *  \param[out] states The states found.
+ */
+void RewindQueue::getConfirmedStates(int ticks,
+                                     std::vector<RewindInfoState*>* states)
+{
+    states->clear();
+    for (auto i = m_all_rewind_info.rbegin(); i != m_all_rewind_info.rend();
+         i++)
+    {
+        if ((*i)->getTicks() < ticks)
+            break;
+        if ((*i)->getTicks() == ticks && (*i)->isState() &&
+            (*i)->isConfirmed())
+            states->push_back(static_cast<RewindInfoState*>(*i));
+    }
+}   // getConfirmedStates
+
 // ----------------------------------------------------------------------------
 /** Replays all events (not states) that happened at the specified time.
  *  \param ticks Time in ticks.
@@ -479,6 +518,20 @@ void RewindQueue::unitTesting()
     rii++;
     assert((*rii)->isEvent());
 
+    // Skipping a rewind must move current past everything before 'now',
+    // and the confirmed states at a time must be found
+    RewindQueue q2;
+    q2.addLocalState(NULL, true, 2);
+    q2.addLocalEvent(NULL, NULL, true, 3);
+    q2.addLocalEvent(NULL, NULL, true, 5);
+    std::vector<RewindInfoState*> states;
+    q2.getConfirmedStates(2, &states);
+    assert(states.size() == 1);
+    q2.getConfirmedStates(3, &states);
+    assert(states.empty());
+    q2.skipUntil(5);
+    assert(q2.getCurrent()->getTicks() == 5);
+
     // Bugs seen before
     // ----------------
     // 1) Current pointer was not reset from end of list when an event
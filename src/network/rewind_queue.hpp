@@ -28,6 +28,7 @@
 class BareNetworkString;
 class EventRewinder;
 class RewindInfo;
+class RewindInfoState;
 class TimeStepInfo;
 
 /** \ingroup network
@@ -55,6 +56,11 @@ private:
     /** Time at which the latest confirmed state is at. */
     int m_latest_confirmed_state_time;
 
+    /** Time of the latest event received from the network for a time before
+     *  the current world time (which then needs to be replayed in a
+     *  rewind), or -1 if there is none. */
+    int m_latest_past_event_time;
+
 
     void cleanupOldRewindInfo(int ticks);
 
@@ -82,7 +88,9 @@ public:
     bool isEmpty() const;
     bool hasMoreRewindInfo() const;
     int  undoUntil(int undo_ticks);
+    void skipUntil(int ticks);
     void insertRewindInfo(RewindInfo *ri);
+    void getConfirmedStates(int ticks, std::vector<RewindInfoState*>* states);
 
     // ------------------------------------------------------------------------
     /** Returns the time of the latest confirmed state. */
@@ -90,6 +98,11 @@ public:
     {
         return m_latest_confirmed_state_time;
     }
+    /** Returns the time of the latest event received in the past of the
+     *  client since the last call of clearPastEvents(), or -1. */
+    int getLatestPastEvent() const { return m_latest_past_event_time; }
+    /** Called once all events received in the past were handled. */
+    void clearPastEvents() { m_latest_past_event_time = -1; }
     // ------------------------------------------------------------------------
     /** Sets the current element to be the next one and returns the next
      *  RewindInfo element. */
@@ -70,12 +70,29 @@ public:
      *  caused by the rewind (which is then visually smoothed over time). */
     virtual void computeError() = 0;
 
-    /** Provides a copy of the state of the object in one memory buffer.
-     *  The memory is managed by the RewindManager.
+    /** Appends a copy of the state of the object to the state buffer, which
+     *  is shared by all rewinders (see RewindManager::saveState).
+     *  \param buffer The buffer to append the state to.
      *  \param[out] ru The unique identity of rewinder writing to.
-     *  \return The address of the memory buffer with the state.
+     *  \return False (and nothing must be written to buffer or ru) if no
+     *          state needs to be sent for this rewinder.
      */
-    virtual BareNetworkString* saveState(std::vector<std::string>* ru) = 0;
+    virtual bool saveState(BareNetworkString *buffer,
+                           std::vector<std::string>* ru) = 0;
+
+    /** Appends the state of the object as predicted by a client, which is
+     *  compared with the confirmed state from the server. The data must be
+     *  the same as written by saveState, but unlike saveState this must not
+     *  update any data used on the server to decide if a state is sent.
+     *  \param buffer The buffer to append the state to.
+     *  \param[out] ru The unique identity of rewinder writing to.
+     *  \return False if there is no state for this rewinder.
+     */
+    virtual bool savePredictedState(BareNetworkString *buffer,
+                                    std::vector<std::string>* ru)
+    {
+        return saveState(buffer, ru);
+    }
 
     /** Called when an event needs to be undone. This is called while going
      *  backwards for rewinding - all stored events will get an 'undo' call.
@@ -344,6 +344,23 @@ namespace ServerConfig
         "more rewind, which clients with slow device may have problem playing "
         "this server, use the default value is recommended."));
 
+    SERVER_CFG_PREFIX FloatServerConfigParam m_state_relevance_distance
+        SERVER_CFG_DEFAULT(FloatServerConfigParam(50.0f,
+        "state-relevance-distance",
+        "Physical objects and karts within this distance (along the track) "
+        "of a player's kart are sent to that player in every state, farther "
+        "ones less often (karts only to players whose game version supports "
+        "it). Items and projectiles are always sent. Set to 0 to send "
+        "everything in every state."));
+
+    SERVER_CFG_PREFIX IntServerConfigParam m_state_bandwidth
+        SERVER_CFG_DEFAULT(IntServerConfigParam(32000,
+        "state-bandwidth",
+        "Maximum number of bytes per second of states sent to each player, "
+        "far away physical objects and karts are updated less often to stay "
+        "within it. Only used if state-relevance-distance is not 0, 0 for "
+        "no limit."));
+
     SERVER_CFG_PREFIX BoolServerConfigParam m_sql_management
         SERVER_CFG_DEFAULT(BoolServerConfigParam(false,
         "sql-management",
@@ -365,13 +382,21 @@ namespace ServerConfig
         "sqlite3_busy_handler. You may need a higher value if your database "
         "is shared by many servers or having a slow hard disk."));
 
+    SERVER_CFG_PREFIX BoolServerConfigParam m_database_wal
+        SERVER_CFG_DEFAULT(BoolServerConfigParam(false,
+        "database-wal",
+        "Use write-ahead logging for the database, so that writes do not "
+        "block servers reading the same database. Do not enable it if the "
+        "database is on a network filesystem, where it does not work."));
+
     SERVER_CFG_PREFIX StringServerConfigParam m_ip_ban_table
         SERVER_CFG_DEFAULT(StringServerConfigParam("ip_ban",
         "ip-ban-table",
         "IPv4 ban list table name, you need to create the table first, see "
         "NETWORKING.md for details, empty to disable. "
         "This table can be shared for all servers if you use the same name. "
-        "STK can auto kick active peer from ban list (update per minute) which"
+        "STK can auto kick active peer from ban list (updated a few seconds "
+        "after the table changes) which"
         "allows live kicking peer by inserting record to database."));
 
     SERVER_CFG_PREFIX StringServerConfigParam m_ipv6_ban_table
@@ -380,7 +405,8 @@ namespace ServerConfig
         "IPv6 ban list table name, you need to create the table first, see "
         "NETWORKING.md for details, empty to disable. "
         "This table can be shared for all servers if you use the same name. "
-        "STK can auto kick active peer from ban list (update per minute) "
+        "STK can auto kick active peer from ban list (updated a few seconds "
+        "after the table changes) "
         "which allows live kicking peer by inserting record to database."));
 
     SERVER_CFG_PREFIX StringServerConfigParam m_online_id_ban_table
@@ -389,7 +415,8 @@ namespace ServerConfig
         "Online ID ban list table name, you need to create the table first, "
         "see NETWORKING.md for details, empty to disable. "
         "This table can be shared for all servers if you use the same name. "
-        "STK can auto kick active peer from ban list (update per minute) "
+        "STK can auto kick active peer from ban list (updated a few seconds "
+        "after the table changes) "
         "which allows live kicking peer by inserting record to database."));
 
     SERVER_CFG_PREFIX StringServerConfigParam m_player_reports_table
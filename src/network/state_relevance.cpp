@@ -0,0 +1,329 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2024 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#include "network/state_relevance.hpp"
+
+#include "config/stk_config.hpp"
+#include "karts/abstract_kart.hpp"
+#include "modes/linear_world.hpp"
+#include "network/rewind_manager.hpp"
+#include "network/rewinder.hpp"
+#include "network/server_config.hpp"
+#include "network/stk_peer.hpp"
+#include "physics/physical_object.hpp"
+#include "tracks/arena_graph.hpp"
+#include "tracks/track.hpp"
+#include "tracks/track_sector.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    /** A rewinder is sent at least every that many states, however far away
+     *  it is, as long as the bandwidth budget allows it. */
+    const int MAX_INTERVAL = 5;
+
+    /** After being left out that many states in a row a rewinder is sent
+     *  even if it exceeds the bandwidth budget. */
+    const int MAX_SKIPPED = 10;
+}   // anonymous namespace
+
+// ----------------------------------------------------------------------------
+/** Computes the location of a position on the track.
+ *  \param xyz The position.
+ *  \param kart_id World kart id if the position is of a kart, else -1.
+ */
+StateRelevance::Location StateRelevance::computeLocation(const Vec3& xyz,
+                                                         int kart_id) const
+{
+    Location l;
+    l.m_always_relevant = false;
+    l.m_kart_id         = kart_id;
+    l.m_xyz             = xyz;
+    l.m_track_distance  = -1.0f;
+    l.m_node            = Graph::UNKNOWN_SECTOR;
+    l.m_state           = m_state_count;
+    if (!Graph::get())
+        return l;
+
+    World* world = World::getWorld();
+    LinearWorld* lw = dynamic_cast<LinearWorld*>(world);
+    WorldWithRank* wwr = dynamic_cast<WorldWithRank*>(world);
+    if (kart_id >= 0 && lw)
+    {
+        l.m_track_distance = lw->getDistanceDownTrackForKart(kart_id,
+                                                             false);
+    }
+    else if (kart_id >= 0 && wwr && ArenaGraph::get())
+    {
+        l.m_node = wwr->getSectorForKart(world->getKart(kart_id));
+    }
+    else if (lw || ArenaGraph::get())
+    {
+        TrackSector sector;
+        sector.update(xyz);
+        if (lw)
+            l.m_track_distance = sector.getDistanceFromStart(false);
+        else
+            l.m_node = sector.getCurrentGraphNode();
+    }
+    return l;
+}   // computeLocation
+
+// ----------------------------------------------------------------------------
+/** Called before the rewinders of a new state are selected, so that the
+ *  locations of all rewinders are computed again. Locations of rewinders
+ *  which were not used in the last state are removed.
+ */
+void StateRelevance::startState()
+{
+    for (auto it = m_locations.begin(); it != m_locations.end();)
+    {
+        if (it->second.m_state < m_state_count)
+            it = m_locations.erase(it);
+        else
+            it++;
+    }
+    m_state_count++;
+}   // startState
+
+// ----------------------------------------------------------------------------
+/** Returns the location of a rewinder in the current state.
+ *  \param name Unique identity of the rewinder.
+ */
+const StateRelevance::Location&
+                         StateRelevance::getLocation(const std::string& name)
+{
+    auto it = m_locations.find(name);
+    if (it != m_locations.end() && it->second.m_state == m_state_count)
+        return it->second;
+
+    std::shared_ptr<Rewinder> r = RewindManager::get()->getRewinder(name);
+    Location l;
+    if (PhysicalObject* po = dynamic_cast<PhysicalObject*>(r.get()))
+    {
+        l = computeLocation(po->getBody()->getWorldTransform().getOrigin(),
+                            -1);
+    }
+    else if (AbstractKart* kart = dynamic_cast<AbstractKart*>(r.get()))
+    {
+        l = getKartLocation(kart->getWorldKartId());
+    }
+    else
+    {
+        // Flyables, the item manager, flags and unknown rewinders. A
+        // client can not restore a flyable locally, so they would drift
+        // apart from the server if they were left out.
+        l.m_always_relevant = true;
+        l.m_kart_id         = -1;
+        l.m_track_distance  = -1.0f;
+        l.m_node            = Graph::UNKNOWN_SECTOR;
+        l.m_state           = m_state_count;
+    }
+    if (it != m_locations.end())
+        return it->second = l;
+    return m_locations[name] = l;
+}   // getLocation
+
+// ----------------------------------------------------------------------------
+/** Returns the location of a kart in the current state.
+ *  \param kart_id World kart id of the kart.
+ */
+const StateRelevance::Location& StateRelevance::getKartLocation(int kart_id)
+{
+    auto it = m_kart_locations.find(kart_id);
+    if (it == m_kart_locations.end())
+        it = m_kart_locations.emplace(kart_id, Location()).first;
+    else if (it->second.m_state == m_state_count)
+        return it->second;
+    return it->second =
+        computeLocation(World::getWorld()->getKart(kart_id)->getXYZ(),
+                        kart_id);
+}   // getKartLocation
+
+// ----------------------------------------------------------------------------
+/** Returns the distance between two locations, which is the shorter of the
+ *  distance on the graph (along the track, which is what matters for the
+ *  race) and the direct distance (which matters for collisions, e.g. on
+ *  tracks crossing themselves).
+ */
+float StateRelevance::getDistance(const Location& a, const Location& b) const
+{
+    float distance = (a.m_xyz - b.m_xyz).length();
+    if (a.m_track_distance >= 0.0f && b.m_track_distance >= 0.0f)
+    {
+        float length = Track::getCurrentTrack()->getTrackLength();
+        float d = std::fabs(a.m_track_distance - b.m_track_distance);
+        distance = std::min(distance, std::min(d, length - d));
+    }
+    else if (a.m_node != Graph::UNKNOWN_SECTOR &&
+             b.m_node != Graph::UNKNOWN_SECTOR && ArenaGraph::get())
+    {
+        distance = std::min(distance,
+                            ArenaGraph::get()->getDistance(a.m_node, b.m_node));
+    }
+    return distance;
+}   // getDistance
+
+// ----------------------------------------------------------------------------
+/** Selects which rewinders of a state are sent to a client.
+ *  \param peer The client.
+ *  \param ticks Time of the state.
+ *  \param names Unique identities of all rewinders that could be sent.
+ *  \param sizes Size of the state of each rewinder.
+ *  \param skip_karts If karts of other players can be left out, which the
+ *         client must support.
+ *  \param[out] selected For each rewinder if it should be sent.
+ */
+void StateRelevance::select(const STKPeer* peer, int ticks,
+                            const std::vector<std::string>& names,
+                            const std::vector<unsigned>& sizes,
+                            bool skip_karts, std::vector<bool>* selected)
+{
+    selected->assign(names.size(), true);
+    const float relevance_distance = ServerConfig::m_state_relevance_distance;
+    const int bandwidth = ServerConfig::m_state_bandwidth;
+    const std::set<unsigned>& own_karts = peer->getAvailableKartIDs();
+    if (relevance_distance <= 0.0f || own_karts.empty())
+    {
+        // Spectators get everything
+        m_peers.erase(peer->getHostId());
+        return;
+    }
+
+    auto it = m_peers.find(peer->getHostId());
+    if (it == m_peers.end())
+    {
+        PeerInfo info;
+        info.m_budget = (float)bandwidth;
+        info.m_last_ticks = ticks;
+        it = m_peers.emplace(peer->getHostId(), info).first;
+    }
+    PeerInfo& info = it->second;
+    if (bandwidth > 0)
+    {
+        float dt = stk_config->ticks2Time(ticks - info.m_last_ticks);
+        info.m_budget = std::min(info.m_budget + dt * bandwidth,
+                                 (float)bandwidth);
+    }
+    info.m_last_ticks = ticks;
+
+    // Sort rewinders which are due by how overdue they are, and then by
+    // distance, rewinders which must be sent are first in any case
+    m_due.clear();
+    for (unsigned i = 0; i < names.size(); i++)
+    {
+        const Location& l = getLocation(names[i]);
+        auto s = info.m_skipped.find(names[i]);
+        if (s == info.m_skipped.end())
+        {
+            Skipped skipped;
+            skipped.m_count = 0;
+            s = info.m_skipped.emplace(names[i], skipped).first;
+        }
+        s->second.m_ticks = ticks;
+        int num_skipped = s->second.m_count;
+        const bool always_relevant = l.m_always_relevant ||
+            (l.m_kart_id >= 0 &&
+             (!skip_karts || own_karts.count((unsigned)l.m_kart_id) > 0));
+        if (always_relevant || num_skipped >= MAX_SKIPPED)
+        {
+            s->second.m_count = 0;
+            m_due.emplace_back(false, 0.0f, 0.0f, i);
+            continue;
+        }
+        float distance = 99999.0f;
+        for (unsigned kart_id : own_karts)
+        {
+            distance = std::min(distance,
+                getDistance(l, getKartLocation(kart_id)));
+        }
+        int interval = std::min(MAX_INTERVAL,
+                                1 + (int)(distance / relevance_distance));
+        if (num_skipped + 1 >= interval)
+        {
+            m_due.emplace_back(true, -float(num_skipped + 1) / interval,
+                               distance, i);
+        }
+        else
+        {
+            (*selected)[i] = false;
+            s->second.m_count = num_skipped + 1;
+        }
+    }
+    std::sort(m_due.begin(), m_due.end());
+
+    for (auto& d : m_due)
+    {
+        unsigned i = std::get<3>(d);
+        // Approximate size in the state: name, size and data
+        float size = float(names[i].size() + 3 + sizes[i]);
+        Skipped& skipped = info.m_skipped[names[i]];
+        if (!std::get<0>(d) || bandwidth <= 0 ||
+            info.m_budget >= size)
+        {
+            info.m_budget -= size;
+            skipped.m_count = 0;
+        }
+        else
+        {
+            (*selected)[i] = false;
+            skipped.m_count++;
+        }
+    }
+    // Rewinders which are no longer used are forgotten
+    for (auto s = info.m_skipped.begin(); s != info.m_skipped.end();)
+    {
+        if (s->second.m_ticks != ticks)
+            s = info.m_skipped.erase(s);
+        else
+            s++;
+    }
+}   // select
+
+// ----------------------------------------------------------------------------
+/** Returns the rewinders which were left out of the last state sent to a
+ *  client. */
+void StateRelevance::getSkipped(const STKPeer* peer,
+                               std::vector<const std::string*>* names) const
+{
+    names->clear();
+    auto it = m_peers.find(peer->getHostId());
+    if (it == m_peers.end())
+        return;
+    for (auto& s : it->second.m_skipped)
+    {
+        if (s.second.m_count > 0)
+            names->push_back(&s.first);
+    }
+}   // getSkipped
+
+// ----------------------------------------------------------------------------
+/** Removes the information of all clients which are not in the given list,
+ *  i.e. which disconnected. */
+void StateRelevance::removeOtherPeers(const std::set<uint32_t>& host_ids)
+{
+    for (auto it = m_peers.begin(); it != m_peers.end();)
+    {
+        if (host_ids.find(it->first) == host_ids.end())
+            it = m_peers.erase(it);
+        else
+            it++;
+    }
+}   // removeOtherPeers
@@ -0,0 +1,131 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2024 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#ifndef HEADER_STATE_RELEVANCE_HPP
+#define HEADER_STATE_RELEVANCE_HPP
+
+#include "utils/no_copy.hpp"
+#include "utils/vec3.hpp"
+
+#include <map>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+class STKPeer;
+
+/** Decides on the server which rewinder states are sent to which client.
+ *  Physical objects and karts close to a kart of the client (measured along
+ *  the drive graph in races, on the arena graph in battle and soccer, or
+ *  directly if that is shorter) are sent in every state, farther ones less
+ *  often, and the states sent to each client are limited to a bandwidth
+ *  budget. All other rewinders (flyables, the item manager) and the karts
+ *  of the client itself are always sent.
+ *  Leaving a physical object out of a state is safe: the client then
+ *  restores its own locally saved transform and velocities for it (just
+ *  like for physical objects which did not move), and once the object is
+ *  sent again the client rewinds to that state like for any other
+ *  correction. A kart left out of a state is still sent with an empty
+ *  state, otherwise the client would think it disconnected, and the client
+ *  then restores the full state it predicted for the kart (see
+ *  KartRewinder::getLocalStateRestoreFunction). Only clients which support
+ *  this get karts left out. Flyables can not be restored from the local
+ *  state, so they are never left out.
+ * \ingroup network
+ */
+class StateRelevance : public NoCopy
+{
+private:
+    /** Where a rewinder is, computed once per state. */
+    struct Location
+    {
+        /** True for rewinders which must be sent in every state, i.e. all
+         *  rewinders except physical objects and karts. */
+        bool  m_always_relevant;
+        /** World kart id if the rewinder is a kart, else -1. */
+        int   m_kart_id;
+        Vec3  m_xyz;
+        /** Distance from start on the drive graph, or -1 if unknown. */
+        float m_track_distance;
+        /** Current node on the arena graph, or Graph::UNKNOWN_SECTOR. */
+        int   m_node;
+        /** The state this location was computed for, see m_state_count. */
+        int   m_state;
+    };
+
+    /** How often a rewinder was left out for a client. */
+    struct Skipped
+    {
+        /** Number of states in a row the rewinder was left out. */
+        int m_count;
+        /** Time of the last state which included the rewinder. */
+        int m_ticks;
+    };
+
+    /** Relevance information of one client. */
+    struct PeerInfo
+    {
+        /** Bytes that can still be sent, refilled each state. */
+        float m_budget;
+        /** Time the last state was sent to this client. */
+        int   m_last_ticks;
+        /** How often each rewinder was left out. Entries are updated in
+         *  place, and only removed once the rewinder is no longer used. */
+        std::map<std::string, Skipped> m_skipped;
+    };
+
+    /** Location of all rewinders, only valid if computed for the current
+     *  state. Kept between states to reuse the memory. */
+    std::map<std::string, Location> m_locations;
+
+    /** Location of all karts, by world kart id, see m_locations. */
+    std::map<int, Location> m_kart_locations;
+
+    /** Number of the current state, to check if a location is valid. */
+    int m_state_count;
+
+    /** Rewinders being considered in select(), kept to reuse the memory. */
+    std::vector<std::tuple<bool, float, float, unsigned> > m_due;
+
+    /** Relevance information of all clients, by host id. */
+    std::map<uint32_t, PeerInfo> m_peers;
+
+    const Location& getLocation(const std::string& name);
+    const Location& getKartLocation(int kart_id);
+    Location computeLocation(const Vec3& xyz, int kart_id) const;
+    float getDistance(const Location& a, const Location& b) const;
+
+public:
+    // ------------------------------------------------------------------------
+    StateRelevance() : m_state_count(0) {}
+    // ------------------------------------------------------------------------
+    void startState();
+    // ------------------------------------------------------------------------
+    void select(const STKPeer* peer, int ticks,
+                const std::vector<std::string>& names,
+                const std::vector<unsigned>& sizes, bool skip_karts,
+                std::vector<bool>* selected);
+    // ------------------------------------------------------------------------
+    void getSkipped(const STKPeer* peer,
+                    std::vector<const std::string*>* names) const;
+    // ------------------------------------------------------------------------
+    void removeOtherPeers(const std::set<uint32_t>& host_ids);
+};   // StateRelevance
+
+#endif
@@ -21,9 +21,11 @@
 #include "config/stk_config.hpp"
 #include "config/user_config.hpp"
 #include "io/file_manager.hpp"
+#include "main_loop.hpp"
 #include "network/event.hpp"
 #include "network/game_setup.hpp"
 #include "network/network.hpp"
+#include "network/network_capture.hpp"
 #include "network/network_config.hpp"
 #include "network/network_console.hpp"
 #include "network/network_player_profile.hpp"
@@ -51,6 +53,12 @@
 #  include <sys/socket.h>
 #endif
 
+#ifdef __linux__
+#  include <poll.h>
+#  include <sys/eventfd.h>
+#  include <unistd.h>
+#endif
+
 #ifdef __MINGW32__
 #  undef _WIN32_WINNT
 #  define _WIN32_WINNT 0x501
@@ -73,6 +81,9 @@
 
 STKHost *STKHost::m_stk_host[PT_COUNT];
 bool     STKHost::m_enable_console = false;
+std::string STKHost::m_capture_file;
+std::string STKHost::m_replay_file;
+bool     STKHost::m_replay_realtime = false;
 
 std::shared_ptr<LobbyProtocol> STKHost::create(ChildLoop* cl)
 {
@@ -303,7 +314,17 @@ STKHost::STKHost(bool server)
                               "ENet server host.");
     }
     if (server)
+    {
         Log::info("STKHost", "Server port is %d", getPrivatePort());
+        if (!m_capture_file.empty())
+            m_capture.reset(NetworkCapture::create(m_capture_file));
+        if (!m_replay_file.empty())
+        {
+            m_replay.reset(NetworkCapture::open(m_replay_file));
+            if (!m_replay)
+                Log::fatal("STKHost", "Cannot replay network capture.");
+        }
+    }
 }   // STKHost
 
 // ----------------------------------------------------------------------------
@@ -321,6 +342,18 @@ void STKHost::init()
     m_network          = NULL;
     m_exit_timeout.store(std::numeric_limits<uint64_t>::max());
     m_client_ping.store(0);
+    m_network_waiting.store(false);
+    m_replay_start_time = 0;
+    m_replay_first_time = 0;
+    m_replay_end_time   = 0;
+    m_replay_budget     = 0;
+    m_replay_events     = 0;
+    m_replay_sent_bytes = 0;
+#ifdef __linux__
+    m_wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#else
+    m_wakeup_fd = -1;
+#endif
 
     // Start with initialising ENet
     // ============================
@@ -363,7 +396,9 @@ STKHost::~STKHost()
     stopListening();
 
     // Drop all unsent packets
-    for (auto& p : m_enet_cmd)
+    std::tuple<ENetPeer*, ENetPacket*, uint32_t, ENetCommandType,
+        ENetAddress> p;
+    while (m_enet_cmd.pop(&p))
     {
         if (std::get<3>(p) == ECT_SEND_PACKET)
         {
@@ -371,6 +406,10 @@ STKHost::~STKHost()
             enet_packet_destroy(packet);
         }
     }
+#ifdef __linux__
+    if (m_wakeup_fd != -1)
+        close(m_wakeup_fd);
+#endif
     delete m_network;
     enet_deinitialize();
     if (m_client_loop)
@@ -909,8 +948,7 @@ void STKHost::mainLoop(ProcessType pt)
                                 player_name.c_str(), ap, max_ping);
                             p.second->setWarnedForHighPing(true);
                             p.second->setDisconnected(true);
-                            std::lock_guard<std::mutex> lock(m_enet_cmd_mutex);
-                            m_enet_cmd.emplace_back(p.second->getENetPeer(),
+                            addEnetCommand(p.second->getENetPeer(),
                                 (ENetPacket*)NULL, PDI_KICK_HIGH_PING,
                                 ECT_DISCONNECT, p.first->address);
                         }
@@ -954,6 +992,7 @@ void STKHost::mainLoop(ProcessType pt)
             for (auto it = m_peers.begin(); it != m_peers.end();)
             {
                 if (!ping_packet.getBuffer().empty() &&
+                    !isReplayPeer(it->first) &&
                     (!sl->allowJoinedPlayersWaiting() ||
                     !sl->isRacing() || it->second->isWaitingForGame()))
                 {
@@ -982,8 +1021,11 @@ void STKHost::mainLoop(ProcessType pt)
                         " than %f seconds, disconnect it by force.",
                         it->second->getAddress().toString().c_str(),
                         timeout);
-                    enet_host_flush(host);
-                    enet_peer_reset(it->first);
+                    if (!isReplayPeer(it->first))
+                    {
+                        enet_host_flush(host);
+                        enet_peer_reset(it->first);
+                    }
                     it = m_peers.erase(it);
                 }
                 else
@@ -994,17 +1036,20 @@ void STKHost::mainLoop(ProcessType pt)
             peer_lock.unlock();
         }
 
-        std::vector<std::tuple<ENetPeer*, ENetPacket*, uint32_t,
-            ENetCommandType, ENetAddress> > copied_list;
-        std::unique_lock<std::mutex> lock(m_enet_cmd_mutex);
-        std::swap(copied_list, m_enet_cmd);
-        lock.unlock();
-        for (auto& p : copied_list)
+        std::tuple<ENetPeer*, ENetPacket*, uint32_t, ENetCommandType,
+            ENetAddress> p;
+        while (m_enet_cmd.pop(&p))
         {
             ENetPeer* peer = std::get<0>(p);
             ENetAddress& ea = std::get<4>(p);
             ENetAddress& ea_peer_now = peer->address;
             ENetPacket* packet = std::get<1>(p);
+            if (isReplayPeer(peer))
+            {
+                handleReplayCommand(peer, packet, std::get<2>(p),
+                    std::get<3>(p));
+                continue;
+            }
             // Enet will reuse a disconnected peer so we check here to avoid
             // sending to wrong peer
             if (peer->state != ENET_PEER_STATE_CONNECTED ||
@@ -1048,7 +1093,8 @@ void STKHost::mainLoop(ProcessType pt)
         }
 
         bool need_ping_update = false;
-        while (enet_host_service(host, &event, 10) != 0)
+        waitForNetwork(host, m_replay ? updateReplay() : 10);
+        while (serviceNetwork(host, &event))
         {
             auto lp = LobbyProtocol::get<LobbyProtocol>();
             if (!is_server &&
@@ -1211,6 +1257,9 @@ void STKHost::mainLoop(ProcessType pt)
 #endif
             }   // if message event
 
+            if (m_capture)
+                m_capture->addEvent(*stk_event, event.channelID);
+
             // notify for the event now.
             auto pm = ProtocolManager::lock();
             if (pm && !pm->isExiting())
@@ -1223,6 +1272,247 @@ void STKHost::mainLoop(ProcessType pt)
     Log::info("STKHost", "Listening has been stopped.");
 }   // mainLoop
 
+// ----------------------------------------------------------------------------
+/** Returns the next event to handle in the listening thread: replayed events
+ *  first, then events received by ENet.
+ *  \return False if there is no event.
+ */
+bool STKHost::serviceNetwork(ENetHost* host, ENetEvent* event)
+{
+    if (getReplayEvent(event))
+        return true;
+    return enet_host_service(host, event, 0) != 0;
+}   // serviceNetwork
+
+// ----------------------------------------------------------------------------
+/** Creates an ENet event for a replay peer disconnected by the server, or
+ *  for the next captured event if it is due.
+ *  \return False if there is no event.
+ */
+bool STKHost::getReplayEvent(ENetEvent* event)
+{
+    memset(event, 0, sizeof(ENetEvent));
+    if (!m_replay_disconnects.empty())
+    {
+        ENetPeer* peer = m_replay_disconnects.back().first;
+        event->type = ENET_EVENT_TYPE_DISCONNECT;
+        event->peer = peer;
+        event->data = m_replay_disconnects.back().second;
+        m_replay_disconnects.pop_back();
+        peer->state = ENET_PEER_STATE_DISCONNECTED;
+        return true;
+    }
+
+    while (m_replay && m_replay_start_time != 0 && m_replay_budget > 0)
+    {
+        const NetworkCapture::Record* r = m_replay->getRecord();
+        if (!r)
+            return false;
+        if (m_replay_realtime && r->m_time - m_replay_first_time >
+            StkTime::getMonoTimeUs() - m_replay_start_time)
+            return false;
+
+        ENetPeer* peer = NULL;
+        if (r->m_type == EVENT_TYPE_CONNECTED)
+        {
+            // Value-initialized, so with no ENet host
+            m_replay_enet_peers.emplace_back(new ENetPeer());
+            peer = m_replay_enet_peers.back().get();
+            peer->state = ENET_PEER_STATE_CONNECTED;
+            peer->address = SocketAddress(r->m_address).toENetAddress();
+            m_replay_peers[r->m_host_id] = peer;
+            event->type = ENET_EVENT_TYPE_CONNECT;
+        }
+        else
+        {
+            auto it = m_replay_peers.find(r->m_host_id);
+            // Skip events of peers which the server disconnected already
+            if (it == m_replay_peers.end() ||
+                it->second->state != ENET_PEER_STATE_CONNECTED)
+            {
+                m_replay->nextRecord();
+                continue;
+            }
+            peer = it->second;
+            if (r->m_type == EVENT_TYPE_DISCONNECTED)
+            {
+                event->type = ENET_EVENT_TYPE_DISCONNECT;
+                event->data = r->m_disconnect_info;
+                peer->state = ENET_PEER_STATE_DISCONNECTED;
+                m_replay_peers.erase(it);
+            }
+            else
+            {
+                event->type = ENET_EVENT_TYPE_RECEIVE;
+                event->channelID = r->m_channel;
+                event->packet = enet_packet_create(r->m_data.data(),
+                    r->m_data.size(), ENET_PACKET_FLAG_RELIABLE);
+            }
+        }
+        event->peer = peer;
+        m_replay->nextRecord();
+        m_replay_budget--;
+        m_replay_events++;
+        return true;
+    }
+    return false;
+}   // getReplayEvent
+
+// ----------------------------------------------------------------------------
+/** Starts the replay once the server waits for players, and ends it (which
+ *  exits the server) a second after all captured events were replayed.
+ *  \return The time in milliseconds until the next captured event is due.
+ */
+int STKHost::updateReplay()
+{
+    // Limit the events in one go, so that commands are still handled
+    m_replay_budget = 100;
+    if (m_replay_start_time == 0)
+    {
+        auto sl = LobbyProtocol::get<ServerLobby>();
+        if (!sl || !sl->waitingForPlayers())
+            return 10;
+        const NetworkCapture::Record* r = m_replay->getRecord();
+        m_replay_first_time = r ? r->m_time : 0;
+        m_replay_start_time = StkTime::getMonoTimeUs();
+        Log::info("STKHost", "Replaying network capture %s.",
+            m_replay_file.c_str());
+    }
+
+    const NetworkCapture::Record* r = m_replay->getRecord();
+    if (r)
+    {
+        if (!m_replay_realtime)
+            return 0;
+        uint64_t due = r->m_time - m_replay_first_time;
+        uint64_t now = StkTime::getMonoTimeUs() - m_replay_start_time;
+        return due <= now ? 0 : (int)std::min<uint64_t>(10,
+            (due - now) / 1000);
+    }
+
+    if (m_replay_end_time == 0)
+    {
+        m_replay_end_time = StkTime::getMonoTimeMs();
+        float seconds = float(StkTime::getMonoTimeUs() -
+            m_replay_start_time) / 1000000.0f;
+        Log::info("STKHost", "Replayed %lu events in %f seconds (%f events "
+            "per second), %lu bytes sent.", (unsigned long)m_replay_events,
+            seconds, seconds > 0.0f ? m_replay_events / seconds : 0.0f,
+            (unsigned long)m_replay_sent_bytes);
+    }
+    else if (StkTime::getMonoTimeMs() > m_replay_end_time + 1000)
+    {
+        auto pm = ProtocolManager::lock();
+        if (pm)
+        {
+            uint64_t count;
+            float average_ms, max_ms;
+            pm->getEventLatency(&count, &average_ms, &max_ms,
+                /*reset*/false);
+            Log::info("STKHost", "Messages: %lu   Average latency (ms): %f   "
+                "Maximum latency (ms): %f", (unsigned long)count, average_ms,
+                max_ms);
+        }
+        m_replay.reset();
+        main_loop->requestAbort();
+    }
+    return 10;
+}   // updateReplay
+
+// ----------------------------------------------------------------------------
+/** Handles a command for a replay peer in the listening thread: packets are
+ *  only counted, and disconnecting generates a disconnect event like ENet
+ *  would.
+ */
+void STKHost::handleReplayCommand(ENetPeer* peer, ENetPacket* packet,
+                                  uint32_t data, ENetCommandType ect)
+{
+    switch (ect)
+    {
+    case ECT_SEND_PACKET:
+        m_replay_sent_bytes += packet->dataLength;
+        enet_packet_destroy(packet);
+        break;
+    case ECT_DISCONNECT:
+        if (peer->state == ENET_PEER_STATE_CONNECTED)
+        {
+            peer->state = ENET_PEER_STATE_DISCONNECTING;
+            m_replay_disconnects.emplace_back(peer, data);
+        }
+        break;
+    case ECT_RESET:
+    {
+        peer->state = ENET_PEER_STATE_DISCONNECTED;
+        for (auto it = m_replay_disconnects.begin();
+             it != m_replay_disconnects.end();)
+        {
+            if (it->first == peer)
+                it = m_replay_disconnects.erase(it);
+            else
+                it++;
+        }
+        std::lock_guard<std::mutex> lock(m_peers_mutex);
+        m_peers.erase(peer);
+        break;
+    }
+    }
+}   // handleReplayCommand
+
+// ----------------------------------------------------------------------------
+/** Waits in the listening thread until a packet is received, a command is
+ *  added with addEnetCommand(), or the timeout is over. Without eventfd
+ *  support only packets end the wait early.
+ *  \param host The ENet host to wait for.
+ *  \param timeout Maximum time to wait in milliseconds.
+ */
+void STKHost::waitForNetwork(ENetHost* host, int timeout)
+{
+#ifdef __linux__
+    if (m_wakeup_fd != -1)
+    {
+        // Commands added after this will call wakeUpNetwork
+        m_network_waiting.store(true);
+        if (m_enet_cmd.empty())
+        {
+            struct pollfd fds[2];
+            fds[0].fd = host->socket;
+            fds[0].events = POLLIN;
+            fds[0].revents = 0;
+            fds[1].fd = m_wakeup_fd;
+            fds[1].events = POLLIN;
+            fds[1].revents = 0;
+            poll(fds, 2, timeout);
+        }
+        m_network_waiting.store(false);
+        // Reset the counter, fails with EAGAIN if wakeUpNetwork was not
+        // called
+        uint64_t count;
+        ssize_t ret = read(m_wakeup_fd, &count, sizeof(count));
+        (void)ret;
+        return;
+    }
+#endif
+    enet_uint32 condition = ENET_SOCKET_WAIT_RECEIVE |
+        ENET_SOCKET_WAIT_INTERRUPT;
+    enet_socket_wait(host->socket, &condition, timeout);
+}   // waitForNetwork
+
+// ----------------------------------------------------------------------------
+/** Wakes up the listening thread if it is waiting in waitForNetwork(), so
+ *  that a new command is executed without delay.
+ */
+void STKHost::wakeUpNetwork()
+{
+#ifdef __linux__
+    if (m_wakeup_fd != -1 && m_network_waiting.load())
+    {
+        uint64_t one = 1;
+        ssize_t ret = write(m_wakeup_fd, &one, sizeof(one));
+        (void)ret;
+    }
+#endif
+}   // wakeUpNetwork
+
 // ----------------------------------------------------------------------------
 /** Handles a direct request given to a socket. This is typically a LAN 
  *  request, but can also be used if the server is public (i.e. not behind
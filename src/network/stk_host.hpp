@@ -22,6 +22,7 @@
 #ifndef STK_HOST_HPP
 #define STK_HOST_HPP
 
+#include "utils/mpsc_queue.hpp"
 #include "utils/stk_process.hpp"
 #include "utils/synchronised.hpp"
 #include "utils/time.hpp"
@@ -43,6 +44,7 @@
 #include <memory>
 #include <mutex>
 #include <set>
+#include <string>
 #include <thread>
 #include <tuple>
 #include <vector>
@@ -51,6 +53,7 @@ class BareNetworkString;
 class GameSetup;
 class LobbyProtocol;
 class Network;
+class NetworkCapture;
 class NetworkPlayerProfile;
 class NetworkString;
 class NetworkTimerSynchronizer;
@@ -90,13 +93,19 @@ private:
     mutable std::mutex m_peers_mutex;
 
     /** Let (atm enet_peer_send and enet_peer_disconnect) run in the listening
-     *  thread. */
-    std::vector<std::tuple</*peer receive*/ENetPeer*,
+     *  thread. Any thread can add commands without locking. */
+    MPSCQueue<std::tuple</*peer receive*/ENetPeer*,
         /*packet to send*/ENetPacket*, /*integer data*/uint32_t,
         ENetCommandType, ENetAddress> > m_enet_cmd;
 
-    /** Protect \ref m_enet_cmd from multiple threads usage. */
-    std::mutex m_enet_cmd_mutex;
+    /** An eventfd which wakes up the listening thread when a command is
+     *  added to \ref m_enet_cmd, or -1 if not supported (then commands wait
+     *  for the next network event or the 10 ms service timeout). */
+    int m_wakeup_fd;
+
+    /** True while the listening thread waits for network events, so that
+     *  it only needs to be woken up then. */
+    std::atomic_bool m_network_waiting;
 
     /** The list of peers connected to this instance. */
     std::map<ENetPeer*, std::shared_ptr<STKPeer> > m_peers;
@@ -157,6 +166,38 @@ private:
 
     std::unique_ptr<NetworkTimerSynchronizer> m_nts;
 
+    /** Records all received events if m_capture_file is set. */
+    std::unique_ptr<NetworkCapture> m_capture;
+
+    /** The events to replay if m_replay_file is set. Reset once all events
+     *  are replayed. */
+    std::unique_ptr<NetworkCapture> m_replay;
+
+    /** The peers created by the replay, by their host id in the capture. */
+    std::map<uint32_t, ENetPeer*> m_replay_peers;
+
+    /** Owns the ENet peers of the replay (which are not part of any ENet
+     *  host), they are kept as STKPeer might still use them. */
+    std::vector<std::unique_ptr<ENetPeer> > m_replay_enet_peers;
+
+    /** Replay peers disconnected by the server, and the disconnect info, for
+     *  which a disconnect event is generated. */
+    std::vector<std::pair<ENetPeer*, uint32_t> > m_replay_disconnects;
+
+    /** Time the replay started, and time of the first captured event, in
+     *  microseconds. */
+    uint64_t m_replay_start_time, m_replay_first_time;
+
+    /** Time in milliseconds when all events were replayed, or 0. */
+    uint64_t m_replay_end_time;
+
+    /** Number of events that can still be replayed before the listening
+     *  thread handles its commands again. */
+    unsigned m_replay_budget;
+
+    /** Number of replayed events, and bytes sent to replay peers. */
+    uint64_t m_replay_events, m_replay_sent_bytes;
+
     // ------------------------------------------------------------------------
     STKHost(bool server);
     // ------------------------------------------------------------------------
@@ -170,12 +211,42 @@ private:
     // ------------------------------------------------------------------------
     void mainLoop(ProcessType pt);
     // ------------------------------------------------------------------------
+    void waitForNetwork(ENetHost* host, int timeout);
+    // ------------------------------------------------------------------------
+    void wakeUpNetwork();
+    // ------------------------------------------------------------------------
+    bool serviceNetwork(ENetHost* host, ENetEvent* event);
+    // ------------------------------------------------------------------------
+    bool getReplayEvent(ENetEvent* event);
+    // ------------------------------------------------------------------------
+    int updateReplay();
+    // ------------------------------------------------------------------------
+    void handleReplayCommand(ENetPeer* peer, ENetPacket* packet,
+                             uint32_t data, ENetCommandType ect);
+    // ------------------------------------------------------------------------
+    /** Returns if a peer was created by the replay, these peers are not part
+     *  of an ENet host. */
+    static bool isReplayPeer(const ENetPeer* peer)
+                                                { return peer->host == NULL; }
+    // ------------------------------------------------------------------------
     void getIPFromStun(int socket, const std::string& stun_address,
                        short family, SocketAddress* result);
 public:
     /** If a network console should be started. */
     static bool m_enable_console;
 
+    /** If not empty, a server records all received events to this file,
+     *  see NetworkCapture. */
+    static std::string m_capture_file;
+
+    /** If not empty, a server replays the events captured in this file
+     *  instead of waiting for real clients, and exits afterwards. */
+    static std::string m_replay_file;
+
+    /** If the replay keeps the original time between events, otherwise the
+     *  events are replayed as fast as possible. */
+    static bool m_replay_realtime;
+
     /** Creates the STKHost. It takes all confifguration parameters from
      *  NetworkConfig. This STKHost can either be a client or a server.
      */
@@ -289,8 +360,8 @@ public:
     void addEnetCommand(ENetPeer* peer, ENetPacket* packet, uint32_t i,
                         ENetCommandType ect, ENetAddress ea)
     {
-        std::lock_guard<std::mutex> lock(m_enet_cmd_mutex);
-        m_enet_cmd.emplace_back(peer, packet, i, ect, ea);
+        m_enet_cmd.push(std::make_tuple(peer, packet, i, ect, ea));
+        wakeUpNetwork();
     }
     // ------------------------------------------------------------------------
     /** Returns the last error (or "" if no error has happened). */
@@ -321,6 +392,15 @@ public:
         return peers;
     }
     // ------------------------------------------------------------------------
+    /** Like getPeers(), but reuses the memory of the given vector. */
+    void getPeers(std::vector<std::shared_ptr<STKPeer> >* peers) const
+    {
+        std::lock_guard<std::mutex> lock(m_peers_mutex);
+        peers->clear();
+        for (auto& p : m_peers)
+            peers->push_back(p.second);
+    }   // getPeers
+    // ------------------------------------------------------------------------
     /** Returns the next (unique) host id. */
     unsigned int getNextHostId() const
     {
@@ -33,7 +33,7 @@
 #define ROLLING_INFLUENCE_FIX
 
 // ============================================================================
-btKart::btKart(btRigidBody* chassis, btVehicleRaycaster* raycaster,
+btKart::btKart(btRigidBody* chassis, btKartRaycaster* raycaster,
                Kart *kart)
       : m_vehicleRaycaster(raycaster), m_fixed_body(0, 0, 0)
 {
@@ -239,8 +239,54 @@ void btKart::updateAllWheelTransformsWS()
                 m_num_wheels_on_ground++;
         }
     }
+    // The prepared results are only valid for one step
+    m_prepared_hits.clear();
 }   // updateAllWheelTransformsWS
 
+// ----------------------------------------------------------------------------
+/** Appends the start and end points of the ray of each wheel (as used in
+ *  rayCast()) to the given arrays. This is used to cast the wheel rays of
+ *  all karts against the track in one batch.
+ *  \param from, to The arrays to which the rays are appended.
+ */
+void btKart::getWheelRays(btAlignedObjectArray<btVector3> *from,
+                          btAlignedObjectArray<btVector3> *to) const
+{
+    const btTransform &chassis_trans = getChassisWorldTransform();
+    for (int i = 0; i < m_wheelInfo.size(); i++)
+    {
+        const btWheelInfo &wheel = m_wheelInfo[i];
+        btScalar raylen = wheel.getSuspensionRestLength()
+                        + wheel.m_maxSuspensionTravel + 0.5f;
+        btVector3 source = chassis_trans(wheel.m_chassisConnectionPointCS
+                                         * 1.0f);
+        btVector3 rayvector = (chassis_trans.getBasis()
+                               * wheel.m_wheelDirectionCS) * raylen;
+        from->push_back(source);
+        to->push_back(source + rayvector);
+    }
+}   // getWheelRays
+
+// ----------------------------------------------------------------------------
+/** Sets the results of the wheel rays against the track, which are used by
+ *  the next rayCast() calls of this step.
+ *  \param from, to The rays as returned by getWheelRays().
+ *  \param hits The result of each ray against the track.
+ */
+void btKart::setPreparedTrackHits(const btVector3 *from, const btVector3 *to,
+                                  const TriangleMesh::RayHit *hits)
+{
+    m_prepared_from.resize(m_wheelInfo.size());
+    m_prepared_to.resize(m_wheelInfo.size());
+    m_prepared_hits.resize(m_wheelInfo.size());
+    for (int i = 0; i < m_wheelInfo.size(); i++)
+    {
+        m_prepared_from[i] = from[i];
+        m_prepared_to[i]   = to[i];
+        m_prepared_hits[i] = hits[i];
+    }
+}   // setPreparedTrackHits
+
 // ----------------------------------------------------------------------------
 /**
  */
@@ -279,7 +325,14 @@ btScalar btKart::rayCast(unsigned int index, float fraction)
 
     btAssert(m_vehicleRaycaster);
 
-    void* object = m_vehicleRaycaster->castRay(source,target,rayResults);
+    // Use the result against the track if it was computed in advance
+    const TriangleMesh::RayHit *track_hit = NULL;
+    if (index < (unsigned int)m_prepared_hits.size() &&
+        m_prepared_from[index] == source && m_prepared_to[index] == target)
+        track_hit = &m_prepared_hits[index];
+
+    void* object = m_vehicleRaycaster->castRay(source, target, rayResults,
+                                               track_hit);
 
     wheel.m_raycastInfo.m_groundObject = 0;
 
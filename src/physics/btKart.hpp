@@ -69,7 +69,7 @@ private:
     btScalar calcRollingFriction(btWheelContactPoint& contactPoint);
 
     btScalar            m_damping;
-    btVehicleRaycaster *m_vehicleRaycaster;
+    btKartRaycaster    *m_vehicleRaycaster;
 
     /** Sliding (skidding) will only be permited when this is true. Also check
      *  the friction parameter in the wheels since friction directly affects
@@ -124,6 +124,16 @@ private:
 
     btAlignedObjectArray<btWheelInfo> m_wheelInfo;
 
+    /** Start and end points of the wheel rays for which m_prepared_hits
+     *  contains the result against the track. */
+    btAlignedObjectArray<btVector3> m_prepared_from;
+    btAlignedObjectArray<btVector3> m_prepared_to;
+
+    /** The result of the wheel rays against the track, computed for all
+     *  karts together in STKDynamicsWorld (or empty). They are only used if
+     *  the rays in this step are identical to the prepared ones. */
+    btAlignedObjectArray<TriangleMesh::RayHit> m_prepared_hits;
+
     void     defaultInit();
     btScalar rayCast(btWheelInfo& wheel, const btVector3& ray);
     void     updateWheelTransformsWS(btWheelInfo& wheel,
@@ -140,7 +150,7 @@ public:
      *         (this is used to get access to the kart properties).
      */
                        btKart(btRigidBody* chassis,
-                              btVehicleRaycaster* raycaster,
+                              btKartRaycaster* raycaster,
                               Kart *kart);
      virtual          ~btKart();
     void               reset();
@@ -165,6 +175,11 @@ public:
     const btWheelInfo& getWheelInfo(int index) const;
     btWheelInfo&       getWheelInfo(int index);
     void               updateAllWheelTransformsWS();
+    void               getWheelRays(btAlignedObjectArray<btVector3> *from,
+                                    btAlignedObjectArray<btVector3> *to) const;
+    void               setPreparedTrackHits(const btVector3 *from,
+                                            const btVector3 *to,
+                                            const TriangleMesh::RayHit *hits);
     void               setAllBrakes(btScalar brake);
     void               updateSuspension(btScalar deltaTime);
     virtual void       updateFriction(btScalar timeStep);
@@ -21,6 +21,20 @@
 
 void* btKartRaycaster::castRay(const btVector3& from, const btVector3& to,
                                btVehicleRaycasterResult& result)
+{
+    return castRay(from, to, result, NULL);
+}   // castRay
+
+// ----------------------------------------------------------------------------
+/** Casts a ray for a wheel.
+ *  \param track_hit If not NULL, the already computed result of this ray
+ *         against the main track mesh (see TriangleMesh::castRays). The
+ *         track is then skipped in the raycast, only other objects that
+ *         are closer than the track hit are tested.
+ */
+void* btKartRaycaster::castRay(const btVector3& from, const btVector3& to,
+                               btVehicleRaycasterResult& result,
+                               const TriangleMesh::RayHit *track_hit)
 {
     // ========================================================================
     class ClosestWithNormal : public btCollisionWorld::ClosestRayResultCallback
@@ -28,14 +42,43 @@ void* btKartRaycaster::castRay(const btVector3& from, const btVector3& to,
     private:
         int m_triangle_index;
     public:
+        /** An object which is not tested (since it was already tested
+         *  before), or NULL. */
+        const btCollisionObject *m_skip_object;
+        // --------------------------------------------------------------------
         /** Constructor, initialises the triangle index. */
         ClosestWithNormal(const btVector3 &from,
                           const btVector3 &to)
                           : btCollisionWorld::ClosestRayResultCallback(from,to)
         {
             m_triangle_index = -1;
+            m_skip_object    = NULL;
         }   // CloestWithNormal
         // --------------------------------------------------------------------
+        /** Sets the result of a hit that was computed earlier, so that only
+         *  closer objects are reported by the raycast. */
+        void setHit(const btCollisionObject *object,
+                    const TriangleMesh::RayHit &hit)
+        {
+            m_skip_object = object;
+            if (!hit.hasHit())
+                return;
+            // This bullet version stores a non-const pointer
+            m_collisionObject    = const_cast<btCollisionObject*>(object);
+            m_closestHitFraction = hit.m_fraction;
+            m_hitPointWorld      = hit.m_hit_point;
+            m_hitNormalWorld     = hit.m_normal;
+            m_triangle_index     = hit.m_triangle_index;
+        }   // setHit
+        // --------------------------------------------------------------------
+        virtual bool needsCollision(btBroadphaseProxy* proxy) const
+        {
+            if (proxy->m_clientObject == m_skip_object)
+                return false;
+            return btCollisionWorld::ClosestRayResultCallback
+                                   ::needsCollision(proxy);
+        }   // needsCollision
+        // --------------------------------------------------------------------
         /** Stores the index of the triangle hit. */
         virtual    btScalar addSingleResult(btCollisionWorld::LocalRayResult& rayResult,
                                          bool normalInWorldSpace)
@@ -58,6 +101,11 @@ void* btKartRaycaster::castRay(const btVector3& from, const btVector3& to,
     // ========================================================================
 
     ClosestWithNormal rayCallback(from,to);
+    if (track_hit)
+    {
+        rayCallback.setHit(Track::getCurrentTrack()->getPtrTriangleMesh()
+                                                   ->getBody(), *track_hit);
+    }
 
     m_dynamicsWorld->rayTest(from, to, rayCallback);
 
@@ -18,6 +18,7 @@ class btDynamicsWorld;
 #include "LinearMath/btAlignedObjectArray.h"
 #include "BulletDynamics/Vehicle/btWheelInfo.h"
 #include "BulletDynamics/Dynamics/btActionInterface.h"
+#include "physics/triangle_mesh.hpp"
 
 
 class btKartRaycaster : public btVehicleRaycaster
@@ -35,6 +36,9 @@ public:
 
     virtual void* castRay(const btVector3& from,const btVector3& to,
                           btVehicleRaycasterResult& result);
+    void* castRay(const btVector3& from, const btVector3& to,
+                  btVehicleRaycasterResult& result,
+                  const TriangleMesh::RayHit *track_hit);
 
 };
 
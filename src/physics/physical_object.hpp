@@ -284,7 +284,10 @@ public:
     void addForRewind();
     virtual void saveTransform();
     virtual void computeError();
-    virtual BareNetworkString* saveState(std::vector<std::string>* ru);
+    virtual bool saveState(BareNetworkString *buffer,
+                           std::vector<std::string>* ru);
+    virtual bool savePredictedState(BareNetworkString *buffer,
+                                    std::vector<std::string>* ru);
     virtual void undoEvent(BareNetworkString *buffer) {}
     virtual void rewindToEvent(BareNetworkString *buffer) {}
     virtual void restoreState(BareNetworkString *buffer, int count);
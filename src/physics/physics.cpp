@@ -77,6 +77,8 @@ Physics::Physics() : btSequentialImpulseConstraintSolver()
 {
     m_collision_conf      = new btDefaultCollisionConfiguration();
     m_dispatcher          = new btCollisionDispatcher(m_collision_conf);
+    m_total_step_time     = 0.0;
+    m_num_steps           = 0;
 }   // Physics
 
 //-----------------------------------------------------------------------------
@@ -110,6 +112,11 @@ void Physics::init(const Vec3 &world_min, const Vec3 &world_max)
     // Modify the mode according to the bits of the solver mode:
     info.m_solverMode = (info.m_solverMode & (~stk_config->m_solver_reset_flags))
                       | stk_config->m_solver_set_flags;
+
+    m_dynamics_world->setMultithreaded(UserConfigParams::m_mt_physics,
+                                    UserConfigParams::m_mt_physics_deterministic);
+    m_total_step_time = 0.0;
+    m_num_steps       = 0;
 }   // init
 
 //-----------------------------------------------------------------------------
@@ -190,16 +197,17 @@ void Physics::update(int ticks)
     // Since the world update (which calls physics update) is called at the
     // fixed frequency necessary for the physics update, we need to do exactly
     // one physic step only.
-    double start;
-    if(UserConfigParams::m_physics_debug) start = StkTime::getRealTime();
+    double start = StkTime::getRealTime();
 
     m_dynamics_world->stepSimulation(stk_config->ticks2Time(1), 1,
                                      stk_config->ticks2Time(1)      );
+    double duration = StkTime::getRealTime() - start;
+    m_total_step_time += duration;
+    m_num_steps++;
     if (UserConfigParams::m_physics_debug)
     {
         Log::verbose("Physics", "At %d physics duration %12.8f",
-                     World::getWorld()->getTicksSinceStart(),
-                     StkTime::getRealTime() - start);
+                     World::getWorld()->getTicksSinceStart(), duration);
     }
 
     // Now handle the actual collision. Note: flyables can not be removed
@@ -556,7 +564,9 @@ void Physics::KartKartCollision(AbstractKart *kart_a,
 }   // KartKartCollision
 
 //-----------------------------------------------------------------------------
-/** This function is called at each internal bullet timestep. It is used
+/** This function is called at each internal bullet timestep once the
+ *  constraints of all simulation islands are solved (which can happen in
+ *  parallel, see STKDynamicsWorld::solveConstraints). It is used
  *  here to do the collision handling: using the contact manifolds after a
  *  physics time step might miss some collisions (when more than one internal
  *  time step was done, and the collision is added and removed). So this
@@ -567,23 +577,11 @@ void Physics::KartKartCollision(AbstractKart *kart_a,
  *  The list of collision
  *  Parameters: see bullet documentation for details.
  */
-btScalar Physics::solveGroup(btCollisionObject** bodies, int numBodies,
-                             btPersistentManifold** manifold,int numManifolds,
-                             btTypedConstraint** constraints,
-                             int numConstraints,
-                             const btContactSolverInfo& info,
-                             btIDebugDraw* debugDrawer,
-                             btStackAlloc* stackAlloc,
-                             btDispatcher* dispatcher)
+void Physics::allSolved(const btContactSolverInfo& info,
+                        btIDebugDraw* debugDrawer, btStackAlloc* stackAlloc)
 {
-    btScalar returnValue=
-        btSequentialImpulseConstraintSolver::solveGroup(bodies, numBodies,
-                                                        manifold, numManifolds,
-                                                        constraints,
-                                                        numConstraints, info,
-                                                        debugDrawer,
-                                                        stackAlloc,
-                                                        dispatcher);
+    btSequentialImpulseConstraintSolver::allSolved(info, debugDrawer,
+                                                   stackAlloc);
     int currentNumManifolds = m_dispatcher->getNumManifolds();
     // We can't explode a rocket in a loop, since a rocket might collide with
     // more than one object, and/or more than once with each object (if there
@@ -756,8 +754,7 @@ btScalar Physics::solveGroup(btCollisionObject** bodies, int numBodies,
             assert("Unknown user pointer");           // 4) Should never happen
     }   // for i<numManifolds
 
-    return returnValue;
-}   // solveGroup
+}   // allSolved
 
 // ----------------------------------------------------------------------------
 /** A debug draw function to show the track and all karts.
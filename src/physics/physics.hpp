@@ -147,6 +147,13 @@ private:
     btDefaultCollisionConfiguration *m_collision_conf;
     CollisionList                    m_all_collisions;
 
+    /** Real time spent in bullet's step since init(), used to compare
+     *  the single and multi-threaded solver with --profile-laps. */
+    double                           m_total_step_time;
+
+    /** Number of physics steps since init(). */
+    int                              m_num_steps;
+
              Physics();
     virtual ~Physics();
 
@@ -176,12 +183,13 @@ public:
     /** Returns true if the debug drawer is enabled. */
     bool  isDebug() const     {return m_debug_drawer->debugEnabled(); }
     IrrDebugDrawer* getDebugDrawer() { return m_debug_drawer; }
-    virtual btScalar solveGroup(btCollisionObject** bodies, int numBodies,
-                                btPersistentManifold** manifold,int numManifolds,
-                                btTypedConstraint** constraints,int numConstraints,
-                                const btContactSolverInfo& info,
-                                btIDebugDraw* debugDrawer, btStackAlloc* stackAlloc,
-                                btDispatcher* dispatcher);
+    /** Returns the average real time of one physics step in seconds. */
+    double getAverageStepTime() const
+    {
+        return m_num_steps > 0 ? m_total_step_time / m_num_steps : 0.0;
+    }
+    virtual void allSolved(const btContactSolverInfo& info,
+                           btIDebugDraw* debugDrawer, btStackAlloc* stackAlloc);
 };
 
 #endif // HEADER_PHYSICS_HPP
@@ -0,0 +1,370 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2024 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#include "physics/stk_dynamics_world.hpp"
+
+#include "physics/btKart.hpp"
+#include "tracks/track.hpp"
+#include "utils/log.hpp"
+#include "utils/thread_pool.hpp"
+#include "utils/time.hpp"
+
+#include "BulletCollision/CollisionDispatch/btSimulationIslandManager.h"
+
+#include <algorithm>
+
+namespace
+{
+    /** Minimum number of contact manifolds and constraints in a step before
+     *  the islands are solved in parallel, below that the overhead of
+     *  waking up the worker threads is bigger than the gain. */
+    const int MIN_PARALLEL_WORK = 8;
+
+    // ------------------------------------------------------------------------
+    /** Returns the island a constraint belongs to (bullet's version of this
+     *  function is local to btDiscreteDynamicsWorld.cpp). */
+    int getConstraintIslandId(const btTypedConstraint* c)
+    {
+        const btCollisionObject& a = c->getRigidBodyA();
+        const btCollisionObject& b = c->getRigidBodyB();
+        return a.getIslandTag() >= 0 ? a.getIslandTag() : b.getIslandTag();
+    }   // getConstraintIslandId
+
+    // ------------------------------------------------------------------------
+    /** Copies the bodies and manifolds of each island reported by the island
+     *  manager, since the manager reuses its arrays for the next island. */
+    struct CollectIslandCallback
+        : public btSimulationIslandManager::IslandCallback
+    {
+        std::vector<int>                    *m_island_ids;
+        std::vector<btCollisionObject*>     *m_bodies;
+        std::vector<btPersistentManifold*>  *m_manifolds;
+        std::vector<int>                    *m_ranges;
+
+        virtual void ProcessIsland(btCollisionObject** bodies, int num_bodies,
+                                   btPersistentManifold** manifolds,
+                                   int num_manifolds, int island_id)
+        {
+            m_island_ids->push_back(island_id);
+            m_ranges->push_back((int)m_bodies->size());
+            m_ranges->push_back(num_bodies);
+            m_ranges->push_back((int)m_manifolds->size());
+            m_ranges->push_back(num_manifolds);
+            m_bodies->insert(m_bodies->end(), bodies, bodies + num_bodies);
+            m_manifolds->insert(m_manifolds->end(), manifolds,
+                                manifolds + num_manifolds);
+        }   // ProcessIsland
+    };   // CollectIslandCallback
+}   // anonymous namespace
+
+// ----------------------------------------------------------------------------
+STKDynamicsWorld::~STKDynamicsWorld()
+{
+    for (btSequentialImpulseConstraintSolver* solver : m_island_solvers)
+        delete solver;
+}   // ~STKDynamicsWorld
+
+// ----------------------------------------------------------------------------
+/** Enables or disables solving simulation islands in parallel.
+ *  \param multithreaded True if the \ref ThreadPool should be used.
+ *  \param deterministic True if the result must not depend on the number
+ *         of threads used.
+ */
+void STKDynamicsWorld::setMultithreaded(bool multithreaded,
+                                        bool deterministic)
+{
+    m_multithreaded = multithreaded;
+    m_deterministic = deterministic;
+}   // setMultithreaded
+
+// ----------------------------------------------------------------------------
+/** Stores the bodies, manifolds and constraints of all awake islands in
+ *  m_islands. Constraints are sorted by island, matching the order in which
+ *  bullet would have passed them to the solver.
+ */
+void STKDynamicsWorld::collectIslands()
+{
+    m_islands.clear();
+    m_island_bodies.clear();
+    m_island_manifolds.clear();
+    m_island_constraints.clear();
+
+    std::vector<btTypedConstraint*> sorted(m_constraints.size());
+    for (int i = 0; i < m_constraints.size(); i++)
+        sorted[i] = m_constraints[i];
+    std::stable_sort(sorted.begin(), sorted.end(),
+        [](const btTypedConstraint* a, const btTypedConstraint* b)
+        {
+            return getConstraintIslandId(a) < getConstraintIslandId(b);
+        });
+
+    std::vector<int> island_ids, ranges;
+    CollectIslandCallback callback;
+    callback.m_island_ids = &island_ids;
+    callback.m_bodies     = &m_island_bodies;
+    callback.m_manifolds  = &m_island_manifolds;
+    callback.m_ranges     = &ranges;
+    m_islandManager->buildAndProcessIslands(getDispatcher(), this, &callback);
+
+    for (unsigned int i = 0; i < island_ids.size(); i++)
+    {
+        Island island;
+        island.m_first_body       = ranges[4 * i    ];
+        island.m_num_bodies       = ranges[4 * i + 1];
+        island.m_first_manifold   = ranges[4 * i + 2];
+        island.m_num_manifolds    = ranges[4 * i + 3];
+        island.m_first_constraint = (int)m_island_constraints.size();
+        for (btTypedConstraint* c : sorted)
+        {
+            if (getConstraintIslandId(c) == island_ids[i])
+                m_island_constraints.push_back(c);
+        }
+        island.m_num_constraints = (int)m_island_constraints.size()
+                                 - island.m_first_constraint;
+        // Like bullet, skip islands without anything to solve
+        if (island.m_num_manifolds + island.m_num_constraints > 0)
+            m_islands.push_back(island);
+    }
+}   // collectIslands
+
+// ----------------------------------------------------------------------------
+/** Solves all islands assigned to one thread, using the solver of that
+ *  thread.
+ *  \param thread Index of the thread (and solver).
+ *  \param info The solver settings.
+ */
+void STKDynamicsWorld::solveIslands(unsigned int thread,
+                                    const btContactSolverInfo &info)
+{
+    btSequentialImpulseConstraintSolver* solver = m_island_solvers[thread];
+    for (int n : m_islands_per_thread[thread])
+    {
+        const Island& island = m_islands[n];
+        if (m_deterministic)
+            solver->reset();
+        btCollisionObject** bodies = island.m_num_bodies > 0
+                                   ? &m_island_bodies[island.m_first_body]
+                                   : NULL;
+        btPersistentManifold** manifolds = island.m_num_manifolds > 0
+                            ? &m_island_manifolds[island.m_first_manifold]
+                            : NULL;
+        btTypedConstraint** constraints = island.m_num_constraints > 0
+                          ? &m_island_constraints[island.m_first_constraint]
+                          : NULL;
+        solver->solveGroup(bodies, island.m_num_bodies,
+                           manifolds, island.m_num_manifolds,
+                           constraints, island.m_num_constraints,
+                           info, m_debugDrawer, m_stackAlloc, m_dispatcher1);
+    }
+}   // solveIslands
+
+// ----------------------------------------------------------------------------
+/** Solves the constraints of all islands. If multi-threading is enabled, the
+ *  islands are distributed over the threads of the \ref ThreadPool, each
+ *  thread using its own solver. Islands never share a dynamic body, so they
+ *  can be solved independently. Afterwards allSolved() of the main solver
+ *  is called, which does the collision handling in \ref Physics.
+ */
+void STKDynamicsWorld::solveConstraints(btContactSolverInfo& solver_info)
+{
+    ThreadPool* pool = ThreadPool::get();
+    if (!m_multithreaded || !pool || pool->getNumThreads() == 0 ||
+        !m_islandManager->getSplitIslands())
+    {
+        btDiscreteDynamicsWorld::solveConstraints(solver_info);
+        return;
+    }
+
+    m_constraintSolver->prepareSolve(getNumCollisionObjects(),
+                                     getDispatcher()->getNumManifolds());
+    collectIslands();
+
+    int work = (int)(m_island_manifolds.size() + m_island_constraints.size());
+    unsigned int num_threads = m_islands.size() < 2 || work < MIN_PARALLEL_WORK
+                             ? 1
+                             : std::min((unsigned)m_islands.size(),
+                                        pool->getNumThreads() + 1);
+    while (m_island_solvers.size() < num_threads)
+        m_island_solvers.push_back(new btSequentialImpulseConstraintSolver());
+
+    // Greedily give the next biggest island to the thread with the least
+    // work. The assignment only depends on the islands, so it is the same
+    // on every run.
+    std::vector<int> order(m_islands.size());
+    for (unsigned int i = 0; i < order.size(); i++)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [this](int a, int b)
+        {
+            return m_islands[a].m_num_manifolds + m_islands[a].m_num_constraints
+                 > m_islands[b].m_num_manifolds + m_islands[b].m_num_constraints;
+        });
+    m_islands_per_thread.resize(num_threads);
+    std::vector<int> load(num_threads, 0);
+    for (unsigned int i = 0; i < num_threads; i++)
+        m_islands_per_thread[i].clear();
+    for (int n : order)
+    {
+        unsigned int t = (unsigned)(std::min_element(load.begin(), load.end())
+                                    - load.begin());
+        m_islands_per_thread[t].push_back(n);
+        load[t] += m_islands[n].m_num_manifolds
+                 + m_islands[n].m_num_constraints;
+    }
+    // Solve the islands of each thread in their original order
+    for (unsigned int i = 0; i < num_threads; i++)
+    {
+        std::sort(m_islands_per_thread[i].begin(),
+                  m_islands_per_thread[i].end());
+    }
+
+    pool->parallelFor(num_threads, [this, &solver_info](unsigned int i)
+        {
+            solveIslands(i, solver_info);
+        });
+
+    m_constraintSolver->allSolved(solver_info, m_debugDrawer, m_stackAlloc);
+}   // solveConstraints
+
+// ----------------------------------------------------------------------------
+/** Moves all bodies, and then casts the wheel rays of all karts against the
+ *  track, so that updateActions() does not need one BVH traversal for each
+ *  wheel of each kart.
+ */
+void STKDynamicsWorld::integrateTransforms(btScalar time_step)
+{
+    btDiscreteDynamicsWorld::integrateTransforms(time_step);
+    prepareWheelRays();
+}   // integrateTransforms
+
+// ----------------------------------------------------------------------------
+/** Casts the rays of all wheels of all karts against the main track mesh in
+ *  one batch. Each kart then only needs to test the other (usually few)
+ *  objects of the world for its wheels, see btKartRaycaster::castRay.
+ */
+void STKDynamicsWorld::prepareWheelRays()
+{
+    Track *track = Track::getCurrentTrack();
+    if (!track || !track->getPtrTriangleMesh() ||
+        !track->getPtrTriangleMesh()->getBody())
+        return;
+
+    m_ray_karts.clear();
+    m_ray_from.resize(0);
+    m_ray_to.resize(0);
+    for (int i = 0; i < m_actions.size(); i++)
+    {
+        btKart *kart = dynamic_cast<btKart*>(m_actions[i]);
+        if (!kart)
+            continue;
+        m_ray_karts.push_back(kart);
+        kart->getWheelRays(&m_ray_from, &m_ray_to);
+    }
+    if (m_ray_from.size() == 0)
+        return;
+
+    m_ray_hits.resize(m_ray_from.size());
+    track->getPtrTriangleMesh()->castRays(m_ray_from.size(), &m_ray_from[0],
+                                          &m_ray_to[0], &m_ray_hits[0]);
+    int n = 0;
+    for (btKart *kart : m_ray_karts)
+    {
+        kart->setPreparedTrackHits(&m_ray_from[n], &m_ray_to[n],
+                                   &m_ray_hits[n]);
+        n += kart->getNumWheels();
+    }
+}   // prepareWheelRays
+
+// ----------------------------------------------------------------------------
+/** Measures the average time of one physics step in a scene with many
+ *  independent stacks of boxes (i.e. many simulation islands), once with
+ *  the islands solved one after another and once solved in parallel on the
+ *  \ref ThreadPool. The results are printed, including a checksum of the
+ *  final positions which must be identical for both runs.
+ *  \param num_stacks Number of stacks of boxes.
+ *  \param num_steps Number of steps to measure.
+ */
+void STKDynamicsWorld::benchmark(int num_stacks, int num_steps)
+{
+    const float dt = 1.0f / 120.0f;
+    float step_time[2], checksum[2];
+    for (int run = 0; run < 2; run++)
+    {
+        btDefaultCollisionConfiguration config;
+        btCollisionDispatcher dispatcher(&config);
+        btDbvtBroadphase broadphase;
+        btSequentialImpulseConstraintSolver solver;
+        STKDynamicsWorld world(&dispatcher, &broadphase, &solver, &config);
+        world.setMultithreaded(/*multithreaded*/run == 1,
+                               /*deterministic*/true);
+        world.setGravity(btVector3(0, -9.8f, 0));
+
+        btStaticPlaneShape ground_shape(btVector3(0, 1, 0), 0);
+        btRigidBody ground(0, NULL, &ground_shape);
+        world.addRigidBody(&ground);
+
+        btBoxShape box(btVector3(0.5f, 0.5f, 0.5f));
+        btVector3 inertia;
+        box.calculateLocalInertia(1.0f, inertia);
+        std::vector<btRigidBody*> bodies;
+        int side = 1;
+        while (side * side < num_stacks)
+            side++;
+        for (int i = 0; i < num_stacks; i++)
+        {
+            // Stacks are far enough apart to be separate islands
+            float x = (i % side) * 6.0f, z = (i / side) * 6.0f;
+            for (int j = 0; j < 5; j++)
+            {
+                btTransform t(btQuaternion(0, 0, 0, 1),
+                              btVector3(x + 0.1f * j, 0.5f + 1.01f * j, z));
+                btRigidBody* body = new btRigidBody(1.0f, NULL, &box,
+                                                    inertia);
+                body->setWorldTransform(t);
+                body->setActivationState(DISABLE_DEACTIVATION);
+                world.addRigidBody(body);
+                bodies.push_back(body);
+            }
+        }
+
+        // Let the boxes settle before measuring
+        for (int i = 0; i < 60; i++)
+            world.stepSimulation(dt, 1, dt);
+        uint64_t start = StkTime::getMonoTimeUs();
+        for (int i = 0; i < num_steps; i++)
+            world.stepSimulation(dt, 1, dt);
+        step_time[run] = (StkTime::getMonoTimeUs() - start) / 1000.0f
+                       / num_steps;
+
+        checksum[run] = 0;
+        for (btRigidBody* body : bodies)
+        {
+            checksum[run] += body->getWorldTransform().getOrigin().length();
+            world.removeRigidBody(body);
+            delete body;
+        }
+        world.removeRigidBody(&ground);
+    }
+    ThreadPool* pool = ThreadPool::get();
+    Log::info("STKDynamicsWorld", "%d stacks, %d worker threads: "
+              "serial %.3f ms/step, parallel %.3f ms/step, "
+              "checksums %f %f.", num_stacks,
+              pool ? pool->getNumThreads() : 0, step_time[0], step_time[1],
+              checksum[0], checksum[1]);
+}   // benchmark
+
+/* EOF */
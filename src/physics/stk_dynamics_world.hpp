@@ -20,13 +20,73 @@
 #define HEADER_STK_DYNAMICS_WORLD_HPP
 
 #include "btBulletDynamicsCommon.h"
+#include "physics/triangle_mesh.hpp"
+#include "utils/cpp2011.hpp"
+
+#include <vector>
+
+class btKart;
 
 /** A thin wrapper around bullet's btDiscreteDynamicsWorld. Used to
  *  be able to query and set the 'left over' time from a previous
  *  time step, which is needed for more precise rewind/replays.
+ *  It can also solve the constraints of independent simulation islands
+ *  in parallel on the \ref ThreadPool. Each thread uses its own solver,
+ *  and since islands do not share any dynamic body the result is the
+ *  same as when solving them one after another.
  */
 class STKDynamicsWorld : public btDiscreteDynamicsWorld
 {
+private:
+    /** Index ranges of one simulation island in m_island_bodies,
+     *  m_island_manifolds and m_island_constraints. */
+    struct Island
+    {
+        int m_first_body, m_num_bodies;
+        int m_first_manifold, m_num_manifolds;
+        int m_first_constraint, m_num_constraints;
+    };
+
+    /** True if islands should be solved in parallel. */
+    bool m_multithreaded;
+
+    /** If set, the solver is reset before each island, so that the result
+     *  does not depend on the number of threads even if the solver uses a
+     *  randomised order. */
+    bool m_deterministic;
+
+    /** One solver for each thread solving islands. */
+    std::vector<btSequentialImpulseConstraintSolver*> m_island_solvers;
+
+    /** All islands of the current step, and the bodies, manifolds and
+     *  constraints they use. */
+    std::vector<Island>                m_islands;
+    std::vector<btCollisionObject*>    m_island_bodies;
+    std::vector<btPersistentManifold*> m_island_manifolds;
+    std::vector<btTypedConstraint*>    m_island_constraints;
+
+    /** For each thread the indices of the islands it solves. */
+    std::vector<std::vector<int> >     m_islands_per_thread;
+
+    /** The wheel rays of all karts, which are cast against the track in one
+     *  batch each step. */
+    std::vector<btKart*>                       m_ray_karts;
+    btAlignedObjectArray<btVector3>            m_ray_from;
+    btAlignedObjectArray<btVector3>            m_ray_to;
+    btAlignedObjectArray<TriangleMesh::RayHit> m_ray_hits;
+
+    // ------------------------------------------------------------------------
+    void collectIslands();
+    // ------------------------------------------------------------------------
+    void solveIslands(unsigned int thread, const btContactSolverInfo &info);
+    // ------------------------------------------------------------------------
+    void prepareWheelRays();
+
+protected:
+    virtual void solveConstraints(btContactSolverInfo& solver_info) OVERRIDE;
+    // ------------------------------------------------------------------------
+    virtual void integrateTransforms(btScalar time_step) OVERRIDE;
+
 public:
     /** The standard constructor which just created a btDiscreteDynamicsWorld. */
     STKDynamicsWorld(btDispatcher*             dispatcher,
@@ -38,8 +98,14 @@ public:
                                              constraintSolver,
                                              collisionConfiguration)
     {
+        m_multithreaded = false;
+        m_deterministic = true;
     }
-
+    // ------------------------------------------------------------------------
+    virtual ~STKDynamicsWorld();
+    // ------------------------------------------------------------------------
+    void setMultithreaded(bool multithreaded, bool deterministic);
+    // ------------------------------------------------------------------------
     /** Resets m_localTime to 0. This allows more precise replay of
      *  physics, which is important for replaying histories. */
     void resetLocalTime() { m_localTime = 0; }
@@ -49,7 +115,8 @@ public:
     // ------------------------------------------------------------------------
     /** Gets the local time. */
     float getLocalTime() const { return m_localTime; }
+    // ------------------------------------------------------------------------
+    static void benchmark(int num_stacks, int num_steps);
 };   // STKDynamicsWorld
 #endif
 /* EOF */
-
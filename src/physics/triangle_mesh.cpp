@@ -23,12 +23,95 @@
 #include "physics/physics.hpp"
 #include "utils/constants.hpp"
 #include "utils/log.hpp"
+#include "utils/thread_pool.hpp"
 #include "utils/time.hpp"
 
 #include "btBulletDynamicsCommon.h"
+#include "BulletCollision/NarrowPhaseCollision/btRaycastCallback.h"
 
+#include <algorithm>
 #include <fstream>
 
+namespace
+{
+    /** Consecutive rays are combined into one packet (which shares one
+     *  traversal of the BVH) as long as the bounding box of the packet is
+     *  at most this big in its two smaller dimensions. So rays of the wheels
+     *  of one kart, or parallel downward rays, end up in the same packet. */
+    const float MAX_PACKET_SIZE = 20.0f;
+
+    /** Minimum number of packets before they are split between the threads
+     *  of the thread pool. */
+    const unsigned int MIN_PARALLEL_PACKETS = 8;
+
+    // ------------------------------------------------------------------------
+    /** Tests one ray against the triangles of a packet. This uses bullet's
+     *  triangle raycast, so the result is the same as that of castRay(). */
+    class PacketRay : public btTriangleRaycastCallback
+    {
+    public:
+        /** Bounding box of the ray in mesh coordinates. */
+        btVector3 m_aabb_min, m_aabb_max;
+        /** Normal of the triangle hit in mesh coordinates. */
+        btVector3 m_normal;
+        /** Index of the closest triangle hit so far, or -1. */
+        int m_index;
+        // --------------------------------------------------------------------
+        PacketRay(const btVector3 &from, const btVector3 &to)
+            : btTriangleRaycastCallback(from, to)
+        {
+            m_aabb_min = from;
+            m_aabb_min.setMin(to);
+            m_aabb_max = from;
+            m_aabb_max.setMax(to);
+            m_index    = -1;
+        }   // PacketRay
+        // --------------------------------------------------------------------
+        virtual btScalar reportHit(const btVector3 &normal, btScalar fraction,
+                                   int part, int index)
+        {
+            m_normal = normal;
+            m_index  = index;
+            return fraction;
+        }   // reportHit
+    };   // PacketRay
+
+    // ------------------------------------------------------------------------
+    /** Passes each triangle found in the BVH to all rays of a packet whose
+     *  bounding box overlaps the triangle. */
+    class PacketTriangleCallback : public btTriangleCallback
+    {
+    public:
+        PacketRay **m_rays;
+        unsigned int m_count;
+        // --------------------------------------------------------------------
+        virtual void processTriangle(btVector3 *triangle, int part, int index)
+        {
+            btVector3 tri_min = triangle[0], tri_max = triangle[0];
+            tri_min.setMin(triangle[1]);
+            tri_min.setMin(triangle[2]);
+            tri_max.setMax(triangle[1]);
+            tri_max.setMax(triangle[2]);
+            for (unsigned int i = 0; i < m_count; i++)
+            {
+                PacketRay *ray = m_rays[i];
+                if (TestAabbAgainstAabb2(tri_min, tri_max, ray->m_aabb_min,
+                                         ray->m_aabb_max))
+                    ray->processTriangle(triangle, part, index);
+            }
+        }   // processTriangle
+    };   // PacketTriangleCallback
+
+    // ------------------------------------------------------------------------
+    /** Returns the second biggest extent of a bounding box. */
+    float getMiddleExtent(const btVector3 &aabb_min, const btVector3 &aabb_max)
+    {
+        btVector3 e = aabb_max - aabb_min;
+        float a = e.getX(), b = e.getY(), c = e.getZ();
+        return std::max(std::min(a, b), std::min(std::max(a, b), c));
+    }   // getMiddleExtent
+}   // anonymous namespace
+
 // -----------------------------------------------------------------------------
 /** Constructor: Initialises all data structures with zero.
  */
@@ -408,3 +491,126 @@ bool TriangleMesh::castRay(const btVector3 &from, const btVector3 &to,
     return ray_callback.hasHit();
 
 }   // castRay
+
+// ----------------------------------------------------------------------------
+/** Casts a batch of rays against this mesh. Consecutive rays that are close
+ *  to each other are grouped into packets, and each packet is tested with a
+ *  single traversal of the BVH instead of one traversal per ray. If there
+ *  are enough packets, they are distributed over the \ref ThreadPool. The
+ *  result for each ray is the same as the one from castRay().
+ *  \param count Number of rays.
+ *  \param from, to Start and end points of each ray.
+ *  \param hits On return the result for each ray.
+ *  \param interpolate_normal If true, the returned normals are interpolated
+ *         based on the three normals of the triangle hit.
+ */
+void TriangleMesh::castRays(unsigned int count, const btVector3 *from,
+                            const btVector3 *to, RayHit *hits,
+                            bool interpolate_normal) const
+{
+    for (unsigned int i = 0; i < count; i++)
+    {
+        hits[i].m_material       = NULL;
+        hits[i].m_triangle_index = -1;
+        hits[i].m_fraction       = 1.0f;
+        hits[i].m_hit_point      = to[i];
+        hits[i].m_normal.setValue(0, 1, 0);
+    }
+    if (count == 0 || !m_collision_shape ||
+        m_collision_shape->getShapeType() != TRIANGLE_MESH_SHAPE_PROXYTYPE)
+        return;
+
+    btBvhTriangleMeshShape *shape =
+        static_cast<btBvhTriangleMeshShape*>(m_collision_shape);
+
+    btTransform world_trans;
+    // If there is a body, take the current transform from the body.
+    if (m_body)
+        world_trans = m_body->getWorldTransform();
+    else
+        world_trans.setIdentity();
+    const btTransform to_local = world_trans.inverse();
+
+    btAlignedObjectArray<PacketRay> rays;
+    rays.reserve(count);
+    for (unsigned int i = 0; i < count; i++)
+        rays.push_back(PacketRay(to_local(from[i]), to_local(to[i])));
+
+    // Group consecutive rays into packets, packets[n] is the index of the
+    // first ray of packet n (the last entry is the total number of rays)
+    std::vector<unsigned int> packets;
+    btVector3 aabb_min, aabb_max;
+    for (unsigned int i = 0; i < count; i++)
+    {
+        if (!packets.empty())
+        {
+            btVector3 new_min = aabb_min, new_max = aabb_max;
+            new_min.setMin(rays[i].m_aabb_min);
+            new_max.setMax(rays[i].m_aabb_max);
+            if (getMiddleExtent(new_min, new_max) <= MAX_PACKET_SIZE)
+            {
+                aabb_min = new_min;
+                aabb_max = new_max;
+                continue;
+            }
+        }
+        packets.push_back(i);
+        aabb_min = rays[i].m_aabb_min;
+        aabb_max = rays[i].m_aabb_max;
+    }
+    packets.push_back(count);
+
+    auto cast_packet = [&rays, &packets, shape](unsigned int n)
+    {
+        unsigned int first = packets[n];
+        unsigned int last  = packets[n + 1];
+        if (last - first == 1)
+        {
+            // A single ray is faster with bullet's ray traversal
+            PacketRay &ray = rays[first];
+            shape->performRaycast(&ray, ray.m_from, ray.m_to);
+            return;
+        }
+        std::vector<PacketRay*> packet_rays;
+        btVector3 packet_min = rays[first].m_aabb_min;
+        btVector3 packet_max = rays[first].m_aabb_max;
+        for (unsigned int i = first; i < last; i++)
+        {
+            packet_rays.push_back(&rays[i]);
+            packet_min.setMin(rays[i].m_aabb_min);
+            packet_max.setMax(rays[i].m_aabb_max);
+        }
+        PacketTriangleCallback callback;
+        callback.m_rays  = packet_rays.data();
+        callback.m_count = last - first;
+        shape->processAllTriangles(&callback, packet_min, packet_max);
+    };
+
+    unsigned int num_packets = (unsigned int)packets.size() - 1;
+    ThreadPool *pool = ThreadPool::get();
+    if (pool && num_packets >= MIN_PARALLEL_PACKETS)
+        pool->parallelFor(num_packets, cast_packet);
+    else
+    {
+        for (unsigned int n = 0; n < num_packets; n++)
+            cast_packet(n);
+    }
+
+    for (unsigned int i = 0; i < count; i++)
+    {
+        const PacketRay &ray = rays[i];
+        if (ray.m_index < 0)
+            continue;
+        RayHit &hit = hits[i];
+        hit.m_triangle_index = ray.m_index;
+        hit.m_fraction       = ray.m_hitFraction;
+        hit.m_material       = m_triangleIndex2Material[ray.m_index];
+        hit.m_hit_point.setInterpolate3(from[i], to[i], ray.m_hitFraction);
+        hit.m_hit_point.setW(0.0f);
+        if (interpolate_normal)
+            hit.m_normal = getInterpolatedNormal(ray.m_index, hit.m_hit_point);
+        else
+            hit.m_normal = world_trans.getBasis() * ray.m_normal;
+        hit.m_normal.normalize();
+    }
+}   // castRays
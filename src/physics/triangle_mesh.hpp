@@ -58,6 +58,23 @@ private:
     bool m_can_be_transformed;
 
 public:
+    /** The result of one ray of a batched raycast, see castRays(). */
+    struct RayHit
+    {
+        /** The position in world where the ray hit. */
+        btVector3       m_hit_point;
+        /** The normal at the hit point (set to (0,1,0) if nothing was hit). */
+        btVector3       m_normal;
+        /** The material of the triangle hit, or NULL. */
+        const Material *m_material;
+        /** Index of the triangle hit, -1 if nothing was hit. */
+        int             m_triangle_index;
+        /** Fraction of the ray (between 0 and 1) at which the hit happened. */
+        float           m_fraction;
+        // --------------------------------------------------------------------
+        bool hasHit() const { return m_triangle_index >= 0; }
+    };   // RayHit
+
     class RigidBodyTriangleMesh : public btRigidBody
     {
     public:
@@ -113,6 +130,10 @@ public:
                  btVector3 *xyz, const Material **material,
                  btVector3 *normal=NULL, bool interpolate_normal=false) const;
     // ------------------------------------------------------------------------
+    void castRays(unsigned int count, const btVector3 *from,
+                  const btVector3 *to, RayHit *hits,
+                  bool interpolate_normal=false) const;
+    // ------------------------------------------------------------------------
     /** Returns the points of the 'indx' triangle.
      *  \param indx Index of the triangle to get.
      *  \param p1,p2,p3 On return the three points of the triangle. */
@@ -150,7 +150,8 @@ void HighscoreManager::saveHighscores()
 
     try
     {
-        UTFWriter highscore_file(m_filename.c_str(), false);
+        UTFWriter highscore_file(m_filename.c_str(), false,
+                                 /*background*/true);
         highscore_file << "<?xml version=\"1.0\"?>\n";
         highscore_file << "<highscores version=\"" << CURRENT_HSCORE_FILE_VERSION << "\">\n";
 
@@ -20,6 +20,8 @@
 
 #include <stdio.h>
 
+#include "config/user_config.hpp"
+#include "io/binary_file.hpp"
 #include "io/file_manager.hpp"
 #include "modes/world.hpp"
 #include "karts/abstract_kart.hpp"
@@ -32,6 +34,12 @@
 #include "utils/constants.hpp"
 #include "utils/file_utils.hpp"
 
+namespace
+{
+    const char    MAGIC[4]       = { 'S', 'T', 'K', 'H' };
+    const uint8_t BINARY_VERSION = 1;
+}   // anonymous namespace
+
 History* history = 0;
 bool History::m_online_history_replay = false;
 //-----------------------------------------------------------------------------
@@ -39,15 +47,29 @@ bool History::m_online_history_replay = false;
  */
 History::History()
 {
-    m_replay_history = false;
+    m_replay_history    = false;
+    m_event_index       = 0;
+    m_num_players       = 0;
+    m_difficulty        = 0;
+    m_reverse           = false;
+    m_binary_file       = NULL;
+    m_last_binary_ticks = 0;
 }   // History
 
+//-----------------------------------------------------------------------------
+History::~History()
+{
+    closeBinaryFile();
+}   // ~History
+
 //-----------------------------------------------------------------------------
 /** Initialise the history for a new recording. It especially allocates memory
  *  to store the history.
  */
 void History::initRecording()
 {
+    // A new binary file is created with the first event of the race
+    closeBinaryFile();
     allocateMemory();
     m_event_index = 0;
     m_all_input_events.clear();
@@ -84,6 +106,12 @@ void History::addEvent(int kart_id, PlayerAction pa, int value)
     ie.m_action      = pa;
     ie.m_value       = value;
     ie.m_kart_index  = kart_id;
+    if (UserConfigParams::m_binary_history &&
+        (m_binary_file || openBinaryFile()))
+    {
+        writeBinaryEvent(m_binary_file, ie);
+        return;
+    }
     m_all_input_events.emplace_back(ie);
 }   // addEvent
 
@@ -127,48 +155,151 @@ void History::updateReplay(int world_ticks)
 }   // updateReplay
 
 //-----------------------------------------------------------------------------
-/** Saves the history stored in the internal data structures into a file called
- *  history.dat.
+/** Takes the race information stored in the history from the current world.
  */
-void History::Save()
+void History::setRaceInfoFromWorld()
 {
-    World *world   = World::getWorld();
+    World *world  = World::getWorld();
+    m_stk_version = STK_VERSION;
+    m_num_players = RaceManager::get()->getNumPlayers();
+    m_difficulty  = RaceManager::get()->getDifficulty();
+    m_reverse     = RaceManager::get()->getReverseTrack();
+    m_track_ident = Track::getCurrentTrack()->getIdent();
+    m_kart_ident.clear();
+    for (unsigned int k = 0; k < world->getNumKarts(); k++)
+        m_kart_ident.push_back(world->getKart(k)->getIdent());
+}   // setRaceInfoFromWorld
+
+//-----------------------------------------------------------------------------
+/** Creates the binary file the events of the current race are written to,
+ *  history.dat in the current directory or in the config directory.
+ *  \return False if the file can not be created, in which case the events
+ *          are kept in memory and saved as text.
+ */
+bool History::openBinaryFile()
+{
+    World *world = World::getWorld();
     if (!world)
-        return;
-    FILE *fd = fopen("history.dat","w");
-    if(fd)
-        Log::info("History", "Saved in ./history.dat.");
-    else
+        return false;
+
+    const int compression = UserConfigParams::m_recording_compression;
+    m_binary_filename = "history.dat";
+    m_binary_file = BinaryFile::create(m_binary_filename, MAGIC,
+                                       BINARY_VERSION, compression);
+    if (!m_binary_file)
     {
-        std::string fn = file_manager->getUserConfigFile("history.dat");
-        fd = FileUtils::fopenU8Path(fn, "w");
-        if(fd)
-            Log::info("History", "Saved in '%s'.", fn.c_str());
+        m_binary_filename = file_manager->getUserConfigFile("history.dat");
+        m_binary_file = BinaryFile::create(m_binary_filename, MAGIC,
+                                           BINARY_VERSION, compression);
     }
-    if(!fd)
+    if (!m_binary_file)
     {
-        Log::info("History", "Can't open history.dat file for writing - can't save history.");
-        Log::info("History", "Make sure history.dat in the current directory "
-                             "or the config directory is writable.");
-        return;
+        Log::warn("History", "Can't create history.dat, the history will be "
+                             "saved as text.");
+        return false;
     }
+    Log::info("History", "Writing history to '%s'.",
+              m_binary_filename.c_str());
+    setRaceInfoFromWorld();
+    writeBinaryHeader(m_binary_file);
+    return true;
+}   // openBinaryFile
 
-    const int num_karts = world->getNumKarts();
-    fprintf(fd, "STK-version:      %s\n",   STK_VERSION);
-    fprintf(fd, "History-version:  %d\n",   1);
-    fprintf(fd, "numkarts:         %d\n",   num_karts);
-    fprintf(fd, "numplayers:       %d\n", RaceManager::get()->getNumPlayers());
-    fprintf(fd, "difficulty:       %d\n", RaceManager::get()->getDifficulty());
-    fprintf(fd, "reverse: %c\n", RaceManager::get()->getReverseTrack() ? 'y' : 'n');
+//-----------------------------------------------------------------------------
+void History::closeBinaryFile()
+{
+    delete m_binary_file;
+    m_binary_file = NULL;
+}   // closeBinaryFile
+
+//-----------------------------------------------------------------------------
+/** Writes the race information after the magic number and version.
+ */
+void History::writeBinaryHeader(BinaryFile *file)
+{
+    file->writeString(m_stk_version);
+    file->writeVarUInt(m_kart_ident.size());
+    file->writeVarUInt(m_num_players);
+    file->writeVarUInt(m_difficulty);
+    file->writeUInt8(m_reverse ? 1 : 0);
+    file->writeString(m_track_ident);
+    for (const std::string &ident : m_kart_ident)
+        file->writeString(ident);
+    m_last_binary_ticks = 0;
+}   // writeBinaryHeader
+
+//-----------------------------------------------------------------------------
+/** Writes an event: the time difference to the previous event, the kart,
+ *  the action and the value.
+ */
+void History::writeBinaryEvent(BinaryFile *file, const InputEvent &ie)
+{
+    file->writeVarInt(ie.m_world_ticks - m_last_binary_ticks);
+    m_last_binary_ticks = ie.m_world_ticks;
+    file->writeVarUInt(ie.m_kart_index);
+    file->writeUInt8((uint8_t)ie.m_action);
+    file->writeVarInt(ie.m_value);
+}   // writeBinaryEvent
+
+//-----------------------------------------------------------------------------
+/** Reads a binary history after the magic number and version.
+ *  \return False if the file is corrupted.
+ */
+bool History::readBinary(BinaryFile *file)
+{
+    m_stk_version = file->readString();
+    uint64_t num_karts = file->readVarUInt();
+    m_num_players  = (unsigned int)file->readVarUInt();
+    m_difficulty   = (int)file->readVarUInt();
+    m_reverse      = file->readUInt8() != 0;
+    m_track_ident  = file->readString();
+    // Avoid allocating huge amounts of memory for corrupted files
+    if (file->hasFailed() || num_karts > 1000)
+        return false;
+    m_kart_ident.clear();
+    for (uint64_t i = 0; i < num_karts; i++)
+        m_kart_ident.push_back(file->readString());
+
+    allocateMemory();
+    int ticks = 0;
+    while (!file->hasFailed() && !file->isEnd())
+    {
+        InputEvent ie;
+        ticks           += (int)file->readVarInt();
+        ie.m_world_ticks = ticks;
+        ie.m_kart_index  = (int)file->readVarUInt();
+        ie.m_action      = (PlayerAction)file->readUInt8();
+        ie.m_value       = (int)file->readVarInt();
+        if (!file->hasFailed())
+            m_all_input_events.push_back(ie);
+    }
+    if (file->hasFailed())
+    {
+        // The events before the corruption (e.g. if STK crashed while
+        // writing the file) can still be used
+        Log::warn("History", "History file is truncated after %u events.",
+                  (unsigned)m_all_input_events.size());
+    }
+    return true;
+}   // readBinary
 
-    fprintf(fd, "track: %s\n", Track::getCurrentTrack()->getIdent().c_str());
+//-----------------------------------------------------------------------------
+/** Writes the history stored in the internal data structures in text format.
+ */
+void History::writeText(FILE *fd)
+{
+    fprintf(fd, "STK-version:      %s\n",   m_stk_version.c_str());
+    fprintf(fd, "History-version:  %d\n",   1);
+    fprintf(fd, "numkarts:         %d\n",   (int)m_kart_ident.size());
+    fprintf(fd, "numplayers:       %d\n",   m_num_players);
+    fprintf(fd, "difficulty:       %d\n",   m_difficulty);
+    fprintf(fd, "reverse: %c\n", m_reverse ? 'y' : 'n');
 
-    assert(num_karts > 0);
+    fprintf(fd, "track: %s\n", m_track_ident.c_str());
 
-    int k;
-    for(k=0; k<num_karts; k++)
+    for(unsigned int k=0; k<m_kart_ident.size(); k++)
     {
-        fprintf(fd, "model %d: %s\n",k, world->getKart(k)->getIdent().c_str());
+        fprintf(fd, "model %d: %s\n",k, m_kart_ident[k].c_str());
     }
     fprintf(fd, "count:     %zu\n", m_all_input_events.size());
 
@@ -182,29 +313,56 @@ void History::Save()
     }   // for i
 
     fprintf(fd, "History file end.\n");
-    fclose(fd);
-}   // Save
+}   // writeText
 
 //-----------------------------------------------------------------------------
-/** Loads a history from history.dat in the current directory.
+/** Saves the history stored in the internal data structures into a file called
+ *  history.dat. If the history is written in binary format while racing,
+ *  only the data written so far is flushed to the file.
  */
-void History::Load()
+void History::Save()
 {
-    char s[1024], s1[1024];
-    int  n;
-
-    FILE *fd = fopen("history.dat","r");
+    World *world   = World::getWorld();
+    if (!world)
+        return;
+    if (m_binary_file)
+    {
+        m_binary_file->flush();
+        Log::info("History", "Saved in '%s'.", m_binary_filename.c_str());
+        return;
+    }
+    FILE *fd = fopen("history.dat","w");
     if(fd)
-        Log::info("History", "Reading ./history.dat");
+        Log::info("History", "Saved in ./history.dat.");
     else
     {
         std::string fn = file_manager->getUserConfigFile("history.dat");
-        fd = FileUtils::fopenU8Path(fn, "r");
+        fd = FileUtils::fopenU8Path(fn, "w");
         if(fd)
-            Log::info("History", "Reading '%s'.", fn.c_str());
+            Log::info("History", "Saved in '%s'.", fn.c_str());
     }
     if(!fd)
-        Log::fatal("History", "Could not open history.dat");
+    {
+        Log::info("History", "Can't open history.dat file for writing - can't save history.");
+        Log::info("History", "Make sure history.dat in the current directory "
+                             "or the config directory is writable.");
+        return;
+    }
+
+    assert(world->getNumKarts() > 0);
+    setRaceInfoFromWorld();
+    writeText(fd);
+    fclose(fd);
+}   // Save
+
+//-----------------------------------------------------------------------------
+/** Reads a history in text format.
+ *  \return False if the file is not a history file.
+ */
+bool History::readText(FILE *fd)
+{
+    char s[1024], s1[1024];
+    int  n;
 
     if (fgets(s, 1023, fd) == NULL)
         Log::fatal("History", "Could not read history.dat.");
@@ -220,9 +378,7 @@ void History::Load()
     if (sscanf(s,"STK-version: %1023s",s1)!=1)
         Log::fatal("History", "No Version information found in history "
                               "file (bogus history file).");
-    if (strcmp(s1,STK_VERSION))
-        Log::warn("History", "History is version '%s', STK version is '%s'.",
-                  s1, STK_VERSION);
+    m_stk_version = s1;
 
     if (fgets(s, 1023, fd) == NULL)
         Log::fatal("History", "Could not read history.dat.");
@@ -241,45 +397,36 @@ void History::Load()
     unsigned int num_karts;
     if(sscanf(s, "numkarts: %u", &num_karts)!=1)
         Log::fatal("History", "No number of karts found in history file.");
-    RaceManager::get()->setNumKarts(num_karts);
 
     fgets(s, 1023, fd);
     if(sscanf(s, "numplayers: %d",&n)!=1)
         Log::fatal("History", "No number of players found in history file.");
-    RaceManager::get()->setNumPlayers(n);
+    m_num_players = n;
 
     fgets(s, 1023, fd);
     if(sscanf(s, "difficulty: %d",&n)!=1)
         Log::fatal("History", "No difficulty found in history file.");
-    RaceManager::get()->setDifficulty((RaceManager::Difficulty)n);
-
+    m_difficulty = n;
 
     fgets(s, 1023, fd);
     char r;
     if (sscanf(s, "reverse: %c", &r) != 1)
         Log::fatal("History", "Could not read reverse information: '%s'", s);
-    RaceManager::get()->setReverseTrack(r == 'y');
+    m_reverse = r == 'y';
 
     fgets(s, 1023, fd);
     if(sscanf(s, "track: %1023s",s1)!=1)
         Log::warn("History", "Track not found in history file.");
-    RaceManager::get()->setTrack(s1);
-    // This value doesn't really matter, but should be defined, otherwise
-    // the racing phase can switch to 'ending'
-    RaceManager::get()->setNumLaps(100);
+    m_track_ident = s1;
 
+    m_kart_ident.clear();
     for(unsigned int i=0; i<num_karts; i++)
     {
         fgets(s, 1023, fd);
         if(sscanf(s, "model %d: %1023s",&n, s1) != 2)
             Log::fatal("History", "No model information for kart %d found.", i);
         m_kart_ident.push_back(s1);
-        if(i<RaceManager::get()->getNumPlayers() && !m_online_history_replay)
-        {
-            RaceManager::get()->setPlayerKart(i, s1);
-        }
     }   // for i<nKarts
-    // FIXME: The model information is currently ignored
 
     fgets(s, 1023, fd);
     int count;
@@ -287,12 +434,6 @@ void History::Load()
         Log::fatal("History", "Number of records not found in history file.");
 
     allocateMemory(count);
-    m_event_index = 0;
-
-    // We need to disable the rewind manager here (otherwise setting the
-    // KartControl data would access the rewind manager).
-    bool rewind_manager_was_enabled = RewindManager::isEnabled();
-    RewindManager::setEnable(false);
 
     for (int i=0; i<count; i++)
     {
@@ -306,8 +447,128 @@ void History::Load()
         }
         ie.m_action = (PlayerAction)action;
     }   // for i
-    RewindManager::setEnable(rewind_manager_was_enabled);
+    return true;
+}   // readText
 
+//-----------------------------------------------------------------------------
+/** Reads a history file in binary or text format.
+ *  \param filename Name of the file.
+ *  \param binary On return true if the file is in binary format.
+ *  \return False if the file can not be read.
+ */
+bool History::readFile(const std::string &filename, bool *binary)
+{
+    uint8_t version;
+    BinaryFile *file = BinaryFile::open(filename, MAGIC, &version);
+    if (file)
+    {
+        *binary = true;
+        bool ok = version == BINARY_VERSION && readBinary(file);
+        if (version != BINARY_VERSION)
+        {
+            Log::error("History", "History file version %d is not "
+                       "supported.", version);
+        }
+        delete file;
+        return ok;
+    }
+
+    *binary = false;
+    FILE *fd = FileUtils::fopenU8Path(filename, "r");
+    if (!fd)
+        return false;
+    bool ok = readText(fd);
     fclose(fd);
+    return ok;
+}   // readFile
+
+//-----------------------------------------------------------------------------
+/** Loads a history from history.dat in the current directory.
+ */
+void History::Load()
+{
+    std::string filename = "history.dat";
+    FILE *fd = fopen(filename.c_str(), "r");
+    if (fd)
+        fclose(fd);
+    else
+        filename = file_manager->getUserConfigFile("history.dat");
+    Log::info("History", "Reading '%s'.", filename.c_str());
+
+    // We need to disable the rewind manager here (otherwise setting the
+    // KartControl data would access the rewind manager).
+    bool rewind_manager_was_enabled = RewindManager::isEnabled();
+    RewindManager::setEnable(false);
+
+    bool binary;
+    if (!readFile(filename, &binary))
+        Log::fatal("History", "Could not read history.dat");
+    m_event_index = 0;
+
+    RewindManager::setEnable(rewind_manager_was_enabled);
+
+    if (m_stk_version != STK_VERSION)
+        Log::warn("History", "History is version '%s', STK version is '%s'.",
+                  m_stk_version.c_str(), STK_VERSION);
+
+    RaceManager::get()->setNumKarts((unsigned int)m_kart_ident.size());
+    RaceManager::get()->setNumPlayers(m_num_players);
+    RaceManager::get()->setDifficulty((RaceManager::Difficulty)m_difficulty);
+    RaceManager::get()->setReverseTrack(m_reverse);
+    RaceManager::get()->setTrack(m_track_ident);
+    // This value doesn't really matter, but should be defined, otherwise
+    // the racing phase can switch to 'ending'
+    RaceManager::get()->setNumLaps(100);
+
+    for(unsigned int i=0; i<m_kart_ident.size(); i++)
+    {
+        if(i<RaceManager::get()->getNumPlayers() && !m_online_history_replay)
+        {
+            RaceManager::get()->setPlayerKart(i, m_kart_ident[i]);
+        }
+    }   // for i<nKarts
+    // FIXME: The model information is currently ignored
 }   // Load
 
+//-----------------------------------------------------------------------------
+/** Converts a history file from binary to text format or the other way
+ *  round (see --convert-history).
+ *  \param in Name of the history file to convert.
+ *  \param out Name of the converted file.
+ *  \return False if an error occurred.
+ */
+bool History::convertFile(const std::string &in, const std::string &out)
+{
+    bool binary;
+    if (!readFile(in, &binary))
+    {
+        Log::error("History", "Can't read history file '%s'.", in.c_str());
+        return false;
+    }
+    if (binary)
+    {
+        FILE *fd = FileUtils::fopenU8Path(out, "w");
+        if (!fd)
+        {
+            Log::error("History", "Can't create '%s'.", out.c_str());
+            return false;
+        }
+        writeText(fd);
+        fclose(fd);
+    }
+    else
+    {
+        BinaryFile *file = BinaryFile::create(out, MAGIC, BINARY_VERSION,
+                                UserConfigParams::m_recording_compression);
+        if (!file)
+            return false;
+        writeBinaryHeader(file);
+        for (const InputEvent &ie : m_all_input_events)
+            writeBinaryEvent(file, ie);
+        delete file;
+    }
+    Log::info("History", "Converted %u events from '%s' (%s) to '%s'.",
+              (unsigned)m_all_input_events.size(), in.c_str(),
+              binary ? "binary" : "text", out.c_str());
+    return true;
+}   // convertFile
@@ -23,12 +23,19 @@
 #include "input/input.hpp"
 #include "karts/controller/kart_control.hpp"
 
+#include <stdio.h>
 #include <string>
 #include <vector>
 
+class BinaryFile;
 class Kart;
 
-/**
+/** Records the input events of the local players, so that a race can be
+ *  replayed for debugging (see --history). The history is either saved as
+ *  text at the end of a race, or (if UserConfigParams::m_binary_history is
+ *  set) written in binary format to the file while racing. Both formats
+ *  are read by Load(), and can be converted into each other with
+ *  convertFile().
   * \ingroup race
   */
 class History
@@ -43,6 +50,23 @@ private:
     /** The identities of the karts to use. */
     std::vector<std::string> m_kart_ident;
 
+    /** Race settings stored in the history. */
+    std::string  m_stk_version;
+    unsigned int m_num_players;
+    int          m_difficulty;
+    bool         m_reverse;
+    std::string  m_track_ident;
+
+    /** The binary file the events are written to while racing, or NULL. */
+    BinaryFile  *m_binary_file;
+
+    /** Name of m_binary_file. */
+    std::string  m_binary_filename;
+
+    /** Time of the last event written to m_binary_file, since only the
+     *  difference to the previous event is stored. */
+    int          m_last_binary_ticks;
+
     // ------------------------------------------------------------------------
     struct InputEvent
     {
@@ -61,14 +85,25 @@ private:
     std::vector<InputEvent> m_all_input_events;
 
     void  allocateMemory(int size=-1);
+    void  setRaceInfoFromWorld();
+    bool  openBinaryFile();
+    void  closeBinaryFile();
+    void  writeBinaryHeader(BinaryFile *file);
+    void  writeBinaryEvent(BinaryFile *file, const InputEvent &ie);
+    bool  readBinary(BinaryFile *file);
+    void  writeText(FILE *fd);
+    bool  readText(FILE *fd);
+    bool  readFile(const std::string &filename, bool *binary);
 public:
     static bool m_online_history_replay;
           History        ();
+         ~History        ();
     void  initRecording  ();
     void  Save           ();
     void  Load           ();
     void  updateReplay(int world_ticks);
     void  addEvent(int kart_id, PlayerAction pa, int value);
+    bool  convertFile(const std::string &in, const std::string &out);
 
     // -------------------I-----------------------------------------------------
     /** Returns the identifier of the n-th kart. */
@@ -605,6 +605,16 @@ void RaceManager::startNextRace()
         }
     }
 
+    // Unload the models of karts which were not used for a while. Only
+    // done in the main process, the child process shares the karts.
+    if (type == PT_MAIN)
+    {
+        std::vector<std::string> idents;
+        for (const KartStatus &ks : m_kart_status)
+            idents.push_back(ks.m_ident);
+        kart_properties_manager->useKarts(idents);
+    }
+
     main_loop->renderGUI(100);
 
     // the constructor assigns this object to the global
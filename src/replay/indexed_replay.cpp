@@ -0,0 +1,418 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2024 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+
+#include "replay/indexed_replay.hpp"
+
+#include "io/binary_file.hpp"
+#include "io/file_manager.hpp"
+#include "utils/file_utils.hpp"
+#include "utils/log.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+#ifndef WIN32
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+namespace
+{
+    /** Reads values written by BinaryFile from memory. */
+    class MemoryReader
+    {
+    private:
+        const uint8_t *m_pos;
+        const uint8_t *m_end;
+        bool           m_failed;
+    public:
+        MemoryReader(const uint8_t *start, const uint8_t *end)
+            : m_pos(start), m_end(end), m_failed(false) {}
+        // --------------------------------------------------------------------
+        uint64_t readVarUInt()
+        {
+            uint64_t value = 0;
+            for (unsigned int shift = 0; shift < 64; shift += 7)
+            {
+                if (m_pos >= m_end)
+                    break;
+                uint8_t c = *m_pos++;
+                value |= (uint64_t)(c & 0x7f) << shift;
+                if ((c & 0x80) == 0)
+                    return value;
+            }
+            m_failed = true;
+            return 0;
+        }   // readVarUInt
+        // --------------------------------------------------------------------
+        int64_t readVarInt()
+        {
+            uint64_t value = readVarUInt();
+            return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+        }   // readVarInt
+        // --------------------------------------------------------------------
+        uint32_t readUInt32()
+        {
+            if (m_end - m_pos < 4)
+            {
+                m_failed = true;
+                return 0;
+            }
+            uint32_t value = m_pos[0] | (m_pos[1] << 8) | (m_pos[2] << 16) |
+                             ((uint32_t)m_pos[3] << 24);
+            m_pos += 4;
+            return value;
+        }   // readUInt32
+        // --------------------------------------------------------------------
+        float readFloat()
+        {
+            uint32_t u = readUInt32();
+            float value;
+            memcpy(&value, &u, sizeof(float));
+            return value;
+        }   // readFloat
+        // --------------------------------------------------------------------
+        bool hasFailed() const { return m_failed; }
+    };   // MemoryReader
+}   // anonymous namespace
+
+// ----------------------------------------------------------------------------
+/** Writes a replay in the indexed format.
+ *  \param filename Name of the file.
+ *  \param rd The header of the replay.
+ *  \param frames The frames of each kart, sorted by time.
+ *  \return False if the file can not be created.
+ */
+bool IndexedReplay::write(const std::string &filename,
+                          const ReplayPlay::ReplayData &rd,
+                          const std::vector<std::vector<ReplayFrame> > &frames)
+{
+    BinaryFile *file = BinaryFile::create(filename, getBinaryReplayMagic(),
+                                          BRV_INDEXED, /*compression*/0);
+    if (!file)
+        return false;
+    rd.writeBinary(file);
+
+    std::vector<std::vector<Chunk> > chunks(frames.size());
+    for (unsigned int k = 0; k < frames.size(); k++)
+    {
+        BinaryFrameValues previous;
+        for (unsigned int i = 0; i < frames[k].size(); i++)
+        {
+            if (i % FRAMES_PER_CHUNK == 0)
+            {
+                // The first frame of a chunk is relative to 0
+                previous = BinaryFrameValues();
+                Chunk chunk;
+                chunk.m_start_time = frames[k][i].m_transform.m_time;
+                chunk.m_offset     = (uint32_t)file->tell();
+                chunk.m_num_frames = 0;
+                chunks[k].push_back(chunk);
+            }
+            writeBinaryFrame(file, frames[k][i], &previous);
+            chunks[k].back().m_num_frames++;
+        }
+    }
+
+    uint64_t index_offset = file->tell();
+    assert(index_offset < UINT32_MAX);
+    file->writeVarUInt(chunks.size());
+    for (const std::vector<Chunk> &kart_chunks : chunks)
+    {
+        file->writeVarUInt(kart_chunks.size());
+        for (const Chunk &chunk : kart_chunks)
+        {
+            file->writeFloat(chunk.m_start_time);
+            file->writeVarUInt(chunk.m_offset);
+            file->writeVarUInt(chunk.m_num_frames);
+        }
+    }
+    file->writeUInt32((uint32_t)index_offset);
+    delete file;
+    return true;
+}   // write
+
+// ----------------------------------------------------------------------------
+IndexedReplay::IndexedReplay()
+{
+    m_data         = NULL;
+    m_size         = 0;
+    m_index_offset = 0;
+}   // IndexedReplay
+
+// ----------------------------------------------------------------------------
+IndexedReplay::~IndexedReplay()
+{
+    close();
+}   // ~IndexedReplay
+
+// ----------------------------------------------------------------------------
+/** Maps a replay file into memory and reads its index.
+ *  \param filename Full path of the file.
+ *  \return False if the file can not be read or is not an indexed replay.
+ */
+bool IndexedReplay::open(const std::string &filename)
+{
+    close();
+    m_filename = filename;
+#ifdef WIN32
+    FILE *fd = FileUtils::fopenU8Path(filename, "rb");
+    if (!fd)
+        return false;
+    fseek(fd, 0, SEEK_END);
+    long size = ftell(fd);
+    fseek(fd, 0, SEEK_SET);
+    m_buffer.resize(size > 0 ? size : 0);
+    if (size <= 0 || fread(m_buffer.data(), 1, size, fd) != (size_t)size)
+    {
+        fclose(fd);
+        close();
+        return false;
+    }
+    fclose(fd);
+    m_data = m_buffer.data();
+    m_size = m_buffer.size();
+#else
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0)
+    {
+        ::close(fd);
+        return false;
+    }
+    void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping stays valid after closing the file
+    ::close(fd);
+    if (data == MAP_FAILED)
+        return false;
+    m_data = (const uint8_t*)data;
+    m_size = st.st_size;
+#endif
+
+    if (!readIndex())
+    {
+        Log::warn("IndexedReplay", "'%s' is not a valid indexed replay.",
+                  filename.c_str());
+        close();
+        return false;
+    }
+    return true;
+}   // open
+
+// ----------------------------------------------------------------------------
+/** Unmaps the file. */
+void IndexedReplay::close()
+{
+#ifdef WIN32
+    m_buffer.clear();
+#else
+    if (m_data)
+        munmap((void*)m_data, m_size);
+#endif
+    m_data         = NULL;
+    m_size         = 0;
+    m_index_offset = 0;
+    m_chunks.clear();
+}   // close
+
+// ----------------------------------------------------------------------------
+/** Checks the file header and reads the index.
+ *  \return False if the file is invalid.
+ */
+bool IndexedReplay::readIndex()
+{
+    // Magic number, version and index offset
+    if (m_size < 9 || memcmp(m_data, getBinaryReplayMagic(), 4) != 0 ||
+        m_data[4] != BRV_INDEXED)
+        return false;
+
+    MemoryReader trailer(m_data + m_size - 4, m_data + m_size);
+    m_index_offset = trailer.readUInt32();
+    if (m_index_offset < 5 || m_index_offset > m_size - 4)
+        return false;
+
+    MemoryReader reader(m_data + m_index_offset, m_data + m_size - 4);
+    uint64_t num_karts = reader.readVarUInt();
+    // Avoid allocating huge amounts of memory for corrupted files
+    if (reader.hasFailed() || num_karts > 1000)
+        return false;
+    m_chunks.resize((size_t)num_karts);
+    for (std::vector<Chunk> &kart_chunks : m_chunks)
+    {
+        uint64_t num_chunks = reader.readVarUInt();
+        if (reader.hasFailed() || num_chunks > m_index_offset)
+            return false;
+        kart_chunks.resize((size_t)num_chunks);
+        for (Chunk &chunk : kart_chunks)
+        {
+            chunk.m_start_time = reader.readFloat();
+            uint64_t offset    = reader.readVarUInt();
+            uint64_t num       = reader.readVarUInt();
+            if (reader.hasFailed() || offset >= m_index_offset ||
+                num > FRAMES_PER_CHUNK)
+                return false;
+            chunk.m_offset     = (uint32_t)offset;
+            chunk.m_num_frames = (uint32_t)num;
+        }
+    }
+    return true;
+}   // readIndex
+
+// ----------------------------------------------------------------------------
+/** Decodes the frames of a kart needed to show the kart between two times,
+ *  i.e. all frames in the time window, plus the last frame before and the
+ *  first frame after it (if they exist). Only the chunks overlapping the
+ *  time window are decoded.
+ *  \param kart Index of the kart in the replay.
+ *  \param from Start of the time window.
+ *  \param to End of the time window.
+ *  \param frames On return the frames.
+ *  \return False if the file is corrupted.
+ */
+bool IndexedReplay::decodeFrames(unsigned int kart, float from, float to,
+                                 std::vector<ReplayFrame> *frames) const
+{
+    frames->clear();
+    if (kart >= m_chunks.size())
+        return false;
+
+    // Start with the last chunk starting at or before 'from'
+    const std::vector<Chunk> &chunks = m_chunks[kart];
+    std::vector<Chunk>::const_iterator chunk =
+        std::upper_bound(chunks.begin(), chunks.end(), from,
+                         [](float time, const Chunk &c)
+                         {
+                             return time < c.m_start_time;
+                         });
+    if (chunk != chunks.begin())
+        chunk--;
+
+    ReplayFrame frame;
+    for (; chunk != chunks.end(); chunk++)
+    {
+        MemoryReader reader(m_data + chunk->m_offset,
+                            m_data + m_index_offset);
+        BinaryFrameValues values = BinaryFrameValues();
+        for (unsigned int i = 0; i < chunk->m_num_frames; i++)
+        {
+            for (int j = 0; j < BinaryFrameValues::NUM_VALUES; j++)
+                values.m_values[j] += reader.readVarInt();
+            if (reader.hasFailed())
+                return false;
+            decodeBinaryFrame(values, &frame);
+            const float time = frame.m_transform.m_time;
+            // Only keep the last frame before the time window
+            if (time <= from && !frames->empty() &&
+                frames->back().m_transform.m_time <= from)
+                frames->back() = frame;
+            else
+                frames->push_back(frame);
+            if (time >= to)
+                return true;
+        }
+    }
+    return true;
+}   // decodeFrames
+
+// ----------------------------------------------------------------------------
+void IndexedReplay::unitTesting()
+{
+    ReplayPlay::ReplayData rd;
+    rd.m_stk_version = "test";
+    rd.m_kart_list   = { "tux", "nolok" };
+    rd.m_name_list   = { "a", "" };
+    rd.m_kart_color  = { 0.5f, 0.0f };
+    rd.m_reverse     = false;
+    rd.m_difficulty  = 2;
+    rd.m_minor_mode  = "time-trial";
+    rd.m_track_name  = "lighthouse";
+    rd.m_laps        = 3;
+    rd.m_min_time    = 9.95f;
+    rd.m_replay_uid  = 1234;
+
+    // 200 frames for the first kart, none for the second
+    std::vector<std::vector<ReplayFrame> > frames(2);
+    for (unsigned int i = 0; i < 200; i++)
+    {
+        ReplayFrame f = ReplayFrame();
+        f.m_transform.m_time = i * 0.05f;
+        f.m_transform.m_transform.setIdentity();
+        f.m_transform.m_transform.setOrigin(btVector3(i * 1.5f, 0.25f, -3.0f));
+        f.m_physic.m_speed = 10.0f;
+        f.m_bonus.m_item_amount = i % 3;
+        f.m_event.m_jumping = (i % 7) == 0;
+        frames[0].push_back(f);
+    }
+
+    const std::string filename =
+        file_manager->getCachedDataDir() + "indexed_replay_test.replay";
+    // All results are collected in ok, so that the calls are not only done
+    // in debug builds
+    bool ok = write(filename, rd, frames);
+    assert(ok);
+
+    IndexedReplay replay;
+    ok &= replay.open(filename);
+    assert(ok);
+    ok &= replay.getNumKarts() == 2;
+    assert(ok);
+    ok &= replay.getNumFrames(0) == 200 && replay.getNumFrames(1) == 0;
+    assert(ok);
+
+    // The window includes the frames at 3s and 4s, which are frames 60
+    // to 80, and it spans two chunks
+    std::vector<ReplayFrame> window;
+    ok &= replay.decodeFrames(0, 3.0f, 4.0f, &window);
+    assert(ok && window.size() == 21);
+    for (unsigned int i = 0; i < window.size(); i++)
+    {
+        const ReplayFrame &a = window[i];
+        const ReplayFrame &b = frames[0][60 + i];
+        ok &= std::fabs(a.m_transform.m_time - b.m_transform.m_time) < 1e-3f;
+        ok &= (a.m_transform.m_transform.getOrigin() -
+               b.m_transform.m_transform.getOrigin()).length() < 0.01f;
+        ok &= a.m_bonus.m_item_amount == b.m_bonus.m_item_amount;
+        ok &= a.m_event.m_jumping == b.m_event.m_jumping;
+        assert(ok);
+    }
+    ok &= replay.decodeAllFrames(0, &window);
+    assert(ok && window.size() == 200);
+    ok &= replay.decodeAllFrames(1, &window);
+    assert(ok && window.empty());
+
+    // The header can still be read like for any other binary replay
+    uint8_t version = 0;
+    BinaryFile *file = BinaryFile::open(filename, getBinaryReplayMagic(),
+                                        &version);
+    assert(file && version == BRV_INDEXED);
+    ReplayPlay::ReplayData header;
+    ok &= file && header.readBinary(file);
+    assert(ok && header.m_kart_list.size() == 2 &&
+           header.m_replay_uid == 1234);
+    delete file;
+
+    replay.close();
+    file_manager->removeFile(filename);
+}   // unitTesting
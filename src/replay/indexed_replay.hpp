@@ -0,0 +1,121 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2024 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+
+#ifndef HEADER_INDEXED_REPLAY_HPP
+#define HEADER_INDEXED_REPLAY_HPP
+
+#include "replay/replay_play.hpp"
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/** Random access to a binary replay file in the indexed format. The frames
+ *  of each kart are stored in chunks of FRAMES_PER_CHUNK frames, and the
+ *  values of the first frame of each chunk are not relative to the previous
+ *  frame, so decoding can start at any chunk. An index at the end of the
+ *  file contains the start time and offset of all chunks of each kart, and
+ *  the last 4 bytes of the file are the offset of the index.
+ *  The file is not compressed and is mapped into memory, so opening it only
+ *  reads the index, and the frames of any time window can be decoded
+ *  without reading the rest of the file. The header of the file is the same
+ *  as for other binary replays, so that it can be read with BinaryFile
+ *  (see ReplayPlay::readReplayFile).
+ * \ingroup replay
+ */
+class IndexedReplay : public ReplayBase
+{
+private:
+    /** Number of frames in a chunk. */
+    static const unsigned int FRAMES_PER_CHUNK = 64;
+
+    /** A chunk of frames of a kart. */
+    struct Chunk
+    {
+        /** Time of the first frame in the chunk. */
+        float    m_start_time;
+        /** Offset of the first frame in the file. */
+        uint32_t m_offset;
+        /** Number of frames in the chunk. */
+        uint32_t m_num_frames;
+    };   // Chunk
+
+    std::string m_filename;
+
+    /** The content of the file. */
+    const uint8_t *m_data;
+
+    /** Size of the file. */
+    size_t m_size;
+
+    /** Offset of the index, which is the end of the frame data. */
+    uint32_t m_index_offset;
+
+#ifdef WIN32
+    /** Windows has no mmap, so the file is read into memory. */
+    std::vector<uint8_t> m_buffer;
+#endif
+
+    /** The chunks of each kart. */
+    std::vector<std::vector<Chunk> > m_chunks;
+
+    bool readIndex();
+
+public:
+    // ------------------------------------------------------------------------
+    static bool write(const std::string &filename,
+                      const ReplayPlay::ReplayData &rd,
+                      const std::vector<std::vector<ReplayFrame> > &frames);
+    // ------------------------------------------------------------------------
+    static void unitTesting();
+    // ------------------------------------------------------------------------
+         IndexedReplay();
+        ~IndexedReplay();
+    bool open(const std::string &filename);
+    void close();
+    bool decodeFrames(unsigned int kart, float from, float to,
+                      std::vector<ReplayFrame> *frames) const;
+    // ------------------------------------------------------------------------
+    /** Returns the number of karts in the replay. */
+    unsigned int getNumKarts() const { return (unsigned int)m_chunks.size(); }
+    // ------------------------------------------------------------------------
+    /** Returns the number of frames of a kart. */
+    unsigned int getNumFrames(unsigned int kart) const
+    {
+        unsigned int n = 0;
+        for (const Chunk &c : m_chunks.at(kart))
+            n += c.m_num_frames;
+        return n;
+    }   // getNumFrames
+    // ------------------------------------------------------------------------
+    /** Decodes all frames of a kart. */
+    bool decodeAllFrames(unsigned int kart,
+                         std::vector<ReplayFrame> *frames) const
+    {
+        return decodeFrames(kart, -1.0f, 1.0e30f, frames);
+    }   // decodeAllFrames
+    // ------------------------------------------------------------------------
+    virtual const std::string& getReplayFilename(int replay_file_number = 1)
+                                                                         const
+    {
+        return m_filename;
+    }   // getReplayFilename
+};   // IndexedReplay
+
+#endif
@@ -17,9 +17,12 @@
 
 #include "replay/replay_base.hpp"
 
+#include "io/binary_file.hpp"
 #include "io/file_manager.hpp"
 #include "utils/file_utils.hpp"
 
+#include <cmath>
+
 // -----------------------------------------------------------------------------
 ReplayBase::ReplayBase()
 {
@@ -42,3 +45,216 @@ FILE* ReplayBase::openReplayFile(bool writeable, bool full_path, int replay_file
     return fd;
 
 }   // openReplayFile
+
+// -----------------------------------------------------------------------------
+/** Writes one frame of a kart as a line of a text replay file.
+ */
+void ReplayBase::writeTextFrame(FILE *fd, const ReplayFrame &frame)
+{
+    const TransformEvent  *p = &frame.m_transform;
+    const PhysicInfo      *q = &frame.m_physic;
+    const BonusInfo       *b = &frame.m_bonus;
+    const KartReplayEvent *r = &frame.m_event;
+    fprintf(fd, "%f  %f %f %f  %f %f %f %f  %f  %f  %f %f %f %f %d  %d %f %d %d %d  %f %d %d %d %d %d\n",
+            p->m_time,
+            p->m_transform.getOrigin().getX(),
+            p->m_transform.getOrigin().getY(),
+            p->m_transform.getOrigin().getZ(),
+            p->m_transform.getRotation().getX(),
+            p->m_transform.getRotation().getY(),
+            p->m_transform.getRotation().getZ(),
+            p->m_transform.getRotation().getW(),
+            q->m_speed,
+            q->m_steer,
+            q->m_suspension_length[0],
+            q->m_suspension_length[1],
+            q->m_suspension_length[2],
+            q->m_suspension_length[3],
+            q->m_skidding_state,
+            b->m_attachment,
+            b->m_nitro_amount,
+            b->m_item_amount,
+            b->m_item_type,
+            b->m_special_value,
+            r->m_distance,
+            r->m_nitro_usage,
+            (int)r->m_zipper_usage,
+            r->m_skidding_effect,
+            (int)r->m_red_skidding,
+            (int)r->m_jumping
+        );
+}   // writeTextFrame
+
+// -----------------------------------------------------------------------------
+/** Reads one frame of a kart from a line of a text replay file.
+ *  \param line The line to parse.
+ *  \param version Version of the replay file.
+ *  \param frame On return the frame read.
+ *  \return False if the line could not be parsed.
+ */
+bool ReplayBase::readTextFrame(const char *line, unsigned int version,
+                               ReplayFrame *frame)
+{
+    float x, y, z, rx, ry, rz, rw, time, speed, steer, w1, w2, w3, w4;
+    float nitro_amount = 0.0f, distance = 0.0f;
+    int skidding_state = 0, attachment = 0, item_amount = 0, item_type = 0,
+        special_value = 0, nitro, zipper, skidding, red_skidding, jumping;
+
+    // Up to STK 0.9.3 replays
+    if (version == 3)
+    {
+        if (sscanf(line, "%f  %f %f %f  %f %f %f %f  %f  %f  %f %f %f %f  %d %d %d %d %d\n",
+            &time,
+            &x, &y, &z,
+            &rx, &ry, &rz, &rw,
+            &speed, &steer, &w1, &w2, &w3, &w4,
+            &nitro, &zipper, &skidding, &red_skidding, &jumping
+            ) != 19)
+            return false;
+    }
+    // version 4 replays (STK 0.9.4 and higher)
+    else
+    {
+        if (sscanf(line, "%f  %f %f %f  %f %f %f %f  %f  %f  %f %f %f %f %d  %d %f %d %d %d  %f %d %d %d %d %d\n",
+            &time,
+            &x, &y, &z,
+            &rx, &ry, &rz, &rw,
+            &speed, &steer, &w1, &w2, &w3, &w4, &skidding_state,
+            &attachment, &nitro_amount, &item_amount, &item_type, &special_value,
+            &distance, &nitro, &zipper, &skidding, &red_skidding, &jumping
+            ) != 26)
+            return false;
+    }
+
+    // Values not saved in version 3 replays are 0
+    frame->m_transform.m_time = time;
+    frame->m_transform.m_transform = btTransform(btQuaternion(rx, ry, rz, rw),
+                                                 btVector3(x, y, z));
+    PhysicInfo      &pi  = frame->m_physic;
+    BonusInfo       &bi  = frame->m_bonus;
+    KartReplayEvent &kre = frame->m_event;
+    pi.m_speed                = speed;
+    pi.m_steer                = steer;
+    pi.m_suspension_length[0] = w1;
+    pi.m_suspension_length[1] = w2;
+    pi.m_suspension_length[2] = w3;
+    pi.m_suspension_length[3] = w4;
+    pi.m_skidding_state       = skidding_state;
+    bi.m_attachment           = attachment;
+    bi.m_nitro_amount         = nitro_amount;
+    bi.m_item_amount          = item_amount;
+    bi.m_item_type            = item_type;
+    bi.m_special_value        = special_value;
+    kre.m_distance            = distance;
+    kre.m_nitro_usage         = nitro;
+    kre.m_zipper_usage        = zipper!=0;
+    kre.m_skidding_effect     = skidding;
+    kre.m_red_skidding        = red_skidding!=0;
+    kre.m_jumping             = jumping != 0;
+    return true;
+}   // readTextFrame
+
+// -----------------------------------------------------------------------------
+/** Writes one frame of a kart to a binary replay file. Each value is
+ *  converted to fixed point and stored as difference to the previous frame
+ *  of the kart, which is small for most values.
+ *  \param file The file to write to.
+ *  \param frame The frame to write.
+ *  \param previous Values of the previous frame of the kart (all 0 for the
+ *         first frame), updated with the values of this frame.
+ */
+void ReplayBase::writeBinaryFrame(BinaryFile *file, const ReplayFrame &frame,
+                                  BinaryFrameValues *previous)
+{
+    const btTransform     &t  = frame.m_transform.m_transform;
+    const PhysicInfo      &pi = frame.m_physic;
+    const BonusInfo       &bi = frame.m_bonus;
+    const KartReplayEvent &r  = frame.m_event;
+    const float values[BinaryFrameValues::NUM_VALUES] =
+    {
+        frame.m_transform.m_time * 10000.0f,
+        t.getOrigin().getX() * 1000.0f,
+        t.getOrigin().getY() * 1000.0f,
+        t.getOrigin().getZ() * 1000.0f,
+        t.getRotation().getX() * 10000.0f,
+        t.getRotation().getY() * 10000.0f,
+        t.getRotation().getZ() * 10000.0f,
+        t.getRotation().getW() * 10000.0f,
+        pi.m_speed * 1000.0f,
+        pi.m_steer * 1000.0f,
+        pi.m_suspension_length[0] * 1000.0f,
+        pi.m_suspension_length[1] * 1000.0f,
+        pi.m_suspension_length[2] * 1000.0f,
+        pi.m_suspension_length[3] * 1000.0f,
+        (float)pi.m_skidding_state,
+        (float)bi.m_attachment,
+        bi.m_nitro_amount * 1000.0f,
+        (float)bi.m_item_amount,
+        (float)bi.m_item_type,
+        (float)bi.m_special_value,
+        r.m_distance * 1000.0f,
+        (float)r.m_nitro_usage,
+        r.m_zipper_usage ? 1.0f : 0.0f,
+        (float)r.m_skidding_effect,
+        r.m_red_skidding ? 1.0f : 0.0f,
+        r.m_jumping ? 1.0f : 0.0f
+    };
+    for (int i = 0; i < BinaryFrameValues::NUM_VALUES; i++)
+    {
+        int64_t value = (int64_t)std::llround(values[i]);
+        file->writeVarInt(value - previous->m_values[i]);
+        previous->m_values[i] = value;
+    }
+}   // writeBinaryFrame
+
+// -----------------------------------------------------------------------------
+/** Reads one frame of a kart written by writeBinaryFrame().
+ *  \param file The file to read from.
+ *  \param frame On return the frame read.
+ *  \param previous Values of the previous frame of the kart, updated with
+ *         the values of this frame.
+ *  \return False if the end of the file was reached.
+ */
+bool ReplayBase::readBinaryFrame(BinaryFile *file, ReplayFrame *frame,
+                                 BinaryFrameValues *previous)
+{
+    for (int i = 0; i < BinaryFrameValues::NUM_VALUES; i++)
+        previous->m_values[i] += file->readVarInt();
+    if (file->hasFailed())
+        return false;
+    decodeBinaryFrame(*previous, frame);
+    return true;
+}   // readBinaryFrame
+
+// -----------------------------------------------------------------------------
+/** Converts the fixed point values of a binary frame into a frame.
+ */
+void ReplayBase::decodeBinaryFrame(const BinaryFrameValues &values,
+                                   ReplayFrame *frame)
+{
+    const int64_t *v = values.m_values;
+    frame->m_transform.m_time = v[0] / 10000.0f;
+    frame->m_transform.m_transform = btTransform(
+        btQuaternion(v[4] / 10000.0f, v[5] / 10000.0f, v[6] / 10000.0f,
+                     v[7] / 10000.0f),
+        btVector3(v[1] / 1000.0f, v[2] / 1000.0f, v[3] / 1000.0f));
+    PhysicInfo      &pi = frame->m_physic;
+    BonusInfo       &bi = frame->m_bonus;
+    KartReplayEvent &r  = frame->m_event;
+    pi.m_speed                = v[8] / 1000.0f;
+    pi.m_steer                = v[9] / 1000.0f;
+    for (int i = 0; i < 4; i++)
+        pi.m_suspension_length[i] = v[10 + i] / 1000.0f;
+    pi.m_skidding_state       = (int)v[14];
+    bi.m_attachment           = (int)v[15];
+    bi.m_nitro_amount         = v[16] / 1000.0f;
+    bi.m_item_amount          = (int)v[17];
+    bi.m_item_type            = (int)v[18];
+    bi.m_special_value        = (int)v[19];
+    r.m_distance              = v[20] / 1000.0f;
+    r.m_nitro_usage           = (int)v[21];
+    r.m_zipper_usage          = v[22] != 0;
+    r.m_skidding_effect       = (int)v[23];
+    r.m_red_skidding          = v[24] != 0;
+    r.m_jumping               = v[25] != 0;
+}   // decodeBinaryFrame
@@ -22,10 +22,13 @@
 #include "LinearMath/btTransform.h"
 #include "utils/no_copy.hpp"
 
+#include <stdint.h>
 #include <stdio.h>
 #include <string>
 #include <vector>
 
+class BinaryFile;
+
 /**
   * \ingroup race
   */
@@ -97,6 +100,55 @@ protected:
         bool        m_jumping;
     };   // KartReplayEvent
 
+    // ------------------------------------------------------------------------
+    /** All data recorded for a kart at a certain time. */
+    struct ReplayFrame
+    {
+        TransformEvent  m_transform;
+        PhysicInfo      m_physic;
+        BonusInfo       m_bonus;
+        KartReplayEvent m_event;
+    };   // ReplayFrame
+
+    // ------------------------------------------------------------------------
+    /** The values of a frame in a binary replay, each stored as difference
+     *  to the value of the previous frame of the same kart. Floats are
+     *  stored in fixed point (time in 0.1 ms, positions in mm). */
+    struct BinaryFrameValues
+    {
+        static const int NUM_VALUES = 26;
+        int64_t m_values[NUM_VALUES];
+    };   // BinaryFrameValues
+
+    // ------------------------------------------------------------------------
+    /** Versions of binary replay files. */
+    enum BinaryReplayVersion
+    {
+        /** Frames of all karts in the order they were recorded, possibly
+         *  compressed. Used for the file written while racing. */
+        BRV_STREAM  = 1,
+        /** Uncompressed, frames grouped by kart, with a time index at the
+         *  end of the file (see IndexedReplay). */
+        BRV_INDEXED = 2
+    };
+
+    // ------------------------------------------------------------------------
+    static void writeTextFrame(FILE *fd, const ReplayFrame &frame);
+    // ------------------------------------------------------------------------
+    static bool readTextFrame(const char *line, unsigned int version,
+                              ReplayFrame *frame);
+    // ------------------------------------------------------------------------
+    static void writeBinaryFrame(BinaryFile *file, const ReplayFrame &frame,
+                                 BinaryFrameValues *previous);
+    // ------------------------------------------------------------------------
+    static bool readBinaryFrame(BinaryFile *file, ReplayFrame *frame,
+                                BinaryFrameValues *previous);
+    // ------------------------------------------------------------------------
+    static void decodeBinaryFrame(const BinaryFrameValues &values,
+                                  ReplayFrame *frame);
+    // ------------------------------------------------------------------------
+    /** Magic number of binary replay files. */
+    static const char *getBinaryReplayMagic() { return "STKR"; }
     // ------------------------------------------------------------------------
     FILE *openReplayFile(bool writeable, bool full_path = false, int replay_file_number=1);
     // ------------------------------------------------------------------------
@@ -105,12 +157,12 @@ protected:
     // ------------------------------------------------------------------------
     /** Returns the version number of the replay file recorderd by this executable.
      *  This is also used as a maximum supported version by this exexcutable. */
-    unsigned int getCurrentReplayVersion() const { return 4; }
+    static unsigned int getCurrentReplayVersion() { return 4; }
 
     // ------------------------------------------------------------------------
     /** This is used to check that a loaded replay file can still
      *  be understood by this executable. */
-    unsigned int getMinSupportedReplayVersion() const { return 3; }
+    static unsigned int getMinSupportedReplayVersion() { return 3; }
 
 public:
              ReplayBase();
@@ -19,11 +19,13 @@
 #include "replay/replay_play.hpp"
 
 #include "config/stk_config.hpp"
+#include "io/binary_file.hpp"
 #include "io/file_manager.hpp"
 #include "karts/ghost_kart.hpp"
 #include "karts/controller/ghost_controller.hpp"
 #include "modes/world.hpp"
 #include "race/race_manager.hpp"
+#include "replay/indexed_replay.hpp"
 #include "tracks/track.hpp"
 #include "tracks/track_manager.hpp"
 #include "utils/file_utils.hpp"
@@ -104,19 +106,14 @@ void ReplayPlay::loadAllReplayFile()
 }   // loadAllReplayFile
 
 //-----------------------------------------------------------------------------
-bool ReplayPlay::addReplayFile(const std::string& fn, bool custom_replay, int call_index)
+/** Reads the header of a text replay file.
+ *  \param fd The file to read from.
+ *  \param fn Name of the file, used in warnings.
+ *  \return False if the header is invalid.
+ */
+bool ReplayPlay::ReplayData::readText(FILE *fd, const std::string &fn)
 {
-
     char s[1024], s1[1024];
-    if (StringUtils::getExtension(fn) != "replay") return false;
-    FILE* fd = FileUtils::fopenU8Path(custom_replay ? fn :
-        file_manager->getReplayDir() + fn, "r");
-    if (fd == NULL) return false;
-    ReplayData rd;
-
-    // custom_replay is true when full path of filename is given
-    rd.m_custom_replay_file = custom_replay;
-    rd.m_filename = fn;
 
     fgets(s, 1023, fd);
     unsigned int version;
@@ -124,7 +121,6 @@ bool ReplayPlay::addReplayFile(const std::string& fn, bool custom_replay, int ca
     {
         Log::warn("Replay", "No Version information "
                   "found in replay file (bogus replay file).");
-        fclose(fd);
         return false;
     }
     if (version > getCurrentReplayVersion() ||
@@ -134,10 +130,9 @@ bool ReplayPlay::addReplayFile(const std::string& fn, bool custom_replay, int ca
         Log::warn("Replay", "STK replay version is '%d'", getCurrentReplayVersion());
         Log::warn("Replay", "Minimum supported replay version is '%d'", getMinSupportedReplayVersion());
         Log::warn("Replay", "Skipped '%s'", fn.c_str());
-        fclose(fd);
         return false;
     }
-        rd.m_replay_version = version;
+    m_replay_version = version;
 
     if (version >= 4)
     {
@@ -145,13 +140,12 @@ bool ReplayPlay::addReplayFile(const std::string& fn, bool custom_replay, int ca
         if(sscanf(s, "stk_version: %1023s", s1) != 1)
         {
             Log::warn("Replay", "No STK release version found in replay file, '%s'.", fn.c_str());
-            fclose(fd);
             return false;
         }
-        rd.m_stk_version = s1;
+        m_stk_version = s1;
     }
     else
-        rd.m_stk_version = "";
+        m_stk_version = "";
 
     while(true)
     {
@@ -169,21 +163,21 @@ bool ReplayPlay::addReplayFile(const std::string& fn, bool custom_replay, int ca
             break;
         }
 
-        rd.m_kart_list.push_back(std::string(s1));
+        m_kart_list.push_back(std::string(s1));
         if (scanned == 2)
         {
             // If username of kart is present, use it
-            rd.m_name_list.push_back(StringUtils::xmlDecode(std::string(display_name_encoded)));
-            if (rd.m_name_list.size() == 1)
+            m_name_list.push_back(StringUtils::xmlDecode(std::string(display_name_encoded)));
+            if (m_name_list.size() == 1)
             {
                 // First user is the game master and the "owner" of this replay file
-                rd.m_user_name = rd.m_name_list[0];
+                m_user_name = m_name_list[0];
             }
         } else
         { // scanned == 1
             // If username is not present, kart display name will default to kart name
             // (see GhostController::getName)
-            rd.m_name_list.push_back("");
+            m_name_list.push_back("");
         }
 
         // Read kart color data
@@ -194,13 +188,12 @@ bool ReplayPlay::addReplayFile(const std::string& fn, bool custom_replay, int ca
             if(sscanf(s, "kart_color: %f", &f) != 1)
             {
                 Log::warn("Replay", "Kart color missing in replay file, '%s'.", fn.c_str());
-                fclose(fd);
                 return false;
             }
-            rd.m_kart_color.push_back(f);
+            m_kart_color.push_back(f);
         }
         else
-            rd.m_kart_color.push_back(0.0f); // Use default kart color
+            m_kart_color.push_back(0.0f); // Use default kart color
     }
 
     int reverse = 0;
@@ -208,16 +201,14 @@ bool ReplayPlay::addReplayFile(const std::string& fn, bool custom_replay, int ca
     if(sscanf(s, "reverse: %d", &reverse) != 1)
     {
         Log::warn("Replay", "No reverse info found in replay file, '%s'.", fn.c_str());
-        fclose(fd);
         return false;
     }
-    rd.m_reverse = reverse != 0;
+    m_reverse = reverse != 0;
 
     fgets(s, 1023, fd);
-    if (sscanf(s, "difficulty: %u", &rd.m_difficulty) != 1)
+    if (sscanf(s, "difficulty: %u", &m_difficulty) != 1)
     {
         Log::warn("Replay", " No difficulty found in replay file, '%s'.", fn.c_str());
-        fclose(fd);
         return false;
     }
 
@@ -227,73 +218,293 @@ bool ReplayPlay::addReplayFile(const std::string& fn, bool custom_replay, int ca
         if (sscanf(s, "mode: %1023s", s1) != 1)
         {
             Log::warn("Replay", "Replay mode not found in replay file, '%s'.", fn.c_str());
-            fclose(fd);
             return false;
         }
-        rd.m_minor_mode = s1;
+        m_minor_mode = s1;
     }
     // Assume time-trial mode for old replays
     else
-        rd.m_minor_mode = "time-trial";
-
+        m_minor_mode = "time-trial";
 
     fgets(s, 1023, fd);
     if (sscanf(s, "track: %1023s", s1) != 1)
     {
         Log::warn("Replay", "Track info not found in replay file, '%s'.", fn.c_str());
-        fclose(fd);
-        return false;
-    }
-    rd.m_track_name = std::string(s1);
-
-    // If former official tracks are present as addons, show the matching replays.
-    if (rd.m_track_name.compare("greenvalley") == 0)
-        rd.m_track_name = std::string("addon_green-valley");
-    if (rd.m_track_name.compare("mansion") == 0)
-        rd.m_track_name = std::string("addon_blackhill-mansion");
-
-    Track* t = track_manager->getTrack(rd.m_track_name);
-    if (t == NULL)
-    {
-        Log::warn("Replay", "Track '%s' used in replay '%s' not found in STK!",
-        rd.m_track_name.c_str(), fn.c_str());
-        fclose(fd);
         return false;
     }
-
-    rd.m_track = t;
+    m_track_name = std::string(s1);
 
     fgets(s, 1023, fd);
-    if (sscanf(s, "laps: %u", &rd.m_laps) != 1)
+    if (sscanf(s, "laps: %u", &m_laps) != 1)
     {
         Log::warn("Replay", "No number of laps found in replay file, '%s'.", fn.c_str());
-        fclose(fd);
         return false;
     }
 
     fgets(s, 1023, fd);
-    if (sscanf(s, "min_time: %f", &rd.m_min_time) != 1)
+    if (sscanf(s, "min_time: %f", &m_min_time) != 1)
     {
         Log::warn("Replay", "Finish time not found in replay file, '%s'.", fn.c_str());
-        fclose(fd);
         return false;
     }
 
     if (version >= 4)
     {
         fgets(s, 1023, fd);
-        if (sscanf(s, "replay_uid: %" PRIu64, &rd.m_replay_uid) != 1)
+        if (sscanf(s, "replay_uid: %" PRIu64, &m_replay_uid) != 1)
         {
             Log::warn("Replay", "Replay UID not found in replay file, '%s'.", fn.c_str());
-            fclose(fd);
             return false;
         }
     }
     // No UID in old replay format
     else
-        rd.m_replay_uid = call_index;
+        m_replay_uid = 0;
+    return true;
+}   // readText
+
+//-----------------------------------------------------------------------------
+/** Writes the header of a text replay file (always in the current version).
+ */
+void ReplayPlay::ReplayData::writeText(FILE *fd) const
+{
+    fprintf(fd, "version: %d\n", getCurrentReplayVersion());
+    // Replays before version 4 have no STK version
+    fprintf(fd, "stk_version: %s\n", m_stk_version.empty() ? "unknown" :
+            StringUtils::wideToUtf8(m_stk_version).c_str());
+    for (unsigned int i = 0; i < m_kart_list.size(); i++)
+    {
+        // XML encode the username to handle Unicode
+        if (m_name_list[i].empty())
+            fprintf(fd, "kart: %s\n", m_kart_list[i].c_str());
+        else
+        {
+            fprintf(fd, "kart: %s %s\n", m_kart_list[i].c_str(),
+                    StringUtils::xmlEncode(m_name_list[i]).c_str());
+        }
+        fprintf(fd, "kart_color: %f\n", m_kart_color[i]);
+    }
+    fprintf(fd, "kart_list_end\n");
+    fprintf(fd, "reverse: %d\n",    (int)m_reverse);
+    fprintf(fd, "difficulty: %d\n", m_difficulty);
+    fprintf(fd, "mode: %s\n",       m_minor_mode.c_str());
+    fprintf(fd, "track: %s\n",      m_track_name.c_str());
+    fprintf(fd, "laps: %d\n",       m_laps);
+    fprintf(fd, "min_time: %f\n",   m_min_time);
+    fprintf(fd, "replay_uid: %" PRIu64 "\n", m_replay_uid);
+}   // writeText
+
+//-----------------------------------------------------------------------------
+/** Reads the header of a binary replay file after the magic number and
+ *  version.
+ *  \return False if the header is invalid.
+ */
+bool ReplayPlay::ReplayData::readBinary(BinaryFile *file)
+{
+    m_replay_version = getCurrentReplayVersion();
+    m_stk_version    = StringUtils::utf8ToWide(file->readString());
+    uint64_t num_karts = file->readVarUInt();
+    // Avoid allocating huge amounts of memory for corrupted files
+    if (file->hasFailed() || num_karts > 1000)
+        return false;
+    for (uint64_t i = 0; i < num_karts; i++)
+    {
+        m_kart_list.push_back(file->readString());
+        m_name_list.push_back(StringUtils::utf8ToWide(file->readString()));
+        m_kart_color.push_back(file->readFloat());
+    }
+    if (!m_name_list.empty())
+        m_user_name = m_name_list[0];
+    m_reverse    = file->readUInt8() != 0;
+    m_difficulty = (unsigned int)file->readVarUInt();
+    m_minor_mode = file->readString();
+    m_track_name = file->readString();
+    m_laps       = (unsigned int)file->readVarUInt();
+    m_min_time   = file->readFloat();
+    m_replay_uid = file->readVarUInt();
+    return !file->hasFailed();
+}   // readBinary
+
+//-----------------------------------------------------------------------------
+/** Writes the header of a binary replay file after the magic number and
+ *  version.
+ */
+void ReplayPlay::ReplayData::writeBinary(BinaryFile *file) const
+{
+    file->writeString(StringUtils::wideToUtf8(m_stk_version));
+    file->writeVarUInt(m_kart_list.size());
+    for (unsigned int i = 0; i < m_kart_list.size(); i++)
+    {
+        file->writeString(m_kart_list[i]);
+        file->writeString(StringUtils::wideToUtf8(m_name_list[i]));
+        file->writeFloat(m_kart_color[i]);
+    }
+    file->writeUInt8(m_reverse ? 1 : 0);
+    file->writeVarUInt(m_difficulty);
+    file->writeString(m_minor_mode);
+    file->writeString(m_track_name);
+    file->writeVarUInt(m_laps);
+    file->writeFloat(m_min_time);
+    file->writeVarUInt(m_replay_uid);
+}   // writeBinary
+
+//-----------------------------------------------------------------------------
+/** Reads a replay file in text or binary format.
+ *  \param filename Full path of the file.
+ *  \param rd On return the header of the replay.
+ *  \param frames If not NULL, on return the frames of each kart, otherwise
+ *         only the header is read.
+ *  \param binary On return true if the file is in binary format.
+ *  \return False if the file can not be read.
+ */
+bool ReplayPlay::readReplayFile(const std::string &filename, ReplayData *rd,
+                                std::vector<std::vector<ReplayFrame> > *frames,
+                                bool *binary)
+{
+    uint8_t version;
+    BinaryFile *file = BinaryFile::open(filename, getBinaryReplayMagic(),
+                                        &version);
+    if (file)
+    {
+        *binary = true;
+        if ((version != BRV_STREAM && version != BRV_INDEXED) ||
+            !rd->readBinary(file))
+        {
+            Log::warn("Replay", "Invalid binary replay file '%s'.",
+                      filename.c_str());
+            delete file;
+            return false;
+        }
+        if (frames && version == BRV_INDEXED)
+        {
+            delete file;
+            IndexedReplay indexed;
+            if (!indexed.open(filename) ||
+                indexed.getNumKarts() != rd->m_kart_list.size())
+                return false;
+            frames->resize(indexed.getNumKarts());
+            for (unsigned int k = 0; k < indexed.getNumKarts(); k++)
+            {
+                if (!indexed.decodeAllFrames(k, &(*frames)[k]))
+                {
+                    Log::warn("Replay", "Replay file '%s' is corrupted.",
+                              filename.c_str());
+                    return false;
+                }
+            }
+            return true;
+        }
+        if (frames)
+        {
+            const unsigned int num_karts = (unsigned int)rd->m_kart_list.size();
+            frames->clear();
+            frames->resize(num_karts);
+            std::vector<BinaryFrameValues> previous(num_karts,
+                                                    BinaryFrameValues());
+            ReplayFrame frame;
+            while (!file->isEnd())
+            {
+                uint64_t kart = file->readVarUInt();
+                if (kart >= num_karts ||
+                    !readBinaryFrame(file, &frame, &previous[kart]))
+                {
+                    Log::warn("Replay", "Replay file '%s' is truncated.",
+                              filename.c_str());
+                    break;
+                }
+                (*frames)[kart].push_back(frame);
+            }
+        }
+        delete file;
+        return true;
+    }
 
+    *binary = false;
+    FILE *fd = FileUtils::fopenU8Path(filename, "r");
+    if (!fd)
+        return false;
+    if (!rd->readText(fd, filename))
+    {
+        fclose(fd);
+        return false;
+    }
+    if (frames)
+    {
+        frames->clear();
+        char s[1024];
+        // eof actually doesn't trigger here, since it requires first to try
+        // reading behind eof, but still it's clearer this way.
+        while (!feof(fd))
+        {
+            if (fgets(s, 1023, fd) == NULL)  // eof reached
+                break;
+            unsigned int size;
+            if (sscanf(s, "size: %u", &size) != 1)
+            {
+                Log::error("Replay", "Number of records not found in replay "
+                           "file for kart %d.", (int)frames->size());
+                fclose(fd);
+                return false;
+            }
+            frames->emplace_back();
+            std::vector<ReplayFrame> &kart_frames = frames->back();
+            kart_frames.reserve(size);
+            for (unsigned int i = 0; i < size; i++)
+            {
+                fgets(s, 1023, fd);
+                ReplayFrame frame;
+                if (readTextFrame(s, rd->m_replay_version, &frame))
+                    kart_frames.push_back(frame);
+                else
+                {
+                    // Invalid record found
+                    // ---------------------
+                    Log::warn("Replay", "Can't read replay data line %d:", i);
+                    Log::warn("Replay", "%s", s);
+                    Log::warn("Replay", "Ignored.");
+                }
+            }   // for i
+        }
+    }
     fclose(fd);
+    return true;
+}   // readReplayFile
+
+//-----------------------------------------------------------------------------
+bool ReplayPlay::addReplayFile(const std::string& fn, bool custom_replay, int call_index)
+{
+    if (StringUtils::getExtension(fn) != "replay") return false;
+    ReplayData rd;
+
+    // custom_replay is true when full path of filename is given
+    rd.m_custom_replay_file = custom_replay;
+    rd.m_filename = fn;
+
+    bool binary;
+    if (!readReplayFile(custom_replay ? fn : file_manager->getReplayDir() + fn,
+                        &rd, /*frames*/NULL, &binary))
+        return false;
+
+    // No UID in old replay format
+    if (rd.m_replay_version < 4)
+        rd.m_replay_uid = call_index;
+
+    // If former official tracks are present as addons, show the matching replays.
+    if (rd.m_track_name.compare("greenvalley") == 0)
+        rd.m_track_name = std::string("addon_green-valley");
+    if (rd.m_track_name.compare("mansion") == 0)
+        rd.m_track_name = std::string("addon_blackhill-mansion");
+
+    Track* t = track_manager->getTrack(rd.m_track_name);
+    if (t == NULL)
+    {
+        Log::warn("Replay", "Track '%s' used in replay '%s' not found in STK!",
+        rd.m_track_name.c_str(), fn.c_str());
+        return false;
+    }
+
+    rd.m_track = t;
+
     m_replay_file_list.push_back(rd);
 
     assert(m_replay_file_list.size() > 0);
@@ -321,15 +532,19 @@ void ReplayPlay::load()
 //-----------------------------------------------------------------------------
 void ReplayPlay::loadFile(bool second_replay)
 {
-    char s[1024];
-
     int replay_index = second_replay ? m_second_replay_file : m_current_replay_file;
     int replay_file_number = second_replay ? 2 : 1;
 
-    FILE *fd = openReplayFile(/*writeable*/false,
-            m_replay_file_list.at(replay_index).m_custom_replay_file, replay_file_number);
+    const ReplayData &rd = m_replay_file_list.at(replay_index);
+    std::string filename = rd.m_custom_replay_file
+                         ? getReplayFilename(replay_file_number)
+                         : file_manager->getReplayDir() +
+                           getReplayFilename(replay_file_number);
 
-    if(!fd)
+    ReplayData header;
+    std::vector<std::vector<ReplayFrame> > frames;
+    bool binary;
+    if (!readReplayFile(filename, &header, &frames, &binary))
     {
         Log::error("Replay", "Can't read '%s', ghost replay disabled.",
                     getReplayFilename(replay_file_number).c_str());
@@ -340,35 +555,18 @@ void ReplayPlay::loadFile(bool second_replay)
     Log::info("Replay", "Reading replay file '%s'.",
                     getReplayFilename(replay_file_number).c_str());
 
-    ReplayData &rd = m_replay_file_list[replay_index];
-    unsigned int num_kart = (unsigned int)m_replay_file_list.at(replay_index)
-                                                            .m_kart_list.size();
-    unsigned int lines_to_skip = (rd.m_replay_version == 3) ? 7 : 10;
-    lines_to_skip += (rd.m_replay_version == 3) ? num_kart : 2*num_kart;
-
-    for (unsigned int i = 0; i < lines_to_skip; i++)
-        fgets(s, 1023, fd);
-
-    // eof actually doesn't trigger here, since it requires first to try
-    // reading behind eof, but still it's clearer this way.
-    while(!feof(fd))
-    {
-        if(fgets(s, 1023, fd)==NULL)  // eof reached
-            break;
-        readKartData(fd, s, second_replay);
-    }
-
-    fclose(fd);
+    for (unsigned int i = 0; i < frames.size(); i++)
+        createGhostKart(second_replay, frames[i]);
 }   // loadFile
 
 //-----------------------------------------------------------------------------
-/** Reads all data from a replay file for a specific kart.
- *  \param fd The file descriptor from which to read.
+/** Creates the ghost kart for the next kart of a replay file.
+ *  \param second_replay True if the kart is from the second replay file.
+ *  \param frames All frames recorded for the kart.
  */
-void ReplayPlay::readKartData(FILE *fd, char *next_line, bool second_replay)
+void ReplayPlay::createGhostKart(bool second_replay,
+                                 const std::vector<ReplayFrame> &frames)
 {
-    char s[1024];
-
     int replay_index = second_replay ? m_second_replay_file
                                      : m_current_replay_file;
 
@@ -388,120 +586,68 @@ void ReplayPlay::readKartData(FILE *fd, char *next_line, bool second_replay)
                                                  rd.m_name_list[kart_num-first_loaded_f_num]);
     getGhostKart(kart_num)->setController(controller);
 
-    unsigned int size;
-    if(sscanf(next_line,"size: %u",&size)!=1)
-        Log::fatal("Replay", "Number of records not found in replay file "
-            "for kart %d.", kart_num);
-
-    for(unsigned int i=0; i<size; i++)
+    for (const ReplayFrame &f : frames)
     {
-        fgets(s, 1023, fd);
-        float x, y, z, rx, ry, rz, rw, time, speed, steer, w1, w2, w3, w4, nitro_amount, distance;
-        int skidding_state, attachment, item_amount, item_type, special_value,
-            nitro, zipper, skidding, red_skidding, jumping;
+        m_ghost_karts[kart_num]->addReplayEvent(f.m_transform.m_time,
+            f.m_transform.m_transform, f.m_physic, f.m_bonus, f.m_event);
+    }
+}   // createGhostKart
 
-        // Check for EV_TRANSFORM event:
-        // -----------------------------
+//-----------------------------------------------------------------------------
+/** Converts a replay file from binary to text format or the other way round
+ *  (see --convert-replay).
+ *  \param in Name of the replay file to convert.
+ *  \param out Name of the converted file.
+ *  \return False if an error occurred.
+ */
+bool ReplayPlay::convert(const std::string &in, const std::string &out)
+{
+    ReplayData rd;
+    std::vector<std::vector<ReplayFrame> > frames;
+    bool binary;
+    if (!readReplayFile(in, &rd, &frames, &binary))
+    {
+        Log::error("Replay", "Can't read replay file '%s'.", in.c_str());
+        return false;
+    }
+    if (frames.size() != rd.m_kart_list.size())
+    {
+        Log::error("Replay", "Replay file '%s' has data for %d of %d karts.",
+                   in.c_str(), (int)frames.size(), (int)rd.m_kart_list.size());
+        return false;
+    }
 
-        // Up to STK 0.9.3 replays
-        if (rd.m_replay_version == 3)
+    unsigned int num_frames = 0;
+    if (binary)
+    {
+        FILE *fd = FileUtils::fopenU8Path(out, "w");
+        if (!fd)
         {
-            if(sscanf(s, "%f  %f %f %f  %f %f %f %f  %f  %f  %f %f %f %f  %d %d %d %d %d\n",
-                &time,
-                &x, &y, &z,
-                &rx, &ry, &rz, &rw,
-                &speed, &steer, &w1, &w2, &w3, &w4,
-                &nitro, &zipper, &skidding, &red_skidding, &jumping
-                )==19)
-            {
-                btQuaternion q(rx, ry, rz, rw);
-                btVector3 xyz(x, y, z);
-                PhysicInfo pi             = {0};
-                BonusInfo bi              = {0};
-                KartReplayEvent kre       = {0};
-
-                pi.m_speed                = speed;
-                pi.m_steer                = steer;
-                pi.m_suspension_length[0] = w1;
-                pi.m_suspension_length[1] = w2;
-                pi.m_suspension_length[2] = w3;
-                pi.m_suspension_length[3] = w4;
-                pi.m_skidding_state       = 0;    //not saved in version 3 replays
-                bi.m_attachment           = 0;    //not saved in version 3 replays
-                bi.m_nitro_amount         = 0;    //not saved in version 3 replays
-                bi.m_item_amount          = 0;    //not saved in version 3 replays
-                bi.m_item_type            = 0;    //not saved in version 3 replays
-                bi.m_special_value        = 0;    //not saved in version 3 replays
-                kre.m_distance            = 0.0f; //not saved in version 3 replays
-                kre.m_nitro_usage         = nitro;
-                kre.m_zipper_usage        = zipper!=0;
-                kre.m_skidding_effect     = skidding;
-                kre.m_red_skidding        = red_skidding!=0;
-                kre.m_jumping             = jumping != 0;
-                m_ghost_karts[kart_num]->addReplayEvent(time,
-                    btTransform(q, xyz), pi, bi, kre);
-            }
-            else
-            {
-                // Invalid record found
-                // ---------------------
-                Log::warn("Replay", "Can't read replay data line %d:", i);
-                Log::warn("Replay", "%s", s);
-                Log::warn("Replay", "Ignored.");
-            }
+            Log::error("Replay", "Can't create '%s'.", out.c_str());
+            return false;
         }
-
-        //version 4 replays (STK 0.9.4 and higher)
-        else
+        rd.writeText(fd);
+        for (const std::vector<ReplayFrame> &kart_frames : frames)
         {
-            if(sscanf(s, "%f  %f %f %f  %f %f %f %f  %f  %f  %f %f %f %f %d  %d %f %d %d %d  %f %d %d %d %d %d\n",
-                &time,
-                &x, &y, &z,
-                &rx, &ry, &rz, &rw,
-                &speed, &steer, &w1, &w2, &w3, &w4, &skidding_state,
-                &attachment, &nitro_amount, &item_amount, &item_type, &special_value,
-                &distance, &nitro, &zipper, &skidding, &red_skidding, &jumping
-                )==26)
-            {
-                btQuaternion q(rx, ry, rz, rw);
-                btVector3 xyz(x, y, z);
-                PhysicInfo pi             = {0};
-                BonusInfo bi              = {0};
-                KartReplayEvent kre       = {0};
-
-                pi.m_speed                = speed;
-                pi.m_steer                = steer;
-                pi.m_suspension_length[0] = w1;
-                pi.m_suspension_length[1] = w2;
-                pi.m_suspension_length[2] = w3;
-                pi.m_suspension_length[3] = w4;
-                pi.m_skidding_state       = skidding_state;
-                bi.m_attachment           = attachment;
-                bi.m_nitro_amount         = nitro_amount;
-                bi.m_item_amount          = item_amount;
-                bi.m_item_type            = item_type;
-                bi.m_special_value        = special_value;
-                kre.m_distance            = distance;
-                kre.m_nitro_usage         = nitro;
-                kre.m_zipper_usage        = zipper!=0;
-                kre.m_skidding_effect     = skidding;
-                kre.m_red_skidding        = red_skidding!=0;
-                kre.m_jumping             = jumping != 0;
-                m_ghost_karts[kart_num]->addReplayEvent(time,
-                    btTransform(q, xyz), pi, bi, kre);
-            }
-            else
-            {
-                // Invalid record found
-                // ---------------------
-                Log::warn("Replay", "Can't read replay data line %d:", i);
-                Log::warn("Replay", "%s", s);
-                Log::warn("Replay", "Ignored.");
-            }
+            fprintf(fd, "size:     %d\n", (int)kart_frames.size());
+            for (const ReplayFrame &frame : kart_frames)
+                writeTextFrame(fd, frame);
+            num_frames += (unsigned int)kart_frames.size();
         }
-    }   // for i
-
-}   // readKartData
+        fclose(fd);
+    }
+    else
+    {
+        if (!IndexedReplay::write(out, rd, frames))
+            return false;
+        for (const std::vector<ReplayFrame> &kart_frames : frames)
+            num_frames += (unsigned int)kart_frames.size();
+    }
+    Log::info("Replay", "Converted %u frames from '%s' (%s) to '%s'.",
+              num_frames, in.c_str(), binary ? "binary" : "text",
+              out.c_str());
+    return true;
+}   // convert
 
 //-----------------------------------------------------------------------------
 /** call getReplayIdByUID and set the current replay file to the first one
@@ -37,7 +37,6 @@ class GhostKart;
   */
 class ReplayPlay : public ReplayBase
 {
-
 public:
     /** Order of sort for ReplayData */
     enum SortOrder
@@ -73,6 +72,11 @@ public:
         uint64_t                   m_replay_uid; //no sorting for this
         float                      m_min_time;
 
+        bool readText(FILE *fd, const std::string &fn);
+        void writeText(FILE *fd) const;
+        bool readBinary(BinaryFile *file);
+        void writeBinary(BinaryFile *file) const;
+        // --------------------------------------------------------------------
         bool operator < (const ReplayData& r) const
         {
             switch (m_sort_order)
@@ -124,12 +128,35 @@ private:
 
           ReplayPlay();
          ~ReplayPlay();
-    void  readKartData(FILE *fd, char *next_line, bool second_replay);
+    void  createGhostKart(bool second_replay,
+                          const std::vector<ReplayFrame> &frames);
+    static bool readReplayFile(const std::string &filename, ReplayData *rd,
+                          std::vector<std::vector<ReplayFrame> > *frames,
+                          bool *binary);
 public:
     void  reset();
     void  load();
     void  loadFile(bool second_replay);
     void  loadAllReplayFile();
+    static bool convert(const std::string &in, const std::string &out);
+    // ------------------------------------------------------------------------
+    /** Reads only the header of a replay file (in any format).
+     *  \return False if the file could not be read. */
+    static bool readHeader(const std::string &filename, ReplayData *rd)
+    {
+        bool binary;
+        return readReplayFile(filename, rd, /*frames*/NULL, &binary);
+    }   // readHeader
+    // ------------------------------------------------------------------------
+    /** Reads the header and the frames of all karts of a replay file (in
+     *  any format).
+     *  \return False if the file could not be read. */
+    static bool readFrames(const std::string &filename, ReplayData *rd,
+                           std::vector<std::vector<ReplayFrame> > *frames)
+    {
+        bool binary;
+        return readReplayFile(filename, rd, frames, &binary);
+    }   // readFrames
     // ------------------------------------------------------------------------
     static void        setSortOrder(SortOrder so)       { m_sort_order = so; }
     // ------------------------------------------------------------------------
@@ -19,6 +19,8 @@
 #include "replay/replay_recorder.hpp"
 
 #include "config/stk_config.hpp"
+#include "config/user_config.hpp"
+#include "io/binary_file.hpp"
 #include "io/file_manager.hpp"
 #include "items/attachment.hpp"
 #include "items/powerup.hpp"
@@ -33,6 +35,8 @@
 #include "modes/world.hpp"
 #include "physics/btKart.hpp"
 #include "race/race_manager.hpp"
+#include "replay/indexed_replay.hpp"
+#include "replay/replay_play.hpp"
 #include "tracks/track.hpp"
 #include "utils/string_utils.hpp"
 #include "utils/translation.hpp"
@@ -40,7 +44,6 @@
 #include <algorithm>
 #include <stdio.h>
 #include <string>
-#include <cinttypes>
 
 ReplayRecorder *ReplayRecorder::m_replay_recorder = NULL;
 
@@ -52,6 +55,7 @@ ReplayRecorder::ReplayRecorder()
     m_complete_replay = false;
     m_incorrect_replay = false;
     m_previous_steer   = 0.0f;
+    m_binary_body      = NULL;
 
     assert(stk_config->m_replay_max_frames >= 0);
     m_max_frames = stk_config->m_replay_max_frames;
@@ -61,8 +65,28 @@ ReplayRecorder::ReplayRecorder()
 /** Frees all stored data. */
 ReplayRecorder::~ReplayRecorder()
 {
+    closeBinaryBody();
 }   // ~Replay
 
+//-----------------------------------------------------------------------------
+/** Returns the name of the temporary file the frames of a binary replay are
+ *  written to while racing. */
+std::string ReplayRecorder::getBinaryBodyFilename() const
+{
+    return file_manager->getReplayDir() + "recording.tmp";
+}   // getBinaryBodyFilename
+
+//-----------------------------------------------------------------------------
+/** Closes and removes the temporary file of a binary replay. */
+void ReplayRecorder::closeBinaryBody()
+{
+    if (!m_binary_body)
+        return;
+    delete m_binary_body;
+    m_binary_body = NULL;
+    file_manager->removeFile(getBinaryBodyFilename());
+}   // closeBinaryBody
+
 //-----------------------------------------------------------------------------
 /** Reset the replay recorder. */
 void ReplayRecorder::reset()
@@ -75,6 +99,8 @@ void ReplayRecorder::reset()
     m_kart_replay_event.clear();
     m_count_transforms.clear();
     m_last_saved_time.clear();
+    m_binary_previous.clear();
+    closeBinaryBody();
 
 #ifdef DEBUG
     m_count                       = 0;
@@ -106,6 +132,20 @@ void ReplayRecorder::init()
     m_count_transforms.resize(RaceManager::get()->getNumberOfKarts(), 0);
     m_last_saved_time.resize(RaceManager::get()->getNumberOfKarts(), -1.0f);
 
+    if (UserConfigParams::m_binary_replay)
+    {
+        // The file is only read back in save(), so don't compress it
+        m_binary_body = BinaryFile::create(getBinaryBodyFilename(),
+                                           getBinaryReplayMagic(),
+                                           BRV_STREAM, /*compression*/0);
+        if (!m_binary_body)
+        {
+            Log::warn("ReplayRecorder", "Can't create '%s', the replay will "
+                      "be saved as text.", getBinaryBodyFilename().c_str());
+        }
+        m_binary_previous.resize(RaceManager::get()->getNumberOfKarts(),
+                                 BinaryFrameValues());
+    }
 }   // init
 
 //-----------------------------------------------------------------------------
@@ -121,6 +161,8 @@ void ReplayRecorder::update(int ticks)
     unsigned int num_karts = world->getNumKarts();
 
     float time = world->getTime();
+    // Index of the kart in the replay file, which does not contain ghosts
+    unsigned int replay_kart = 0;
     for(unsigned int i=0; i<num_karts; i++)
     {
         AbstractKart *kart = world->getKart(i);
@@ -128,6 +170,7 @@ void ReplayRecorder::update(int ticks)
         if (kart->isEliminated() && single_player) return;
 
         if (kart->isGhostKart()) continue;
+        replay_kart++;
 #ifdef DEBUG
         m_count++;
 #endif
@@ -304,6 +347,13 @@ void ReplayRecorder::update(int ticks)
         kart->getKartGFX()->getGFXStatus(&(r->m_nitro_usage),
             &(r->m_zipper_usage), &(r->m_skidding_effect), &(r->m_red_skidding));
         r->m_jumping = kart->isJumping();
+
+        if (m_binary_body)
+        {
+            ReplayFrame frame = { *p, *q, *b, *r };
+            m_binary_body->writeVarUInt(replay_kart - 1);
+            writeBinaryFrame(m_binary_body, frame, &m_binary_previous[i]);
+        }
     }   // for i
 
     if (world->getPhase() == World::RESULT_DISPLAY_PHASE && !m_complete_replay)
@@ -385,98 +435,103 @@ void ReplayRecorder::save()
         << "_" << num_karts << "_" << time << ".replay";
     m_filename = oss.str();
 
-    FILE *fd = openReplayFile(/*writeable*/true);
-    if (!fd)
-    {
-        Log::error("ReplayRecorder", "Can't open '%s' for writing - "
-            "can't save replay data.", getReplayFilename().c_str());
-        return;
-    }
-
-    core::stringw msg = _("Replay saved in \"%s\".",
-        StringUtils::utf8ToWide(file_manager->getReplayDir() + getReplayFilename()));
-    MessageQueue::add(MessageQueue::MT_GENERIC, msg);
+    m_last_uid = computeUID(min_time);
 
-    fprintf(fd, "version: %d\n", getCurrentReplayVersion());
-    fprintf(fd, "stk_version: %s\n", STK_VERSION);
+    int num_laps = RaceManager::get()->getNumLaps();
+    if (num_laps == 9999) num_laps = 0; // no lap in that race mode
 
+    ReplayPlay::ReplayData rd;
+    rd.m_stk_version = STK_VERSION;
     unsigned int player_count = 0;
     for (unsigned int real_karts = 0; real_karts < num_karts; real_karts++)
     {
         const AbstractKart *kart = world->getKart(real_karts);
         if (kart->isGhostKart()) continue;
 
-        // XML encode the username to handle Unicode
-        fprintf(fd, "kart: %s %s\n", kart->getIdent().c_str(),
-                StringUtils::xmlEncode(kart->getController()->getName()).c_str());
-
+        rd.m_kart_list.push_back(kart->getIdent());
+        rd.m_name_list.push_back(kart->getController()->getName());
         if (kart->getController()->isPlayerController())
         {
-            fprintf(fd, "kart_color: %f\n", StateManager::get()->getActivePlayer(player_count)->getConstProfile()->getDefaultKartColor());
+            rd.m_kart_color.push_back(StateManager::get()
+                ->getActivePlayer(player_count)->getConstProfile()
+                ->getDefaultKartColor());
             player_count++;
         }
         else
-            fprintf(fd, "kart_color: 0\n");
+            rd.m_kart_color.push_back(0.0f);
     }
+    rd.m_reverse    = RaceManager::get()->getReverseTrack();
+    rd.m_difficulty = RaceManager::get()->getDifficulty();
+    rd.m_minor_mode = RaceManager::get()->getMinorModeName();
+    rd.m_track_name = Track::getCurrentTrack()->getIdent();
+    rd.m_laps       = num_laps;
+    rd.m_min_time   = min_time;
+    rd.m_replay_uid = m_last_uid;
+
+    if (m_binary_body)
+    {
+        // Read the frames written while racing back, and group them by kart
+        // with an index for random access
+        std::vector<std::vector<ReplayFrame> > frames(rd.m_kart_list.size());
+        std::vector<BinaryFrameValues> previous(frames.size(),
+                                                BinaryFrameValues());
+        delete m_binary_body;
+        uint8_t version;
+        m_binary_body = BinaryFile::open(getBinaryBodyFilename(),
+                                         getBinaryReplayMagic(), &version);
+        ReplayFrame frame;
+        while (m_binary_body && !m_binary_body->isEnd())
+        {
+            uint64_t kart = m_binary_body->readVarUInt();
+            if (kart >= frames.size() ||
+                !readBinaryFrame(m_binary_body, &frame, &previous[kart]))
+                break;
+            frames[kart].push_back(frame);
+        }
+        closeBinaryBody();
 
-    m_last_uid = computeUID(min_time);
-
-    int num_laps = RaceManager::get()->getNumLaps();
-    if (num_laps == 9999) num_laps = 0; // no lap in that race mode
-
-    fprintf(fd, "kart_list_end\n");
-    fprintf(fd, "reverse: %d\n",    (int)RaceManager::get()->getReverseTrack());
-    fprintf(fd, "difficulty: %d\n", RaceManager::get()->getDifficulty());
-    fprintf(fd, "mode: %s\n",       RaceManager::get()->getMinorModeName().c_str());
-    fprintf(fd, "track: %s\n",      Track::getCurrentTrack()->getIdent().c_str());
-    fprintf(fd, "laps: %d\n",       num_laps);
-    fprintf(fd, "min_time: %f\n",   min_time);
-    fprintf(fd, "replay_uid: %" PRIu64 "\n", m_last_uid);
-
-    for (unsigned int k = 0; k < num_karts; k++)
+        std::string filename = file_manager->getReplayDir() +
+                               getReplayFilename();
+        if (!IndexedReplay::write(filename, rd, frames))
+        {
+            Log::error("ReplayRecorder", "Can't open '%s' for writing - "
+                "can't save replay data.", getReplayFilename().c_str());
+            return;
+        }
+    }
+    else
     {
-        if (world->getKart(k)->isGhostKart()) continue;
-        fprintf(fd, "size:     %d\n", m_count_transforms[k]);
+        FILE *fd = openReplayFile(/*writeable*/true);
+        if (!fd)
+        {
+            Log::error("ReplayRecorder", "Can't open '%s' for writing - "
+                "can't save replay data.", getReplayFilename().c_str());
+            return;
+        }
+        rd.writeText(fd);
 
-        unsigned int num_transforms = std::min(m_max_frames,
-                                               m_count_transforms[k]);
-        for (unsigned int i = 0; i < num_transforms; i++)
+        for (unsigned int k = 0; k < num_karts; k++)
         {
-            const TransformEvent *p  = &(m_transform_events[k][i]);
-            const PhysicInfo *q      = &(m_physic_info[k][i]);
-            const BonusInfo *b      = &(m_bonus_info[k][i]);
-            const KartReplayEvent *r = &(m_kart_replay_event[k][i]);
-            fprintf(fd, "%f  %f %f %f  %f %f %f %f  %f  %f  %f %f %f %f %d  %d %f %d %d %d  %f %d %d %d %d %d\n",
-                    p->m_time,
-                    p->m_transform.getOrigin().getX(),
-                    p->m_transform.getOrigin().getY(),
-                    p->m_transform.getOrigin().getZ(),
-                    p->m_transform.getRotation().getX(),
-                    p->m_transform.getRotation().getY(),
-                    p->m_transform.getRotation().getZ(),
-                    p->m_transform.getRotation().getW(),
-                    q->m_speed,
-                    q->m_steer,
-                    q->m_suspension_length[0],
-                    q->m_suspension_length[1],
-                    q->m_suspension_length[2],
-                    q->m_suspension_length[3],
-                    q->m_skidding_state,
-                    b->m_attachment,
-                    b->m_nitro_amount,
-                    b->m_item_amount,
-                    b->m_item_type,
-                    b->m_special_value,
-                    r->m_distance,
-                    r->m_nitro_usage,
-                    (int)r->m_zipper_usage,
-                    r->m_skidding_effect,
-                    (int)r->m_red_skidding,
-                    (int)r->m_jumping
-                );
-        }   // for i
+            if (world->getKart(k)->isGhostKart()) continue;
+            fprintf(fd, "size:     %d\n", m_count_transforms[k]);
+
+            unsigned int num_transforms = std::min(m_max_frames,
+                                                   m_count_transforms[k]);
+            for (unsigned int i = 0; i < num_transforms; i++)
+            {
+                ReplayFrame frame = { m_transform_events[k][i],
+                                      m_physic_info[k][i],
+                                      m_bonus_info[k][i],
+                                      m_kart_replay_event[k][i] };
+                writeTextFrame(fd, frame);
+            }   // for i
+        }
+        fclose(fd);
     }
-    fclose(fd);
+
+    core::stringw msg = _("Replay saved in \"%s\".",
+        StringUtils::utf8ToWide(file_manager->getReplayDir() + getReplayFilename()));
+    MessageQueue::add(MessageQueue::MT_GENERIC, msg);
 }   // save
 
 /* Returns an encoding value for a given attachment type.
@@ -71,6 +71,14 @@ private:
 
     uint64_t m_last_uid;
 
+    /** If replays are saved in binary format, the frames are written to
+     *  this temporary file while racing, and the replay file is written
+     *  from it in save(). */
+    BinaryFile *m_binary_body;
+
+    /** Values of the last frame written to m_binary_body for each kart. */
+    std::vector<BinaryFrameValues> m_binary_previous;
+
 #ifdef DEBUG
     /** Counts overall number of events stored. */
     unsigned int m_count;
@@ -85,6 +93,8 @@ private:
     /** Compute the replay's UID ; partly based on race data ; partly randomly */
     uint64_t computeUID(float min_time);
 
+    std::string getBinaryBodyFilename() const;
+    void  closeBinaryBody();
 
           ReplayRecorder();
          ~ReplayRecorder();
@@ -0,0 +1,561 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2024 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#include "replay/replay_verifier.hpp"
+
+#include "io/file_manager.hpp"
+#include "io/xml_node.hpp"
+#include "race/race_manager.hpp"
+#include "replay/indexed_replay.hpp"
+#include "tracks/check_line.hpp"
+#include "tracks/drive_graph.hpp"
+#include "tracks/track.hpp"
+#include "tracks/track_manager.hpp"
+#include "utils/log.hpp"
+#include "utils/string_utils.hpp"
+#include "utils/thread_pool.hpp"
+#include "utils/time.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <set>
+
+namespace
+{
+    /** No kart can drive faster than this (in m/s), even with zippers. */
+    const float MAX_SPEED = 60.0f;
+
+    /** Progress along the track (in m) which is allowed on top of the
+     *  distance the kart actually moved since the reference frame. The
+     *  distance is computed from the sector of the drive graph the kart is
+     *  on, and jumps by up to about 250 m in the official replays, e.g.
+     *  where the track overlaps itself. The reference frame only changes
+     *  after an error, so this is not granted again in each frame. */
+    const float PROGRESS_TOLERANCE = 300.0f;
+
+    /** The distance along the drive graph is measured along the center of
+     *  the quads, which is longer than the racing line through curves. So
+     *  the progress can exceed the distance moved by this fraction. */
+    const float PROGRESS_FACTOR = 1.1f;
+
+    /** When a kart crosses the start line, the distance of a single frame
+     *  can be that of the previous lap. Frames with a distance this much
+     *  (in m) smaller than that of both neighbours are ignored. */
+    const float DISTANCE_GLITCH = 100.0f;
+
+    /** Largest allowed difference (in s) between the finish time stored in
+     *  the header and the time derived from the frames. */
+    const float FINISH_TIME_TOLERANCE = 0.1f;
+}   // anonymous namespace
+
+// ----------------------------------------------------------------------------
+/** Returns true if the replay could be read and all checks passed. */
+bool ReplayVerifier::FileReport::isValid() const
+{
+    if (!m_readable || m_karts.empty())
+        return false;
+    float first_finish = -1.0f;
+    for (const KartReport &kart : m_karts)
+    {
+        if (kart.m_num_frames == 0 || kart.m_time_errors > 0 ||
+            kart.m_progress_errors > 0)
+            return false;
+        if (kart.m_finish_time >= 0.0f &&
+            (first_finish < 0.0f || kart.m_finish_time < first_finish))
+            first_finish = kart.m_finish_time;
+    }
+    // In modes without laps there is no finish line to check
+    if (m_laps == 0)
+        return true;
+    // Without a drive graph (e.g. unknown track) the laps can't be checked
+    if (m_lap_length <= 0.0f)
+        return false;
+    return first_finish >= 0.0f &&
+           std::fabs(first_finish - m_min_time) <= FINISH_TIME_TOLERANCE;
+}   // isValid
+
+// ----------------------------------------------------------------------------
+/** Loads the lap length and the checklines of a track. This uses the drive
+ *  graph singleton and the race manager, so it must be called from the main
+ *  thread, and not while a race is running.
+ *  \param track_name Identifier of the track.
+ *  \param reverse If the track is driven in reverse.
+ *  \param info The lap length and checklines are stored here, the lap
+ *         length is 0 if the track could not be loaded.
+ */
+void ReplayVerifier::loadTrackInfo(const std::string &track_name,
+                                   bool reverse, TrackInfo *info)
+{
+    info->m_lap_length = 0.0f;
+    info->m_check_lines.clear();
+
+    Track *track = track_manager->getTrack(track_name);
+    if (!track || Graph::get())
+    {
+        Log::warn("ReplayVerifier", "Can't load track '%s'.",
+                  track_name.c_str());
+        return;
+    }
+
+    // The drive graph and the checklines read the direction from the race
+    // manager
+    RaceManager::get()->setReverseTrack(reverse);
+    new DriveGraph(track->getModeQuadFile(0), track->getModeGraphFile(0),
+                   reverse);
+    info->m_lap_length = DriveGraph::get()->getLapLength();
+
+    XMLNode *root = file_manager->createXMLTree(track->getModeSceneFile(0));
+    const XMLNode *checks = root ? root->getNode("checks") : NULL;
+    for (unsigned int i = 0; checks && i < checks->getNumNodes(); i++)
+    {
+        const XMLNode *node = checks->getNode(i);
+        if (node->getName() == "check-line")
+            info->m_check_lines.push_back(new CheckLine(*node, i));
+        else
+            info->m_check_lines.push_back(NULL);
+    }
+    delete root;
+
+    Graph::destroy();
+    RaceManager::get()->setReverseTrack(false);
+}   // loadTrackInfo
+
+// ----------------------------------------------------------------------------
+/** Checks the frames of a kart for consistency.
+ *  \param frames The frames of the kart.
+ *  \param report The report in which the results are stored.
+ */
+void ReplayVerifier::verifyKart(const std::vector<ReplayFrame> &frames,
+                                KartReport *report)
+{
+    report->m_num_frames       = (unsigned int)frames.size();
+    report->m_finish_time      = -1.0f;
+    report->m_lap_times.clear();
+    report->m_time_errors      = 0;
+    report->m_progress_errors  = 0;
+    report->m_max_speed_error  = 0.0f;
+    report->m_mean_speed_error = 0.0f;
+
+    unsigned int num_speeds = 0;
+    // The progress along the track is compared with the distance moved
+    // since a reference frame, which is the first frame after crossing the
+    // start line (the distance is negative before), and again each frame in
+    // which an error was found. The distance moved in each frame is limited
+    // by MAX_SPEED, so that teleporting ahead is not counted as moving.
+    int   reference = -1;
+    float moved_since_reference = 0.0f;
+    for (unsigned int i = 1; i < frames.size(); i++)
+    {
+        const ReplayFrame &prev = frames[i - 1];
+        const ReplayFrame &cur  = frames[i];
+        float dt = cur.m_transform.m_time - prev.m_transform.m_time;
+        if (dt <= 0.0f)
+        {
+            report->m_time_errors++;
+            continue;
+        }
+
+        btVector3 moved = cur.m_transform.m_transform.getOrigin()
+                        - prev.m_transform.m_transform.getOrigin();
+        float speed    = moved.length() / dt;
+        float recorded = 0.5f * (std::fabs(prev.m_physic.m_speed) +
+                                 std::fabs(cur.m_physic.m_speed));
+        float error = std::fabs(speed - recorded);
+        report->m_max_speed_error = std::max(report->m_max_speed_error,
+                                             error);
+        report->m_mean_speed_error += error;
+        num_speeds++;
+        moved_since_reference += std::min(moved.length(), MAX_SPEED * dt);
+
+        float distance = cur.m_event.m_distance;
+        if (i + 1 < frames.size() &&
+            distance < prev.m_event.m_distance - DISTANCE_GLITCH &&
+            distance < frames[i + 1].m_event.m_distance - DISTANCE_GLITCH)
+            continue;
+        if (distance < 0.0f && reference < 0)
+            continue;
+        if (reference < 0 ||
+            distance - frames[reference].m_event.m_distance >
+                PROGRESS_FACTOR * moved_since_reference + PROGRESS_TOLERANCE)
+        {
+            if (reference >= 0)
+                report->m_progress_errors++;
+            reference             = i;
+            moved_since_reference = 0.0f;
+        }
+    }
+    if (num_speeds > 0)
+        report->m_mean_speed_error /= num_speeds;
+}   // verifyKart
+
+// ----------------------------------------------------------------------------
+/** Finds the checklines crossed by a kart, in the order in which they were
+ *  crossed.
+ *  \param frames The frames of the kart.
+ *  \param track The checklines of the track.
+ *  \param report The indices of the checklines are stored here.
+ */
+void ReplayVerifier::findCheckLines(const std::vector<ReplayFrame> &frames,
+                                    const TrackInfo &track,
+                                    KartReport *report)
+{
+    report->m_checklines.clear();
+    for (unsigned int i = 1; i < frames.size(); i++)
+    {
+        const ReplayFrame &prev = frames[i - 1];
+        const ReplayFrame &cur  = frames[i];
+        if (cur.m_transform.m_time <= prev.m_transform.m_time)
+            continue;
+        Vec3 old_pos(prev.m_transform.m_transform.getOrigin());
+        Vec3 new_pos(cur.m_transform.m_transform.getOrigin());
+        for (unsigned int j = 0; j < track.m_check_lines.size(); j++)
+        {
+            const CheckLine *line = track.m_check_lines[j];
+            if (line && line->intersects(old_pos, new_pos,
+                                         /*ignore_height*/false))
+                report->m_checklines.push_back(j);
+        }
+    }
+}   // findCheckLines
+
+// ----------------------------------------------------------------------------
+/** Computes the times at which a kart finished each lap, i.e. when its
+ *  distance along the track reached a multiple of the lap length.
+ *  \param frames The frames of the kart.
+ *  \param lap_length Length of a lap.
+ *  \param laps Number of laps of the race.
+ *  \param report The report in which the lap and finish times are stored.
+ */
+void ReplayVerifier::computeLapTimes(const std::vector<ReplayFrame> &frames,
+                                     float lap_length, unsigned int laps,
+                                     KartReport *report)
+{
+    unsigned int i = 1;
+    for (unsigned int lap = 1; lap <= laps; lap++)
+    {
+        float target = lap * lap_length;
+        while (i < frames.size() &&
+               (frames[i].m_event.m_distance < target ||
+                frames[i - 1].m_event.m_distance < 0.0f))
+            i++;
+        if (i >= frames.size())
+            break;
+        const ReplayFrame &prev = frames[i - 1];
+        const ReplayFrame &cur  = frames[i];
+        float progress = cur.m_event.m_distance - prev.m_event.m_distance;
+        float f = progress > 0.0f
+                ? (target - prev.m_event.m_distance) / progress
+                : 1.0f;
+        f = std::min(std::max(f, 0.0f), 1.0f);
+        report->m_lap_times.push_back(prev.m_transform.m_time + f *
+            (cur.m_transform.m_time - prev.m_transform.m_time));
+    }
+    if (laps > 0 && report->m_lap_times.size() == laps)
+        report->m_finish_time = report->m_lap_times.back();
+}   // computeLapTimes
+
+// ----------------------------------------------------------------------------
+/** Reads a replay file and verifies all karts in it.
+ *  \param filename Full path of the replay file.
+ *  \param tracks The loaded tracks. If the track of the replay is not
+ *         included, the lap times and checklines are not computed.
+ *  \param report The report in which the results are stored.
+ */
+void ReplayVerifier::verifyFile(const std::string &filename,
+                                const TrackInfoMap &tracks,
+                                FileReport *report)
+{
+    report->m_filename   = filename;
+    report->m_min_time   = 0.0f;
+    report->m_laps       = 0;
+    report->m_lap_length = 0.0f;
+    report->m_karts.clear();
+
+    ReplayPlay::ReplayData rd;
+    std::vector<std::vector<ReplayFrame> > frames;
+    report->m_readable = ReplayPlay::readFrames(filename, &rd, &frames) &&
+                         frames.size() == rd.m_kart_list.size();
+    if (!report->m_readable)
+        return;
+
+    report->m_min_time = rd.m_min_time;
+    report->m_laps     = rd.m_laps;
+    report->m_karts.resize(frames.size());
+    for (unsigned int k = 0; k < frames.size(); k++)
+    {
+        report->m_karts[k].m_ident = rd.m_kart_list[k];
+        verifyKart(frames[k], &report->m_karts[k]);
+    }
+
+    TrackInfoMap::const_iterator track =
+        tracks.find(std::make_pair(rd.m_track_name, rd.m_reverse));
+    if (track == tracks.end())
+        return;
+    for (unsigned int k = 0; k < frames.size(); k++)
+        findCheckLines(frames[k], track->second, &report->m_karts[k]);
+
+    report->m_lap_length = track->second.m_lap_length;
+    if (rd.m_laps == 0 || report->m_lap_length <= 0.0f)
+        return;
+    for (unsigned int k = 0; k < frames.size(); k++)
+    {
+        computeLapTimes(frames[k], report->m_lap_length, rd.m_laps,
+                        &report->m_karts[k]);
+    }
+}   // verifyFile
+
+// ----------------------------------------------------------------------------
+/** Prints the result of verifying a replay file. */
+void ReplayVerifier::printReport(const FileReport &report)
+{
+    if (!report.m_readable)
+    {
+        Log::error("ReplayVerifier", "%s: can't be read.",
+                   report.m_filename.c_str());
+        return;
+    }
+    if (report.m_lap_length > 0.0f)
+    {
+        Log::info("ReplayVerifier", "%s: %s, %d karts, %d laps of %.1f m, "
+                  "finish time %.3f.", report.m_filename.c_str(),
+                  report.isValid() ? "valid" : "INVALID",
+                  (int)report.m_karts.size(), report.m_laps,
+                  report.m_lap_length, report.m_min_time);
+    }
+    else
+    {
+        Log::info("ReplayVerifier", "%s: %s, %d karts, %d laps, lap length "
+                  "unknown, finish time %.3f.", report.m_filename.c_str(),
+                  report.isValid() ? "valid" : "INVALID",
+                  (int)report.m_karts.size(), report.m_laps,
+                  report.m_min_time);
+    }
+    for (const KartReport &kart : report.m_karts)
+    {
+        std::string laps;
+        for (float t : kart.m_lap_times)
+            laps += " " + StringUtils::toString(t);
+        std::string checklines;
+        for (int c : kart.m_checklines)
+            checklines += " " + StringUtils::toString(c);
+        Log::info("ReplayVerifier", "  %s: %d frames, finish %.3f, laps:%s, "
+                  "checklines:%s, speed error max %.2f mean %.2f, "
+                  "%d time errors, %d progress errors.", kart.m_ident.c_str(),
+                  kart.m_num_frames, kart.m_finish_time,
+                  laps.empty() ? " -" : laps.c_str(),
+                  checklines.empty() ? " -" : checklines.c_str(),
+                  kart.m_max_speed_error, kart.m_mean_speed_error,
+                  kart.m_time_errors, kart.m_progress_errors);
+    }
+}   // printReport
+
+// ----------------------------------------------------------------------------
+/** Verifies a replay file, or all replay files in a directory, and prints
+ *  the results and the number of replays verified per minute. The headers
+ *  are read first to find the tracks used, which are then loaded in the
+ *  main thread, before the files are verified in parallel.
+ *  \param path A replay file or a directory.
+ *  \return True if all replays are valid.
+ */
+bool ReplayVerifier::verify(const std::string &path)
+{
+    std::vector<std::string> files;
+    if (file_manager->isDirectory(path))
+    {
+        std::set<std::string> names;
+        file_manager->listFiles(names, path, /*make_full_path*/true);
+        for (const std::string &name : names)
+        {
+            if (StringUtils::getExtension(name) == "replay")
+                files.push_back(name);
+        }
+    }
+    else
+        files.push_back(path);
+    if (files.empty())
+    {
+        Log::error("ReplayVerifier", "No replay files found in '%s'.",
+                   path.c_str());
+        return false;
+    }
+
+    uint64_t start = StkTime::getMonoTimeMs();
+    ThreadPool *pool = ThreadPool::get();
+    std::vector<ReplayPlay::ReplayData> headers(files.size());
+    auto read_header = [&files, &headers](unsigned int i)
+    {
+        if (!ReplayPlay::readHeader(files[i], &headers[i]))
+            headers[i].m_laps = 0;
+    };
+    if (pool)
+        pool->parallelFor((unsigned)files.size(), read_header);
+    else
+    {
+        for (unsigned int i = 0; i < files.size(); i++)
+            read_header(i);
+    }
+
+    TrackInfoMap tracks;
+    for (const ReplayPlay::ReplayData &rd : headers)
+    {
+        if (rd.m_laps == 0)
+            continue;
+        std::pair<std::string, bool> key(rd.m_track_name, rd.m_reverse);
+        if (tracks.find(key) == tracks.end())
+            loadTrackInfo(rd.m_track_name, rd.m_reverse, &tracks[key]);
+    }
+
+    std::vector<FileReport> reports(files.size());
+    auto verify_file = [&files, &tracks, &reports](unsigned int i)
+    {
+        verifyFile(files[i], tracks, &reports[i]);
+    };
+    if (pool)
+        pool->parallelFor((unsigned)files.size(), verify_file);
+    else
+    {
+        for (unsigned int i = 0; i < files.size(); i++)
+            verify_file(i);
+    }
+    uint64_t ms = std::max<uint64_t>(StkTime::getMonoTimeMs() - start, 1);
+
+    unsigned int num_valid = 0;
+    for (const FileReport &report : reports)
+    {
+        printReport(report);
+        if (report.isValid())
+            num_valid++;
+    }
+    Log::info("ReplayVerifier", "%d of %d replays valid, verified in %.3f s "
+              "with %d threads (%.1f replays per minute).", num_valid,
+              (int)files.size(), ms / 1000.0f,
+              pool ? pool->getNumThreads() + 1 : 1,
+              files.size() * 60000.0f / ms);
+
+    for (TrackInfoMap::value_type &track : tracks)
+    {
+        for (CheckLine *line : track.second.m_check_lines)
+            delete line;
+    }
+    return num_valid == files.size();
+}   // verify
+
+// ----------------------------------------------------------------------------
+void ReplayVerifier::unitTesting()
+{
+    ReplayPlay::ReplayData rd;
+    rd.m_stk_version = "test";
+    rd.m_kart_list   = { "tux", "nolok" };
+    rd.m_name_list   = { "a", "" };
+    rd.m_kart_color  = { 0.5f, 0.0f };
+    rd.m_reverse     = false;
+    rd.m_difficulty  = 2;
+    rd.m_minor_mode  = "normal";
+    rd.m_track_name  = "lighthouse";
+    rd.m_laps        = 3;
+    rd.m_min_time    = 30.0f;
+    rd.m_replay_uid  = 1234;
+
+    // Tux drives 3 laps of 200 m at 20 m/s, nolok at 15 m/s and does not
+    // finish before the recording ends
+    std::vector<std::vector<ReplayFrame> > frames(2);
+    for (unsigned int k = 0; k < 2; k++)
+    {
+        float speed = k == 0 ? 20.0f : 15.0f;
+        for (unsigned int i = 0; i <= 350; i++)
+        {
+            ReplayFrame f = ReplayFrame();
+            f.m_transform.m_time = i * 0.1f;
+            f.m_transform.m_transform.setIdentity();
+            f.m_transform.m_transform.setOrigin(
+                btVector3(speed * f.m_transform.m_time, 0.0f, 3.0f * k));
+            f.m_physic.m_speed   = speed;
+            f.m_event.m_distance = speed * f.m_transform.m_time;
+            frames[k].push_back(f);
+        }
+    }
+    // Before the start line is crossed the distance is negative
+    frames[0][0].m_event.m_distance = -200.0f;
+
+    const std::string filename =
+        file_manager->getUserConfigFile("replay_verifier_test.replay");
+    bool ok = IndexedReplay::write(filename, rd, frames);
+    assert(ok);
+
+    // A checkline across the track after 101 m
+    XMLNode *line_node = file_manager->createXMLTreeFromString(
+        "<check-line kind=\"activate\" p1=\"101 -5\" p2=\"101 10\" "
+        "min-height=\"-1\"/>");
+    TrackInfoMap tracks;
+    TrackInfo &track = tracks[std::make_pair(std::string("lighthouse"),
+                                             false)];
+    track.m_lap_length = 200.0f;
+    track.m_check_lines.push_back(NULL);
+    track.m_check_lines.push_back(new CheckLine(*line_node, 1));
+    delete line_node;
+
+    FileReport report;
+    verifyFile(filename, tracks, &report);
+    assert(report.m_readable);
+    assert(report.m_lap_length == 200.0f);
+    assert(report.m_karts.size() == 2);
+    assert(report.m_karts[0].m_lap_times.size() == 3);
+    assert(std::fabs(report.m_karts[0].m_lap_times[0] - 10.0f) < 0.01f);
+    assert(std::fabs(report.m_karts[0].m_finish_time - 30.0f) < 0.01f);
+    assert(report.m_karts[0].m_max_speed_error < 0.1f);
+    assert(report.m_karts[0].m_checklines == std::vector<int>(1, 1));
+    assert(report.m_karts[1].m_lap_times.size() == 2);
+    assert(report.m_karts[1].m_finish_time < 0.0f);
+    assert(report.m_karts[1].m_checklines == std::vector<int>(1, 1));
+    assert(report.isValid());
+
+    // Without the track the laps can't be checked
+    verifyFile(filename, TrackInfoMap(), &report);
+    assert(report.m_readable);
+    assert(!report.isValid());
+
+    // A kart teleporting far ahead along the track, and time going back
+    std::vector<ReplayFrame> broken = frames[1];
+    for (unsigned int i = 200; i < broken.size(); i++)
+        broken[i].m_event.m_distance += 600.0f;
+    broken[300].m_transform.m_time = 1.0f;
+    KartReport kart;
+    verifyKart(broken, &kart);
+    assert(kart.m_progress_errors == 1);
+    assert(kart.m_time_errors == 1);
+
+    // A kart gaining 250 m in each frame, which is less than the tolerance,
+    // but not in total
+    broken = frames[1];
+    for (unsigned int i = 100; i < broken.size(); i++)
+        broken[i].m_event.m_distance += 250.0f * (i - 99);
+    verifyKart(broken, &kart);
+    assert(kart.m_progress_errors > 1);
+
+    // A header with a finish time after the end of the recording
+    rd.m_min_time = 40.0f;
+    ok = IndexedReplay::write(filename, rd, frames);
+    assert(ok);
+    verifyFile(filename, tracks, &report);
+    assert(!report.isValid());
+    (void)ok;
+
+    delete track.m_check_lines[1];
+    file_manager->removeFile(filename);
+}   // unitTesting
@@ -0,0 +1,119 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2024 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#ifndef HEADER_REPLAY_VERIFIER_HPP
+#define HEADER_REPLAY_VERIFIER_HPP
+
+#include "replay/replay_play.hpp"
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+class CheckLine;
+
+/** Checks replay files without running a race, e.g. to validate replays
+ *  submitted for a leaderboard (see --verify-replays). Replays only contain
+ *  the recorded transforms and states of the karts, not the inputs of the
+ *  players, so they are not simulated again. Instead the frames of each
+ *  kart are checked for consistency: time must increase, the kart can not
+ *  progress along the track much further than it actually moved, and the
+ *  recorded speed is compared with the speed computed from consecutive
+ *  positions. The lap length is taken from the drive graph of the track,
+ *  the lap times of each kart are derived from the distance driven, and
+ *  the first finish time must match the time stored in the header. The
+ *  sequence of checklines crossed by each kart is reported.
+ *  The tracks are loaded first in the main thread, then the files are
+ *  verified in parallel using the \ref ThreadPool.
+ * \ingroup replay
+ */
+class ReplayVerifier : public ReplayBase
+{
+private:
+    /** The data of a track (in one direction) needed to verify replays. */
+    struct TrackInfo
+    {
+        /** Length of a lap according to the drive graph, 0 if unknown. */
+        float                   m_lap_length;
+        /** The checklines of the track, NULL for other check structures
+         *  so that the index is the same as in the check manager. */
+        std::vector<CheckLine*> m_check_lines;
+    };   // TrackInfo
+
+    // ------------------------------------------------------------------------
+    /** The result of verifying a kart of a replay. */
+    struct KartReport
+    {
+        std::string        m_ident;
+        unsigned int       m_num_frames;
+        /** Time the kart crossed the finish line, or -1 if it did not. */
+        float              m_finish_time;
+        /** Time at which the kart finished each lap. */
+        std::vector<float> m_lap_times;
+        /** Indices of the checklines crossed, in order. */
+        std::vector<int>   m_checklines;
+        /** Number of frames with a time not after the previous frame. */
+        unsigned int       m_time_errors;
+        /** Number of times the kart got further along the track than it
+         *  moved since the last error (or since crossing the start line). */
+        unsigned int       m_progress_errors;
+        /** Largest and average difference between the recorded speed and
+         *  the speed computed from the positions. */
+        float              m_max_speed_error;
+        float              m_mean_speed_error;
+    };   // KartReport
+
+    // ------------------------------------------------------------------------
+    /** The result of verifying a replay file. */
+    struct FileReport
+    {
+        std::string             m_filename;
+        /** False if the file could not be read. */
+        bool                    m_readable;
+        float                   m_min_time;
+        unsigned int            m_laps;
+        /** Length of a lap from the drive graph, or 0 if unknown. */
+        float                   m_lap_length;
+        std::vector<KartReport> m_karts;
+        // --------------------------------------------------------------------
+        bool isValid() const;
+    };   // FileReport
+
+    /** Loaded tracks, by name and reverse. */
+    typedef std::map<std::pair<std::string, bool>, TrackInfo> TrackInfoMap;
+
+    static void loadTrackInfo(const std::string &track_name, bool reverse,
+                              TrackInfo *info);
+    static void verifyFile(const std::string &filename,
+                           const TrackInfoMap &tracks, FileReport *report);
+    static void verifyKart(const std::vector<ReplayFrame> &frames,
+                           KartReport *report);
+    static void findCheckLines(const std::vector<ReplayFrame> &frames,
+                               const TrackInfo &track, KartReport *report);
+    static void computeLapTimes(const std::vector<ReplayFrame> &frames,
+                                float lap_length, unsigned int laps,
+                                KartReport *report);
+    static void printReport(const FileReport &report);
+
+public:
+    static bool verify(const std::string &path);
+    static void unitTesting();
+};   // ReplayVerifier
+
+#endif
@@ -591,6 +591,8 @@ public:
             kartCharacteristics.engineMaxSpeed = kart->getEngineMaxSpeed();
             kartCharacteristics.accelerationEfficiency = kart->getAccelerationEfficiency();
             kartCharacteristics.nitroConsumption = kart->getNitroConsumption();
+            kartCharacteristics.modelLoaded = kart->areModelsLoaded();
+            kartCharacteristics.modelMemory = kart->getModelsMemory();
             result.emplace_back(std::move(kartCharacteristics));
         }
         return result;
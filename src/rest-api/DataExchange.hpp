@@ -76,6 +76,8 @@ struct KartModelWrapper
     float engineMaxSpeed;
     float accelerationEfficiency;
     float nitroConsumption;
+    bool modelLoaded;
+    size_t modelMemory;
 };
 class KartModelExchange : public DataExchange
 {
@@ -712,6 +712,8 @@ private:
         kart.AddMember("engine-max-speed", kartCharacteristics.engineMaxSpeed, alloc);
         kart.AddMember("acceleration-efficiency", kartCharacteristics.accelerationEfficiency, alloc);
         kart.AddMember("nitro-consumption", kartCharacteristics.nitroConsumption, alloc);
+        kart.AddMember("model-loaded", kartCharacteristics.modelLoaded, alloc);
+        kart.AddMember("model-memory", static_cast<uint64_t>(kartCharacteristics.modelMemory), alloc);
         return kart;
     }
 
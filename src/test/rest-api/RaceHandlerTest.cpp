@@ -122,7 +122,9 @@ TEST_F(RaceHandlerTest, GetKartsOne)
                     0.5f,
                     1.0f,
                     2.0f,
-                    0.25f
+                    0.25f,
+                    true,
+                    4096
     }}));
     auto handler = RestApi::Handler::createKartModelHandler(karts, getMutex());
     auto [status, result] = handler->handleGet();
@@ -136,7 +138,9 @@ TEST_F(RaceHandlerTest, GetKartsOne)
         "        \"mass\": 0.5,\n"
         "        \"engine-max-speed\": 1.0,\n"
         "        \"acceleration-efficiency\": 2.0,\n"
-        "        \"nitro-consumption\": 0.25\n"
+        "        \"nitro-consumption\": 0.25,\n"
+        "        \"model-loaded\": true,\n"
+        "        \"model-memory\": 4096\n"
         "    }\n"
         "]");
     EXPECT_EQ(handler->handleGet("id").first, RestApi::STATUS_CODE::NOT_FOUND);
@@ -150,7 +154,9 @@ TEST_F(RaceHandlerTest, GetKartsOne)
         "    \"mass\": 0.5,\n"
         "    \"engine-max-speed\": 1.0,\n"
         "    \"acceleration-efficiency\": 2.0,\n"
-        "    \"nitro-consumption\": 0.25\n"
+        "    \"nitro-consumption\": 0.25,\n"
+        "    \"model-loaded\": true,\n"
+        "    \"model-memory\": 4096\n"
         "}");
 }
 
@@ -166,7 +172,9 @@ TEST_F(RaceHandlerTest, GetKartsMany)
                     5.0f,
                     8.0f,
                     12.0f,
-                    1.0f
+                    1.0f,
+                    false,
+                    0
                 },
                 RestApi::KartModelWrapper{
                     "id2",
@@ -174,7 +182,9 @@ TEST_F(RaceHandlerTest, GetKartsMany)
                     8.0f,
                     4.0f,
                     3.0f,
-                    2.0f
+                    2.0f,
+                    true,
+                    123456
                 }}));
     auto handler = RestApi::Handler::createKartModelHandler(karts, getMutex());
     auto [status, result] = handler->handleGet();
@@ -188,7 +198,9 @@ TEST_F(RaceHandlerTest, GetKartsMany)
         "        \"mass\": 5.0,\n"
         "        \"engine-max-speed\": 8.0,\n"
         "        \"acceleration-efficiency\": 12.0,\n"
-        "        \"nitro-consumption\": 1.0\n"
+        "        \"nitro-consumption\": 1.0,\n"
+        "        \"model-loaded\": false,\n"
+        "        \"model-memory\": 0\n"
         "    },\n"
         "    {\n"
         "        \"id\": \"id2\",\n"
@@ -196,7 +208,9 @@ TEST_F(RaceHandlerTest, GetKartsMany)
         "        \"mass\": 8.0,\n"
         "        \"engine-max-speed\": 4.0,\n"
         "        \"acceleration-efficiency\": 3.0,\n"
-        "        \"nitro-consumption\": 2.0\n"
+        "        \"nitro-consumption\": 2.0,\n"
+        "        \"model-loaded\": true,\n"
+        "        \"model-memory\": 123456\n"
         "    }\n"
         "]");
     EXPECT_EQ(handler->handleGet("id").first, RestApi::STATUS_CODE::NOT_FOUND);
@@ -210,7 +224,9 @@ TEST_F(RaceHandlerTest, GetKartsMany)
         "    \"mass\": 5.0,\n"
         "    \"engine-max-speed\": 8.0,\n"
         "    \"acceleration-efficiency\": 12.0,\n"
-        "    \"nitro-consumption\": 1.0\n"
+        "    \"nitro-consumption\": 1.0,\n"
+        "    \"model-loaded\": false,\n"
+        "    \"model-memory\": 0\n"
         "}");
     std::tie(status, result) = handler->handleGet("id2");
     EXPECT_EQ(status, RestApi::STATUS_CODE::OK);
@@ -222,7 +238,9 @@ TEST_F(RaceHandlerTest, GetKartsMany)
         "    \"mass\": 8.0,\n"
         "    \"engine-max-speed\": 4.0,\n"
         "    \"acceleration-efficiency\": 3.0,\n"
-        "    \"nitro-consumption\": 2.0\n"
+        "    \"nitro-consumption\": 2.0,\n"
+        "    \"model-loaded\": true,\n"
+        "    \"model-memory\": 123456\n"
         "}");
 }
 
@@ -238,7 +256,9 @@ TEST_F(RaceHandlerTest, PutKart)
                     7.0f,
                     0.5f,
                     5.0f,
-                    11.0f
+                    11.0f,
+                    false,
+                    0
                 },
                 RestApi::KartModelWrapper{
                     "MyId_2",
@@ -246,7 +266,9 @@ TEST_F(RaceHandlerTest, PutKart)
                     8.0f,
                     6.0f,
                     12.0f,
-                    1.5f
+                    1.5f,
+                    true,
+                    2048
                 }}));
     Sequence sequenceUnzipFunction;
     EXPECT_CALL(karts, getUnzipFunction()).Times(1).InSequence(sequenceUnzipFunction).WillOnce([] {
@@ -280,7 +302,9 @@ TEST_F(RaceHandlerTest, PutKart)
         "    \"mass\": 8.0,\n"
         "    \"engine-max-speed\": 6.0,\n"
         "    \"acceleration-efficiency\": 12.0,\n"
-        "    \"nitro-consumption\": 1.5\n"
+        "    \"nitro-consumption\": 1.5,\n"
+        "    \"model-loaded\": true,\n"
+        "    \"model-memory\": 2048\n"
         "}");
     std::tie(status, result) = handler->handlePutZip("DATA_2");
     EXPECT_EQ(status, RestApi::STATUS_CODE::CREATED);
@@ -292,7 +316,9 @@ TEST_F(RaceHandlerTest, PutKart)
         "    \"mass\": 7.0,\n"
         "    \"engine-max-speed\": 0.5,\n"
         "    \"acceleration-efficiency\": 5.0,\n"
-        "    \"nitro-consumption\": 11.0\n"
+        "    \"nitro-consumption\": 11.0,\n"
+        "    \"model-loaded\": false,\n"
+        "    \"model-memory\": 0\n"
         "}");
 }
 
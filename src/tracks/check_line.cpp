@@ -212,12 +212,7 @@ bool CheckLine::isTriggered(const Vec3 &old_pos, const Vec3 &new_pos,
     bool ignore_height = m_ignore_height;
     bool check_line_debug = false;
 start:
-    irr::core::triangle3df* check_plane =
-        ignore_height ? &m_check_plane[2] : &m_check_plane[0];
-    core::line3df test(old_pos.toIrrVector(), new_pos.toIrrVector());
-    core::vector3df intersect;
-    if (check_plane[0].getIntersectionWithLimitedLine(test, intersect) ||
-        check_plane[1].getIntersectionWithLimitedLine(test, intersect))
+    if (intersects(old_pos, new_pos, ignore_height))
     {
         if (UserConfigParams::m_check_debug && check_line_debug)
         {
@@ -255,6 +250,25 @@ start:
     return result;
 }   // isTriggered
 
+// ----------------------------------------------------------------------------
+/** True if the line from old_pos to new_pos goes through the check planes of
+ *  this checkline. Unlike isTriggered this does not change any state, so it
+ *  can be used from any thread (e.g. by the \ref ReplayVerifier).
+ *  \param old_pos   Position in previous frame.
+ *  \param new_pos   Position in current frame.
+ *  \param ignore_height If the higher check planes should be used.
+ */
+bool CheckLine::intersects(const Vec3 &old_pos, const Vec3 &new_pos,
+                           bool ignore_height) const
+{
+    const irr::core::triangle3df* check_plane =
+        ignore_height ? &m_check_plane[2] : &m_check_plane[0];
+    core::line3df test(old_pos.toIrrVector(), new_pos.toIrrVector());
+    core::vector3df intersect;
+    return check_plane[0].getIntersectionWithLimitedLine(test, intersect) ||
+           check_plane[1].getIntersectionWithLimitedLine(test, intersect);
+}   // intersects
+
 // ----------------------------------------------------------------------------
 void CheckLine::saveCompleteState(BareNetworkString* bns)
 {
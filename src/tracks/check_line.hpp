@@ -74,6 +74,8 @@ public:
     virtual     ~CheckLine();
     virtual bool isTriggered(const Vec3 &old_pos, const Vec3 &new_pos,
                              int indx) OVERRIDE;
+    bool         intersects(const Vec3 &old_pos, const Vec3 &new_pos,
+                            bool ignore_height) const;
     virtual void reset(const Track &track) OVERRIDE;
     virtual void resetAfterKartMove(unsigned int kart_index) OVERRIDE;
     virtual void resetAfterRewind(unsigned int kart_index) OVERRIDE
@@ -29,8 +29,16 @@
 #include "tracks/check_manager.hpp"
 #include "tracks/drive_node.hpp"
 #include "tracks/track.hpp"
+#include "utils/file_utils.hpp"
 #include "utils/string_utils.hpp"
 
+#include <algorithm>
+#include <cstdio>
+
+/** Version of the cached AI data, must be increased whenever the data or
+ *  the way it is computed changes. */
+static const uint8_t AI_DATA_CACHE_VERSION = 1;
+
 // ----------------------------------------------------------------------------
 /** Constructor, loads the graph information for a given set of quads
  *  from a graph file.
@@ -169,6 +177,7 @@ void DriveGraph::load(const std::string &quad_file_name,
         // Set the default loop:
         setDefaultSuccessors();
         computeDirectionData();
+        computeAIData(filename);
 
         if (m_all_nodes.size() > 0)
         {
@@ -248,6 +257,7 @@ void DriveGraph::load(const std::string &quad_file_name,
     setDefaultSuccessors();
     computeDistanceFromStart(getStartNode(), 0.0f);
     computeDirectionData();
+    computeAIData(filename);
 
     // Define the track length as the maximum at the end of a quad
     // (i.e. distance_from_start + length till successor 0).
@@ -680,6 +690,250 @@ void DriveGraph::determineDirection(unsigned int current,
     getNode(current)->setDirectionData(succ_index, dir, next);
 }   // determineDirection
 
+//-----------------------------------------------------------------------------
+/** Computes the data used by the AI for each node and successor: the radius
+ *  of the curve ahead, the racing line point and the look-ahead node (see
+ *  determineAIData()). Since this can take a while on big tracks, the data
+ *  is cached in the cached data directory and only recomputed if the quad
+ *  or graph file is newer than the cache. Must be called after
+ *  computeDirectionData().
+ *  \param graph_file_name Name of the graph file (which might not exist).
+ */
+void DriveGraph::computeAIData(const std::string &graph_file_name)
+{
+    const std::string cache_file = getAIDataCacheFile();
+    if (file_manager->fileExists(cache_file) &&
+        file_manager->fileIsNewer(cache_file, m_quad_filename) &&
+        (!file_manager->fileExists(graph_file_name) ||
+         file_manager->fileIsNewer(cache_file, graph_file_name)) &&
+        loadAIData(cache_file))
+        return;
+
+    for(unsigned int i=0; i<m_all_nodes.size(); i++)
+    {
+        for(unsigned int succ_index=0;
+            succ_index<getNode(i)->getNumberOfSuccessors();
+            succ_index++)
+        {
+            determineAIData(i, succ_index);
+        }   // for succ_index < getNumberOfSuccessors
+    }   // for i < m_all_nodes.size()
+    saveAIData(cache_file);
+}   // computeAIData
+
+//-----------------------------------------------------------------------------
+/** Computes the AI data of one node when driving to the specified successor:
+ *  1. The radius of the circle through the center of this node (with the
+ *     direction to the successor as tangent) and the center of the last
+ *     node with the same direction, i.e. the curve the AI has to drive.
+ *  2. The racing line point, which is moved from the center of the node to
+ *     the inside of a curve.
+ *  3. The look-ahead node, i.e. the furthest node whose center can be
+ *     reached in a straight line from the center of this node without
+ *     getting close to the edge of the track. Similar to
+ *     SkiddingAI::findNonCrashingPoint(), it stops at very sharp turns.
+ *     After the successor only successor 0 is followed, and the search
+ *     stops at a node with more than one successor, since the AI might
+ *     take a different way there.
+ *  \param current Index of the graph node.
+ *  \param succ_index The successor to be followed from the current node.
+ */
+void DriveGraph::determineAIData(unsigned int current,
+                                 unsigned int succ_index)
+{
+    // Maximum number of nodes to look ahead
+    const unsigned int max_look_ahead = 20;
+
+    DriveNode *dn = getNode(current);
+    DriveNode::DirectionType dir;
+    unsigned int last;
+    dn->getDirectionData(succ_index, &dir, &last);
+    const unsigned int next = dn->getSuccessor(succ_index);
+
+    float radius = DriveNode::STRAIGHT_RADIUS;
+    Vec3 racing_line_point = dn->getCenter();
+    if (dir == DriveNode::DIR_LEFT || dir == DriveNode::DIR_RIGHT)
+    {
+        // With t the tangent and p the vector to the last node the radius
+        // is |p|^2 / (2 * distance of p from the tangent)
+        Vec3 tangent = getNode(next)->getCenter() - dn->getCenter();
+        Vec3 p       = getNode(last)->getCenter() - dn->getCenter();
+        tangent.setY(0);
+        p.setY(0);
+        const float cross = fabsf(tangent.getX()*p.getZ()
+                                 -tangent.getZ()*p.getX());
+        const float length = tangent.length();
+        if (cross > 0.001f * length)
+        {
+            radius = std::min(p.length2() * length / (2.0f * cross),
+                              DriveNode::STRAIGHT_RADIUS);
+        }
+
+        const float offset = 0.25f * dn->getPathWidth();
+        if (dir == DriveNode::DIR_LEFT)
+            racing_line_point -= dn->getRightUnitVector() * offset;
+        else
+            racing_line_point += dn->getRightUnitVector() * offset;
+    }
+
+    int look_ahead = next;
+    const float angle = getAngleToNext(current, succ_index);
+    std::vector<unsigned int> path;
+    path.push_back(current);
+    path.push_back(next);
+    for (unsigned int i = 0; i < max_look_ahead; i++)
+    {
+        const DriveNode *dn_last = getNode(path.back());
+        if (dn_last->getNumberOfSuccessors() != 1)
+            break;
+        const unsigned int target = dn_last->getSuccessor(0);
+        if (target == current ||
+            fabsf(normalizeAngle(getAngleToNext(target, 0) - angle)) > 1.5f)
+            break;
+        path.push_back(target);
+        if (!isLineOnTrack(dn->getCenter(), getNode(target)->getCenter(),
+                           path))
+            break;
+        look_ahead = target;
+    }
+
+    dn->setAIData(succ_index, radius, racing_line_point, look_ahead);
+}   // determineAIData
+
+//-----------------------------------------------------------------------------
+/** Tests if all points on the line between start and end are close to the
+ *  center line of one of the nodes in path. Close means within a quarter of
+ *  the width, so that a kart which is up to a quarter of the width away from
+ *  the center can still drive this line without leaving the track.
+ *  \param start Start point of the line.
+ *  \param end End point of the line.
+ *  \param path All nodes the line can go through.
+ */
+bool DriveGraph::isLineOnTrack(const Vec3 &start, const Vec3 &end,
+                               const std::vector<unsigned int> &path) const
+{
+    // Distance between two tested points on the line
+    const float step_size = 1.0f;
+
+    const Vec3 direction = end - start;
+    const unsigned int steps =
+        std::max((unsigned int)(direction.length() / step_size), 1u);
+    for (unsigned int i = 1; i <= steps; i++)
+    {
+        const Vec3 point = start + direction * (float(i) / float(steps));
+        bool on_track = false;
+        for (unsigned int n : path)
+        {
+            Vec3 track_coord;
+            getNode(n)->getDistances(point, &track_coord);
+            if (fabsf(track_coord.getX()) <= 0.25f * getNode(n)->getPathWidth())
+            {
+                on_track = true;
+                break;
+            }
+        }
+        if (!on_track)
+            return false;
+    }
+    return true;
+}   // isLineOnTrack
+
+//-----------------------------------------------------------------------------
+/** Returns the name of the file in which the AI data of this graph is
+ *  cached. It depends on the track, the quad file and the direction.
+ */
+std::string DriveGraph::getAIDataCacheFile() const
+{
+    const std::string track_dir =
+        StringUtils::getBasename(StringUtils::getPath(m_quad_filename));
+    const std::string quad_name =
+        StringUtils::removeExtension(StringUtils::getBasename(m_quad_filename));
+    return file_manager->getCachedDataDir() + track_dir + "-" + quad_name
+         + (m_reverse ? "-reverse" : "") + ".aidata";
+}   // getAIDataCacheFile
+
+//-----------------------------------------------------------------------------
+/** Loads the AI data from the cache file.
+ *  \param cache_file Name of the cache file.
+ *  \return False if the file can not be read or does not match the graph,
+ *          in which case the data must be computed.
+ */
+bool DriveGraph::loadAIData(const std::string &cache_file)
+{
+    FILE *fd = FileUtils::fopenU8Path(cache_file, "rb");
+    if (!fd)
+        return false;
+
+    uint8_t version = 0;
+    uint32_t num_nodes = 0;
+    bool ok = fread(&version, 1, 1, fd) == 1 &&
+              version == AI_DATA_CACHE_VERSION &&
+              fread(&num_nodes, 4, 1, fd) == 1 &&
+              num_nodes == m_all_nodes.size();
+    for (unsigned int i = 0; ok && i < m_all_nodes.size(); i++)
+    {
+        DriveNode *dn = getNode(i);
+        uint32_t num_succ = 0;
+        ok = fread(&num_succ, 4, 1, fd) == 1 &&
+             num_succ == dn->getNumberOfSuccessors();
+        for (unsigned int j = 0; ok && j < num_succ; j++)
+        {
+            float data[4];
+            int32_t look_ahead;
+            ok = fread(data, 4, 4, fd) == 4 &&
+                 fread(&look_ahead, 4, 1, fd) == 1 &&
+                 look_ahead >= 0 && look_ahead < (int)m_all_nodes.size();
+            if (ok)
+            {
+                dn->setAIData(j, data[0], Vec3(data[1], data[2], data[3]),
+                              look_ahead);
+            }
+        }
+    }
+    fclose(fd);
+    if (!ok)
+    {
+        Log::warn("DriveGraph", "Invalid AI data cache '%s', recomputing.",
+                  cache_file.c_str());
+    }
+    return ok;
+}   // loadAIData
+
+//-----------------------------------------------------------------------------
+/** Saves the AI data to the cache file. Errors are only logged, the data
+ *  will then be recomputed the next time.
+ *  \param cache_file Name of the cache file.
+ */
+void DriveGraph::saveAIData(const std::string &cache_file) const
+{
+    FILE *fd = FileUtils::fopenU8Path(cache_file, "wb");
+    if (!fd)
+    {
+        Log::warn("DriveGraph", "Can not write AI data cache '%s'.",
+                  cache_file.c_str());
+        return;
+    }
+    const uint32_t num_nodes = (uint32_t)m_all_nodes.size();
+    fwrite(&AI_DATA_CACHE_VERSION, 1, 1, fd);
+    fwrite(&num_nodes, 4, 1, fd);
+    for (unsigned int i = 0; i < m_all_nodes.size(); i++)
+    {
+        const DriveNode *dn = getNode(i);
+        const uint32_t num_succ = dn->getNumberOfSuccessors();
+        fwrite(&num_succ, 4, 1, fd);
+        for (unsigned int j = 0; j < num_succ; j++)
+        {
+            const Vec3 &p = dn->getRacingLinePoint(j);
+            const float data[4] = { dn->getCurveRadius(j),
+                                    p.getX(), p.getY(), p.getZ() };
+            const int32_t look_ahead = dn->getLookAheadNode(j);
+            fwrite(data, 4, 4, fd);
+            fwrite(&look_ahead, 4, 1, fd);
+        }
+    }
+    fclose(fd);
+}   // saveAIData
+
 
 //-----------------------------------------------------------------------------
 /** This function takes absolute coordinates (coordinates in OpenGL
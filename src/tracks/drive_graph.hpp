@@ -56,6 +56,19 @@ private:
     // ------------------------------------------------------------------------
     void determineDirection(unsigned int current, unsigned int succ_index);
     // ------------------------------------------------------------------------
+    void computeAIData(const std::string &graph_file_name);
+    // ------------------------------------------------------------------------
+    void determineAIData(unsigned int current, unsigned int succ_index);
+    // ------------------------------------------------------------------------
+    bool isLineOnTrack(const Vec3 &start, const Vec3 &end,
+                       const std::vector<unsigned int> &path) const;
+    // ------------------------------------------------------------------------
+    std::string getAIDataCacheFile() const;
+    // ------------------------------------------------------------------------
+    bool loadAIData(const std::string &cache_file);
+    // ------------------------------------------------------------------------
+    void saveAIData(const std::string &cache_file) const;
+    // ------------------------------------------------------------------------
     float normalizeAngle(float f);
     // ------------------------------------------------------------------------
     void addSuccessor(unsigned int from, unsigned int to);
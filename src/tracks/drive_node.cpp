@@ -23,6 +23,8 @@
 #include "tracks/drive_graph.hpp"
 #include "utils/log.hpp"
 
+const float DriveNode::STRAIGHT_RADIUS = 9999.9f;
+
 // ----------------------------------------------------------------------------
 DriveNode::DriveNode(const Vec3 &p0, const Vec3 &p1, const Vec3 &p2,
                      const Vec3 &p3, const Vec3 &normal,
@@ -162,6 +164,24 @@ void DriveNode::setDirectionData(unsigned int successor, DirectionType dir,
     m_last_index_same_direction[successor] = last_node_index;
 }   // setDirectionData
 
+// ----------------------------------------------------------------------------
+/** Sets the precomputed AI data for a successor, see
+ *  DriveGraph::computeAIData().
+ */
+void DriveNode::setAIData(unsigned int successor, float curve_radius,
+                          const Vec3 &racing_line_point, int look_ahead_node)
+{
+    if(m_curve_radius.size()<successor+1)
+    {
+        m_curve_radius.resize(successor+1);
+        m_racing_line_point.resize(successor+1);
+        m_look_ahead_node.resize(successor+1);
+    }
+    m_curve_radius[successor]      = curve_radius;
+    m_racing_line_point[successor] = racing_line_point;
+    m_look_ahead_node[successor]   = look_ahead_node;
+}   // setAIData
+
 // ----------------------------------------------------------------------------
 void DriveNode::setChecklineRequirements(int latest_checkline)
 {
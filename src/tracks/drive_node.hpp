@@ -36,6 +36,9 @@ public:
      *  AI only. */
     enum         DirectionType {DIR_STRAIGHT, DIR_LEFT, DIR_RIGHT,
                                 DIR_UNDEFINED};
+
+    /** The curve radius used for straight sections. */
+    static const float STRAIGHT_RADIUS;
 protected:
     /** Lower center point of the drive node. */
     Vec3 m_lower_center;
@@ -89,6 +92,19 @@ private:
      *  to the driving direction. */
     Vec3 m_right_unit_vector;
 
+    /** For each successor the radius of the curve from this node to the last
+     *  node with the same direction, or STRAIGHT_RADIUS. */
+    std::vector<float> m_curve_radius;
+
+    /** For each successor the point on this node the AI should drive
+     *  through, i.e. the center moved to the inside of a curve. */
+    std::vector<Vec3> m_racing_line_point;
+
+    /** For each successor the furthest node that can be reached in a
+     *  straight line from the center of this node without leaving the
+     *  track. */
+    std::vector<int> m_look_ahead_node;
+
     /**
      * Sets of checklines you should have activated when you are driving on
      * this node (there is a possibility of more than one set because of
@@ -118,6 +134,9 @@ public:
     void         setDirectionData(unsigned int successor, DirectionType dir,
                                   unsigned int last_node_index);
     // ------------------------------------------------------------------------
+    void         setAIData(unsigned int successor, float curve_radius,
+                           const Vec3 &racing_line_point, int look_ahead_node);
+    // ------------------------------------------------------------------------
     /** Returns the number of successors. */
     unsigned int getNumberOfSuccessors() const
                              { return (unsigned int)m_successor_nodes.size(); }
@@ -190,6 +209,21 @@ public:
     /** Returns a unit vector pointing to the right side of the quad. */
     const Vec3 &getRightUnitVector() const      { return m_right_unit_vector; }
     // ------------------------------------------------------------------------
+    /** Returns the radius of the curve ahead when driving to successor
+     *  succ, or STRAIGHT_RADIUS if the track is straight. */
+    float getCurveRadius(unsigned int succ) const
+                                              { return m_curve_radius[succ]; }
+    // ------------------------------------------------------------------------
+    /** Returns the point on this node the AI should drive through when
+     *  driving to successor succ. */
+    const Vec3& getRacingLinePoint(unsigned int succ) const
+                                         { return m_racing_line_point[succ]; }
+    // ------------------------------------------------------------------------
+    /** Returns the furthest node that can be reached in a straight line from
+     *  the center of this node when driving to successor succ. */
+    int getLookAheadNode(unsigned int succ) const
+                                           { return m_look_ahead_node[succ]; }
+    // ------------------------------------------------------------------------
     /** True if this node should be ignored by the AI. */
     bool        letAIIgnore() const                     { return m_ai_ignore; }
     // ------------------------------------------------------------------------
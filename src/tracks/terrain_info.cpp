@@ -31,8 +31,9 @@
  */
 TerrainInfo::TerrainInfo()
 {
-    m_last_material = NULL;
-    m_material      = NULL;
+    m_last_material    = NULL;
+    m_material         = NULL;
+    m_has_prepared_hit = false;
 }   // TerrainInfo
 
 //-----------------------------------------------------------------------------
@@ -44,6 +45,7 @@ TerrainInfo::TerrainInfo(const Vec3 &pos)
     // initialise HoT
     m_last_material = NULL;
     m_material = NULL;
+    m_has_prepared_hit = false;
     update(pos);
 }   // TerrainInfo
 
@@ -79,12 +81,24 @@ void TerrainInfo::update(const btMatrix3x3 &rotation, const Vec3 &from)
 
     // Compute the 'to' vector by rotating a long 'down' vectory by the
     // kart rotation, and adding the start point to it.
-    btVector3 to(0, -10000.0f, 0);
-    to = from + rotation*to;
+    Vec3 to = getRayEnd(rotation, from);
 
-    const TriangleMesh &tm = Track::getCurrentTrack()->getTriangleMesh();
-    tm.castRay(from, to, &m_hit_point, &m_material, &m_normal,
-               /*interpolate*/true);
+    if (m_has_prepared_hit && m_prepared_from == from && m_prepared_to == to)
+    {
+        // Same ray as cast in advance, just copy the result (castRay
+        // does not modify the hit point if nothing was hit)
+        m_material = m_prepared_hit.m_material;
+        m_normal   = m_prepared_hit.m_normal;
+        if (m_prepared_hit.hasHit())
+            m_hit_point = m_prepared_hit.m_hit_point;
+    }
+    else
+    {
+        const TriangleMesh &tm = Track::getCurrentTrack()->getTriangleMesh();
+        tm.castRay(from, to, &m_hit_point, &m_material, &m_normal,
+                   /*interpolate*/true);
+    }
+    m_has_prepared_hit = false;
     // Now also raycast against all track objects (that are driveable). If
     // there should be a closer result (than the one against the main track 
     // mesh), its data will be returned.
@@ -92,6 +106,23 @@ void TerrainInfo::update(const btMatrix3x3 &rotation, const Vec3 &from)
                             ->castRay(from, to, &m_hit_point, &m_material,
                                       &m_normal, /*interpolate*/true);
 }   // update
+//-----------------------------------------------------------------------------
+/** Sets the result of the ray against the track which was cast in advance
+ *  (together with the rays of all other karts, see World::prepareTerrainRays).
+ *  It is used by the next update(rotation, from) call if that casts exactly
+ *  the same ray.
+ *  \param from, to Start and end point of the ray.
+ *  \param hit The result against the track mesh.
+ */
+void TerrainInfo::setPreparedHit(const Vec3 &from, const Vec3 &to,
+                                 const TriangleMesh::RayHit &hit)
+{
+    m_has_prepared_hit = true;
+    m_prepared_from    = from;
+    m_prepared_to      = to;
+    m_prepared_hit     = hit;
+}   // setPreparedHit
+
 //-----------------------------------------------------------------------------
 /** Update the terrain information based on the latest position.
 *  \param Position from which to start the rayast from.
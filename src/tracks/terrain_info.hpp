@@ -19,6 +19,7 @@
 #ifndef HEADER_TERRAIN_INFO_HPP
 #define HEADER_TERRAIN_INFO_HPP
 
+#include "physics/triangle_mesh.hpp"
 #include "utils/vec3.hpp"
 
 class btTransform;
@@ -43,6 +44,16 @@ private:
     /** DEBUG only: origin of raycast. */
     Vec3 m_origin_ray;
 
+    /** True if m_prepared_hit contains the result of the next ray against
+     *  the track, see setPreparedHit(). */
+    bool                 m_has_prepared_hit;
+
+    /** Start and end of the ray that was cast in advance. */
+    Vec3                 m_prepared_from, m_prepared_to;
+
+    /** Result of the ray cast in advance against the track mesh. */
+    TriangleMesh::RayHit m_prepared_hit;
+
 public:
              TerrainInfo();
              TerrainInfo(const Vec3 &pos);
@@ -53,6 +64,14 @@ public:
     virtual void update(const btMatrix3x3 &rotation, const Vec3 &from);
     virtual void update(const Vec3 &from);
     virtual void update(const Vec3 &from, const Vec3 &towards);
+    void     setPreparedHit(const Vec3 &from, const Vec3 &to,
+                            const TriangleMesh::RayHit &hit);
+    // ------------------------------------------------------------------------
+    /** Returns the end point of the ray used by update(rotation, from). */
+    static Vec3 getRayEnd(const btMatrix3x3 &rotation, const Vec3 &from)
+    {
+        return from + rotation * btVector3(0, -10000.0f, 0);
+    }
 
     // ------------------------------------------------------------------------
     /** Simple wrapper with no offset. */
@@ -110,7 +110,12 @@ bool        Track::m_dont_load_navmesh = false;
 std::atomic<Track*> Track::m_current_track[PT_COUNT];
 
 // ----------------------------------------------------------------------------
-Track::Track(const std::string &filename)
+/** Creates a track and loads the information needed for the menus.
+ *  \param filename Name of the track.xml file.
+ *  \param root The already parsed track.xml file (see AssetScanner), or NULL
+ *         to read it here. The track takes the ownership.
+ */
+Track::Track(const std::string &filename, XMLNode *root)
 {
 #ifdef DEBUG
     m_magic_number          = 0x17AC3802;
@@ -183,7 +188,7 @@ Track::Track(const std::string &filename)
     m_all_nodes.clear();
     m_static_physics_only_nodes.clear();
     m_all_cached_meshes.clear();
-    loadTrackInfo();
+    loadTrackInfo(root);
 }   // Track
 //-----------------------------------------------------------------------------
 /** Destructor, removes quad data structures etc. */
@@ -508,7 +513,10 @@ void Track::cleanup()
 }   // cleanup
 
 //-----------------------------------------------------------------------------
-void Track::loadTrackInfo()
+/** Loads the track information from track.xml.
+ *  \param root The parsed track.xml, or NULL to read it from m_filename.
+ */
+void Track::loadTrackInfo(XMLNode *root)
 {
     // Default values
     m_use_fog               = false;
@@ -532,7 +540,8 @@ void Track::loadTrackInfo()
     irr_driver->setSSAORadius(1.);
     irr_driver->setSSAOK(1.5);
     irr_driver->setSSAOSigma(1.);
-    XMLNode *root           = file_manager->createXMLTree(m_filename);
+    if (!root)
+        root = file_manager->createXMLTree(m_filename);
 
     if(!root || root->getName()!="track")
     {
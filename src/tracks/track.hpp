@@ -395,7 +395,7 @@ private:
     /** The number of laps that is predefined in a track info dialog. */
     int m_actual_number_of_laps;
 
-    void loadTrackInfo();
+    void loadTrackInfo(XMLNode *root);
     void loadDriveGraph(unsigned int mode_id, const bool reverse);
     void loadArenaGraph(const XMLNode &node);
     btQuaternion getArenaStartRotation(const Vec3& xyz, float heading);
@@ -442,7 +442,8 @@ public:
 
     static const float NOHIT;
 
-                       Track             (const std::string &filename);
+                       Track             (const std::string &filename,
+                                          XMLNode *root = NULL);
                       ~Track             ();
     void               cleanup           ();
     void               removeCachedData  ();
@@ -588,6 +589,18 @@ public:
     const std::string &getModeName(unsigned int i) const
                                               { return m_all_modes[i].m_name; }
     // ------------------------------------------------------------------------
+    /** Returns the full path of the quad file of the i-th. mode. */
+    std::string getModeQuadFile(unsigned int i) const
+                                { return m_root + m_all_modes[i].m_quad_name; }
+    // ------------------------------------------------------------------------
+    /** Returns the full path of the graph file of the i-th. mode. */
+    std::string getModeGraphFile(unsigned int i) const
+                               { return m_root + m_all_modes[i].m_graph_name; }
+    // ------------------------------------------------------------------------
+    /** Returns the full path of the scene file of the i-th. mode. */
+    std::string getModeSceneFile(unsigned int i) const
+                                    { return m_root + m_all_modes[i].m_scene; }
+    // ------------------------------------------------------------------------
     /** Returns the default ambient color. */
     const video::SColor &getDefaultAmbientColor() const
                                             { return m_default_ambient_color; }
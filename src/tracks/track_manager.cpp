@@ -20,8 +20,11 @@
 
 #include "config/stk_config.hpp"
 #include "graphics/irr_driver.hpp"
+#include "io/asset_scanner.hpp"
 #include "io/file_manager.hpp"
 #include "tracks/track.hpp"
+#include "utils/log.hpp"
+#include "utils/time.hpp"
 
 #include <algorithm>
 #include <iostream>
@@ -156,43 +159,39 @@ void TrackManager::loadTrackList()
         delete track;
     m_tracks.clear();
 
-    for(unsigned int i=0; i<m_track_search_path.size(); i++)
-    {
-        const std::string &dir = m_track_search_path[i];
-
-        // First test if the directory itself contains a track:
-        // ----------------------------------------------------
-        if(loadTrack(dir)) continue;  // track found, no more tests
-
-        // Then see if a subdir of this dir contains tracks
-        // ------------------------------------------------
-        std::set<std::string> dirs;
-        file_manager->listFiles(dirs, dir);
-        for(std::set<std::string>::iterator subdir = dirs.begin();
-            subdir != dirs.end(); subdir++)
-        {
-            if(*subdir=="." || *subdir=="..") continue;
-            loadTrack(dir+*subdir+"/");
-        }   // for dir in dirs
-    }   // for i <m_track_search_path.size()
+    // Find and parse all track.xml files in parallel, then create the
+    // tracks in the order they were found
+    AssetScanner scanner(m_track_search_path, "track.xml", "/",
+                         "tracks.index");
+    uint64_t start = StkTime::getMonoTimeUs();
+    for (unsigned int i = 0; i < scanner.getNumAssets(); i++)
+        loadTrack(scanner.getDir(i), scanner.takeXML(i));
+
+    Log::info("TrackManager", "Loaded %d tracks (%d from index): discovery "
+              "%.1f ms, parsing %.1f ms, loading %.1f ms.",
+              (int)m_tracks.size(), (int)scanner.getNumIndexed(),
+              scanner.getDiscoveryTime(), scanner.getParseTime(),
+              (StkTime::getMonoTimeUs() - start) / 1000.0f);
 }  // loadTrackList
 
 // ----------------------------------------------------------------------------
 /** Tries to load a track from a single directory. Returns true if a track was
  *  successfully loaded.
  *  \param dirname Name of the directory to load the track from.
+ *  \param root The already parsed track.xml file, or NULL to read it. Its
+ *         ownership is passed to the track.
  */
-bool TrackManager::loadTrack(const std::string& dirname)
+bool TrackManager::loadTrack(const std::string& dirname, XMLNode *root)
 {
     std::string config_file = dirname+"track.xml";
-    if(!file_manager->fileExists(config_file))
+    if(!root && !file_manager->fileExists(config_file))
         return false;
 
     Track *track;
 
     try
     {
-        track = new Track(config_file);
+        track = new Track(config_file, root);
     }
     catch (std::exception& e)
     {
@@ -332,6 +332,8 @@ void Log::openOutputFiles(const std::string &logout)
 /** Function to close output files */
 void Log::closeOutputFiles()
 {
-    fclose(m_file_stdout);
+    if (m_file_stdout)
+        fclose(m_file_stdout);
+    m_file_stdout = NULL;
 } // closeOutputFiles
 
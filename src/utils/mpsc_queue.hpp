@@ -0,0 +1,172 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2024 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#ifndef HEADER_MPSC_QUEUE_HPP
+#define HEADER_MPSC_QUEUE_HPP
+
+#include "utils/no_copy.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <utility>
+
+/** A lock-free queue into which any number of threads can push, and from
+ *  which one thread (the consumer) pops. Pushing adds a node to a lock-free
+ *  stack; the consumer takes the whole stack at once and reverses it, so
+ *  elements are popped in the order they were pushed by each thread.
+ *  Popped nodes are kept in a free list and reused by later pushes, so a
+ *  queue with a steady flow of elements stops allocating. The free list is
+ *  protected by a mutex (taking a node from a lock-free stack with several
+ *  producers would suffer from the ABA problem), it is only held to unlink
+ *  or link one node.
+ */
+template<typename TYPE>
+class MPSCQueue : public NoCopy
+{
+private:
+    /** Maximum number of unused nodes kept in the free list. */
+    static const unsigned MAX_FREE = 1024;
+
+    struct Node
+    {
+        TYPE  m_value;
+        Node *m_next;
+    };
+
+    /** The most recently pushed node, shared by all threads. */
+    std::atomic<Node*> m_head;
+
+    /** Consumer only: nodes taken from m_head, oldest first. */
+    Node *m_pending;
+
+    /** Unused nodes which are reused by push, protected by m_free_mutex. */
+    Node *m_free;
+    unsigned m_num_free;
+    std::mutex m_free_mutex;
+
+    /** Number of nodes allocated so far. */
+    std::atomic<unsigned> m_num_allocations;
+
+    // ------------------------------------------------------------------------
+    Node* getNode()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_free_mutex);
+            if (m_free)
+            {
+                Node *n = m_free;
+                m_free = n->m_next;
+                m_num_free--;
+                return n;
+            }
+        }
+        m_num_allocations.fetch_add(1);
+        return new Node();
+    }   // getNode
+    // ------------------------------------------------------------------------
+    void releaseNode(Node *n)
+    {
+        n->m_value = TYPE();
+        {
+            std::lock_guard<std::mutex> lock(m_free_mutex);
+            if (m_num_free < MAX_FREE)
+            {
+                n->m_next = m_free;
+                m_free = n;
+                m_num_free++;
+                return;
+            }
+        }
+        delete n;
+    }   // releaseNode
+
+public:
+    // ------------------------------------------------------------------------
+    MPSCQueue() : m_head(NULL), m_pending(NULL), m_free(NULL), m_num_free(0),
+                  m_num_allocations(0) {}
+    // ------------------------------------------------------------------------
+    /** Deletes all remaining nodes, their values are not cleaned up. */
+    ~MPSCQueue()
+    {
+        while (m_free)
+        {
+            Node *next = m_free->m_next;
+            delete m_free;
+            m_free = next;
+        }
+        Node *n = m_head.exchange(NULL);
+        while (n)
+        {
+            Node *next = n->m_next;
+            delete n;
+            n = next;
+        }
+        while (m_pending)
+        {
+            Node *next = m_pending->m_next;
+            delete m_pending;
+            m_pending = next;
+        }
+    }   // ~MPSCQueue
+    // ------------------------------------------------------------------------
+    /** Adds a value to the queue, can be called from any thread. */
+    void push(const TYPE &value)
+    {
+        Node *n = getNode();
+        n->m_value = value;
+        n->m_next = m_head.load();
+        while (!m_head.compare_exchange_weak(n->m_next, n)) {}
+    }   // push
+    // ------------------------------------------------------------------------
+    /** Removes the oldest value from the queue. Must only be called by the
+     *  consumer thread.
+     *  \param value The value removed.
+     *  \return False if the queue was empty.
+     */
+    bool pop(TYPE *value)
+    {
+        if (!m_pending)
+        {
+            Node *n = m_head.exchange(NULL);
+            while (n)
+            {
+                Node *next = n->m_next;
+                n->m_next = m_pending;
+                m_pending = n;
+                n = next;
+            }
+            if (!m_pending)
+                return false;
+        }
+        Node *n = m_pending;
+        m_pending = n->m_next;
+        *value = std::move(n->m_value);
+        releaseNode(n);
+        return true;
+    }   // pop
+    // ------------------------------------------------------------------------
+    /** Returns if the queue is empty. Must only be called by the consumer
+     *  thread, other threads could still be pushing. */
+    bool empty() const { return !m_pending && !m_head.load(); }
+    // ------------------------------------------------------------------------
+    /** Returns how many nodes were allocated so far. */
+    unsigned getNumAllocations() const      { return m_num_allocations.load(); }
+};   // MPSCQueue
+
+#endif
@@ -46,6 +46,7 @@ Profiler profiler;
 
 #define MARKERS_NAMES_POS     core::rect<s32>(50,100,150,600)
 #define GPU_MARKERS_NAMES_POS core::rect<s32>(50,165,150,300)
+#define COUNTERS_NAMES_POS    core::rect<s32>(250,100,450,600)
 
 // The width of the profiler corresponds to TIME_DRAWN_MS milliseconds
 #define TIME_DRAWN_MS 30.0f 
@@ -198,6 +199,27 @@ void Profiler::popCPUMarker()
     m_lock.unlock();
 }   // popCPUMarker
 
+//-----------------------------------------------------------------------------
+/** Sets the value of a counter for the current frame. If the counter is set
+ *  more than once in a frame, the last value is kept.
+ *  \param name Name of the counter.
+ *  \param value The value for this frame.
+ */
+void Profiler::setCounter(const char* name, int value)
+{
+    // Don't do anything when disabled or frozen
+    if (!UserConfigParams::m_profiler_enabled ||
+         m_freeze_state == FROZEN || m_freeze_state == WAITING_FOR_UNFREEZE )
+        return;
+
+    m_lock.lock();
+    std::vector<int> &values = m_all_counters[name];
+    if (values.empty())
+        values.resize(m_max_frames, 0);
+    values[m_current_frame] = value;
+    m_lock.unlock();
+}   // setCounter
+
 //-----------------------------------------------------------------------------
 /** Switches the profiler either on or off.
  */
@@ -266,6 +288,8 @@ void Profiler::synchronizeFrame()
             for (k = aed.begin(); k != aed.end(); ++k)
                 k->second.getMarker(next_frame).clear();
         }
+        for (auto &counter : m_all_counters)
+            counter.second[next_frame] = 0;
     }   // is has wrapped around
 
     m_current_frame = next_frame;
@@ -465,6 +489,17 @@ void Profiler::draw()
             font->drawQuick(oss.str().c_str(), GPU_MARKERS_NAMES_POS,
                        video::SColor(0xFF, 0xFF, 0x00, 0x00));
         }
+
+        if (!m_all_counters.empty())
+        {
+            std::ostringstream oss;
+            m_lock.lock();
+            for (auto &counter : m_all_counters)
+                oss << counter.first << ": " << counter.second[indx] << std::endl;
+            m_lock.unlock();
+            font->drawQuick(oss.str().c_str(), COUNTERS_NAMES_POS,
+                            video::SColor(0xFF, 0x00, 0x00, 0xFF));
+        }
     }
 
     PROFILER_POP_CPU_MARKER();
@@ -580,6 +615,27 @@ void Profiler::writeToFile()
         start = (start + 1) % m_max_frames;
     }
     f_gpu.close();
+
+    if (!m_all_counters.empty())
+    {
+        std::ofstream f_counters(FileUtils::getPortableWritingPath(
+                                        base_name + ".profile-counters"));
+        f_counters << "#  ";
+        int n = 1;
+        for (auto &counter : m_all_counters)
+            f_counters << "\"" << counter.first << "(" << n++ << ")\"   ";
+        f_counters << std::endl;
+        start = m_has_wrapped_around ? m_current_frame + 1 : 0;
+        if (start > m_max_frames) start -= m_max_frames;
+        while (start != m_current_frame)
+        {
+            for (auto &counter : m_all_counters)
+                f_counters << counter.second[start] << " ";
+            f_counters << std::endl;
+            start = (start + 1) % m_max_frames;
+        }
+        f_counters.close();
+    }
     m_lock.unlock();
 
 }   // writeFile
@@ -75,6 +75,9 @@ double getTimeMilliseconds();
     #define PROFILER_POP_CPU_MARKER()  \
         profiler.popCPUMarker()
 
+    #define PROFILER_SET_COUNTER(name, value) \
+        profiler.setCounter(name, value)
+
     #define PROFILER_SYNC_FRAME()   \
         profiler.synchronizeFrame()
 
@@ -83,6 +86,7 @@ double getTimeMilliseconds();
 #else
     #define PROFILER_PUSH_CPU_MARKER(name, r, g, b)
     #define PROFILER_POP_CPU_MARKER()
+    #define PROFILER_SET_COUNTER(name, value)
     #define PROFILER_SYNC_FRAME()
     #define PROFILER_DRAW()
 #endif
@@ -224,6 +228,10 @@ private:
      *  is the thread id. */
     std::vector< ThreadData> m_all_threads_data;
 
+    /** Buffered values of all counters (e.g. number of objects handled in
+     *  a certain way), indexed by counter name and then by frame. */
+    std::map<std::string, std::vector<int> > m_all_counters;
+
     /** Buffer for the GPU times (in ms). */
     std::vector<int> m_gpu_times;
 
@@ -280,6 +288,7 @@ public:
     void     pushCPUMarker(const char* name="N/A",
                            const video::SColor& color=video::SColor());
     void     popCPUMarker();
+    void     setCounter(const char* name, int value);
     void     toggleStatus(); 
     void     synchronizeFrame();
     void     draw();
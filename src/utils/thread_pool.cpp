@@ -0,0 +1,176 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2024 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#include "utils/thread_pool.hpp"
+
+#include "utils/log.hpp"
+#include "utils/string_utils.hpp"
+#include "utils/vs.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <memory>
+
+ThreadPool *ThreadPool::m_thread_pool = NULL;
+
+// ----------------------------------------------------------------------------
+/** Creates the thread pool.
+ *  \param num_threads Number of worker threads, 0 disables the pool (all
+ *         work is then done on the calling thread), a negative value uses
+ *         the number of CPU cores minus one.
+ */
+void ThreadPool::create(int num_threads)
+{
+    assert(!m_thread_pool);
+    if (num_threads < 0)
+    {
+        int cores = (int)std::thread::hardware_concurrency();
+        num_threads = std::max(cores - 1, 0);
+    }
+    m_thread_pool = new ThreadPool((unsigned)num_threads);
+}   // create
+
+// ----------------------------------------------------------------------------
+void ThreadPool::destroy()
+{
+    delete m_thread_pool;
+    m_thread_pool = NULL;
+}   // destroy
+
+// ----------------------------------------------------------------------------
+ThreadPool::ThreadPool(unsigned num_threads)
+{
+    m_exit = false;
+    for (unsigned i = 0; i < num_threads; i++)
+        m_threads.emplace_back(&ThreadPool::mainLoop, this, i);
+    Log::info("ThreadPool", "Started %d worker threads.", num_threads);
+}   // ThreadPool
+
+// ----------------------------------------------------------------------------
+ThreadPool::~ThreadPool()
+{
+    std::unique_lock<std::mutex> ul(m_tasks_mutex);
+    m_exit = true;
+    ul.unlock();
+    m_tasks_cv.notify_all();
+    for (std::thread& t : m_threads)
+        t.join();
+}   // ~ThreadPool
+
+// ----------------------------------------------------------------------------
+/** The main loop of a worker thread: runs queued tasks until the pool is
+ *  destroyed. Remaining tasks are still executed before exiting, so a
+ *  caller waiting in parallelFor() can never hang.
+ */
+void ThreadPool::mainLoop(unsigned thread_id)
+{
+    std::string name = StringUtils::insertValues("ThreadPool%d", thread_id);
+    VS::setThreadName(name.c_str());
+    while (true)
+    {
+        std::unique_lock<std::mutex> ul(m_tasks_mutex);
+        m_tasks_cv.wait(ul, [this]{ return m_exit || !m_tasks.empty(); });
+        if (m_tasks.empty())
+            return;
+        Task task = std::move(m_tasks.front());
+        m_tasks.pop_front();
+        ul.unlock();
+
+        STKProcess::init(task.m_process_type);
+        task.m_function();
+    }
+}   // mainLoop
+
+// ----------------------------------------------------------------------------
+/** Queues a task to be run by one of the worker threads. If the pool has
+ *  no threads, the task is run immediately.
+ */
+void ThreadPool::addTask(std::function<void()> task)
+{
+    if (m_threads.empty())
+    {
+        task();
+        return;
+    }
+    std::unique_lock<std::mutex> ul(m_tasks_mutex);
+    m_tasks.push_back({ std::move(task), STKProcess::getType() });
+    ul.unlock();
+    m_tasks_cv.notify_one();
+}   // addTask
+
+// ----------------------------------------------------------------------------
+/** Calls function(i) for all i in [0, count) using the worker threads and
+ *  the calling thread, and returns once all calls have finished. The order
+ *  in which indices are processed is undefined, so function must only
+ *  write data that belongs to its index.
+ *  \param count Number of indices.
+ *  \param function The function to call for each index.
+ */
+void ThreadPool::parallelFor(unsigned count,
+                             const std::function<void(unsigned)> &function)
+{
+    if (m_threads.empty() || count < 2)
+    {
+        for (unsigned i = 0; i < count; i++)
+            function(i);
+        return;
+    }
+
+    // Shared between all helpers, since a helper task can start after
+    // this function has returned (if all indices were already done).
+    struct Batch
+    {
+        std::atomic<unsigned>                m_next;
+        std::atomic<unsigned>                m_done;
+        unsigned                             m_count;
+        const std::function<void(unsigned)> *m_function;
+        std::mutex                           m_mutex;
+        std::condition_variable              m_cv;
+        // --------------------------------------------------------------------
+        void run()
+        {
+            while (true)
+            {
+                unsigned i = m_next.fetch_add(1);
+                if (i >= m_count)
+                    return;
+                (*m_function)(i);
+                if (m_done.fetch_add(1) + 1 == m_count)
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_cv.notify_all();
+                }
+            }
+        }   // run
+    };
+    auto batch = std::make_shared<Batch>();
+    batch->m_next.store(0);
+    batch->m_done.store(0);
+    batch->m_count = count;
+    batch->m_function = &function;
+
+    unsigned helpers = std::min(count - 1, getNumThreads());
+    for (unsigned i = 0; i < helpers; i++)
+        addTask([batch]() { batch->run(); });
+
+    batch->run();
+    std::unique_lock<std::mutex> ul(batch->m_mutex);
+    batch->m_cv.wait(ul, [&batch]
+        { return batch->m_done.load() == batch->m_count; });
+}   // parallelFor
@@ -0,0 +1,96 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2024 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#ifndef HEADER_THREAD_POOL_HPP
+#define HEADER_THREAD_POOL_HPP
+
+#include "utils/no_copy.hpp"
+#include "utils/stk_process.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/** A fixed size pool of worker threads shared by the main and the child
+ *  (server) process. Work can either be added as independent tasks with
+ *  addTask(), or be split into indices with parallelFor(), in which case
+ *  the calling thread takes part in the work and only returns once all
+ *  indices are done. Idle workers always pick the next unclaimed index,
+ *  so uneven work (e.g. one AI doing a long raycast) is balanced
+ *  automatically. Each task runs with the \ref ProcessType of the thread
+ *  that queued it, so World::getWorld() and friends return the right
+ *  instance.
+ * \ingroup utils
+ */
+class ThreadPool : public NoCopy
+{
+private:
+    /** A queued task together with the process type it belongs to. */
+    struct Task
+    {
+        std::function<void()> m_function;
+        ProcessType           m_process_type;
+    };
+
+    /** The singleton. */
+    static ThreadPool *m_thread_pool;
+
+    /** All worker threads. */
+    std::vector<std::thread> m_threads;
+
+    /** Protects m_tasks and m_exit. */
+    std::mutex m_tasks_mutex;
+
+    /** Signalled when a task is added or the pool is shut down. */
+    std::condition_variable m_tasks_cv;
+
+    /** Tasks not yet picked up by a worker. */
+    std::deque<Task> m_tasks;
+
+    /** Set when the pool is destroyed. */
+    bool m_exit;
+
+    // ------------------------------------------------------------------------
+    ThreadPool(unsigned num_threads);
+    // ------------------------------------------------------------------------
+    ~ThreadPool();
+    // ------------------------------------------------------------------------
+    void mainLoop(unsigned thread_id);
+
+public:
+    // ------------------------------------------------------------------------
+    static void create(int num_threads);
+    // ------------------------------------------------------------------------
+    static void destroy();
+    // ------------------------------------------------------------------------
+    /** Returns the thread pool, or NULL if it was not created. */
+    static ThreadPool *get()                         { return m_thread_pool; }
+    // ------------------------------------------------------------------------
+    /** Returns the number of worker threads (excluding the caller). */
+    unsigned getNumThreads() const     { return (unsigned)m_threads.size(); }
+    // ------------------------------------------------------------------------
+    void addTask(std::function<void()> task);
+    // ------------------------------------------------------------------------
+    void parallelFor(unsigned count,
+                     const std::function<void(unsigned)> &function);
+};   // ThreadPool
+
+#endif
@@ -111,6 +111,17 @@ public:
         return value.count();
     }
     // ------------------------------------------------------------------------
+    /** Returns a time based since the starting of stk (monotonic clock).
+     *  The value is a 64bit unsigned integer in microseconds.
+     */
+    static uint64_t getMonoTimeUs()
+    {
+        auto duration = std::chrono::steady_clock::now() - m_mono_start;
+        auto value =
+            std::chrono::duration_cast<std::chrono::microseconds>(duration);
+        return value.count();
+    }
+    // ------------------------------------------------------------------------
     /**
      * \brief Compare two different times.
      * \return A signed integral indicating the relation between the time.